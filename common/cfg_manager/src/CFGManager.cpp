@@ -573,6 +573,23 @@ namespace mars {
     }
 
 
+    CFGValueCache* CFGManager::acquireValueCache(const cfgParamId &_id,
+                                                 const cfgParamType &_type) {
+      // the lock keeps the param from being removed before the cache is
+      // acquired
+      utils::MutexLocker locker(&mutexCFGParams);
+      CFGParam *param = NULL;
+      if( getParam(&param, _id) && param->getParamType() == _type ) {
+        CFGValueCache *cache = param->getValueCache();
+        if(cache) {
+          cache->acquire();
+        }
+        return cache;
+      }
+      return NULL;
+    }
+
+
     const cfgParamInfo CFGManager::getParamInfo(const cfgParamId &_id) const {
       utils::MutexLocker locker(&mutexCFGParams);
       CFGParam *param = NULL;
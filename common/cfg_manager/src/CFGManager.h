@@ -131,6 +131,9 @@ namespace mars {
       virtual cfgParamId getParamId(const std::string &_group,
                                     const std::string &_name) const;
 
+      virtual CFGValueCache* acquireValueCache(const cfgParamId &_id,
+                                               const cfgParamType &_type);
+
       virtual const cfgParamInfo getParamInfo(const cfgParamId &_id) const;
       virtual const cfgParamInfo getParamInfo(const std::string &_group,
                                               const std::string &_name) const;
@@ -35,6 +35,7 @@
 
 #include "CFGDefs.h"
 #include "CFGClient.h"
+#include "CfgHandle.h"
 
 #include <lib_manager/LibManager.hpp>
 
@@ -124,6 +125,31 @@ namespace mars {
       virtual cfgParamId getParamId(const std::string &_group,
                                     const std::string &_name) const = 0;
 
+      /**
+       * \brief Returns a handle to the "value" property of a double, int
+       * or bool param. The handle is empty if the param does not exist or
+       * is of another type.
+       */
+      template <typename T>
+      CfgHandle<T> getHandle(const std::string &_group,
+                             const std::string &_name) {
+        return getHandle<T>(getParamId(_group, _name));
+      }
+
+      template <typename T>
+      CfgHandle<T> getHandle(const cfgParamId &_id) {
+        return CfgHandle<T>(acquireValueCache(_id,
+                                              CfgHandleType<T>::paramType()));
+      }
+
+      /**
+       * \brief Returns the acquired value cache of the param or \c NULL if
+       * the param does not exist or is not of \a _type.
+       * The caller has to release the cache; use getHandle() instead.
+       */
+      virtual CFGValueCache* acquireValueCache(const cfgParamId &_id,
+                                               const cfgParamType &_type) = 0;
+
       virtual const cfgParamInfo getParamInfo(const cfgParamId &_id) const = 0;
       virtual const cfgParamInfo getParamInfo(const std::string &_group,
                                               const std::string &_name) const = 0;
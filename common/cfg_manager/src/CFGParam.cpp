@@ -42,11 +42,25 @@ namespace mars {
       this->paramName = _name;
       this->paramType = _type;
       this->options = noParamOption;
+      switch(_type) {
+      case doubleParam:
+      case intParam:
+      case boolParam:
+        valueCache = new CFGValueCache(_id, _type);
+        break;
+      default:
+        valueCache = NULL;
+      }
     }
 
 
     CFGParam::~CFGParam() {
       //cout << "destroy CFGParam" << endl;
+      if(valueCache) {
+        // handles may still hold the cache
+        valueCache->invalidate();
+        valueCache->release();
+      }
 
       //vector<CFGClient*>::iterator iter;
       //mutexCFGClients.lock();
@@ -96,6 +110,11 @@ namespace mars {
     }
 
 
+    CFGValueCache* CFGParam::getValueCache() const {
+      return valueCache;
+    }
+
+
     void CFGParam::addClient(CFGClient *client) {
       if(client != NULL) {
         mutexCFGClients.lock();
@@ -320,11 +339,15 @@ namespace mars {
         } // switch
       } // if
 #endif
+      if(index == 0) {
+        updateValueCache();
+      }
     }
 
 
     bool CFGParam::writeProperty(const CFGProperty &property) const {
       unsigned int state = property.getState();
+      bool written = false;
       if( (state & CFGProperty::allSet) == CFGProperty::allSet ) {
         double dValue = 0.0;
         int iValue = 0;
@@ -333,34 +356,61 @@ namespace mars {
         switch( property.getPropertyType() ) {
         case doubleProperty :
           if( property.getValue(&dValue) ) {
-            return propertys.at( property.getPropertyIndex() )->setValue(dValue);
-          } else {
-            return false;
+            written = propertys.at( property.getPropertyIndex() )->setValue(dValue);
           }
+          break;
         case intProperty :
           if( property.getValue(&iValue) ) {
-            return propertys.at( property.getPropertyIndex() )->setValue(iValue);
-          } else {
-            return false;
+            written = propertys.at( property.getPropertyIndex() )->setValue(iValue);
           }
+          break;
         case boolProperty :
           if( property.getValue(&bValue) ) {
-            return propertys.at( property.getPropertyIndex() )->setValue(bValue);
-          } else {
-            return false;
+            written = propertys.at( property.getPropertyIndex() )->setValue(bValue);
           }
+          break;
         case stringProperty :
           if( property.getValue(&sValue) ) {
-            return propertys.at( property.getPropertyIndex() )->setValue(sValue);
-          } else {
-            return false;
+            written = propertys.at( property.getPropertyIndex() )->setValue(sValue);
           }
+          break;
         default :
           // do nothing
-          return false;
+          break;
         } //switch
       } //if
-      return false;
+      if(written && property.getPropertyIndex() == 0) {
+        updateValueCache();
+      }
+      return written;
+    }
+
+
+    // PRIVATE
+
+    void CFGParam::updateValueCache() const {
+      if(!valueCache || propertys.empty() || !propertys[0]->isValueSet()) {
+        return;
+      }
+      double dValue = 0.0;
+      int iValue = 0;
+      bool bValue = false;
+      switch( paramType ) {
+      case doubleParam:
+        propertys[0]->getValue(&dValue);
+        valueCache->write(dValue);
+        break;
+      case intParam:
+        propertys[0]->getValue(&iValue);
+        valueCache->write(iValue);
+        break;
+      case boolParam:
+        propertys[0]->getValue(&bValue);
+        valueCache->write(bValue);
+        break;
+      default:
+        break;
+      } // switch
     }
 
   } // end namespace cfg_manager
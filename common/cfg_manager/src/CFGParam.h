@@ -37,6 +37,7 @@
 #include "CFGDefs.h"
 #include "CFGProperty.h"
 #include "CFGClient.h"
+#include "CfgHandle.h"
 
 #include <yaml-cpp/yaml.h>
 
@@ -74,6 +75,12 @@ namespace mars {
       virtual void setOption(const unsigned char _newOption);
       virtual void unsetOption(const unsigned char _newOption);
 
+      /**
+       * \brief Returns the cache of the "value" property or \c NULL for
+       * string params. The cache is not acquired.
+       */
+      CFGValueCache* getValueCache() const;
+
       void addClient(CFGClient *client);
       void removeClient(CFGClient *client);
 
@@ -89,6 +96,10 @@ namespace mars {
       std::vector<CFGClient*> cfgClients;
       utils::Mutex mutexCFGClients;
 
+      CFGValueCache *valueCache;
+
+      void updateValueCache() const;
+
 
     protected:
       std::vector<CFGProperty*> propertys;
@@ -0,0 +1,212 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file CfgHandle.h
+ * \brief CfgHandle gives lock free read access to the value of a param
+ *
+ * Version 0.1
+ */
+
+#ifndef CFG_HANDLE_H
+#define CFG_HANDLE_H
+
+#ifdef _PRINT_HEADER_
+  #warning "CfgHandle.h"
+#endif
+
+#include "CFGDefs.h"
+
+#include <mars/utils/Mutex.h>
+
+#include <cstddef>
+
+
+namespace mars {
+  namespace cfg_manager {
+
+    /**
+     * \brief CFGValueCache mirrors the "value" property of a double, int
+     * or bool param.
+     *
+     * The cache is owned by the CFGParam and by every CfgHandle pointing
+     * to it, so a handle stays usable after its param was removed. Every
+     * value lives in its own naturally aligned field and is read with a
+     * single load. The version is incremented after each write.
+     */
+    class CFGValueCache {
+
+    public:
+      CFGValueCache(const cfgParamId &_id, const cfgParamType &_type)
+        : id(_id), type(_type), version(0), refCount(1), valid(true),
+          dValue(0.0), iValue(0), bValue(0) {}
+
+      const cfgParamId& getParamId() const {return id;}
+      const cfgParamType& getParamType() const {return type;}
+
+      void acquire() {
+        __sync_add_and_fetch(&refCount, 1);
+      }
+
+      void release() {
+        if(__sync_sub_and_fetch(&refCount, 1) == 0) {
+          delete this;
+        }
+      }
+
+      bool isValid() const {return valid;}
+      void invalidate() {valid = false;}
+
+      unsigned long getVersion() const {return version;}
+
+      void read(double *value) const {*value = dValue;}
+      void read(int *value) const {*value = iValue;}
+      void read(bool *value) const {*value = bValue;}
+
+      void write(double value) {
+        writeMutex.lock();
+        dValue = value;
+        __sync_add_and_fetch(&version, 1);
+        writeMutex.unlock();
+      }
+
+      void write(int value) {
+        writeMutex.lock();
+        iValue = value;
+        __sync_add_and_fetch(&version, 1);
+        writeMutex.unlock();
+      }
+
+      void write(bool value) {
+        writeMutex.lock();
+        bValue = value;
+        __sync_add_and_fetch(&version, 1);
+        writeMutex.unlock();
+      }
+
+    private:
+      CFGValueCache(const CFGValueCache &);
+      CFGValueCache &operator=(const CFGValueCache &);
+      ~CFGValueCache() {}
+
+      cfgParamId id;
+      cfgParamType type;
+      volatile unsigned long version;
+      volatile int refCount;
+      volatile bool valid;
+      volatile double dValue;
+      volatile int iValue;
+      volatile bool bValue;
+      utils::Mutex writeMutex;
+
+    }; // end class CFGValueCache
+
+
+    template <typename T> struct CfgHandleType;
+    template <> struct CfgHandleType<double> {
+      static cfgParamType paramType() {return doubleParam;}
+    };
+    template <> struct CfgHandleType<int> {
+      static cfgParamType paramType() {return intParam;}
+    };
+    template <> struct CfgHandleType<bool> {
+      static cfgParamType paramType() {return boolParam;}
+    };
+
+
+    /**
+     * \brief A pre-resolved handle to the value of a double, int or bool
+     * param.
+     *
+     * Handles are created by CFGManagerInterface::getHandle(). get() does
+     * not lock and does not look up the param, so it can be called from
+     * the simulation loop. To react on changes without registering a
+     * CFGClient, a caller keeps the last seen version and polls changed()
+     * once per step; all writes in between are reported as one change.
+     */
+    template <typename T>
+    class CfgHandle {
+
+    public:
+      CfgHandle() : cache(NULL) {}
+
+      /**
+       * \brief Takes over one reference of an already acquired cache.
+       */
+      explicit CfgHandle(CFGValueCache *acquiredCache)
+        : cache(acquiredCache) {}
+
+      CfgHandle(const CfgHandle &other) : cache(other.cache) {
+        if(cache) cache->acquire();
+      }
+
+      ~CfgHandle() {
+        if(cache) cache->release();
+      }
+
+      CfgHandle& operator=(const CfgHandle &other) {
+        if(other.cache) other.cache->acquire();
+        if(cache) cache->release();
+        cache = other.cache;
+        return *this;
+      }
+
+      /**
+       * \brief Returns \c false for an empty handle or if the param was
+       * removed. In the second case get() returns the last value.
+       */
+      bool isValid() const {
+        return cache && cache->isValid();
+      }
+
+      cfgParamId getParamId() const {
+        return cache ? cache->getParamId() : 0;
+      }
+
+      T get() const {
+        T value = T();
+        if(cache) cache->read(&value);
+        return value;
+      }
+
+      unsigned long getVersion() const {
+        return cache ? cache->getVersion() : 0;
+      }
+
+      /**
+       * \brief Returns \c true if the value was written since the version
+       * stored in \a lastVersion and updates \a lastVersion.
+       */
+      bool changed(unsigned long *lastVersion) const {
+        unsigned long v = getVersion();
+        if(v == *lastVersion) return false;
+        *lastVersion = v;
+        return true;
+      }
+
+    private:
+      CFGValueCache *cache;
+
+    }; // end class CfgHandle
+
+  } // end namespace cfg_manager
+} // end namespace mars
+
+#endif /* CFG_HANDLE_H */
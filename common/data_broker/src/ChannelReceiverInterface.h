@@ -0,0 +1,73 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ChannelReceiverInterface.h
+ * \brief Interface for classes that want to receive the blocks of a
+ *        DataChannel.
+ */
+
+#ifndef CHANNELRECEIVERINTERFACE_H
+#define CHANNELRECEIVERINTERFACE_H
+
+#ifdef _PRINT_HEADER_
+  #warning "ChannelReceiverInterface.h"
+#endif
+
+
+namespace mars {
+
+  namespace data_broker {
+
+    // forward declarations
+    class DataInfo;
+    class DataChannelBlock;
+
+    /**
+     * \brief Interface for classes that want to receive data of a
+     *        \ref DataChannel "typed channel" from the DataBroker.
+     */
+    class ChannelReceiverInterface {
+
+    public:
+      ChannelReceiverInterface() {}
+      virtual ~ChannelReceiverInterface() {}
+      /**
+       * \brief The DataBroker calls this method from within
+       *        \ref DataBrokerInterface::publishChannel "publishChannel"
+       *        for every new block of the channel.
+       * \param info Information about the channel.
+       * \param block The published values. The reference is only valid
+       *              during the call. A receiver that wants to keep the
+       *              block has to call DataChannelBlock::ref and later
+       *              DataChannelBlock::unref.
+       * \param callbackParam The \c int the receiver passed during
+       *                      registration.
+       */
+      virtual void receiveChannel(const DataInfo &info,
+                                  const DataChannelBlock &block,
+                                  int callbackParam) = 0;
+    }; // end of class ChannelReceiverInterface
+
+  } // end of namespace data_broker
+
+} // end of namespace mars
+
+#endif // CHANNELRECEIVERINTERFACE_H
@@ -44,6 +44,9 @@
 #include "DataBroker.h"
 #include "ProducerInterface.h"
 #include "ReceiverInterface.h"
+#include "ChannelReceiverInterface.h"
+#include "ElementTable.h"
+#include "ReadyQueue.h"
 
 #include <mars/utils/MutexLocker.h>
 #include <mars/utils/misc.h>
@@ -66,6 +69,12 @@ namespace mars {
       DataPackage package;
       const ReceiverInterface *producer;
     };
+
+    struct DeferredChannelCallback {
+      std::list<ChannelReceiver> receivers;
+      DataInfo info;
+      const DataChannelBlock *block;
+    };
     /// \endcond
 
 
@@ -95,8 +104,8 @@ namespace mars {
       next_id(1), thread_running(false), stop_thread(false),
       realtimeThreadRunning(false), startingRealtimeThread(false) {
 
-      updatedElementsBackBuffer = new std::set<DataElement*>;
-      updatedElementsFrontBuffer = new std::set<DataElement*>;
+      elementTable = new ElementTable;
+      readyQueue = new ReadyQueue;
 
       DataElement *e;
       e = createDataElement("data_broker", "newStream", DATA_PACKAGE_READ_FLAG);
@@ -138,25 +147,17 @@ namespace mars {
     DataBroker::~DataBroker() {
       stopRealtimeThread = true;
       stop_thread = true;
-      if(wakeupMutex.tryLock() == MUTEX_ERROR_NO_ERROR) {
-        wakeupCondition.wakeOne();
-        wakeupMutex.unlock();
-      }
+      readyQueue->wakeup();
       while(thread_running || realtimeThreadRunning) {
         msleep(10);
       }
-      std::map<unsigned long, DataElement*>::iterator elementIt;
       std::map<std::string, Timer>::iterator timerIt;
       std::map<std::string, Trigger>::iterator triggerIt;
       // TODO: This cleanup code is not really perfect threadingwise
       elementsLock.lockForWrite();
       timersLock.lockForWrite();
       triggersLock.lockForWrite();
-      updatedElementsLock.lock();
-      updatedElementsBackBuffer->clear();
-      updatedElementsFrontBuffer->clear();
-      delete updatedElementsBackBuffer;
-      delete updatedElementsFrontBuffer;
+      delete readyQueue;
       for(timerIt = timers.begin(); timerIt != timers.end(); ++timerIt) {
         //destroyLock(&timerIt->second.lock);
       }
@@ -166,18 +167,18 @@ namespace mars {
         //destroyLock(&triggerIt->second.lock);
       }
       triggers.clear();
-      for(elementIt = elementsById.begin();
-          elementIt != elementsById.end(); ++elementIt) {
-        DataElement *element = elementIt->second;
+      for(unsigned long id = 1; id < elementTable->getSize(); ++id) {
+        DataElement *element = elementTable->get(id);
+        if(!element) continue;
         //destroyLock(&element->receiverLock);
         //destroyLock(&element->bufferLock);
         delete element->backBuffer;
         delete element->frontBuffer;
+        delete element->channel;
         delete element;
       }
-      elementsById.clear();
+      delete elementTable;
       elementsByName.clear();
-      updatedElementsLock.unlock();
       triggersLock.unlock();
       timersLock.unlock();
       elementsLock.unlock();
@@ -186,7 +187,6 @@ namespace mars {
       //      destroyLock(&timersLock);
       //      destroyLock(&elementsLock);
       //      destroyLock(&idMutex);
-      //      destroyLock(&updatedElementsLock);
       //      destroyLock(&pendingRegistrationLock);
       //fprintf(stderr, "Delete data_broker\n");
     }
@@ -288,6 +288,7 @@ namespace mars {
     bool DataBroker::stepTimer(const std::string &timerName, long step) {
       std::map<std::string, Timer>::iterator timerIt, endIt;
       std::list<DeferredCallback> deferredCallbacks;
+      std::list<DeferredChannelCallback> deferredChannelCallbacks;
       std::set<DataItemConnection> activeConnections;
       std::set<DataElement*> connectionActivatedElements;
       DataItem currentItem;
@@ -325,6 +326,7 @@ namespace mars {
                                             element->backBuffer,
                                             producerIt->callbackParam);
           std::swap(element->backBuffer, element->frontBuffer);
+          ++element->sequence;
           element->receiverLock->lockForRead();
           if(!element->syncReceivers.empty()) {
             deferredCallback.package = *element->frontBuffer;
@@ -332,6 +334,14 @@ namespace mars {
             deferredCallback.producer = NULL;
             deferredCallback.receivers = element->syncReceivers;
           }
+          if(element->channel) {
+            DeferredChannelCallback channelCallback;
+            element->channel->readPackage(*element->frontBuffer);
+            channelCallback.block = element->channel->swap();
+            channelCallback.info = element->info;
+            channelCallback.receivers = element->channelReceivers;
+            deferredChannelCallbacks.push_back(channelCallback);
+          }
           std::list<DataItemConnection>::iterator connectionIt;
           for(connectionIt = element->connections.begin();
               connectionIt != element->connections.end(); ++connectionIt) {
@@ -345,9 +355,7 @@ namespace mars {
           element->receiverLock->unlock();
           element->bufferLock->unlock();
 
-          updatedElementsLock.lock();
-          updatedElementsBackBuffer->insert(element);
-          updatedElementsLock.unlock();
+          readyQueue->push(element);
 
           // defer synchronous callbacks until we do not hold any locks anymore
           if(!deferredCallback.receivers.empty())
@@ -414,6 +422,14 @@ namespace mars {
                                             receiverIt->callbackParam);
         }
       }
+      std::list<DeferredChannelCallback>::iterator channelCallbackIt;
+      for(channelCallbackIt = deferredChannelCallbacks.begin();
+          channelCallbackIt != deferredChannelCallbacks.end();
+          ++channelCallbackIt) {
+        callChannelReceivers(channelCallbackIt->receivers,
+                             channelCallbackIt->info, channelCallbackIt->block);
+        channelCallbackIt->block->unref();
+      }
 
       return true;
     }
@@ -916,70 +932,248 @@ namespace mars {
                                        const DataPackage &dataPackage,
                                        const ReceiverInterface *producer) {
       std::list<Receiver>::iterator syncReceiverIt;
-      std::map<unsigned long, DataElement*>::iterator elementIt;
       std::set<DataElement*> connectionActivatedElements;
       std::list<Receiver> syncReceivers;
-      DataInfo info;
-      DataElement *element = NULL;
-      elementsLock.lockForRead();
-      elementIt = elementsById.find(id);
-      if(elementIt == elementsById.end()) {
+      std::list<ChannelReceiver> channelReceivers;
+      const DataChannelBlock *channelBlock = NULL;
+      // elements are never removed, so no lock is needed for the lookup
+      DataElement *element = elementTable->get(id);
+      if(!element) {
         // ERROR: id not found!
-        elementsLock.unlock();
         return 0;
-      } else {
-        element = elementIt->second;
-        *element->backBuffer = dataPackage;
-        element->bufferLock->lockForWrite();
-        std::swap(element->backBuffer, element->frontBuffer);
-        element->lastProducer = producer;
-        element->bufferLock->unlock();
+      }
+      element->bufferLock->lockForWrite();
+      *element->backBuffer = dataPackage;
+      std::swap(element->backBuffer, element->frontBuffer);
+      element->lastProducer = producer;
+      ++element->sequence;
+      if(element->channel) {
+        // DataPackage producer of a typed channel
+        element->channel->readPackage(dataPackage);
+        channelBlock = element->channel->swap();
+      }
+      element->bufferLock->unlock();
 
-        updatedElementsLock.lock();
-        updatedElementsBackBuffer->insert(element);
-        updatedElementsLock.unlock();
+      readyQueue->push(element);
 
-        element->receiverLock->lockForRead();
-        // defer synchronous callbacks until we do not hold any locks anymore
+      element->receiverLock->lockForRead();
+      // defer synchronous callbacks until we do not hold any locks anymore
+      if(!element->syncReceivers.empty()) {
         syncReceivers = element->syncReceivers;
-        info = element->info;
-        element->receiverLock->unlock();
-        for(std::list<DataItemConnection>::iterator connectionIt = element->connections.begin(); connectionIt != element->connections.end(); ++connectionIt) {
-          long fromIdx = connectionIt->fromDataItemIndex;
-          long toIdx = connectionIt->toDataItemIndex;
-          DataItem currentItem;
-          currentItem = (*connectionIt->fromElement->frontBuffer)[fromIdx];
-          currentItem.setName((*connectionIt->toElement->frontBuffer)[toIdx].getName());
-          (*connectionIt->toElement->frontBuffer)[toIdx] = currentItem;
-          connectionActivatedElements.insert(connectionIt->toElement);
-        }
       }
-      elementsLock.unlock();
+      if(channelBlock && !element->channelReceivers.empty()) {
+        channelReceivers = element->channelReceivers;
+      }
+      for(std::list<DataItemConnection>::iterator connectionIt = element->connections.begin(); connectionIt != element->connections.end(); ++connectionIt) {
+        long fromIdx = connectionIt->fromDataItemIndex;
+        long toIdx = connectionIt->toDataItemIndex;
+        DataItem currentItem;
+        currentItem = (*connectionIt->fromElement->frontBuffer)[fromIdx];
+        currentItem.setName((*connectionIt->toElement->frontBuffer)[toIdx].getName());
+        (*connectionIt->toElement->frontBuffer)[toIdx] = currentItem;
+        connectionActivatedElements.insert(connectionIt->toElement);
+      }
+      element->receiverLock->unlock();
 
-      // do the synchronous callbacks
+      // do the synchronous callbacks; the DataInfo of an element is never
+      // changed after its creation
       for(syncReceiverIt = syncReceivers.begin();
           syncReceiverIt != syncReceivers.end();
           ++syncReceiverIt) {
         if(syncReceiverIt->receiver != producer)
-          syncReceiverIt->receiver->receiveData(info, dataPackage,
+          syncReceiverIt->receiver->receiveData(element->info, dataPackage,
                                                 syncReceiverIt->callbackParam);
       }
+      if(channelBlock) {
+        callChannelReceivers(channelReceivers, element->info, channelBlock);
+        channelBlock->unref();
+      }
 
       for(std::set<DataElement*>::iterator toElementIt = connectionActivatedElements.begin(); toElementIt != connectionActivatedElements.end(); ++toElementIt) {
         DataElement *toElement = *toElementIt;
         pushData(toElement->info.dataId, *toElement->frontBuffer);
       }
+      return id;
+    }
 
-      // The main thread only releases the wakeupMutex when it goes to sleep.
-      // So if we can lock it, we wake up the main thread so it can process the
-      // data we just pushed. Otherwise it is still running and will process it.
-      if(wakeupMutex.tryLock() == MUTEX_ERROR_NO_ERROR) {
-        wakeupCondition.wakeOne();
-        wakeupMutex.unlock();
+    DataChannel* DataBroker::createChannel(const std::string &groupName,
+                                           const std::string &dataName,
+                                           const std::vector<std::string> &itemNames,
+                                           PackageFlag flags) {
+      std::map<std::pair<std::string, std::string>, DataElement*>::iterator elementIt;
+      DataElement *element = NULL;
+      const DataChannelBlock *block;
+      bool newElement = false;
+      elementsLock.lockForWrite();
+      elementIt = elementsByName.find(std::make_pair(groupName, dataName));
+      if(elementIt != elementsByName.end()) {
+        element = elementIt->second;
+      } else {
+        element = createDataElement(groupName, dataName, flags);
+        newElement = true;
+      }
+      if(!element->channel) {
+        element->bufferLock->lockForWrite();
+        element->channel = new DataChannel(element->info, itemNames);
+        if(!element->frontBuffer->empty()) {
+          // keep the values of a stream that was pushed before
+          element->channel->readPackage(*element->frontBuffer);
+          element->channel->swap()->unref();
+        }
+        // set up the package layout once; publishChannel only sets values
+        block = element->channel->acquire();
+        element->channel->writePackage(*block, element->backBuffer);
+        element->channel->writePackage(*block, element->frontBuffer);
+        block->unref();
+        element->bufferLock->unlock();
+      }
+      if(newElement) {
+        publishDataElement(element);
+      }
+      elementsLock.unlock();
+      return element->channel;
+    }
+
+    DataChannel* DataBroker::getChannel(const std::string &groupName,
+                                        const std::string &dataName) const {
+      std::map<std::pair<std::string, std::string>, DataElement*>::const_iterator elementIt;
+      DataChannel *channel = NULL;
+      elementsLock.lockForRead();
+      elementIt = elementsByName.find(std::make_pair(groupName, dataName));
+      if(elementIt != elementsByName.end()) {
+        channel = elementIt->second->channel;
+      }
+      elementsLock.unlock();
+      return channel;
+    }
+
+    unsigned long DataBroker::publishChannel(DataChannel *channel,
+                                             const ReceiverInterface *producer) {
+      std::list<Receiver>::iterator syncReceiverIt;
+      std::set<DataElement*> connectionActivatedElements;
+      std::list<Receiver> syncReceivers;
+      std::list<ChannelReceiver> channelReceivers;
+      const DataChannelBlock *block;
+      unsigned long id = channel->getInfo().dataId;
+      DataElement *element = elementTable->get(id);
+
+      if(!element || element->channel != channel) {
+        // ERROR: channel not found!
+        return 0;
+      }
+      element->bufferLock->lockForWrite();
+      block = channel->swap();
+      // keep the DataPackage of the stream up to date for all other
+      // receivers; the layout exists already, so only values are set
+      channel->writePackage(*block, element->backBuffer);
+      std::swap(element->backBuffer, element->frontBuffer);
+      element->lastProducer = producer;
+      ++element->sequence;
+      element->bufferLock->unlock();
+
+      readyQueue->push(element);
+
+      element->receiverLock->lockForRead();
+      // defer synchronous callbacks until we do not hold any locks anymore
+      if(!element->syncReceivers.empty()) {
+        syncReceivers = element->syncReceivers;
+      }
+      if(!element->channelReceivers.empty()) {
+        channelReceivers = element->channelReceivers;
+      }
+      for(std::list<DataItemConnection>::iterator connectionIt = element->connections.begin(); connectionIt != element->connections.end(); ++connectionIt) {
+        long fromIdx = connectionIt->fromDataItemIndex;
+        long toIdx = connectionIt->toDataItemIndex;
+        DataItem currentItem;
+        currentItem = (*connectionIt->fromElement->frontBuffer)[fromIdx];
+        currentItem.setName((*connectionIt->toElement->frontBuffer)[toIdx].getName());
+        (*connectionIt->toElement->frontBuffer)[toIdx] = currentItem;
+        connectionActivatedElements.insert(connectionIt->toElement);
+      }
+      element->receiverLock->unlock();
+
+      callChannelReceivers(channelReceivers, channel->getInfo(), block);
+      if(!syncReceivers.empty()) {
+        // the receivers get a copy, so they may push to this element
+        DataPackage package;
+        element->bufferLock->lockForRead();
+        package = *element->frontBuffer;
+        element->bufferLock->unlock();
+        for(syncReceiverIt = syncReceivers.begin();
+            syncReceiverIt != syncReceivers.end();
+            ++syncReceiverIt) {
+          if(syncReceiverIt->receiver != producer)
+            syncReceiverIt->receiver->receiveData(channel->getInfo(),
+                                                  package,
+                                                  syncReceiverIt->callbackParam);
+        }
+      }
+      block->unref();
+
+      for(std::set<DataElement*>::iterator toElementIt = connectionActivatedElements.begin(); toElementIt != connectionActivatedElements.end(); ++toElementIt) {
+        DataElement *toElement = *toElementIt;
+        pushData(toElement->info.dataId, *toElement->frontBuffer);
       }
       return id;
     }
 
+    void DataBroker::callChannelReceivers(const std::list<ChannelReceiver> &receivers,
+                                          const DataInfo &info,
+                                          const DataChannelBlock *block) {
+      std::list<ChannelReceiver>::const_iterator receiverIt;
+      for(receiverIt = receivers.begin(); receiverIt != receivers.end();
+          ++receiverIt) {
+        receiverIt->receiver->receiveChannel(info, *block,
+                                             receiverIt->callbackParam);
+      }
+    }
+
+    bool DataBroker::registerChannelReceiver(ChannelReceiverInterface *receiver,
+                                             const std::string &groupName,
+                                             const std::string &dataName,
+                                             int callbackParam) {
+      std::map<std::pair<std::string, std::string>, DataElement*>::iterator elementIt;
+      bool ok = false;
+      elementsLock.lockForRead();
+      elementIt = elementsByName.find(std::make_pair(groupName, dataName));
+      if(elementIt != elementsByName.end() && elementIt->second->channel) {
+        DataElement *element = elementIt->second;
+        ChannelReceiver r = { receiver, callbackParam };
+        element->receiverLock->lockForWrite();
+        element->channelReceivers.locked_push_back(r);
+        element->receiverLock->unlock();
+        ok = true;
+      }
+      elementsLock.unlock();
+      return ok;
+    }
+
+    bool DataBroker::unregisterChannelReceiver(ChannelReceiverInterface *receiver,
+                                               const std::string &groupName,
+                                               const std::string &dataName) {
+      std::map<std::pair<std::string, std::string>, DataElement*>::iterator elementIt;
+      std::list<ChannelReceiver>::iterator receiverIt;
+      int cnt = 0;
+      elementsLock.lockForRead();
+      elementIt = elementsByName.find(std::make_pair(groupName, dataName));
+      if(elementIt != elementsByName.end()) {
+        DataElement *element = elementIt->second;
+        element->receiverLock->lockForWrite();
+        for(receiverIt = element->channelReceivers.begin();
+            receiverIt != element->channelReceivers.end(); /* do nothing */) {
+          if(receiverIt->receiver == receiver) {
+            receiverIt = element->channelReceivers.erase(receiverIt);
+            ++cnt;
+          } else {
+            ++receiverIt;
+          }
+        }
+        element->receiverLock->unlock();
+      }
+      elementsLock.unlock();
+      return cnt;
+    }
+
     void DataBroker::pushMessage(MessageType messageType,
                                  const std::string &format, va_list args) {
       const int MAX_BUFFER_SIZE = 1024;
@@ -1045,27 +1239,31 @@ namespace mars {
     }
 
     void DataBroker::run() {
-      std::set<DataElement*>::iterator updatedElementsIt;
+      std::vector<DataElement*> readyElements;
+      std::vector<DataElement*>::iterator readyElementIt;
       std::list<Receiver>::iterator receiverIt;
       std::list<DeferredCallback> deferredCallbacks;
       std::list<DeferredCallback>::iterator callbackIt;
 
-      wakeupMutex.lock();
       while(!stop_thread) {
-        elementsLock.lockForRead();
-        updatedElementsLock.lock();
-        std::swap(updatedElementsBackBuffer, updatedElementsFrontBuffer);
-        updatedElementsLock.unlock();
+        // If there is no data to process go to sleep. The first push to the
+        // empty ReadyQueue will wake us up.
+        if(!readyQueue->popAll(&readyElements)) {
+          readyQueue->wait();
+          continue;
+        }
 
-        for(updatedElementsIt = updatedElementsFrontBuffer->begin();
-            updatedElementsIt != updatedElementsFrontBuffer->end();
-            ++updatedElementsIt) {
-          DataElement *element = *updatedElementsIt;
+        for(readyElementIt = readyElements.begin();
+            readyElementIt != readyElements.end(); ++readyElementIt) {
+          DataElement *element = *readyElementIt;
 
           element->bufferLock->lockForRead();
           element->receiverLock->lockForRead();
-          // defer callbacks until we do not hold any lock anymore
-          if(!element->asyncReceivers.empty()) {
+          // defer callbacks until we do not hold any lock anymore;
+          // an element that was queued again after we already delivered
+          // its latest data is skipped
+          if(!element->asyncReceivers.empty() &&
+             element->sequence != element->dispatchedSequence) {
             DeferredCallback deferred;
             deferred.receivers = element->asyncReceivers;
             deferred.info = element->info;
@@ -1073,11 +1271,10 @@ namespace mars {
             deferred.producer = element->lastProducer;
             deferredCallbacks.push_back(deferred);
           }
+          element->dispatchedSequence = element->sequence;
           element->receiverLock->unlock();
           element->bufferLock->unlock();
         }
-        updatedElementsFrontBuffer->clear();
-        elementsLock.unlock();
 
         // make the callbacks
         //pushError("DataBroker::deferredCallbacks %d", deferredCallbacks.size());
@@ -1093,27 +1290,19 @@ namespace mars {
           }
         }
         deferredCallbacks.clear();
-
-        // If there is no data to process go to sleep. pushData() will wake us up.
-        updatedElementsLock.lock();
-        bool bufferIsEmpty = updatedElementsBackBuffer->empty();
-        updatedElementsLock.unlock();
-        if(bufferIsEmpty) {
-          wakeupCondition.wait(&wakeupMutex);
-        }
-        msleep(10);
       }
-      wakeupMutex.unlock();
     }
 
 
     const std::vector<DataInfo> DataBroker::getDataList(PackageFlag flags) const {
       std::vector<DataInfo> dataList;
-      std::map<unsigned long, DataElement*>::const_iterator it;
+      DataElement *element;
       elementsLock.lockForRead();
-      for(it = elementsById.begin(); it != elementsById.end(); ++it) {
-        if(flags == DATA_PACKAGE_NO_FLAG || flags & it->second->info.flags) {
-          dataList.push_back(it->second->info);
+      for(unsigned long id = 1; id < elementTable->getSize(); ++id) {
+        element = elementTable->get(id);
+        if(!element) continue;
+        if(flags == DATA_PACKAGE_NO_FLAG || flags & element->info.flags) {
+          dataList.push_back(element->info);
         }
       }
       elementsLock.unlock();
@@ -1123,16 +1312,12 @@ namespace mars {
 
     const DataPackage DataBroker::getDataPackage(unsigned long id) const {
       DataPackage dataPackage;
-      std::map<unsigned long, DataElement*>::const_iterator elementIt;
-      elementsLock.lockForRead();
-      elementIt = elementsById.find(id);
-      if(elementIt != elementsById.end()) {
-        DataElement *element = elementIt->second;
+      DataElement *element = elementTable->get(id);
+      if(element) {
         element->bufferLock->lockForRead();
-        dataPackage = *elementIt->second->frontBuffer;
+        dataPackage = *element->frontBuffer;
         element->bufferLock->unlock();
       }
-      elementsLock.unlock();
       return dataPackage;
     }
 
@@ -1180,9 +1365,14 @@ namespace mars {
       element->frontBuffer = new DataPackage;
       element->bufferLock = new ReadWriteLock;
       element->receiverLock = new ReadWriteLock;
+      element->channel = NULL;
+      element->sequence = 0;
+      element->dispatchedSequence = 0;
+      element->queued = 0;
+      element->nextReady = NULL;
       elementsByName[std::make_pair(groupName.c_str(),
                                     dataName.c_str())] = element;
-      elementsById[element->info.dataId] = element;
+      elementTable->insert(element->info.dataId, element);
       updatePendingRegistrations(element);
       return element;
     }
@@ -1375,7 +1565,9 @@ namespace mars {
         connection.toDataItemIndex = element->frontBuffer->getIndexByName(toItemName);
       }
 
+      connection.fromElement->receiverLock->lockForWrite();
       connection.fromElement->connections.push_back(connection);
+      connection.fromElement->receiverLock->unlock();
     }
 
     void DataBroker::disconnectDataItems(const std::string &fromGroupName,
@@ -1411,7 +1603,9 @@ namespace mars {
                jt->toElement->info.dataName == toDataName &&
                (*jt->toElement->frontBuffer)[jt->toDataItemIndex].getName() == toItemName) {
               jt->toElement->bufferLock->unlock();
+              element->receiverLock->lockForWrite();
               element->connections.erase(jt);
+              element->receiverLock->unlock();
               break;
             }
           }
@@ -1423,13 +1617,15 @@ namespace mars {
     void DataBroker::disconnectDataItems(const std::string &toGroupName,
                                          const std::string &toDataName,
                                          const std::string &toItemName) {
-      std::map<unsigned long, DataElement*>::iterator it;
       std::list<DataItemConnection>::iterator jt;
+      DataElement *element;
 
       elementsLock.lockForWrite();
-      for(it=elementsById.begin(); it!=elementsById.end(); ++it) {
-        for(jt=it->second->connections.begin();
-            jt!=it->second->connections.end(); ++jt) {
+      for(unsigned long id = 1; id < elementTable->getSize(); ++id) {
+        element = elementTable->get(id);
+        if(!element) continue;
+        for(jt=element->connections.begin();
+            jt!=element->connections.end(); ++jt) {
           jt->toElement->bufferLock->lockForWrite();
           if(jt->toDataItemIndex >= (int)jt->toElement->frontBuffer->size()) {
             pushError("DataBroker::disconnectDataItems : connection index does not match!");
@@ -1439,7 +1635,9 @@ namespace mars {
                jt->toElement->info.dataName == toDataName &&
                (*jt->toElement->frontBuffer)[jt->toDataItemIndex].getName() == toItemName) {
               jt->toElement->bufferLock->unlock();
-              it->second->connections.erase(jt);
+              element->receiverLock->lockForWrite();
+              element->connections.erase(jt);
+              element->receiverLock->unlock();
               //jt = it->second->connections.begin();
               break;
             }
@@ -29,6 +29,7 @@
 #include "DataPackage.h"
 #include "DataItem.h"
 #include "DataInfo.h"
+#include "DataChannel.h"
 #include "LockableContainer.h"
 
 #include <mars/utils/Thread.h>
@@ -49,8 +50,11 @@ namespace mars {
   namespace data_broker {
 
     class ReceiverInterface;
+    class ChannelReceiverInterface;
     class ProducerInterface;
     struct DataElement;
+    class ElementTable;
+    class ReadyQueue;
 
     inline bool hasWildcards(const std::string &str) {
       return (str.find("*") != str.npos);
@@ -130,6 +134,11 @@ namespace mars {
       int callbackParam;
     };
 
+    struct ChannelReceiver {
+      ChannelReceiverInterface *receiver;
+      int callbackParam;
+    };
+
     struct DataElement {
       DataInfo info;
       //    bool updated;
@@ -141,6 +150,15 @@ namespace mars {
       mars::utils::ReadWriteLock *receiverLock;
       const ReceiverInterface *lastProducer;
       std::list<DataItemConnection> connections;
+      DataChannel *channel;
+      LockableContainer<std::list<ChannelReceiver> > channelReceivers;
+      // incremented by every push; the async dispatcher skips elements
+      // whose sequence it already delivered
+      volatile unsigned long sequence;
+      unsigned long dispatchedSequence;
+      // ReadyQueue state
+      volatile int queued;
+      DataElement *nextReady;
     };
     /// \endcond
 
@@ -218,6 +236,22 @@ namespace mars {
                              const DataPackage &dataPackage,
                              const ReceiverInterface *producer=NULL);
 
+      DataChannel* createChannel(const std::string &groupName,
+                                 const std::string &dataName,
+                                 const std::vector<std::string> &itemNames,
+                                 PackageFlag flags);
+      DataChannel* getChannel(const std::string &groupName,
+                              const std::string &dataName) const;
+      unsigned long publishChannel(DataChannel *channel,
+                                   const ReceiverInterface *producer=NULL);
+      bool registerChannelReceiver(ChannelReceiverInterface *receiver,
+                                   const std::string &groupName,
+                                   const std::string &dataName,
+                                   int callbackParam=0);
+      bool unregisterChannelReceiver(ChannelReceiverInterface *receiver,
+                                     const std::string &groupName,
+                                     const std::string &dataName);
+
       unsigned long getDataID(const std::string &groupName,
                               const std::string &dataName) const;
 
@@ -274,6 +308,9 @@ namespace mars {
                                      const std::string &dataName,
                                      PackageFlag flags);
       void publishDataElement(const DataElement *element);
+      void callChannelReceivers(const std::list<ChannelReceiver> &receivers,
+                                const DataInfo &info,
+                                const DataChannelBlock *block);
       void updatePendingRegistrations(DataElement *newElement);
       unsigned long createId();
       //void destroyLock(pthread_rwlock_t *rwlock);
@@ -291,8 +328,8 @@ namespace mars {
                              const std::string &dataName,
                              std::vector<DataElement*> *elements) const;
 
-      std::set<DataElement*> *updatedElementsBackBuffer;
-      std::set<DataElement*> *updatedElementsFrontBuffer;
+      ElementTable *elementTable;
+      ReadyQueue *readyQueue;
 
       unsigned long next_id;
       pthread_t theThread;
@@ -308,17 +345,13 @@ namespace mars {
       LockableContainer<std::list<PendingTimedProducer> > pendingTimedProducers;
       LockableContainer<std::list<PendingTimedRegistration> > pendingTimedRegistrations;
       std::list<PendingTriggeredRegistration> pendingTriggeredRegistrations;
-      std::map<unsigned long, DataElement*> elementsById;
       std::map<std::string, Trigger> triggers;
       std::map<std::pair<std::string, std::string>, DataElement*> elementsByName;
       mutable mars::utils::ReadWriteLock elementsLock;
       mars::utils::ReadWriteLock timersLock;
       mars::utils::ReadWriteLock triggersLock;
-      mars::utils::Mutex updatedElementsLock;
       mars::utils::Mutex pendingRegistrationLock;
 
-      mars::utils::WaitCondition wakeupCondition;
-      mars::utils::Mutex wakeupMutex;
       std::map<std::string, Timer> timers;
       unsigned long newStreamId;
       unsigned long pushMessageIds[__DB_MESSAGE_TYPE_COUNT];
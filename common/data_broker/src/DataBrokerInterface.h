@@ -25,6 +25,10 @@
  *  1) producer:
  *     - push an initial data set and get an ID back
  *     - then call pushData(ID, ...)
+ *     - streams with a fixed set of numeric items can be created with
+ *       createChannel(); the values are written by index into
+ *       DataChannel::getWriteBuffer() and published by publishChannel()
+ *       without copying any DataPackage
  *  2) receiver:
  *     a) Asynchronous (this should be the default):
  *        - call registerAsyncReceiver() with (sensor group and name)
@@ -47,6 +51,11 @@
  *          all receivers registered to it.
  *        NOTE: you will get the latest datum. regardless whether it's been 
  *              updated or not since the last update.
+ *     e) Channel:
+ *        - call registerChannelReceiver() for a stream created by
+ *          createChannel()
+ *        - updates the receiver from within the publishChannel-call with a
+ *          const reference to the published block of values.
  *
  * TYPICAL USECASES:
  *  1) Plotter:
@@ -90,6 +99,8 @@ namespace mars {
 
     class ReceiverInterface;
     class ProducerInterface;
+    class ChannelReceiverInterface;
+    class DataChannel;
 
     enum MessageType {
       DB_MESSAGE_TYPE_FATAL,
@@ -494,6 +505,69 @@ namespace mars {
                                      const DataPackage &dataPackage,
                                      const ReceiverInterface *producer=NULL) =0;
 
+      /**
+       * \brief creates a typed channel with a fixed schema
+       * \param groupName The groupName of the stream.
+       * \param dataName The dataName of the stream.
+       * \param itemNames The names of the items of the channel. They are
+       *                  resolved once; afterwards the producer only writes
+       *                  values by index.
+       * \param flags This is used to indicate the nature of the data.
+       * \return The channel of the stream. If the stream already has a
+       *         channel that one is returned and \a itemNames are ignored.
+       *
+       * The stream can still be received as DataPackage by all other
+       * receiver types. The channel updates the stream's DataPackage in
+       * place without allocating. DataPackages pushed to the stream with
+       * \ref pushData are read into the channel.
+       *
+       * \see publishChannel, registerChannelReceiver, DataChannel
+       */
+      virtual DataChannel* createChannel(const std::string &groupName,
+                                         const std::string &dataName,
+                                         const std::vector<std::string> &itemNames,
+                                         PackageFlag flags) = 0;
+
+      /**
+       * \brief returns the channel of the stream or \c NULL if the stream
+       *        does not exist or has no channel.
+       */
+      virtual DataChannel* getChannel(const std::string &groupName,
+                                      const std::string &dataName) const = 0;
+
+      /**
+       * \brief publishes the values written to
+       *        DataChannel::getWriteBuffer
+       * \param channel A channel created by \ref createChannel.
+       * \param producer See \ref pushData. Only used for the DataPackage
+       *                 receivers of the stream.
+       * \return The dataId of the stream or 0 if the channel is unknown.
+       *
+       * The channel receivers are called synchronously with a const
+       * reference to the published block.
+       */
+      virtual unsigned long publishChannel(DataChannel *channel,
+                                           const ReceiverInterface *producer=NULL) = 0;
+
+      /**
+       * \brief registers a receiver for the blocks of a channel
+       * \param receiver The receiver to call from within
+       *                 \ref publishChannel.
+       * \param groupName The groupName of the channel.
+       * \param dataName The dataName of the channel.
+       * \param callbackParam An optional \c int that will be passed back to
+       *                      the \a receiver.
+       * \return \c false if the stream does not exist or has no channel.
+       *         Wildcards are not supported.
+       */
+      virtual bool registerChannelReceiver(ChannelReceiverInterface *receiver,
+                                           const std::string &groupName,
+                                           const std::string &dataName,
+                                           int callbackParam=0) = 0;
+      virtual bool unregisterChannelReceiver(ChannelReceiverInterface *receiver,
+                                             const std::string &groupName,
+                                             const std::string &dataName) = 0;
+
       /**
        * \brief get the unique dataId assosiated with a given groupName and 
        *        dataName
@@ -0,0 +1,171 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DataChannel.h"
+#include "DataPackage.h"
+
+#include <mars/utils/MutexLocker.h>
+
+#include <cstring>
+
+namespace mars {
+
+  namespace data_broker {
+
+    using namespace mars::utils;
+
+    static bool itemToDouble(const DataItem &item, double *val) {
+      switch(item.type) {
+      case INT_TYPE: *val = item.i; return true;
+      case UINT_TYPE: *val = item.ui; return true;
+      case LONG_TYPE: *val = item.l; return true;
+      case ULONG_TYPE: *val = item.ul; return true;
+      case FLOAT_TYPE: *val = item.f; return true;
+      case DOUBLE_TYPE: *val = item.d; return true;
+      case BOOL_TYPE: *val = item.b ? 1.0 : 0.0; return true;
+      default: return false;
+      }
+    }
+
+    DataChannelBlock::DataChannelBlock(DataChannel *channel, size_t numItems)
+      : channel(channel), numItems(numItems), sequence(0), refCount(0) {
+      data = new double[numItems ? numItems : 1];
+      memset(data, 0, sizeof(double) * numItems);
+    }
+
+    DataChannelBlock::~DataChannelBlock() {
+      delete[] data;
+    }
+
+    void DataChannelBlock::ref() const {
+      MutexLocker locker(&channel->blockMutex);
+      ++refCount;
+    }
+
+    void DataChannelBlock::unref() const {
+      channel->releaseBlock(this);
+    }
+
+
+    DataChannel::DataChannel(const DataInfo &info,
+                             const std::vector<std::string> &itemNames)
+      : info(info), itemNames(itemNames), nextSequence(1), packageSize(0) {
+      front = new DataChannelBlock(this, itemNames.size());
+      back = new DataChannelBlock(this, itemNames.size());
+      // the channel itself holds a reference on its front block
+      front->refCount = 1;
+      blocks.push_back(front);
+      blocks.push_back(back);
+    }
+
+    DataChannel::~DataChannel() {
+      std::vector<DataChannelBlock*>::iterator it;
+      for(it = blocks.begin(); it != blocks.end(); ++it) {
+        delete *it;
+      }
+      blocks.clear();
+      freeBlocks.clear();
+    }
+
+    long DataChannel::getIndexByName(const std::string &itemName) const {
+      for(size_t i = 0; i < itemNames.size(); ++i) {
+        if(itemNames[i] == itemName) {
+          return (long)i;
+        }
+      }
+      return -1;
+    }
+
+    const DataChannelBlock* DataChannel::acquire() const {
+      MutexLocker locker(&blockMutex);
+      ++front->refCount;
+      return front;
+    }
+
+    const DataChannelBlock* DataChannel::swap() {
+      DataChannelBlock *oldFront;
+      MutexLocker locker(&blockMutex);
+      oldFront = front;
+      front = back;
+      front->sequence = nextSequence++;
+      // one reference for the channel and one for the caller
+      front->refCount = 2;
+      if(--oldFront->refCount == 0) {
+        back = oldFront;
+      } else if(!freeBlocks.empty()) {
+        // a receiver still holds the old front block
+        back = freeBlocks.back();
+        freeBlocks.pop_back();
+      } else {
+        back = new DataChannelBlock(this, itemNames.size());
+        blocks.push_back(back);
+      }
+      memcpy(back->data, front->data, sizeof(double) * itemNames.size());
+      return front;
+    }
+
+    void DataChannel::releaseBlock(const DataChannelBlock *block) {
+      MutexLocker locker(&blockMutex);
+      if(--block->refCount == 0 && block != front && block != back) {
+        freeBlocks.push_back(const_cast<DataChannelBlock*>(block));
+      }
+    }
+
+    void DataChannel::writePackage(const DataChannelBlock &block,
+                                   DataPackage *package) const {
+      bool layoutOk = (package->size() == itemNames.size());
+      for(size_t i = 0; layoutOk && i < itemNames.size(); ++i) {
+        layoutOk = package->set((long)i, block[i]);
+      }
+      if(!layoutOk) {
+        // the package was not created from this channel or was overwritten
+        // by a DataPackage producer
+        package->clear();
+        for(size_t i = 0; i < itemNames.size(); ++i) {
+          package->add(itemNames[i], block[i]);
+        }
+      }
+    }
+
+    void DataChannel::readPackage(const DataPackage &package) {
+      double *data = back->data;
+      double val;
+      long index;
+
+      // producers keep the layout of their packages, so the names are only
+      // resolved again if the size of the package changes
+      if(package.size() != packageSize || packageIndices.empty()) {
+        packageIndices.resize(itemNames.size());
+        for(size_t i = 0; i < itemNames.size(); ++i) {
+          packageIndices[i] = package.getIndexByName(itemNames[i]);
+        }
+        packageSize = package.size();
+      }
+      for(size_t i = 0; i < itemNames.size(); ++i) {
+        index = packageIndices[i];
+        if(index >= 0 && itemToDouble(package[index], &val)) {
+          data[i] = val;
+        }
+      }
+    }
+
+  } // end of namespace data_broker
+
+} // end of namespace mars
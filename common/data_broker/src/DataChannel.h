@@ -0,0 +1,172 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file DataChannel.h
+ * \brief A typed channel with a fixed schema that publishes its values
+ *        as a contiguous block of doubles.
+ */
+
+#ifndef DATACHANNEL_H
+#define DATACHANNEL_H
+
+#ifdef _PRINT_HEADER_
+  #warning "DataChannel.h"
+#endif
+
+#include "DataInfo.h"
+
+#include <mars/utils/Mutex.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace mars {
+
+  namespace data_broker {
+
+    class DataChannel;
+    class DataPackage;
+
+    /**
+     * \brief One buffer of a DataChannel.
+     *
+     * The block holds one value for every item of the channel's schema.
+     * Blocks are owned and recycled by the channel. A receiver that keeps
+     * a block beyond its callback has to hold a reference.
+     */
+    class DataChannelBlock {
+    public:
+      inline const double* getData() const {
+        return data;
+      }
+      inline double operator[](size_t index) const {
+        return data[index];
+      }
+      inline size_t size() const {
+        return numItems;
+      }
+      /** \brief The number of the publication that filled this block. */
+      inline unsigned long getSequence() const {
+        return sequence;
+      }
+      void ref() const;
+      void unref() const;
+
+    private:
+      friend class DataChannel;
+      DataChannelBlock(DataChannel *channel, size_t numItems);
+      ~DataChannelBlock();
+      DataChannelBlock(const DataChannelBlock &);
+      DataChannelBlock &operator=(const DataChannelBlock &);
+
+      DataChannel *channel;
+      double *data;
+      size_t numItems;
+      unsigned long sequence;
+      mutable int refCount;
+    }; // end of class DataChannelBlock
+
+    /**
+     * \brief A stream of the DataBroker with a fixed schema.
+     *
+     * The item names are given once when the channel is created by
+     * DataBrokerInterface::createChannel. The producer resolves the
+     * indices of its items once, writes the values into the buffer
+     * returned by getWriteBuffer and calls
+     * DataBrokerInterface::publishChannel. The written block becomes the
+     * front block and the \ref ChannelReceiverInterface "receivers" get a
+     * const reference to it; nothing is copied on the way.
+     *
+     * Every channel has exactly one producer. Old front blocks that are
+     * still referenced by receivers are kept until they are released,
+     * otherwise the channel only switches between two blocks.
+     */
+    class DataChannel {
+    public:
+      DataChannel(const DataInfo &info,
+                  const std::vector<std::string> &itemNames);
+      ~DataChannel();
+
+      inline const DataInfo& getInfo() const {
+        return info;
+      }
+      inline size_t getNumItems() const {
+        return itemNames.size();
+      }
+      inline const std::string& getItemName(size_t index) const {
+        return itemNames[index];
+      }
+      /**
+       * \brief Returns the index of the item \a itemName or -1 if the
+       *        channel has no such item.
+       */
+      long getIndexByName(const std::string &itemName) const;
+
+      /**
+       * \brief Returns the buffer the producer writes the next values to.
+       *
+       * The buffer starts with the values of the last publication, so a
+       * producer may only update the items that changed.
+       */
+      inline double* getWriteBuffer() {
+        return back->data;
+      }
+
+      /**
+       * \brief Returns the current front block with an additional
+       *        reference. The caller has to call unref on it.
+       */
+      const DataChannelBlock* acquire() const;
+
+      /// \cond HIDDEN_SYMBOLS
+      // used by the DataBroker
+      const DataChannelBlock* swap();
+      void writePackage(const DataChannelBlock &block,
+                        DataPackage *package) const;
+      void readPackage(const DataPackage &package);
+      /// \endcond
+
+    private:
+      friend class DataChannelBlock;
+      DataChannel(const DataChannel &);
+      DataChannel &operator=(const DataChannel &);
+
+      void releaseBlock(const DataChannelBlock *block);
+
+      DataInfo info;
+      std::vector<std::string> itemNames;
+      std::vector<DataChannelBlock*> blocks;
+      std::vector<DataChannelBlock*> freeBlocks;
+      DataChannelBlock *front, *back;
+      unsigned long nextSequence;
+      mutable mars::utils::Mutex blockMutex;
+      // indices of the channel items in the last DataPackage read by
+      // readPackage; only resolved again if the package layout changes
+      std::vector<long> packageIndices;
+      size_t packageSize;
+    }; // end of class DataChannel
+
+  } // end of namespace data_broker
+
+} // end of namespace mars
+
+#endif // DATACHANNEL_H
@@ -0,0 +1,97 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file DataLogFormat.h
+ * \brief The layout of the binary log written by the DataRecorder and
+ *        read by the DataReplayer.
+ *
+ * The file starts with a DataLogHeader padded to \c headerSize bytes.
+ * It is followed by chunks of \c chunkSize bytes. Each chunk starts with a
+ * DataLogChunkHeader and is followed by records. A record starts with a
+ * DataLogRecordHeader and is padded to a multiple of 8 bytes.
+ *
+ * There are two kinds of records:
+ *  - A schema record describes a stream. It is written before the stream's
+ *    first data record and again if the layout of its DataPackage changes.
+ *    Its payload holds the groupName, the dataName and the flags, followed
+ *    by the type and name of every item. Strings are stored as uint32
+ *    length followed by the characters.
+ *  - A data record holds the raw values of one DataPackage in item
+ *    order. INT, UINT and FLOAT take 4 bytes, LONG, ULONG and DOUBLE take
+ *    8 bytes, BOOL takes 1 byte, and STRING is a uint32 length followed by
+ *    the characters.
+ *
+ * All values are stored in host byte order.
+ */
+
+#ifndef DATALOGFORMAT_H
+#define DATALOGFORMAT_H
+
+#ifdef _PRINT_HEADER_
+  #warning "DataLogFormat.h"
+#endif
+
+#include <stdint.h>
+
+#define DATA_LOG_MAGIC "MARSDLOG"
+#define DATA_LOG_VERSION 1
+#define DATA_LOG_CHUNK_MAGIC 0x4b4e4843 // "CHNK"
+#define DATA_LOG_DEFAULT_CHUNK_SIZE (1 << 20)
+
+namespace mars {
+
+  namespace data_broker {
+
+    enum DataLogRecordType {
+      DATA_LOG_SCHEMA_RECORD = 1,
+      DATA_LOG_DATA_RECORD = 2
+    };
+
+    struct DataLogHeader {
+      char magic[8];
+      uint32_t version;
+      uint32_t headerSize;
+      uint32_t chunkSize;
+      uint32_t reserved;
+    };
+
+    struct DataLogChunkHeader {
+      uint32_t magic;
+      uint32_t usedBytes;   ///< including this header
+      uint32_t numRecords;
+      uint32_t reserved;
+      double firstTime;     ///< sim time of the first record
+      double lastTime;      ///< sim time of the last record
+    };
+
+    struct DataLogRecordHeader {
+      uint32_t size;        ///< including this header and the padding
+      uint32_t type;        ///< DataLogRecordType
+      uint32_t stream;      ///< index of the stream within the log
+      uint32_t reserved;
+      double time;          ///< sim time in ms
+    };
+
+  } // end of namespace data_broker
+
+} // end of namespace mars
+
+#endif // DATALOGFORMAT_H
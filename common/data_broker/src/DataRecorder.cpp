@@ -0,0 +1,393 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DataRecorder.h"
+#include "DataBrokerInterface.h"
+#include "DataPackage.h"
+#include "DataInfo.h"
+
+#include <mars/utils/MutexLocker.h>
+
+#include <cstring>
+#include <cstdlib>
+
+#ifndef WIN32
+  #include <sys/mman.h>
+  #include <sys/types.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+// callbackParam of the simTime registration
+#define SIM_TIME_CALLBACK 1
+
+namespace mars {
+
+  namespace data_broker {
+
+    using namespace mars::utils;
+
+    static inline size_t alignRecord(size_t size) {
+      return (size + 7) & ~((size_t)7);
+    }
+
+    static inline char* writeString(char *p, const std::string &s) {
+      uint32_t length = s.size();
+      memcpy(p, &length, sizeof(length));
+      memcpy(p + sizeof(length), s.data(), length);
+      return p + sizeof(length) + length;
+    }
+
+    static size_t getItemSize(const DataItem &item) {
+      switch(item.type) {
+      case INT_TYPE:
+      case UINT_TYPE:
+      case FLOAT_TYPE:
+        return 4;
+      case LONG_TYPE:
+      case ULONG_TYPE:
+      case DOUBLE_TYPE:
+        return 8;
+      case BOOL_TYPE:
+        return 1;
+      case STRING_TYPE:
+        return sizeof(uint32_t) + item.s.size();
+      default:
+        return 0;
+      }
+    }
+
+    DataRecorder::DataRecorder(DataBrokerInterface *dataBroker)
+      : dataBroker(dataBroker), recording(false), simTime(0.0),
+        numStreams(0), fd(-1), file(NULL), headerSize(0), chunkSize(0),
+        currentChunk(0), chunk(NULL), chunkPos(0), recordPos(0) {
+    }
+
+    DataRecorder::~DataRecorder() {
+      stop();
+    }
+
+    bool DataRecorder::start(const std::string &filename,
+                             const std::string &groupName,
+                             const std::string &dataName,
+                             size_t chunkSize) {
+      DataLogHeader header;
+      size_t pageSize = 4096;
+
+      stop();
+      MutexLocker locker(&recordMutex);
+#ifndef WIN32
+      pageSize = sysconf(_SC_PAGESIZE);
+      fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if(fd == -1) {
+        dataBroker->pushError("DataRecorder: could not create \"%s\"",
+                              filename.c_str());
+        return false;
+      }
+#else
+      file = fopen(filename.c_str(), "wb");
+      if(!file) {
+        dataBroker->pushError("DataRecorder: could not create \"%s\"",
+                              filename.c_str());
+        return false;
+      }
+#endif
+      this->groupName = groupName;
+      this->dataName = dataName;
+      // chunks are mapped separately, so they have to start at a page
+      headerSize = pageSize;
+      if(chunkSize < pageSize) chunkSize = pageSize;
+      this->chunkSize = ((chunkSize + pageSize - 1) / pageSize) * pageSize;
+      streams.clear();
+      numStreams = 0;
+      simTime = 0.0;
+
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, DATA_LOG_MAGIC, sizeof(header.magic));
+      header.version = DATA_LOG_VERSION;
+      header.headerSize = headerSize;
+      header.chunkSize = this->chunkSize;
+#ifndef WIN32
+      if(ftruncate(fd, headerSize) != 0 ||
+         pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        close(fd);
+        fd = -1;
+        return false;
+      }
+#else
+      {
+        std::vector<char> page(headerSize, 0);
+        memcpy(&page[0], &header, sizeof(header));
+        fwrite(&page[0], 1, headerSize, file);
+      }
+#endif
+      if(!mapChunk(0)) {
+#ifndef WIN32
+        close(fd);
+        fd = -1;
+#else
+        fclose(file);
+        file = NULL;
+#endif
+        return false;
+      }
+      recording = true;
+      locker.unlock();
+
+      dataBroker->registerSyncReceiver(this, "mars_sim", "simTime",
+                                       SIM_TIME_CALLBACK);
+      dataBroker->registerSyncReceiver(this, groupName, dataName);
+      return true;
+    }
+
+    void DataRecorder::stop() {
+      size_t fileSize;
+      {
+        MutexLocker locker(&recordMutex);
+        if(fd == -1 && !file) return;
+        recording = false;
+      }
+      dataBroker->unregisterSyncReceiver(this, groupName, dataName);
+      dataBroker->unregisterSyncReceiver(this, "mars_sim", "simTime");
+
+      MutexLocker locker(&recordMutex);
+      fileSize = headerSize + currentChunk * chunkSize + chunkPos;
+      finishChunk();
+#ifndef WIN32
+      // the last chunk only keeps the used bytes
+      if(ftruncate(fd, fileSize) != 0) {
+        dataBroker->pushWarning("DataRecorder: could not truncate the log");
+      }
+      close(fd);
+      fd = -1;
+#else
+      fclose(file);
+      file = NULL;
+#endif
+    }
+
+    bool DataRecorder::isRecording() const {
+      return recording;
+    }
+
+    bool DataRecorder::mapChunk(size_t index) {
+      currentChunk = index;
+      chunkPos = sizeof(DataLogChunkHeader);
+#ifndef WIN32
+      off_t offset = headerSize + index * chunkSize;
+      if(ftruncate(fd, offset + chunkSize) != 0) {
+        chunk = NULL;
+      } else {
+        void *p = mmap(NULL, chunkSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, offset);
+        chunk = (p == MAP_FAILED) ? NULL : (char*)p;
+      }
+#else
+      chunk = (char*)calloc(chunkSize, 1);
+#endif
+      if(!chunk) {
+        dataBroker->pushError("DataRecorder: could not map chunk %lu",
+                              (unsigned long)index);
+        return false;
+      }
+      DataLogChunkHeader *header = (DataLogChunkHeader*)chunk;
+      memset(header, 0, sizeof(DataLogChunkHeader));
+      header->magic = DATA_LOG_CHUNK_MAGIC;
+      header->usedBytes = chunkPos;
+      return true;
+    }
+
+    void DataRecorder::finishChunk() {
+      if(!chunk) return;
+#ifndef WIN32
+      munmap(chunk, chunkSize);
+#else
+      fseek(file, headerSize + currentChunk * chunkSize, SEEK_SET);
+      fwrite(chunk, 1, chunkPos, file);
+      free(chunk);
+#endif
+      chunk = NULL;
+    }
+
+    char* DataRecorder::beginRecord(uint32_t type, uint32_t stream,
+                                    size_t payloadSize) {
+      size_t size = alignRecord(sizeof(DataLogRecordHeader) + payloadSize);
+      if(size > chunkSize - sizeof(DataLogChunkHeader)) {
+        return NULL;
+      }
+      if(!chunk) {
+        return NULL;
+      }
+      if(chunkPos + size > chunkSize) {
+        finishChunk();
+        if(!mapChunk(currentChunk + 1)) {
+          recording = false;
+          return NULL;
+        }
+      }
+      DataLogRecordHeader *header = (DataLogRecordHeader*)(chunk + chunkPos);
+      header->size = size;
+      header->type = type;
+      header->stream = stream;
+      header->reserved = 0;
+      header->time = simTime;
+      recordPos = chunkPos;
+      return chunk + chunkPos + sizeof(DataLogRecordHeader);
+    }
+
+    void DataRecorder::endRecord() {
+      DataLogChunkHeader *chunkHeader = (DataLogChunkHeader*)chunk;
+      DataLogRecordHeader *header = (DataLogRecordHeader*)(chunk + recordPos);
+      if(chunkHeader->numRecords == 0) {
+        chunkHeader->firstTime = header->time;
+      }
+      chunkHeader->lastTime = header->time;
+      ++chunkHeader->numRecords;
+      chunkPos = recordPos + header->size;
+      chunkHeader->usedBytes = chunkPos;
+    }
+
+    DataRecorder::Stream* DataRecorder::getStream(const DataInfo &info) {
+      if(info.dataId >= streams.size()) {
+        Stream empty;
+        empty.valid = false;
+        empty.hasSchema = false;
+        empty.index = 0;
+        streams.resize(info.dataId + 1, empty);
+      }
+      Stream *stream = &streams[info.dataId];
+      if(!stream->valid) {
+        stream->valid = true;
+        stream->index = numStreams++;
+      }
+      return stream;
+    }
+
+    bool DataRecorder::schemaChanged(const Stream &stream,
+                                     const DataPackage &dataPackage) const {
+      if(!stream.hasSchema || stream.types.size() != dataPackage.size()) {
+        return true;
+      }
+      for(size_t i = 0; i < dataPackage.size(); ++i) {
+        if(stream.types[i] != dataPackage[i].type ||
+           stream.names[i] != dataPackage[i].getName()) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void DataRecorder::writeSchema(Stream *stream, const DataInfo &info,
+                                   const DataPackage &dataPackage) {
+      std::vector<std::string> names(dataPackage.size());
+      size_t payloadSize = 4 * sizeof(uint32_t);
+      char *p;
+      uint32_t value;
+
+      payloadSize += info.groupName.size() + info.dataName.size();
+      for(size_t i = 0; i < dataPackage.size(); ++i) {
+        names[i] = dataPackage[i].getName();
+        payloadSize += 2 * sizeof(uint32_t) + names[i].size();
+      }
+      p = beginRecord(DATA_LOG_SCHEMA_RECORD, stream->index, payloadSize);
+      if(!p) {
+        return;
+      }
+      p = writeString(p, info.groupName);
+      p = writeString(p, info.dataName);
+      value = info.flags;
+      memcpy(p, &value, sizeof(value));
+      p += sizeof(value);
+      value = dataPackage.size();
+      memcpy(p, &value, sizeof(value));
+      p += sizeof(value);
+      stream->hasSchema = true;
+      stream->types.resize(dataPackage.size());
+      stream->names.swap(names);
+      for(size_t i = 0; i < dataPackage.size(); ++i) {
+        stream->types[i] = dataPackage[i].type;
+        value = dataPackage[i].type;
+        memcpy(p, &value, sizeof(value));
+        p += sizeof(value);
+        p = writeString(p, stream->names[i]);
+      }
+      endRecord();
+    }
+
+    void DataRecorder::writeData(const Stream &stream,
+                                 const DataPackage &dataPackage) {
+      size_t payloadSize = 0;
+      char *p;
+
+      for(size_t i = 0; i < dataPackage.size(); ++i) {
+        payloadSize += getItemSize(dataPackage[i]);
+      }
+      p = beginRecord(DATA_LOG_DATA_RECORD, stream.index, payloadSize);
+      if(!p) {
+        return;
+      }
+      for(size_t i = 0; i < dataPackage.size(); ++i) {
+        const DataItem &item = dataPackage[i];
+        switch(item.type) {
+        case INT_TYPE: memcpy(p, &item.i, 4); p += 4; break;
+        case UINT_TYPE: memcpy(p, &item.ui, 4); p += 4; break;
+        case FLOAT_TYPE: memcpy(p, &item.f, 4); p += 4; break;
+        case LONG_TYPE: {
+          int64_t l = item.l;
+          memcpy(p, &l, 8);
+          p += 8;
+          break;
+        }
+        case ULONG_TYPE: {
+          uint64_t ul = item.ul;
+          memcpy(p, &ul, 8);
+          p += 8;
+          break;
+        }
+        case DOUBLE_TYPE: memcpy(p, &item.d, 8); p += 8; break;
+        case BOOL_TYPE: *p++ = item.b ? 1 : 0; break;
+        case STRING_TYPE: p = writeString(p, item.s); break;
+        default: break;
+        }
+      }
+      endRecord();
+    }
+
+    void DataRecorder::receiveData(const DataInfo &info,
+                                   const DataPackage &dataPackage,
+                                   int callbackParam) {
+      MutexLocker locker(&recordMutex);
+      if(!recording) {
+        return;
+      }
+      if(callbackParam == SIM_TIME_CALLBACK) {
+        dataPackage.get(0, &simTime);
+        return;
+      }
+      Stream *stream = getStream(info);
+      if(schemaChanged(*stream, dataPackage)) {
+        writeSchema(stream, info, dataPackage);
+      }
+      writeData(*stream, dataPackage);
+    }
+
+  } // end of namespace data_broker
+
+} // end of namespace mars
@@ -0,0 +1,138 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file DataRecorder.h
+ * \brief Records DataBroker streams into a chunked binary log.
+ */
+
+#ifndef DATARECORDER_H
+#define DATARECORDER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "DataRecorder.h"
+#endif
+
+#include "ReceiverInterface.h"
+#include "DataItem.h"
+#include "DataLogFormat.h"
+
+#include <mars/utils/Mutex.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace mars {
+
+  namespace data_broker {
+
+    class DataBrokerInterface;
+    class DataPackage;
+
+    /**
+     * \brief The DataRecorder registers as synchronous receiver for all
+     *        streams that match a group and data pattern and appends
+     *        their values to a binary log.
+     *
+     * The log is written into memory mapped chunks of the file, so a
+     * record is only copied once into the page cache. The sim time of
+     * each record is taken from the \c mars_sim/simTime stream. The
+     * layout of the file is described in DataLogFormat.h; it can be read
+     * by the DataReplayer.
+     */
+    class DataRecorder : public ReceiverInterface {
+    public:
+      DataRecorder(DataBrokerInterface *dataBroker);
+      ~DataRecorder();
+
+      /**
+       * \brief Creates the log file and starts recording.
+       * \param filename The log file. An existing file is overwritten.
+       * \param groupName The groupName pattern of the recorded streams.
+       *                  May contain wildcards.
+       * \param dataName The dataName pattern of the recorded streams.
+       *                 May contain wildcards.
+       * \param chunkSize The size of one chunk of the log. It is rounded
+       *                  up to a multiple of the page size.
+       * \return \c false if the file could not be created.
+       */
+      bool start(const std::string &filename,
+                 const std::string &groupName = "*",
+                 const std::string &dataName = "*",
+                 size_t chunkSize = DATA_LOG_DEFAULT_CHUNK_SIZE);
+
+      /** \brief Stops recording and closes the log file. */
+      void stop();
+
+      bool isRecording() const;
+
+      virtual void receiveData(const DataInfo &info,
+                               const DataPackage &dataPackage,
+                               int callbackParam);
+
+    private:
+      struct Stream {
+        bool valid;
+        bool hasSchema;
+        uint32_t index;
+        std::vector<DataType> types;
+        std::vector<std::string> names;
+      };
+
+      DataRecorder(const DataRecorder &);
+      DataRecorder &operator=(const DataRecorder &);
+
+      Stream* getStream(const DataInfo &info);
+      bool schemaChanged(const Stream &stream,
+                         const DataPackage &dataPackage) const;
+      void writeSchema(Stream *stream, const DataInfo &info,
+                       const DataPackage &dataPackage);
+      void writeData(const Stream &stream, const DataPackage &dataPackage);
+      char* beginRecord(uint32_t type, uint32_t stream, size_t payloadSize);
+      void endRecord();
+      bool mapChunk(size_t chunk);
+      void finishChunk();
+
+      DataBrokerInterface *dataBroker;
+      std::string groupName, dataName;
+      mars::utils::Mutex recordMutex;
+      bool recording;
+      double simTime;
+
+      // streams indexed by their DataInfo::dataId
+      std::vector<Stream> streams;
+      uint32_t numStreams;
+
+      int fd;
+      FILE *file;
+      size_t headerSize, chunkSize;
+      size_t currentChunk;
+      char *chunk;
+      size_t chunkPos;
+      size_t recordPos;
+    }; // end of class DataRecorder
+
+  } // end of namespace data_broker
+
+} // end of namespace mars
+
+#endif // DATARECORDER_H
@@ -0,0 +1,400 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DataReplayer.h"
+#include "DataBrokerInterface.h"
+
+#include <mars/utils/misc.h>
+
+#include <cstring>
+#include <cstdio>
+
+#ifndef WIN32
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+namespace mars {
+
+  namespace data_broker {
+
+    static bool readUInt(const char **p, const char *end, uint32_t *value) {
+      if(*p + sizeof(uint32_t) > end) return false;
+      memcpy(value, *p, sizeof(uint32_t));
+      *p += sizeof(uint32_t);
+      return true;
+    }
+
+    static bool readString(const char **p, const char *end, std::string *s) {
+      uint32_t length;
+      if(!readUInt(p, end, &length) || *p + length > end) return false;
+      s->assign(*p, length);
+      *p += length;
+      return true;
+    }
+
+    DataReplayer::DataReplayer(DataBrokerInterface *dataBroker)
+      : dataBroker(dataBroker), data(NULL), dataSize(0), fd(-1),
+        currentChunk(0), currentPos(0) {
+    }
+
+    DataReplayer::~DataReplayer() {
+      close();
+    }
+
+    bool DataReplayer::open(const std::string &filename) {
+      const DataLogHeader *header;
+      const DataLogChunkHeader *chunkHeader;
+      const DataLogRecordHeader *record;
+      ChunkInfo info;
+
+      close();
+#ifndef WIN32
+      struct stat fileStat;
+      fd = ::open(filename.c_str(), O_RDONLY);
+      if(fd == -1 || fstat(fd, &fileStat) != 0) {
+        dataBroker->pushError("DataReplayer: could not open \"%s\"",
+                              filename.c_str());
+        close();
+        return false;
+      }
+      dataSize = fileStat.st_size;
+      if(dataSize) {
+        void *p = mmap(NULL, dataSize, PROT_READ, MAP_SHARED, fd, 0);
+        data = (p == MAP_FAILED) ? NULL : (const char*)p;
+      }
+#else
+      FILE *file = fopen(filename.c_str(), "rb");
+      if(file) {
+        fseek(file, 0, SEEK_END);
+        buffer.resize(ftell(file));
+        fseek(file, 0, SEEK_SET);
+        if(!buffer.empty() &&
+           fread(&buffer[0], 1, buffer.size(), file) == buffer.size()) {
+          data = &buffer[0];
+          dataSize = buffer.size();
+        }
+        fclose(file);
+      }
+#endif
+      if(!data || dataSize < sizeof(DataLogHeader)) {
+        dataBroker->pushError("DataReplayer: could not read \"%s\"",
+                              filename.c_str());
+        close();
+        return false;
+      }
+      header = (const DataLogHeader*)data;
+      if(memcmp(header->magic, DATA_LOG_MAGIC, sizeof(header->magic)) ||
+         header->version != DATA_LOG_VERSION || header->chunkSize == 0) {
+        dataBroker->pushError("DataReplayer: \"%s\" is no data log",
+                              filename.c_str());
+        close();
+        return false;
+      }
+
+      // build the chunk index from the chunk headers
+      for(size_t offset = header->headerSize;
+          offset + sizeof(DataLogChunkHeader) <= dataSize;
+          offset += header->chunkSize) {
+        chunkHeader = (const DataLogChunkHeader*)(data + offset);
+        if(chunkHeader->magic != DATA_LOG_CHUNK_MAGIC) break;
+        info.offset = offset;
+        info.usedBytes = chunkHeader->usedBytes;
+        if(offset + info.usedBytes > dataSize) {
+          // the recording was not stopped properly
+          info.usedBytes = dataSize - offset;
+        }
+        info.numRecords = chunkHeader->numRecords;
+        info.firstTime = chunkHeader->firstTime;
+        info.lastTime = chunkHeader->lastTime;
+        chunks.push_back(info);
+      }
+
+      // collect the schemas; the data records are only skipped
+      currentChunk = 0;
+      currentPos = sizeof(DataLogChunkHeader);
+      skipEmptyChunks();
+      while(!atEnd()) {
+        record = getRecord(currentChunk, currentPos);
+        if(record->type == DATA_LOG_SCHEMA_RECORD) {
+          schemaOffsets.push_back(chunks[currentChunk].offset + currentPos);
+        }
+        nextRecord();
+      }
+      return seek(getStartTime());
+    }
+
+    void DataReplayer::close() {
+#ifndef WIN32
+      if(data) {
+        munmap((void*)data, dataSize);
+      }
+      if(fd != -1) {
+        ::close(fd);
+        fd = -1;
+      }
+#endif
+      buffer.clear();
+      data = NULL;
+      dataSize = 0;
+      chunks.clear();
+      streams.clear();
+      schemaOffsets.clear();
+      currentChunk = currentPos = 0;
+    }
+
+    void DataReplayer::setGroupPrefix(const std::string &prefix) {
+      groupPrefix = prefix;
+    }
+
+    double DataReplayer::getStartTime() const {
+      for(size_t i = 0; i < chunks.size(); ++i) {
+        if(chunks[i].numRecords) return chunks[i].firstTime;
+      }
+      return 0.0;
+    }
+
+    double DataReplayer::getEndTime() const {
+      for(size_t i = chunks.size(); i > 0; --i) {
+        if(chunks[i-1].numRecords) return chunks[i-1].lastTime;
+      }
+      return 0.0;
+    }
+
+    double DataReplayer::getCurrentTime() const {
+      if(atEnd()) return getEndTime();
+      return getRecord(currentChunk, currentPos)->time;
+    }
+
+    bool DataReplayer::atEnd() const {
+      return currentChunk >= chunks.size();
+    }
+
+    const DataLogRecordHeader* DataReplayer::getRecord(size_t chunk,
+                                                       size_t pos) const {
+      const DataLogRecordHeader *record;
+      if(chunk >= chunks.size() ||
+         pos + sizeof(DataLogRecordHeader) > chunks[chunk].usedBytes) {
+        return NULL;
+      }
+      record = (const DataLogRecordHeader*)(data + chunks[chunk].offset + pos);
+      if(record->size < sizeof(DataLogRecordHeader) ||
+         pos + record->size > chunks[chunk].usedBytes) {
+        return NULL;
+      }
+      return record;
+    }
+
+    void DataReplayer::skipEmptyChunks() {
+      while(currentChunk < chunks.size() &&
+            !getRecord(currentChunk, currentPos)) {
+        ++currentChunk;
+        currentPos = sizeof(DataLogChunkHeader);
+      }
+    }
+
+    bool DataReplayer::nextRecord() {
+      const DataLogRecordHeader *record = getRecord(currentChunk, currentPos);
+      if(record) {
+        currentPos += record->size;
+      }
+      skipEmptyChunks();
+      return !atEnd();
+    }
+
+    bool DataReplayer::seek(double simTime) {
+      const DataLogRecordHeader *record;
+      size_t first = 0, last = chunks.size(), middle;
+      size_t position;
+
+      // find the first chunk that ends at or after simTime
+      while(first < last) {
+        middle = (first + last) / 2;
+        if(chunks[middle].numRecords && chunks[middle].lastTime < simTime) {
+          first = middle + 1;
+        } else {
+          last = middle;
+        }
+      }
+      currentChunk = first;
+      currentPos = sizeof(DataLogChunkHeader);
+      skipEmptyChunks();
+      while(!atEnd()) {
+        record = getRecord(currentChunk, currentPos);
+        if(record->time >= simTime) break;
+        nextRecord();
+      }
+
+      // restore the schemas that were valid at the new position
+      position = atEnd() ? dataSize : chunks[currentChunk].offset + currentPos;
+      for(size_t i = 0; i < schemaOffsets.size(); ++i) {
+        if(schemaOffsets[i] >= position) break;
+        readSchema((const DataLogRecordHeader*)(data + schemaOffsets[i]));
+      }
+      return !atEnd();
+    }
+
+    size_t DataReplayer::replayUntil(double simTime) {
+      const DataLogRecordHeader *record;
+      size_t count = 0;
+      while(!atEnd()) {
+        record = getRecord(currentChunk, currentPos);
+        if(record->time > simTime) break;
+        if(record->type == DATA_LOG_SCHEMA_RECORD) {
+          readSchema(record);
+        } else if(pushRecord(record)) {
+          ++count;
+        }
+        nextRecord();
+      }
+      return count;
+    }
+
+    void DataReplayer::replay(double speed) {
+      long long startTime = utils::getTime();
+      double startSimTime = getCurrentTime();
+      double simTime;
+      long long wait;
+
+      while(!atEnd()) {
+        simTime = getCurrentTime();
+        if(speed > 0.0) {
+          wait = (long long)((simTime - startSimTime) / speed);
+          wait -= utils::getTimeDiff(startTime);
+          if(wait > 0) {
+            utils::msleep(wait);
+          }
+        }
+        replayUntil(simTime);
+      }
+    }
+
+    bool DataReplayer::readSchema(const DataLogRecordHeader *record) {
+      const char *p = (const char*)record + sizeof(DataLogRecordHeader);
+      const char *end = (const char*)record + record->size;
+      uint32_t flags, numItems, type;
+      std::string groupName, dataName, itemName;
+      DataPackage package;
+
+      if(!readString(&p, end, &groupName) ||
+         !readString(&p, end, &dataName) ||
+         !readUInt(&p, end, &flags) || !readUInt(&p, end, &numItems)) {
+        return false;
+      }
+      for(uint32_t i = 0; i < numItems; ++i) {
+        if(!readUInt(&p, end, &type) || !readString(&p, end, &itemName)) {
+          return false;
+        }
+        switch(type) {
+        case INT_TYPE: package.add(itemName, (int)0); break;
+        case UINT_TYPE: package.add(itemName, (unsigned int)0); break;
+        case LONG_TYPE: package.add(itemName, (long)0); break;
+        case ULONG_TYPE: package.add(itemName, (unsigned long)0); break;
+        case FLOAT_TYPE: package.add(itemName, 0.0f); break;
+        case DOUBLE_TYPE: package.add(itemName, 0.0); break;
+        case BOOL_TYPE: package.add(itemName, false); break;
+        case STRING_TYPE: package.add(itemName, std::string()); break;
+        default: return false;
+        }
+      }
+      if(record->stream >= streams.size()) {
+        Stream empty;
+        empty.valid = false;
+        empty.flags = DATA_PACKAGE_NO_FLAG;
+        empty.pushId = 0;
+        streams.resize(record->stream + 1, empty);
+      }
+      Stream &stream = streams[record->stream];
+      if(stream.groupName != groupName || stream.dataName != dataName) {
+        stream.pushId = 0;
+      }
+      stream.valid = true;
+      stream.groupName = groupName;
+      stream.dataName = dataName;
+      stream.flags = (PackageFlag)flags;
+      stream.package = package;
+      return true;
+    }
+
+    bool DataReplayer::pushRecord(const DataLogRecordHeader *record) {
+      const char *p = (const char*)record + sizeof(DataLogRecordHeader);
+      const char *end = (const char*)record + record->size;
+
+      if(record->stream >= streams.size() || !streams[record->stream].valid) {
+        return false;
+      }
+      Stream &stream = streams[record->stream];
+      for(size_t i = 0; i < stream.package.size(); ++i) {
+        DataItem &item = stream.package[i];
+        switch(item.type) {
+        case INT_TYPE:
+        case UINT_TYPE:
+        case FLOAT_TYPE:
+          if(p + 4 > end) return false;
+          memcpy(&item.i, p, 4);
+          p += 4;
+          break;
+        case LONG_TYPE: {
+          int64_t l;
+          if(p + 8 > end) return false;
+          memcpy(&l, p, 8);
+          item.l = l;
+          p += 8;
+          break;
+        }
+        case ULONG_TYPE: {
+          uint64_t ul;
+          if(p + 8 > end) return false;
+          memcpy(&ul, p, 8);
+          item.ul = ul;
+          p += 8;
+          break;
+        }
+        case DOUBLE_TYPE:
+          if(p + 8 > end) return false;
+          memcpy(&item.d, p, 8);
+          p += 8;
+          break;
+        case BOOL_TYPE:
+          if(p + 1 > end) return false;
+          item.b = (*p++ != 0);
+          break;
+        case STRING_TYPE:
+          if(!readString(&p, end, &item.s)) return false;
+          break;
+        default:
+          return false;
+        }
+      }
+      if(stream.pushId) {
+        dataBroker->pushData(stream.pushId, stream.package);
+      } else {
+        stream.pushId = dataBroker->pushData(groupPrefix + stream.groupName,
+                                             stream.dataName, stream.package,
+                                             NULL, stream.flags);
+      }
+      return true;
+    }
+
+  } // end of namespace data_broker
+
+} // end of namespace mars
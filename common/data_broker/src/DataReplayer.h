@@ -0,0 +1,145 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file DataReplayer.h
+ * \brief Publishes the streams of a log written by the DataRecorder.
+ */
+
+#ifndef DATAREPLAYER_H
+#define DATAREPLAYER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "DataReplayer.h"
+#endif
+
+#include "DataPackage.h"
+#include "DataInfo.h"
+#include "DataLogFormat.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace mars {
+
+  namespace data_broker {
+
+    class DataBrokerInterface;
+
+    /**
+     * \brief The DataReplayer pushes the recorded DataPackages back into
+     *        the DataBroker.
+     *
+     * The replay can be driven by the sim time with replayUntil() or run
+     * with a fixed speed by replay(). seek() uses the chunk headers of the
+     * log as index and only walks the records of one chunk.
+     */
+    class DataReplayer {
+    public:
+      DataReplayer(DataBrokerInterface *dataBroker);
+      ~DataReplayer();
+
+      /**
+       * \brief Opens the log and reads the chunk index and the schemas of
+       *        all streams. The replay starts at the first record.
+       */
+      bool open(const std::string &filename);
+      void close();
+
+      /**
+       * \brief The prefix is added to the groupName of every replayed
+       *        stream, e.g. to replay next to a running simulation.
+       */
+      void setGroupPrefix(const std::string &prefix);
+
+      /** \brief The sim time of the first and last record in ms. */
+      double getStartTime() const;
+      double getEndTime() const;
+      /** \brief The sim time of the next record that is replayed. */
+      double getCurrentTime() const;
+      bool atEnd() const;
+
+      /**
+       * \brief Moves the replay to the first record with a sim time not
+       *        less than \a simTime.
+       */
+      bool seek(double simTime);
+
+      /**
+       * \brief Pushes all records up to and including \a simTime.
+       * \return The number of pushed DataPackages.
+       */
+      size_t replayUntil(double simTime);
+
+      /**
+       * \brief Replays the log until its end.
+       * \param speed 1.0 replays in real time, 2.0 twice as fast. With a
+       *              speed of 0 or less the records are pushed as fast as
+       *              possible.
+       */
+      void replay(double speed = 1.0);
+
+    private:
+      struct Stream {
+        bool valid;
+        std::string groupName, dataName;
+        PackageFlag flags;
+        DataPackage package;
+        unsigned long pushId;
+      };
+
+      struct ChunkInfo {
+        size_t offset;
+        size_t usedBytes;
+        uint32_t numRecords;
+        double firstTime, lastTime;
+      };
+
+      DataReplayer(const DataReplayer &);
+      DataReplayer &operator=(const DataReplayer &);
+
+      const DataLogRecordHeader* getRecord(size_t chunk, size_t pos) const;
+      bool nextRecord();
+      bool readSchema(const DataLogRecordHeader *record);
+      bool pushRecord(const DataLogRecordHeader *record);
+      void skipEmptyChunks();
+
+      DataBrokerInterface *dataBroker;
+      std::string groupPrefix;
+
+      const char *data;
+      size_t dataSize;
+      std::vector<char> buffer;
+      int fd;
+
+      std::vector<ChunkInfo> chunks;
+      std::vector<Stream> streams;
+      // offset of every schema record in the order they were written;
+      // used to restore the schemas after a seek
+      std::vector<size_t> schemaOffsets;
+      size_t currentChunk, currentPos;
+    }; // end of class DataReplayer
+
+  } // end of namespace data_broker
+
+} // end of namespace mars
+
+#endif // DATAREPLAYER_H
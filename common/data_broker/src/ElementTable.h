@@ -0,0 +1,139 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ElementTable.h
+ * \brief Flat table that maps the dataIds of the DataBroker to their
+ *        DataElements.
+ */
+
+#ifndef ELEMENTTABLE_H
+#define ELEMENTTABLE_H
+
+#ifdef _PRINT_HEADER_
+  #warning "ElementTable.h"
+#endif
+
+#include <cstring>
+#include <vector>
+
+#define ELEMENT_TABLE_CHUNK_BITS 10
+#define ELEMENT_TABLE_CHUNK_SIZE (1 << ELEMENT_TABLE_CHUNK_BITS)
+#define ELEMENT_TABLE_INITIAL_CHUNKS 16
+
+namespace mars {
+
+  namespace data_broker {
+
+    struct DataElement;
+
+    /// \cond HIDDEN_SYMBOLS
+    /**
+     * The dataIds are handed out sequentially, so the elements are stored
+     * in chunks indexed by the id. Chunks are never moved or freed while
+     * the table exists, so get() can be called from any thread without a
+     * lock. Only insert() has to be serialized by the caller.
+     *
+     * The directory of the chunks doubles when an id does not fit. The
+     * old directories are kept until the table is destroyed, because a
+     * reader may still use them.
+     */
+    class ElementTable {
+    public:
+      ElementTable() : chunks(NULL), numChunks(0), size(0) {
+        grow(ELEMENT_TABLE_INITIAL_CHUNKS);
+      }
+
+      ~ElementTable() {
+        for(unsigned long i = 0; i < numChunks; ++i) {
+          delete[] chunks[i];
+        }
+        delete[] chunks;
+        for(size_t i = 0; i < retired.size(); ++i) {
+          delete[] retired[i];
+        }
+      }
+
+      void insert(unsigned long id, DataElement *element) {
+        unsigned long chunk = id >> ELEMENT_TABLE_CHUNK_BITS;
+        if(chunk >= numChunks) {
+          unsigned long n = numChunks;
+          while(chunk >= n) n *= 2;
+          grow(n);
+        }
+        if(!chunks[chunk]) {
+          DataElement **newChunk = new DataElement*[ELEMENT_TABLE_CHUNK_SIZE];
+          memset(newChunk, 0, sizeof(DataElement*) * ELEMENT_TABLE_CHUNK_SIZE);
+          chunks[chunk] = newChunk;
+        }
+        chunks[chunk][id & (ELEMENT_TABLE_CHUNK_SIZE - 1)] = element;
+        // the element has to be visible before the new size
+        __sync_synchronize();
+        if(id >= size) {
+          size = id + 1;
+        }
+      }
+
+      inline DataElement* get(unsigned long id) const {
+        unsigned long n = size;
+        __sync_synchronize();
+        if(id >= n) {
+          return NULL;
+        }
+        return chunks[id >> ELEMENT_TABLE_CHUNK_BITS][id & (ELEMENT_TABLE_CHUNK_SIZE - 1)];
+      }
+
+      /** \brief One more than the highest id in the table. */
+      inline unsigned long getSize() const {
+        return size;
+      }
+
+    private:
+      ElementTable(const ElementTable &);
+      ElementTable &operator=(const ElementTable &);
+
+      void grow(unsigned long n) {
+        DataElement ***newChunks = new DataElement**[n];
+        memset((void*)newChunks, 0, sizeof(DataElement**) * n);
+        DataElement ***oldChunks = chunks;
+        if(oldChunks) {
+          memcpy((void*)newChunks, (void*)oldChunks,
+                 sizeof(DataElement**) * numChunks);
+          retired.push_back(oldChunks);
+        }
+        // the copied directory has to be visible before it is used
+        __sync_synchronize();
+        chunks = newChunks;
+        numChunks = n;
+      }
+
+      DataElement *** volatile chunks;
+      unsigned long numChunks;
+      volatile unsigned long size;
+      // directories replaced by grow()
+      std::vector<DataElement***> retired;
+    }; // end of class ElementTable
+    /// \endcond
+
+  } // end of namespace data_broker
+
+} // end of namespace mars
+
+#endif // ELEMENTTABLE_H
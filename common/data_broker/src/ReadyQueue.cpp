@@ -0,0 +1,120 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ReadyQueue.h"
+#include "DataBroker.h"
+
+#include <mars/utils/MutexLocker.h>
+
+#include <algorithm>
+
+#ifdef __linux__
+  #include <sys/eventfd.h>
+  #include <unistd.h>
+  #include <stdint.h>
+  #include <cerrno>
+#endif
+
+namespace mars {
+
+  namespace data_broker {
+
+    using namespace mars::utils;
+
+    ReadyQueue::ReadyQueue() : head(NULL), eventFd(-1), signaled(false) {
+#ifdef __linux__
+      eventFd = eventfd(0, 0);
+#endif
+    }
+
+    ReadyQueue::~ReadyQueue() {
+#ifdef __linux__
+      if(eventFd != -1) {
+        close(eventFd);
+      }
+#endif
+    }
+
+    void ReadyQueue::push(DataElement *element) {
+      DataElement *oldHead;
+      if(!__sync_bool_compare_and_swap(&element->queued, 0, 1)) {
+        // already queued; the dispatcher reads the latest data anyway
+        return;
+      }
+      do {
+        oldHead = head;
+        element->nextReady = oldHead;
+      } while(!__sync_bool_compare_and_swap(&head, oldHead, element));
+      // only the push to the empty queue has to wake up the consumer
+      if(!oldHead) {
+        wakeup();
+      }
+    }
+
+    bool ReadyQueue::popAll(std::vector<DataElement*> *elements) {
+      DataElement *element;
+      elements->clear();
+      element = __sync_lock_test_and_set(&head, (DataElement*)NULL);
+      while(element) {
+        elements->push_back(element);
+        element = element->nextReady;
+      }
+      // the list is in reverse push order
+      std::reverse(elements->begin(), elements->end());
+      // nextReady is not read anymore, the elements can be queued again
+      __sync_synchronize();
+      for(size_t i = 0; i < elements->size(); ++i) {
+        (*elements)[i]->queued = 0;
+      }
+      __sync_synchronize();
+      return !elements->empty();
+    }
+
+    void ReadyQueue::wait() {
+#ifdef __linux__
+      if(eventFd != -1) {
+        uint64_t value;
+        while(read(eventFd, &value, sizeof(value)) == -1 && errno == EINTR);
+        return;
+      }
+#endif
+      MutexLocker locker(&signalMutex);
+      while(!signaled) {
+        signalCondition.wait(&signalMutex);
+      }
+      signaled = false;
+    }
+
+    void ReadyQueue::wakeup() {
+#ifdef __linux__
+      if(eventFd != -1) {
+        uint64_t value = 1;
+        while(write(eventFd, &value, sizeof(value)) == -1 && errno == EINTR);
+        return;
+      }
+#endif
+      MutexLocker locker(&signalMutex);
+      signaled = true;
+      signalCondition.wakeOne();
+    }
+
+  } // end of namespace data_broker
+
+} // end of namespace mars
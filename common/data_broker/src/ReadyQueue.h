@@ -0,0 +1,90 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ReadyQueue.h
+ * \brief Queue of the updated DataElements that are waiting for the
+ *        asynchronous dispatcher of the DataBroker.
+ */
+
+#ifndef READYQUEUE_H
+#define READYQUEUE_H
+
+#ifdef _PRINT_HEADER_
+  #warning "ReadyQueue.h"
+#endif
+
+#include <mars/utils/Mutex.h>
+#include <mars/utils/WaitCondition.h>
+
+#include <vector>
+
+namespace mars {
+
+  namespace data_broker {
+
+    struct DataElement;
+
+    /// \cond HIDDEN_SYMBOLS
+    /**
+     * Lock free multi producer / single consumer queue. The producers
+     * push an element with a compare and swap on the list head; the
+     * consumer takes the whole list at once. An element is only queued
+     * once until the consumer took it.
+     *
+     * The consumer sleeps in wait() until a producer pushes to the empty
+     * queue. On linux an eventfd is used for the wakeup, otherwise a
+     * WaitCondition.
+     */
+    class ReadyQueue {
+    public:
+      ReadyQueue();
+      ~ReadyQueue();
+
+      /** \brief Queues the element. Can be called from any thread. */
+      void push(DataElement *element);
+
+      /**
+       * \brief Takes all queued elements in the order they were pushed.
+       * \return \c false if the queue was empty.
+       */
+      bool popAll(std::vector<DataElement*> *elements);
+
+      /** \brief Blocks until an element is pushed or wakeup() is called. */
+      void wait();
+      void wakeup();
+
+    private:
+      ReadyQueue(const ReadyQueue &);
+      ReadyQueue &operator=(const ReadyQueue &);
+
+      DataElement * volatile head;
+      int eventFd;
+      bool signaled;
+      mars::utils::Mutex signalMutex;
+      mars::utils::WaitCondition signalCondition;
+    }; // end of class ReadyQueue
+    /// \endcond
+
+  } // end of namespace data_broker
+
+} // end of namespace mars
+
+#endif // READYQUEUE_H
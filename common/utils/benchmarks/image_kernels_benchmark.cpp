@@ -0,0 +1,202 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file image_kernels_benchmark.cpp
+ * \brief Compares the image kernels with the scalar loops they replace
+ *        for images of 640x480 and 1920x1080 pixels.
+ *
+ * Usage: image_kernels_benchmark [numRuns]
+ *
+ * Every kernel is run on the same random input as its scalar loop and
+ * the results have to be equal bit by bit. The program returns 1 if a
+ * result differs.
+ */
+
+#include "imageKernels.h"
+#include "misc.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+using namespace mars::utils;
+
+// the scalar loops of the sensors and the GraphicsWidget
+
+static void linearizeDepthScalar(const uint32_t *depth, float *distance,
+                                 int width, int height,
+                                 double zNear, double zFar) {
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  for(int y=0; y<height; ++y) {
+    for(int x=0; x<width; ++x) {
+      const float dv = (float)depth[(height-1-y)*width+x] / 4294967296.0f;
+      if(dv >= 1.0f) distance[y*width+x] = nan;
+      else distance[y*width+x] = zNear*zFar/(zFar-dv*(zFar-zNear));
+    }
+  }
+}
+
+static void convertToDoubleScalar(const uint8_t *src, double *dst,
+                                  std::size_t n, double scale) {
+  for(std::size_t i=0; i<n; ++i) dst[i] = src[i]*scale;
+}
+
+static void gatherPixelsScalar(const float *image, const int *indices,
+                               float *dst, std::size_t n) {
+  for(std::size_t i=0; i<n; ++i) dst[i] = image[indices[i]];
+}
+
+static void transformPointsScalar(const float *src, float *dst,
+                                  std::size_t n, const float *m) {
+  for(std::size_t i=0; i<n; ++i) {
+    const float x = src[i*3], y = src[i*3+1], z = src[i*3+2];
+    dst[i*3] = m[0]*x + m[1]*y + m[2]*z + m[3];
+    dst[i*3+1] = m[4]*x + m[5]*y + m[6]*z + m[7];
+    dst[i*3+2] = m[8]*x + m[9]*y + m[10]*z + m[11];
+  }
+}
+
+static bool failed = false;
+
+template <typename T>
+static void report(const char *name, int width, int height,
+                   double scalarTime, double kernelTime,
+                   const std::vector<T> &expected,
+                   const std::vector<T> &result) {
+  bool equal = !memcmp(&expected[0], &result[0], expected.size()*sizeof(T));
+  if(!equal) failed = true;
+  printf("%-18s %4dx%-4d %10.3f %10.3f %8.2f  %s\n", name, width, height,
+         scalarTime, kernelTime,
+         kernelTime > 0 ? scalarTime/kernelTime : 0.0,
+         equal ? "ok" : "DIFFERENT");
+}
+
+static void runImage(int width, int height, int numRuns) {
+  const std::size_t numPixels = (std::size_t)width*height;
+  const double zNear = 0.1, zFar = 100.0;
+  const float matrix[12] = {0.36f, -0.48f, 0.8f, 1.5f,
+                            0.8f, 0.6f, 0.0f, -2.25f,
+                            -0.48f, 0.64f, 0.6f, 0.125f};
+  std::vector<uint32_t> depth(numPixels);
+  std::vector<uint8_t> rgba(numPixels*4);
+  std::vector<int> indices(numPixels/4);
+  std::vector<float> points(numPixels*3);
+  long long start;
+  double scalarTime, kernelTime;
+
+  srand(1);
+  for(std::size_t i=0; i<numPixels; ++i) {
+    // some pixels at the far plane
+    if(rand() % 16 == 0) depth[i] = 0xffffffff;
+    else depth[i] = (uint32_t)rand() << 16 ^ (uint32_t)rand();
+  }
+  for(std::size_t i=0; i<rgba.size(); ++i) rgba[i] = (uint8_t)rand();
+  for(std::size_t i=0; i<indices.size(); ++i) {
+    indices[i] = rand() % (int)numPixels;
+  }
+  for(std::size_t i=0; i<points.size(); ++i) {
+    points[i] = (float)rand() / RAND_MAX * 20.0f - 10.0f;
+  }
+
+  {
+    std::vector<float> expected(numPixels), result(numPixels);
+    start = getTime();
+    for(int r=0; r<numRuns; ++r) {
+      linearizeDepthScalar(&depth[0], &expected[0], width, height,
+                           zNear, zFar);
+    }
+    scalarTime = (double)getTimeDiff(start) / numRuns;
+    start = getTime();
+    for(int r=0; r<numRuns; ++r) {
+      linearizeDepth(&depth[0], &result[0], width, height,
+                     zNear, zFar, true);
+    }
+    kernelTime = (double)getTimeDiff(start) / numRuns;
+    report("linearizeDepth", width, height, scalarTime, kernelTime,
+           expected, result);
+  }
+
+  {
+    std::vector<double> expected(rgba.size()), result(rgba.size());
+    start = getTime();
+    for(int r=0; r<numRuns; ++r) {
+      convertToDoubleScalar(&rgba[0], &expected[0], rgba.size(), 1./255.);
+    }
+    scalarTime = (double)getTimeDiff(start) / numRuns;
+    start = getTime();
+    for(int r=0; r<numRuns; ++r) {
+      convertToDouble(&rgba[0], &result[0], rgba.size(), 1./255.);
+    }
+    kernelTime = (double)getTimeDiff(start) / numRuns;
+    report("convertToDouble", width, height, scalarTime, kernelTime,
+           expected, result);
+  }
+
+  {
+    std::vector<float> image(numPixels);
+    std::vector<float> expected(indices.size()), result(indices.size());
+    linearizeDepth(&depth[0], &image[0], width, height, zNear, zFar, false);
+    start = getTime();
+    for(int r=0; r<numRuns; ++r) {
+      gatherPixelsScalar(&image[0], &indices[0], &expected[0],
+                         indices.size());
+    }
+    scalarTime = (double)getTimeDiff(start) / numRuns;
+    start = getTime();
+    for(int r=0; r<numRuns; ++r) {
+      gatherPixels(&image[0], &indices[0], &result[0], indices.size());
+    }
+    kernelTime = (double)getTimeDiff(start) / numRuns;
+    report("gatherPixels", width, height, scalarTime, kernelTime,
+           expected, result);
+  }
+
+  {
+    std::vector<float> expected(points.size()), result(points.size());
+    start = getTime();
+    for(int r=0; r<numRuns; ++r) {
+      transformPointsScalar(&points[0], &expected[0], numPixels, matrix);
+    }
+    scalarTime = (double)getTimeDiff(start) / numRuns;
+    start = getTime();
+    for(int r=0; r<numRuns; ++r) {
+      transformPoints(&points[0], &result[0], numPixels, matrix);
+    }
+    kernelTime = (double)getTimeDiff(start) / numRuns;
+    report("transformPoints", width, height, scalarTime, kernelTime,
+           expected, result);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int numRuns = (argc > 1) ? atoi(argv[1]) : 50;
+
+  printf("image kernels: %s, ms per image (%d runs)\n",
+         getImageKernelISA(), numRuns);
+  printf("%-18s %9s %10s %10s %8s\n", "kernel", "size", "scalar", "kernel",
+         "speedup");
+  runImage(640, 480, numRuns);
+  runImage(1920, 1080, numRuns);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,318 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "imageKernels.h"
+
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+  #define MARS_IMAGE_KERNELS_X86
+  #include <immintrin.h>
+  #define MARS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace mars {
+  namespace utils {
+
+    enum KernelISA {ISA_SCALAR, ISA_SSE2, ISA_AVX2};
+
+    static KernelISA detectISA() {
+#ifdef MARS_IMAGE_KERNELS_X86
+      __builtin_cpu_init();
+      if(__builtin_cpu_supports("avx2")) return ISA_AVX2;
+      return ISA_SSE2;
+#else
+      return ISA_SCALAR;
+#endif
+    }
+
+    static KernelISA getISA() {
+      static const KernelISA isa = detectISA();
+      return isa;
+    }
+
+    const char* getImageKernelISA() {
+      switch(getISA()) {
+      case ISA_AVX2: return "avx2";
+      case ISA_SSE2: return "sse2";
+      default: return "scalar";
+      }
+    }
+
+    /*
+     * depth linearization
+     *
+     * The depth is converted to float and scaled by 2^-32 before the
+     * projection is inverted in double precision; this matches the
+     * former per pixel loop of the GraphicsWidget bit by bit.
+     */
+
+    struct DepthParams {
+      double a, b, c;   // zNear*zFar, zFar, zFar-zNear
+    };
+
+    static void linearizeRowScalar(const uint32_t *src, float *dst, int n,
+                                   const DepthParams &p) {
+      const float nan = std::numeric_limits<float>::quiet_NaN();
+      const float scale = 1.0f / 4294967296.0f;
+
+      for(int i=0; i<n; ++i) {
+        const float dv = (float)src[i] * scale;
+        // 1.0 is the max depth in the depth buffer, and
+        // is represented as a nan in the distance image
+        if(dv >= 1.0f) dst[i] = nan;
+        else dst[i] = p.a/(p.b-dv*p.c);
+      }
+    }
+
+#ifdef MARS_IMAGE_KERNELS_X86
+    static int linearizeRowSSE2(const uint32_t *src, float *dst, int n,
+                                const DepthParams &p) {
+      const __m128i low16 = _mm_set1_epi32(0xffff);
+      const __m128 shift16 = _mm_set1_ps(65536.0f);
+      const __m128 scale = _mm_set1_ps(1.0f / 4294967296.0f);
+      const __m128 one = _mm_set1_ps(1.0f);
+      const __m128 nan = _mm_set1_ps(std::numeric_limits<float>::quiet_NaN());
+      const __m128d a = _mm_set1_pd(p.a);
+      const __m128d b = _mm_set1_pd(p.b);
+      const __m128d c = _mm_set1_pd(p.c);
+      int i = 0;
+
+      for(; i+4<=n; i+=4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src+i));
+        // unsigned to float: both halves are exact, the sum is rounded once
+        __m128 hi = _mm_cvtepi32_ps(_mm_srli_epi32(v, 16));
+        __m128 lo = _mm_cvtepi32_ps(_mm_and_si128(v, low16));
+        __m128 dv = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(hi, shift16), lo), scale);
+        __m128 far = _mm_cmpge_ps(dv, one);
+        __m128d d0 = _mm_cvtps_pd(dv);
+        __m128d d1 = _mm_cvtps_pd(_mm_movehl_ps(dv, dv));
+        d0 = _mm_div_pd(a, _mm_sub_pd(b, _mm_mul_pd(d0, c)));
+        d1 = _mm_div_pd(a, _mm_sub_pd(b, _mm_mul_pd(d1, c)));
+        __m128 r = _mm_movelh_ps(_mm_cvtpd_ps(d0), _mm_cvtpd_ps(d1));
+        r = _mm_or_ps(_mm_and_ps(far, nan), _mm_andnot_ps(far, r));
+        _mm_storeu_ps(dst+i, r);
+      }
+      return i;
+    }
+
+    MARS_TARGET_AVX2
+    static int linearizeRowAVX2(const uint32_t *src, float *dst, int n,
+                                const DepthParams &p) {
+      const __m256i low16 = _mm256_set1_epi32(0xffff);
+      const __m256 shift16 = _mm256_set1_ps(65536.0f);
+      const __m256 scale = _mm256_set1_ps(1.0f / 4294967296.0f);
+      const __m256 one = _mm256_set1_ps(1.0f);
+      const __m256 nan = _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN());
+      const __m256d a = _mm256_set1_pd(p.a);
+      const __m256d b = _mm256_set1_pd(p.b);
+      const __m256d c = _mm256_set1_pd(p.c);
+      int i = 0;
+
+      for(; i+8<=n; i+=8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src+i));
+        __m256 hi = _mm256_cvtepi32_ps(_mm256_srli_epi32(v, 16));
+        __m256 lo = _mm256_cvtepi32_ps(_mm256_and_si256(v, low16));
+        __m256 dv = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(hi, shift16),
+                                                lo), scale);
+        __m256 far = _mm256_cmp_ps(dv, one, _CMP_GE_OQ);
+        __m256d d0 = _mm256_cvtps_pd(_mm256_castps256_ps128(dv));
+        __m256d d1 = _mm256_cvtps_pd(_mm256_extractf128_ps(dv, 1));
+        d0 = _mm256_div_pd(a, _mm256_sub_pd(b, _mm256_mul_pd(d0, c)));
+        d1 = _mm256_div_pd(a, _mm256_sub_pd(b, _mm256_mul_pd(d1, c)));
+        __m256 r = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(d0)),
+                                        _mm256_cvtpd_ps(d1), 1);
+        r = _mm256_blendv_ps(r, nan, far);
+        _mm256_storeu_ps(dst+i, r);
+      }
+      return i;
+    }
+#endif
+
+    void linearizeDepth(const uint32_t *depth, float *distance,
+                        int width, int height,
+                        double zNear, double zFar, bool flipRows) {
+      DepthParams p;
+      const KernelISA isa = getISA();
+
+      p.a = zNear*zFar;
+      p.b = zFar;
+      p.c = zFar-zNear;
+      for(int y=0; y<height; ++y) {
+        const uint32_t *src = depth + (std::size_t)(flipRows ? height-1-y : y)*width;
+        float *dst = distance + (std::size_t)y*width;
+        int i = 0;
+#ifdef MARS_IMAGE_KERNELS_X86
+        if(isa == ISA_AVX2) i = linearizeRowAVX2(src, dst, width, p);
+        else i = linearizeRowSSE2(src, dst, width, p);
+#else
+        (void)isa;
+#endif
+        linearizeRowScalar(src+i, dst+i, width-i, p);
+      }
+    }
+
+    /*
+     * byte to floating point conversion
+     */
+
+#ifdef MARS_IMAGE_KERNELS_X86
+    static std::size_t convertToDoubleSSE2(const uint8_t *src, double *dst,
+                                           std::size_t n, double scale) {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128d s = _mm_set1_pd(scale);
+      std::size_t i = 0;
+
+      for(; i+8<=n; i+=8) {
+        __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src+i)),
+                                      zero);
+        __m128i v0 = _mm_unpacklo_epi16(v, zero);
+        __m128i v1 = _mm_unpackhi_epi16(v, zero);
+        _mm_storeu_pd(dst+i, _mm_mul_pd(_mm_cvtepi32_pd(v0), s));
+        _mm_storeu_pd(dst+i+2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(v0, 0x4e)), s));
+        _mm_storeu_pd(dst+i+4, _mm_mul_pd(_mm_cvtepi32_pd(v1), s));
+        _mm_storeu_pd(dst+i+6, _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(v1, 0x4e)), s));
+      }
+      return i;
+    }
+
+    MARS_TARGET_AVX2
+    static std::size_t convertToDoubleAVX2(const uint8_t *src, double *dst,
+                                           std::size_t n, double scale) {
+      const __m256d s = _mm256_set1_pd(scale);
+      std::size_t i = 0;
+
+      for(; i+8<=n; i+=8) {
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src+i)));
+        __m256d d0 = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v));
+        __m256d d1 = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1));
+        _mm256_storeu_pd(dst+i, _mm256_mul_pd(d0, s));
+        _mm256_storeu_pd(dst+i+4, _mm256_mul_pd(d1, s));
+      }
+      return i;
+    }
+
+#endif
+
+    void convertToDouble(const uint8_t *src, double *dst,
+                         std::size_t n, double scale) {
+      std::size_t i = 0;
+
+#ifdef MARS_IMAGE_KERNELS_X86
+      if(getISA() == ISA_AVX2) i = convertToDoubleAVX2(src, dst, n, scale);
+      else i = convertToDoubleSSE2(src, dst, n, scale);
+#endif
+      for(; i<n; ++i) dst[i] = src[i]*scale;
+    }
+
+    /*
+     * sensor data
+     */
+
+#ifdef MARS_IMAGE_KERNELS_X86
+    MARS_TARGET_AVX2
+    static std::size_t gatherPixelsAVX2(const float *image, const int *indices,
+                                        float *dst, std::size_t n) {
+      std::size_t i = 0;
+
+      for(; i+8<=n; i+=8) {
+        __m256i idx = _mm256_loadu_si256((const __m256i*)(indices+i));
+        _mm256_storeu_ps(dst+i, _mm256_i32gather_ps(image, idx, 4));
+      }
+      return i;
+    }
+
+    static std::size_t transformPointsSSE2(const float *src, float *dst,
+                                           std::size_t n, const float *m) {
+      std::size_t i = 0;
+
+      for(; i+4<=n; i+=4) {
+        // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+        __m128 a = _mm_loadu_ps(src+i*3);
+        __m128 b = _mm_loadu_ps(src+i*3+4);
+        __m128 c = _mm_loadu_ps(src+i*3+8);
+        __m128 p = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 1, 2));
+        __m128 q = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 1, 2, 1));
+        __m128 r = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 0, 0, 3));
+        __m128 s = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+        __m128 x = _mm_shuffle_ps(a, p, _MM_SHUFFLE(3, 0, 3, 0));
+        __m128 y = _mm_shuffle_ps(q, r, _MM_SHUFFLE(3, 0, 3, 0));
+        __m128 z = _mm_shuffle_ps(q, s, _MM_SHUFFLE(2, 0, 2, 1));
+        __m128 v[3];
+
+        // same order of operations as the scalar loop
+        for(int k=0; k<3; ++k) {
+          const float *row = m+k*4;
+          v[k] = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                   _mm_mul_ps(_mm_set1_ps(row[0]), x),
+                   _mm_mul_ps(_mm_set1_ps(row[1]), y)),
+                   _mm_mul_ps(_mm_set1_ps(row[2]), z)),
+                   _mm_set1_ps(row[3]));
+        }
+        __m128 xyLo = _mm_unpacklo_ps(v[0], v[1]);
+        __m128 xyHi = _mm_unpackhi_ps(v[0], v[1]);
+        __m128 w = _mm_shuffle_ps(v[2], xyLo, _MM_SHUFFLE(3, 2, 1, 0));
+        __m128 u = _mm_shuffle_ps(v[2], xyHi, _MM_SHUFFLE(3, 2, 3, 2));
+        _mm_storeu_ps(dst+i*3, _mm_shuffle_ps(xyLo, w, _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(dst+i*3+4, _mm_shuffle_ps(w, xyHi, _MM_SHUFFLE(1, 0, 1, 3)));
+        _mm_storeu_ps(dst+i*3+8, _mm_shuffle_ps(u, u, _MM_SHUFFLE(1, 3, 2, 0)));
+      }
+      return i;
+    }
+#endif
+
+    void gatherPixels(const float *image, const int *indices,
+                      float *dst, std::size_t n) {
+      std::size_t i = 0;
+
+#ifdef MARS_IMAGE_KERNELS_X86
+      if(getISA() == ISA_AVX2) i = gatherPixelsAVX2(image, indices, dst, n);
+#endif
+      for(; i<n; ++i) dst[i] = image[indices[i]];
+    }
+
+    void distanceHistogram(const float *distance, std::size_t n,
+                           double binSize, double *bins, int numBins) {
+      for(std::size_t i=0; i<n; ++i) {
+        // NaN fails the comparison
+        if(!(distance[i] >= 0.0f)) continue;
+        const double bin = distance[i]/binSize;
+        if(bin < numBins) bins[(int)bin] += 1.0;
+      }
+    }
+
+    void transformPoints(const float *src, float *dst, std::size_t n,
+                         const float *matrix) {
+      const float *m = matrix;
+      std::size_t i = 0;
+
+#ifdef MARS_IMAGE_KERNELS_X86
+      i = transformPointsSSE2(src, dst, n, m);
+#endif
+      for(; i<n; ++i) {
+        const float x = src[i*3], y = src[i*3+1], z = src[i*3+2];
+        dst[i*3] = m[0]*x + m[1]*y + m[2]*z + m[3];
+        dst[i*3+1] = m[4]*x + m[5]*y + m[6]*z + m[7];
+        dst[i*3+2] = m[8]*x + m[9]*y + m[10]*z + m[11];
+      }
+    }
+
+  } // end of namespace utils
+} // end of namespace mars
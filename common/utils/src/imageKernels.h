@@ -0,0 +1,86 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MARS_UTILS_IMAGE_KERNELS_H
+#define MARS_UTILS_IMAGE_KERNELS_H
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace mars {
+  namespace utils {
+
+    /**
+     * Image conversions used by the camera based sensors.
+     *
+     * On x86 the kernels use AVX2 if the cpu supports it and SSE2
+     * otherwise; the instruction set is selected once at runtime. All
+     * other platforms use the scalar implementation. Every path gives the
+     * same results as the scalar one.
+     */
+
+    /**
+     * @return the instruction set used by the image kernels: "avx2",
+     *         "sse2" or "scalar"
+     */
+    const char* getImageKernelISA();
+
+    /**
+     * converts a depth buffer with 32 bit fixed point values into the
+     * distance to the image plane of a perspective projection.
+     * Values at the far plane are set to NaN.
+     * @param flipRows if true the last row of \a depth becomes the
+     *                 first row of \a distance
+     */
+    void linearizeDepth(const uint32_t *depth, float *distance,
+                        int width, int height,
+                        double zNear, double zFar, bool flipRows);
+
+    /**
+     * converts bytes into floating point values multiplied with \a scale,
+     * e.g. 1/255 to get the color channels in [0, 1].
+     */
+    void convertToDouble(const uint8_t *src, double *dst,
+                         std::size_t n, double scale);
+
+    /** dst[i] = image[indices[i]] */
+    void gatherPixels(const float *image, const int *indices,
+                      float *dst, std::size_t n);
+
+    /**
+     * counts the distances into bins of size \a binSize starting at 0;
+     * NaN and distances beyond the last bin are ignored.
+     */
+    void distanceHistogram(const float *distance, std::size_t n,
+                           double binSize, double *bins, int numBins);
+
+    /**
+     * applies an affine transformation to \a n points stored as x, y, z.
+     * @param matrix the upper 3x4 part of the transformation in row major
+     *               order
+     * \a src and \a dst may be the same buffer.
+     */
+    void transformPoints(const float *src, float *dst, std::size_t n,
+                         const float *matrix);
+
+  } // end of namespace utils
+} // end of namespace mars
+
+#endif /* MARS_UTILS_IMAGE_KERNELS_H */
@@ -195,7 +195,7 @@ namespace mars {
       for(int y = 0; y < info.height; ++y) {
         for(int x = 0; x < info.width; ++x) {
           // create height
-          height_data[y][x] = info.pixelData[(y*info.width)+x] * info.scale;
+          height_data[y][x] = info.getPixel(x, y) * info.scale;
 
           // create the tex_coords
           if(y<1 || x<1) {
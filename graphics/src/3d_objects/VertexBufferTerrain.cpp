@@ -60,15 +60,16 @@ namespace mars {
                                             1.0, 1.0, 1.0, ts->texScaleX,
                                             ts->texScaleY);
       double maxHeight = 0.0;
-      double offset;
+      double offset, h;
 
       for(int i=0; i<ts->height; ++i)
         for(int j=0; j<ts->width; ++j) {
           if(i==0 || j==0 || i==ts->height-1 || j==ts->width-1) offset = -0.1;
           else offset = 0.0;
-          mrhmr->setHeight(j, i, offset+ts->scale*ts->pixelData[i*ts->width+j]);
-          if(ts->pixelData[i*ts->width+j]*ts->scale > maxHeight) {
-            maxHeight = ts->pixelData[i*ts->width+j]*ts->scale;
+          h = ts->scale*ts->getPixel(j, i);
+          mrhmr->setHeight(j, i, offset+h);
+          if(h > maxHeight) {
+            maxHeight = h;
           }
         }
 
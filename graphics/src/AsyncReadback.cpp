@@ -0,0 +1,313 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file AsyncReadback.cpp
+ * \brief The "AsyncReadback" reads the pixels of a camera through a ring of
+ *        pixel buffer objects.
+ */
+
+#include "AsyncReadback.h"
+
+#include <mars/utils/MutexLocker.h>
+
+#include <osg/BufferObject>
+#include <osg/FrameStamp>
+#include <osg/GraphicsThread>
+
+#ifdef HAVE_OSG_VERSION_H
+  #include <osg/Version>
+#else
+  #include <osg/Export>
+#endif
+
+#if (OPENSCENEGRAPH_MAJOR_VERSION > 3 || (OPENSCENEGRAPH_MAJOR_VERSION == 3 && OPENSCENEGRAPH_MINOR_VERSION >= 4))
+  #include <osg/GLExtensions>
+  #define MARS_OSG_GL_EXTENSIONS
+#endif
+
+#include <cstring>
+
+namespace mars {
+  namespace graphics {
+
+    using mars::utils::MutexLocker;
+
+#ifdef MARS_OSG_GL_EXTENSIONS
+    typedef osg::GLExtensions BufferExtensions;
+
+    static BufferExtensions* getBufferExtensions(osg::State &state) {
+      return osg::GLExtensions::Get(state.getContextID(), true);
+    }
+
+    static bool hasPixelBuffers(const BufferExtensions *ext) {
+      return ext && ext->isPBOSupported;
+    }
+#else
+    typedef osg::GLBufferObject::Extensions BufferExtensions;
+
+    static BufferExtensions* getBufferExtensions(osg::State &state) {
+      return osg::GLBufferObject::getExtensions(state.getContextID(), true);
+    }
+
+    static bool hasPixelBuffers(const BufferExtensions *ext) {
+      return ext && ext->isPBOSupported();
+    }
+#endif
+
+    /**
+     * Maps the buffers of a readback after the cameras of the following
+     * frames were drawn. It is kept in the operation queue of the context
+     * until no buffer is pending anymore.
+     */
+    class CollectReadbackOperation : public osg::GraphicsOperation {
+    public:
+      CollectReadbackOperation(AsyncReadback *readback) :
+        osg::GraphicsOperation("CollectReadback", true), readback(readback) {}
+
+      virtual void operator () (osg::GraphicsContext *context) {
+        osg::ref_ptr<AsyncReadback> r;
+        if(readback.lock(r) && context->getState()) {
+          r->collectPending(*context->getState());
+          if(r->hasPending()) return;
+          r->collectRequested = false;
+        }
+        setKeep(false);
+      }
+
+    private:
+      osg::observer_ptr<AsyncReadback> readback;
+    };
+
+    class DeletePixelBuffersOperation : public osg::GraphicsOperation {
+    public:
+      DeletePixelBuffersOperation(const std::vector<GLuint> &ids) :
+        osg::GraphicsOperation("DeletePixelBuffers", false), ids(ids) {}
+
+      virtual void operator () (osg::GraphicsContext *context) {
+        if(!context->getState()) return;
+        BufferExtensions *ext = getBufferExtensions(*context->getState());
+        if(hasPixelBuffers(ext)) {
+          ext->glDeleteBuffers((GLsizei)ids.size(), &ids[0]);
+        }
+      }
+
+    private:
+      std::vector<GLuint> ids;
+    };
+
+    AsyncReadback::AsyncReadback(osg::Texture2D *texture, GLenum pixelFormat,
+                                 GLenum type, int pixelSize,
+                                 int numBuffers) :
+      texture(texture), pixelFormat(pixelFormat), type(type),
+      pixelSize(pixelSize), width(0), height(0), frameHandler(0),
+      nextBuffer(0), collectRequested(false),
+      frontWidth(0), frontHeight(0), frameCount(0) {
+      PixelBuffer buffer;
+
+      if(numBuffers < 2) numBuffers = 2;
+      buffer.id = 0;
+      buffer.size = 0;
+      buffer.width = buffer.height = 0;
+      buffer.pending = false;
+      buffer.frameNumber = 0;
+      buffers.resize(numBuffers, buffer);
+    }
+
+    AsyncReadback::~AsyncReadback() {
+      std::vector<GLuint> ids;
+      std::vector<PixelBuffer>::iterator iter;
+      osg::ref_ptr<osg::GraphicsContext> gc;
+
+      for(iter=buffers.begin(); iter!=buffers.end(); ++iter) {
+        if(iter->id) ids.push_back(iter->id);
+      }
+      // the buffers can only be deleted with the context being current
+      if(!ids.empty() && context.lock(gc)) {
+        gc->add(new DeletePixelBuffersOperation(ids));
+      }
+    }
+
+    void AsyncReadback::setSize(int width, int height) {
+      this->width = width;
+      this->height = height;
+    }
+
+    void AsyncReadback::setFrameHandler(FrameHandler *handler) {
+      frameHandler = handler;
+    }
+
+    void AsyncReadback::operator () (osg::RenderInfo &renderInfo) const {
+      osg::State &state = *renderInfo.getState();
+      osg::ref_ptr<osg::Texture2D> tex;
+      GLuint textureId = 0;
+      int w = width, h = height;
+
+      if(texture.valid()) {
+        if(!texture.lock(tex)) return;
+        osg::Texture::TextureObject *textureObject;
+        textureObject = tex->getTextureObject(state.getContextID());
+        if(!textureObject) return;
+        textureId = textureObject->id();
+        w = tex->getTextureWidth();
+        h = tex->getTextureHeight();
+      }
+      if(w <= 0 || h <= 0) return;
+
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      if(textureId) {
+        state.setActiveTextureUnit(0);
+        glBindTexture(GL_TEXTURE_2D, textureId);
+        state.haveAppliedTextureAttribute(0, osg::StateAttribute::TEXTURE);
+      }
+
+      BufferExtensions *ext = getBufferExtensions(state);
+      if(!hasPixelBuffers(ext)) {
+        readSync(state, w, h);
+        return;
+      }
+
+      PixelBuffer &buffer = buffers[nextBuffer];
+      // the ring is full; this buffer was filled numBuffers frames ago
+      if(buffer.pending) collect(state, buffer);
+
+      std::size_t size = (std::size_t)w*h*pixelSize;
+      if(!buffer.id) ext->glGenBuffers(1, &buffer.id);
+      ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, buffer.id);
+      if(buffer.size != size) {
+        ext->glBufferData(GL_PIXEL_PACK_BUFFER_ARB, size, 0,
+                          GL_STREAM_READ_ARB);
+        buffer.size = size;
+      }
+      // with a bound pack buffer the last argument is an offset and the
+      // call returns without waiting for the transfer
+      if(textureId) {
+        glGetTexImage(GL_TEXTURE_2D, 0, pixelFormat, type, 0);
+      }
+      else {
+        glReadPixels(0, 0, w, h, pixelFormat, type, 0);
+      }
+      ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
+
+      buffer.width = w;
+      buffer.height = h;
+      buffer.pending = true;
+      buffer.frameNumber = (state.getFrameStamp() ?
+                            state.getFrameStamp()->getFrameNumber() : 0);
+      nextBuffer = (nextBuffer + 1) % buffers.size();
+      requestCollect(state);
+    }
+
+    void AsyncReadback::readSync(osg::State &state, int w, int h) const {
+      osg::ref_ptr<osg::Texture2D> tex;
+
+      (void)state;
+      backData.resize((std::size_t)w*h*pixelSize);
+      if(texture.lock(tex)) {
+        glGetTexImage(GL_TEXTURE_2D, 0, pixelFormat, type, &backData[0]);
+      }
+      else {
+        glReadPixels(0, 0, w, h, pixelFormat, type, &backData[0]);
+      }
+      publish(w, h);
+    }
+
+    void AsyncReadback::collect(osg::State &state,
+                                PixelBuffer &buffer) const {
+      BufferExtensions *ext = getBufferExtensions(state);
+      const void *pixels;
+      std::size_t size = (std::size_t)buffer.width*buffer.height*pixelSize;
+
+      buffer.pending = false;
+      if(!hasPixelBuffers(ext)) return;
+
+      ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, buffer.id);
+      pixels = ext->glMapBuffer(GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB);
+      if(pixels) {
+        backData.resize(size);
+        memcpy(&backData[0], pixels, size);
+        ext->glUnmapBuffer(GL_PIXEL_PACK_BUFFER_ARB);
+      }
+      ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
+      if(pixels) publish(buffer.width, buffer.height);
+    }
+
+    void AsyncReadback::collectPending(osg::State &state) const {
+      unsigned int frameNumber = (state.getFrameStamp() ?
+                                  state.getFrameStamp()->getFrameNumber() :
+                                  0);
+      std::size_t i, k;
+
+      // oldest buffer first; buffers filled in this frame are left for the
+      // next one to give the transfer a frame of time
+      for(i=0; i<buffers.size(); ++i) {
+        k = (nextBuffer + i) % buffers.size();
+        if(buffers[k].pending && buffers[k].frameNumber != frameNumber) {
+          collect(state, buffers[k]);
+        }
+      }
+    }
+
+    bool AsyncReadback::hasPending() const {
+      std::vector<PixelBuffer>::const_iterator iter;
+
+      for(iter=buffers.begin(); iter!=buffers.end(); ++iter) {
+        if(iter->pending) return true;
+      }
+      return false;
+    }
+
+    void AsyncReadback::requestCollect(osg::State &state) const {
+      osg::GraphicsContext *gc = state.getGraphicsContext();
+
+      if(collectRequested || !gc) return;
+      context = gc;
+      gc->add(new CollectReadbackOperation(const_cast<AsyncReadback*>(this)));
+      collectRequested = true;
+    }
+
+    void AsyncReadback::publish(int w, int h) const {
+      if(frameHandler) {
+        frameHandler->frameRead(&backData[0], w, h, pixelFormat, type);
+      }
+      MutexLocker locker(&dataMutex);
+      frontData.swap(backData);
+      frontWidth = w;
+      frontHeight = h;
+      ++frameCount;
+    }
+
+    bool AsyncReadback::getData(void *buffer, std::size_t size,
+                                int &width, int &height) const {
+      MutexLocker locker(&dataMutex);
+      width = frontWidth;
+      height = frontHeight;
+      if(frontData.empty() || size < frontData.size()) return false;
+      memcpy(buffer, &frontData[0], frontData.size());
+      return true;
+    }
+
+    unsigned long AsyncReadback::getFrameCount() const {
+      MutexLocker locker(&dataMutex);
+      return frameCount;
+    }
+
+  } // end of namespace graphics
+} // end of namespace mars
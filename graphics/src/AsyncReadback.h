@@ -0,0 +1,150 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file AsyncReadback.h
+ * \brief The "AsyncReadback" reads the pixels of a camera through a ring of
+ *        pixel buffer objects.
+ */
+
+#ifndef MARS_GRAPHICS_ASYNCREADBACK_H
+#define MARS_GRAPHICS_ASYNCREADBACK_H
+
+#ifdef _PRINT_HEADER_
+  #warning "AsyncReadback.h"
+#endif
+
+#include <osg/Camera>
+#include <osg/GraphicsContext>
+#include <osg/Texture2D>
+#include <osg/observer_ptr>
+
+#include <mars/utils/Mutex.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace mars {
+  namespace graphics {
+
+    /**
+     * \brief Draw callback that copies the rendered pixels into a pixel
+     *        buffer object instead of reading them synchronously.
+     *
+     * Each draw issues the read into the next buffer of the ring and
+     * returns without waiting for the transfer. A buffer is mapped in a
+     * later frame, either by the next draw that reuses it or by a graphics
+     * operation that runs after the cameras of the following frame; thus a
+     * camera that is only rendered for a single frame still gets its image
+     * one frame later. The newest mapped frame is kept in memory and can be
+     * copied from any thread by getData().
+     *
+     * The source is either a texture, e.g. the color or depth attachment of
+     * a RTT camera, or the read buffer of the current frame buffer. Without
+     * pixel buffer object support the pixels are read synchronously.
+     */
+    class AsyncReadback : public osg::Camera::DrawCallback {
+    public:
+      /**
+       * \brief Is called in the graphics thread with every mapped frame.
+       */
+      class FrameHandler {
+      public:
+        virtual ~FrameHandler() {}
+        virtual void frameRead(const void *data, int width, int height,
+                               GLenum pixelFormat, GLenum type) = 0;
+      };
+
+      /**
+       * \param texture The texture that is read. If it is NULL the read
+       *                buffer is read with the size given by setSize().
+       * \param pixelSize The size of one pixel in \a pixelFormat and
+       *                  \a type in bytes.
+       * \param numBuffers The number of pixel buffer objects; 2 for double
+       *                   and 3 for triple buffering.
+       */
+      AsyncReadback(osg::Texture2D *texture, GLenum pixelFormat,
+                    GLenum type, int pixelSize, int numBuffers = 2);
+
+      virtual void operator () (osg::RenderInfo &renderInfo) const;
+
+      void setSize(int width, int height);
+      void setFrameHandler(FrameHandler *handler);
+
+      /**
+       * \brief Copies the newest frame into \a buffer.
+       * \return \c false if no frame was read yet or if \a size is too
+       *         small; \a width and \a height are set in both cases.
+       */
+      bool getData(void *buffer, std::size_t size,
+                   int &width, int &height) const;
+      /** \brief The number of frames that were read so far. */
+      unsigned long getFrameCount() const;
+
+      /**
+       * \brief Maps all buffers that were filled before the current frame.
+       *
+       * Has to be called in the graphics thread of the context.
+       */
+      void collectPending(osg::State &state) const;
+      bool hasPending() const;
+
+    protected:
+      ~AsyncReadback();
+
+    private:
+      struct PixelBuffer {
+        GLuint id;
+        std::size_t size;
+        int width, height;
+        bool pending;
+        unsigned int frameNumber;
+      };
+
+      void collect(osg::State &state, PixelBuffer &buffer) const;
+      void readSync(osg::State &state, int width, int height) const;
+      void publish(int width, int height) const;
+      void requestCollect(osg::State &state) const;
+
+      osg::observer_ptr<osg::Texture2D> texture;
+      GLenum pixelFormat, type;
+      int pixelSize;
+      int width, height;
+      FrameHandler *frameHandler;
+
+      // only used by the graphics thread
+      mutable std::vector<PixelBuffer> buffers;
+      mutable unsigned int nextBuffer;
+      mutable std::vector<char> backData;
+      mutable bool collectRequested;
+      mutable osg::observer_ptr<osg::GraphicsContext> context;
+
+      mutable mars::utils::Mutex dataMutex;
+      mutable std::vector<char> frontData;
+      mutable int frontWidth, frontHeight;
+      mutable unsigned long frameCount;
+
+      friend class CollectReadbackOperation;
+    }; // end of class AsyncReadback
+
+  } // end of namespace graphics
+} // end of namespace mars
+
+#endif // MARS_GRAPHICS_ASYNCREADBACK_H
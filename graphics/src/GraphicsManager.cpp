@@ -55,6 +55,7 @@
 #include "wrapper/OSGLightStruct.h"
 #include "wrapper/OSGMaterialStruct.h"
 #include "wrapper/OSGDrawItem.h"
+#include "wrapper/OSGDrawBatch.h"
 #include "wrapper/OSGHudElementStruct.h"
 
 #include "GraphicsWidget.h"
@@ -456,16 +457,19 @@ namespace mars {
       //update drawElements
       for (unsigned int i=0; i<draws.size(); i++) {
         drawMapper &draw = draws[i];
-        vector<draw_item> tmp_ditem;
-        vector<osg::Node*> tmp_nodes;
+        // erased items are dropped by moving the remaining ones down
+        unsigned int n = 0;
         //update draws
         draw.ds.ptr_draw->update(&(draw.ds.drawItems));
+        // new items do not have a node yet
+        draw.nodes.resize(draw.ds.drawItems.size(), NULL);
 
         for (unsigned int j=0; j<draw.ds.drawItems.size(); j++) {
           draw_item &di = draw.ds.drawItems[j];
 
           if(di.draw_state == DRAW_STATE_ERASE) {
             scene->removeChild(draw.nodes[j]);
+            continue;
           }
           else if (di.draw_state == DRAW_STATE_CREATE) {
             std::string font_path = resources_path.sValue;
@@ -473,34 +477,37 @@ namespace mars {
             osg::ref_ptr<osg::Group> osgNode = new OSGDrawItem(osgWidget, di,
                                                                font_path);
             scene->addChild(osgNode.get());
-
-            di.draw_state = DRAW_UNKNOWN;
-            tmp_ditem.push_back(di);
-            tmp_nodes.push_back(osgNode.get());
+            draw.nodes[j] = osgNode.get();
           }
           else if (di.draw_state == DRAW_STATE_UPDATE) {
-            assert(draws[i].nodes.size() > j);
-            osg::Node *n = draws[i].nodes[j];
-            OSGDrawItem *diWrapper = dynamic_cast<OSGDrawItem*>(n->asGroup()); // TODO: asGroup unneeded?
+            assert(draw.nodes.size() > j);
+            osg::Node *node = draw.nodes[j];
+            OSGDrawItem *diWrapper = dynamic_cast<OSGDrawItem*>(node->asGroup()); // TODO: asGroup unneeded?
             assert(diWrapper != NULL); // TODO: handle this case better
 
             diWrapper->update(di);
-
-            di.draw_state = DRAW_UNKNOWN;
-            tmp_ditem.push_back(di);
-            tmp_nodes.push_back(n);
           }
-          else { // invalid draw state!
-            di.draw_state = DRAW_UNKNOWN;
-            tmp_ditem.push_back(di);
-            tmp_nodes.push_back(draws[i].nodes[j]);
+          di.draw_state = DRAW_UNKNOWN;
+          if(n != j) {
+            draw.ds.drawItems[n] = di;
+            draw.nodes[n] = draw.nodes[j];
           }
+          ++n;
         }
+        draw.ds.drawItems.resize(n);
+        draw.nodes.resize(n);
 
-        draws[i].ds.drawItems.clear();
-        draws[i].ds.drawItems = tmp_ditem;
-        draws[i].nodes.clear();
-        draws[i].nodes = tmp_nodes;
+        // the batch node is created once and then rewritten in place
+        draw.ds.ptr_draw->updateBatch(&draw.batch);
+        if(!draw.batchNode && !draw.batch.empty()) {
+          std::string font_path = resources_path.sValue;
+          font_path.append("/Fonts");
+          draw.batchNode = new OSGDrawBatch(font_path);
+          scene->addChild(draw.batchNode);
+        }
+        if(draw.batchNode) {
+          draw.batchNode->update(draw.batch);
+        }
       }
     }
 
@@ -770,6 +777,7 @@ namespace mars {
     }
 
     void GraphicsManager::setGrabFrames(bool value) {
+      graphicsWindows[0]->setSaveFormat(grab_format.sValue);
       graphicsWindows[0]->setGrabFrames(value);
       graphicsWindows[0]->setSaveFrames(value);
     }
@@ -1084,6 +1092,7 @@ namespace mars {
       //create a mapper
       drawMapper myMapper;
       myMapper.ds = *draw;
+      myMapper.batchNode = NULL;
       draws.push_back(myMapper);
     }
 
@@ -1097,6 +1106,9 @@ namespace mars {
             jt != it->nodes.end(); ++jt) {
           scene->removeChild(*jt);
         }
+        if(it->batchNode) {
+          scene->removeChild(it->batchNode);
+        }
         it->nodes.clear();
         it->ds.drawItems.clear();
         draws.erase(it);
@@ -1868,6 +1880,10 @@ namespace mars {
       grab_frames = cfg->getOrCreateProperty("Graphics", "make movie", false,
                                              cfgClient);
 
+      // file extension of the grabbed frames: "png" or "raw"
+      grab_format = cfg->getOrCreateProperty("Graphics", "movie format",
+                                             string("png"), cfgClient);
+
       marsShader = cfg->getOrCreateProperty("Graphics", "marsShader", true,
                                             cfgClient);
 
@@ -2003,6 +2019,11 @@ namespace mars {
         return;
       }
 
+      if(_property.paramId == grab_format.paramId) {
+        grab_format.sValue = _property.sValue;
+        return;
+      }
+
       if(_property.paramId == showGridProp.paramId) {
         showGridProp.bValue = _property.bValue;
         if(showGridProp.bValue) showGrid();
@@ -83,6 +83,7 @@ namespace mars {
     class DrawObject;
     class OSGNodeStruct;
     class OSGHudElementStruct;
+    class OSGDrawBatch;
     class HUDElement;
 
 
@@ -90,6 +91,8 @@ namespace mars {
     struct drawMapper {
       interfaces::drawStruct ds;
       std::vector<osg::Node*> nodes;
+      interfaces::drawBatch batch;
+      OSGDrawBatch *batchNode; // owned by the scene
     };
 
     /**
@@ -402,7 +405,7 @@ namespace mars {
         drawLineLaserProp, drawMainCamera, marsShadow, hudWidthProp,
         hudHeightProp, defaultMaxNumNodeLights, shadowTextureSize,
         showGridProp, showCoordsProp, showSelectionProp;
-      cfg_manager::cfgPropertyStruct grab_frames;
+      cfg_manager::cfgPropertyStruct grab_frames, grab_format;
       cfg_manager::cfgPropertyStruct resources_path;
       cfg_manager::cfgPropertyStruct configPath;
       cfg_manager::cfgPropertyStruct shadowSamples;
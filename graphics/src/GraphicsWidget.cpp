@@ -24,6 +24,7 @@
 #include "GraphicsManager.h"
 
 #include <mars/utils/Color.h>
+#include <mars/utils/imageKernels.h>
 
 #include <iostream>
 #include <string>
@@ -81,6 +82,7 @@ namespace mars {
       widgetHeight = 405;
 
       graphicsWindow = 0;
+      postDrawCallback = 0;
       myHUD = 0;
       hudCamera = 0;
       graphicsCamera = 0;
@@ -839,8 +841,7 @@ namespace mars {
         osgCamera->setCullMask(CULL_LAYER);
         view->setCamera(osgCamera.get());
 
-        osg::Image* grabImage = new osg::Image();
-        postDrawCallback = new PostDrawCallback(grabImage);
+        postDrawCallback = new PostDrawCallback();
         postDrawCallback->setSize(widgetWidth, widgetHeight);
         postDrawCallback->setGrab(false);
         //osgCamera->setFinalDrawCallback(postDrawCallback);
@@ -896,17 +897,19 @@ namespace mars {
 
 
 
-        rttImage = new osg::Image();
-        rttImage->allocateImage(widgetWidth, widgetHeight,
-                                1, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV);
-        osgCamera->attach(osg::Camera::COLOR_BUFFER, rttImage.get());
-        rttTexture->setImage(rttImage);
+        // render directly into the textures; the pixels are read back
+        // asynchronously after the camera was drawn
+        osgCamera->attach(osg::Camera::COLOR_BUFFER, rttTexture.get());
+        rttReadback = new AsyncReadback(rttTexture.get(), GL_RGBA,
+                                        GL_UNSIGNED_INT_8_8_8_8_REV, 4);
+        osgCamera->setPostDrawCallback(rttReadback.get());
 
         // depth component
         rttDepthTexture = new osg::Texture2D();
         rttDepthTexture->setResizeNonPowerOfTwoHint(false);
         rttDepthTexture->setDataVariance(osg::Object::DYNAMIC);
         rttDepthTexture->setTextureSize(widgetWidth, widgetHeight);
+        rttDepthTexture->setInternalFormat(GL_DEPTH_COMPONENT);
         rttDepthTexture->setSourceType(GL_UNSIGNED_INT);
         rttDepthTexture->setSourceFormat(GL_DEPTH_COMPONENT);
         rttDepthTexture->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
@@ -915,17 +918,12 @@ namespace mars {
                                    osg::Texture2D::LINEAR);
         rttDepthTexture->setFilter(osg::Texture2D::MAG_FILTER,
                                    osg::Texture2D::LINEAR);
-        rttDepthImage = new osg::Image();
-        rttDepthImage->allocateImage(widgetWidth, widgetHeight,
-                                     1, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
-
-        osgCamera->attach(osg::Camera::DEPTH_BUFFER, rttDepthImage.get());
-
-        std::fill(rttDepthImage->data(), rttDepthImage->data() + widgetWidth * widgetHeight * sizeof(GLuint), 0);
-
-        rttDepthTexture->setImage(rttDepthImage);
-
 
+        osgCamera->attach(osg::Camera::DEPTH_BUFFER, rttDepthTexture.get());
+        rttDepthReadback = new AsyncReadback(rttDepthTexture.get(),
+                                             GL_DEPTH_COMPONENT,
+                                             GL_UNSIGNED_INT, 4);
+        osgCamera->setFinalDrawCallback(rttDepthReadback.get());
       }
       graphicsCamera = new GraphicsCamera(osgCamera, widgetWidth, widgetHeight);
     }
@@ -1041,6 +1039,10 @@ namespace mars {
       if(!isRTTWidget) postDrawCallback->setSaveGrab(grab);
     }
 
+    void GraphicsWidget::setSaveFormat(const std::string &extension) {
+      if(!isRTTWidget) postDrawCallback->setSaveFormat(extension);
+    }
+
     std::vector<osg::Node*> GraphicsWidget::getPickedObjects() {
       return pickedObjects;
     }
@@ -1066,28 +1068,36 @@ namespace mars {
 
     void GraphicsWidget::getImageData(char* buffer, int& width, int& height)
     {
+      // the caller sized the buffer for the current widget size
+      std::size_t size = (std::size_t)widgetWidth*widgetHeight*4;
+      bool read;
       if(isRTTWidget) {
-        osg::Image *image = rttImage;
-        width = image->s();
-        height = image->t();
-        memcpy(buffer, image->data(), width*height*4);
+        read = rttReadback->getData(buffer, size, width, height);
       }
-      else
-      {
-        //slow but works...
-        void *data;
-        postDrawCallback->getImageData(&data, width, height);
-        memcpy(buffer, data, width*height*4);
-        free(data);
+      else {
+        read = postDrawCallback->getImageData(buffer, size, width, height);
+      }
+      if(!read) {
+        // no frame was read yet
+        memset(buffer, 0, size);
+        width = widgetWidth;
+        height = widgetHeight;
       }
     }
 
     void GraphicsWidget::getImageData(void **data, int &width, int &height) {
       if(isRTTWidget) {
-        width = rttImage->s();
-        height = rttImage->t();
-        *data = malloc(width*height*4);
-        getImageData((char *) *data, width, height);
+        std::size_t size;
+        int w, h;
+
+        rttReadback->getData(NULL, 0, w, h);
+        size = (std::size_t)w*h*4;
+        *data = malloc(size);
+        if(!rttReadback->getData(*data, size, width, height)) {
+          memset(*data, 0, size);
+          width = w;
+          height = h;
+        }
       }
       else {
         postDrawCallback->getImageData(data, width, height);
@@ -1097,26 +1107,21 @@ namespace mars {
     void GraphicsWidget::getRTTDepthData(float* buffer, int& width, int& height)
     {
       if(isRTTWidget) {
-        GLuint* data2 = (GLuint *)rttDepthImage->data();
-        width = rttDepthImage->s();
-        height = rttDepthImage->t();
+        rttDepthBuffer.resize(widgetWidth*widgetHeight);
+        if(!rttDepthReadback->getData(&rttDepthBuffer[0],
+                                      rttDepthBuffer.size()*sizeof(GLuint),
+                                      width, height)) {
+          // no frame was read yet
+          std::fill(rttDepthBuffer.begin(), rttDepthBuffer.end(), 0);
+          width = widgetWidth;
+          height = widgetHeight;
+        }
 
         double fovy, aspectRatio, Zn, Zf;
         graphicsCamera->getOSGCamera()->getProjectionMatrixAsPerspective( fovy, aspectRatio, Zn, Zf );
-        int d = 0;
-        for(int i=height-1; i>=0; --i) {
-          for(int k=0; k<width; ++k) {
-              GLuint di = data2[i*width+k];
-
-            const float dv = ((float) di) / std::numeric_limits< GLuint >::max() ;
-            // 1.0 is the max depth in the depth buffer, and
-            // is represented as a nan in the distance image
-            if( dv >= 1.0 )
-              buffer[d++] = std::numeric_limits<float>::quiet_NaN();
-            else
-              buffer[d++] = Zn*Zf/(Zf-dv*(Zf-Zn));
-          }
-        }
+        // the depth buffer starts with the bottom row
+        utils::linearizeDepth(&rttDepthBuffer[0], buffer, width, height,
+                              Zn, Zf, true);
       } else {
         throw std::runtime_error("Depth image not supported on non RTT Widges");
       }
@@ -1124,10 +1129,8 @@ namespace mars {
 
     void GraphicsWidget::getRTTDepthData(float **data, int &width, int &height) {
       if(isRTTWidget) {
-        width = rttDepthImage->s();
-        height = rttDepthImage->t();
-        *data = (float*)malloc(width*height*sizeof(float));
-        getRTTDepthData(data, width, height);
+        *data = (float*)malloc(widgetWidth*widgetHeight*sizeof(float));
+        getRTTDepthData(*data, width, height);
       } else {
         throw std::runtime_error("Depth image not supported on non RTT Widges");
       }
@@ -1196,7 +1199,7 @@ namespace mars {
     }
 
     void GraphicsWidget::applyResize() {
-      postDrawCallback->setSize(widgetWidth, widgetHeight);
+      if(postDrawCallback) postDrawCallback->setSize(widgetWidth, widgetHeight);
       graphicsCamera->setViewport(0, 0, widgetWidth, widgetHeight);
       graphicsCamera->changeCameraTypeToPerspective();
       if (hudCamera) hudCamera->setViewport(0, 0, widgetWidth, widgetHeight);
@@ -108,6 +108,7 @@ namespace mars {
 
       void setGrabFrames(bool grab);
       void setSaveFrames(bool grab);
+      void setSaveFormat(const std::string &extension);
 
       virtual void* getWidget() {return NULL;}
       virtual void showWidget() {};
@@ -291,13 +292,14 @@ namespace mars {
 
       // destination texture if isRTTWidget==true
       osg::ref_ptr<osg::Texture2D> rttTexture;
-      // destination image if isRTTWidget==true
-      osg::ref_ptr<osg::Image> rttImage;
+      // reads rttTexture back if isRTTWidget==true
+      osg::ref_ptr<AsyncReadback> rttReadback;
 
       // destination texture if isRTTWidget==true
       osg::ref_ptr<osg::Texture2D> rttDepthTexture;
-      // destination image if isRTTWidget==true
-      osg::ref_ptr<osg::Image> rttDepthImage;
+      // reads rttDepthTexture back if isRTTWidget==true
+      osg::ref_ptr<AsyncReadback> rttDepthReadback;
+      std::vector<GLuint> rttDepthBuffer;
 
       // list of picked objects
       std::vector<osg::Node*> pickedObjects;
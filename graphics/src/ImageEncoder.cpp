@@ -0,0 +1,199 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ImageEncoder.cpp
+ * \brief The "ImageEncoder" writes images on a pool of background threads.
+ */
+
+#include "ImageEncoder.h"
+
+#include <mars/utils/MutexLocker.h>
+#include <mars/utils/Thread.h>
+
+#include <osg/Image>
+#include <osg/ref_ptr>
+#include <osgDB/WriteFile>
+
+#include <cstdio>
+#include <cstring>
+
+namespace mars {
+  namespace graphics {
+
+    using namespace mars::utils;
+
+    class ImageEncoderThread : public Thread {
+    public:
+      ImageEncoderThread(ImageEncoder *encoder) : encoder(encoder) {}
+
+    protected:
+      void run() {
+        encoder->workerLoop();
+      }
+
+    private:
+      ImageEncoder *encoder;
+    };
+
+    static int getPixelSize(GLenum pixelFormat) {
+      switch(pixelFormat) {
+      case GL_RGB: return 3;
+      case GL_LUMINANCE: return 1;
+      default: return 4;
+      }
+    }
+
+    static bool hasExtension(const std::string &filename,
+                             const std::string &extension) {
+      return (filename.size() >= extension.size() &&
+              filename.compare(filename.size() - extension.size(),
+                               extension.size(), extension) == 0);
+    }
+
+    ImageEncoder::ImageEncoder(int numThreads, std::size_t maxQueued) :
+      maxQueued(maxQueued), busyThreads(0), quit(false) {
+      ImageEncoderThread *thread;
+
+      if(numThreads < 1) numThreads = 1;
+      if(this->maxQueued < 1) this->maxQueued = 1;
+      for(int i=0; i<numThreads; ++i) {
+        thread = new ImageEncoderThread(this);
+        threads.push_back(thread);
+        thread->start();
+      }
+    }
+
+    ImageEncoder::~ImageEncoder() {
+      std::vector<ImageEncoderThread*>::iterator iter;
+      std::vector<Job*>::iterator jter;
+
+      // the queued images are still written
+      queueMutex.lock();
+      quit = true;
+      jobCondition.wakeAll();
+      queueMutex.unlock();
+
+      for(iter=threads.begin(); iter!=threads.end(); ++iter) {
+        (*iter)->wait();
+        delete *iter;
+      }
+      for(jter=freeJobs.begin(); jter!=freeJobs.end(); ++jter) {
+        delete *jter;
+      }
+    }
+
+    void ImageEncoder::encode(const void *data, int width, int height,
+                              GLenum pixelFormat,
+                              const std::string &filename) {
+      std::size_t size = (std::size_t)width*height*getPixelSize(pixelFormat);
+      Job *job;
+
+      queueMutex.lock();
+      while(queue.size() >= maxQueued) spaceCondition.wait(&queueMutex);
+      if(freeJobs.empty()) job = new Job;
+      else {
+        job = freeJobs.back();
+        freeJobs.pop_back();
+      }
+      queueMutex.unlock();
+
+      // copy outside of the lock; the job is not yet visible to the threads
+      job->pixels.resize(size);
+      memcpy(&job->pixels[0], data, size);
+      job->width = width;
+      job->height = height;
+      job->pixelFormat = pixelFormat;
+      job->filename = filename;
+
+      queueMutex.lock();
+      queue.push_back(job);
+      jobCondition.wakeOne();
+      queueMutex.unlock();
+    }
+
+    void ImageEncoder::waitForQueue() {
+      MutexLocker locker(&queueMutex);
+      while(!queue.empty() || busyThreads > 0) {
+        idleCondition.wait(&queueMutex);
+      }
+    }
+
+    void ImageEncoder::workerLoop() {
+      Job *job;
+
+      queueMutex.lock();
+      while(true) {
+        while(!quit && queue.empty()) jobCondition.wait(&queueMutex);
+        if(queue.empty()) break;
+        job = queue.front();
+        queue.pop_front();
+        ++busyThreads;
+        spaceCondition.wakeOne();
+        queueMutex.unlock();
+
+        write(job);
+
+        queueMutex.lock();
+        freeJobs.push_back(job);
+        if(--busyThreads == 0 && queue.empty()) idleCondition.wakeAll();
+      }
+      queueMutex.unlock();
+    }
+
+    void ImageEncoder::write(Job *job) {
+      GLenum pixelFormat = job->pixelFormat;
+
+      if(hasExtension(job->filename, ".raw")) {
+        FILE *file = fopen(job->filename.c_str(), "wb");
+        if(!file) {
+          fprintf(stderr, "ImageEncoder: could not open %s\n",
+                  job->filename.c_str());
+          return;
+        }
+        fwrite(&job->pixels[0], 1, job->pixels.size(), file);
+        fclose(file);
+        return;
+      }
+
+      // most image writers only know RGBA
+      if(pixelFormat == GL_BGRA) {
+        unsigned char *p = &job->pixels[0];
+        unsigned char *end = p + job->pixels.size();
+        for(; p<end; p+=4) {
+          unsigned char b = p[0];
+          p[0] = p[2];
+          p[2] = b;
+        }
+        pixelFormat = GL_RGBA;
+      }
+
+      osg::ref_ptr<osg::Image> image = new osg::Image();
+      image->setImage(job->width, job->height, 1, pixelFormat, pixelFormat,
+                      GL_UNSIGNED_BYTE, &job->pixels[0],
+                      osg::Image::NO_DELETE);
+      if(!osgDB::writeImageFile(*image, job->filename)) {
+        fprintf(stderr, "ImageEncoder: could not write %s\n",
+                job->filename.c_str());
+      }
+    }
+
+  } // end of namespace graphics
+} // end of namespace mars
@@ -0,0 +1,104 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ImageEncoder.h
+ * \brief The "ImageEncoder" writes images on a pool of background threads.
+ */
+
+#ifndef MARS_GRAPHICS_IMAGEENCODER_H
+#define MARS_GRAPHICS_IMAGEENCODER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "ImageEncoder.h"
+#endif
+
+#include <osg/GL>
+
+#include <mars/utils/Mutex.h>
+#include <mars/utils/WaitCondition.h>
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace mars {
+  namespace graphics {
+
+    class ImageEncoderThread;
+
+    /**
+     * \brief Encodes and writes images on background threads.
+     *
+     * The queue is bounded: encode() blocks while \a maxQueued images are
+     * waiting, so a slow disk slows the rendering down instead of filling
+     * the memory. The pixel buffers of written images are reused.
+     *
+     * The file type is chosen by the extension of the filename. ".raw"
+     * writes the pixels unchanged, every other extension is handed to
+     * osgDB, e.g. ".png".
+     */
+    class ImageEncoder {
+    public:
+      ImageEncoder(int numThreads = 2, std::size_t maxQueued = 8);
+      ~ImageEncoder();
+
+      /**
+       * \brief Copies the pixels and queues them for writing.
+       *
+       * \a pixelFormat is GL_RGBA, GL_BGRA or GL_RGB with GL_UNSIGNED_BYTE
+       * components; BGRA is converted to RGBA before it is encoded.
+       */
+      void encode(const void *data, int width, int height,
+                  GLenum pixelFormat, const std::string &filename);
+
+      /** \brief Blocks until all queued images are written. */
+      void waitForQueue();
+
+      void workerLoop();
+
+    private:
+      struct Job {
+        std::vector<unsigned char> pixels;
+        int width, height;
+        GLenum pixelFormat;
+        std::string filename;
+      };
+
+      ImageEncoder(const ImageEncoder &);
+      ImageEncoder &operator=(const ImageEncoder &);
+
+      void write(Job *job);
+
+      std::vector<ImageEncoderThread*> threads;
+      std::deque<Job*> queue;
+      std::vector<Job*> freeJobs;
+      std::size_t maxQueued;
+      int busyThreads;
+      bool quit;
+      mars::utils::Mutex queueMutex;
+      mars::utils::WaitCondition jobCondition, spaceCondition, idleCondition;
+    }; // end of class ImageEncoder
+
+  } // end of namespace graphics
+} // end of namespace mars
+
+#endif // MARS_GRAPHICS_IMAGEENCODER_H
@@ -25,9 +25,9 @@
  *      Author: daniel
  */
 
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
-#include <string>
-#include <osgDB/WriteFile>
 
 #include "PostDrawCallback.h"
 
@@ -35,49 +35,39 @@
 namespace mars {
   namespace graphics {
 
-    PostDrawCallback::PostDrawCallback(osg::Image* image) {
-      _image = image;
+    PostDrawCallback::PostDrawCallback() : encoder(0), saveFormat("png") {
+      // BGRA is the native layout of the frame buffer on most drivers
+      readback = new AsyncReadback(NULL, GL_BGRA, GL_UNSIGNED_BYTE, 4);
+      readback->setFrameHandler(this);
       _grab = false;
       _save_grab = false;
-      image_id = (unsigned long*)malloc(sizeof(unsigned long));
-      *image_id = 1;
-      fprintf(stderr, "initialized postDrawCallback\n");
-      imageMutex = new pthread_mutex_t;
-      pthread_mutex_init(imageMutex, NULL);
+      image_id = 1;
     }
 
     PostDrawCallback::~PostDrawCallback() {
-      pthread_mutex_lock(imageMutex);
-      delete image_id;
-      delete imageMutex;
+      readback->setFrameHandler(NULL);
+      // writes the remaining frames
+      delete encoder;
     }
 
     void PostDrawCallback::operator () (osg::RenderInfo& renderInfo) const{
-      (void) renderInfo;
-      if(_grab) {
-        pthread_mutex_lock(imageMutex);
-        if(_save_grab)
-          _image->readPixels(0, 0 , _width, _height, GL_RGBA,
-                             GL_UNSIGNED_BYTE);
-        else
-          _image->readPixels(0, 0 , _width, _height, GL_BGRA,
-                             GL_UNSIGNED_BYTE);
-        if(_save_grab) {
-          char c_filename[255];
-          sprintf(c_filename, "movie/pic%.6lu.png", *image_id);
-          std::string filename = c_filename;
-          osgDB::writeImageFile(*_image, filename);
-          *image_id += 1;
-        }
-        pthread_mutex_unlock(imageMutex);
-      }
+      if(_grab) (*readback)(renderInfo);
+    }
+
+    void PostDrawCallback::frameRead(const void *data, int width, int height,
+                                     GLenum pixelFormat, GLenum type) {
+      (void)type;
+      if(!_save_grab) return;
+      if(!encoder) encoder = new ImageEncoder();
+      char c_filename[255];
+      sprintf(c_filename, "movie/pic%.6lu.%s", image_id,
+              saveFormat.c_str());
+      encoder->encode(data, width, height, pixelFormat, c_filename);
+      image_id += 1;
     }
 
     void PostDrawCallback::setSize(int width, int height) {
-      pthread_mutex_lock(imageMutex);
-      _width = width;
-      _height = height;
-      pthread_mutex_unlock(imageMutex);
+      readback->setSize(width, height);
     }
 
     void PostDrawCallback::setGrab(bool grab) {
@@ -87,16 +77,29 @@ namespace mars {
       _save_grab = grab;
     }
 
+    void PostDrawCallback::setSaveFormat(const std::string &extension) {
+      saveFormat = extension;
+    }
+
     void PostDrawCallback::getImageData(void **data, int &width, int &height) {
-      pthread_mutex_lock(imageMutex);
-      if(_image->valid()) {
-        width = _image->s();
-        height = _image->t();
-        // allocating width*height*3byte
-        *data = malloc(width*height*4);
-        memcpy(*data, _image->data(), width*height*4);
+      std::size_t size;
+      int w, h;
+
+      readback->getData(NULL, 0, w, h);
+      size = (std::size_t)w*h*4;
+      // allocating width*height*4byte
+      *data = malloc(size);
+      if(!readback->getData(*data, size, width, height)) {
+        // no frame yet or the window was resized in between
+        memset(*data, 0, size);
+        width = w;
+        height = h;
       }
-      pthread_mutex_unlock(imageMutex);
+    }
+
+    bool PostDrawCallback::getImageData(char *buffer, std::size_t size,
+                                        int &width, int &height) {
+      return readback->getData(buffer, size, width, height);
     }
 
   } // end of namespace graphics
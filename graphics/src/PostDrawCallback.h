@@ -21,17 +21,26 @@
 #ifndef MARS_GRAPHICS_POSTDRAWCALLBACK_H
 #define MARS_GRAPHICS_POSTDRAWCALLBACK_H
 
+#include "AsyncReadback.h"
+#include "ImageEncoder.h"
+
 #include <osgViewer/Viewer>
 
-#include <pthread.h>
+#include <string>
 
 
 namespace mars {
   namespace graphics {
 
-    class PostDrawCallback : public osg::Camera::Camera::DrawCallback {
+    /**
+     * Grabs the frames of a window. The pixels are read asynchronously by
+     * an AsyncReadback and saved frames are written by an ImageEncoder, so
+     * neither blocks the draw thread.
+     */
+    class PostDrawCallback : public osg::Camera::Camera::DrawCallback,
+                             public AsyncReadback::FrameHandler {
     public:
-      PostDrawCallback(osg::Image* image);
+      PostDrawCallback();
 
       ~PostDrawCallback();
 
@@ -41,16 +50,22 @@ namespace mars {
 
       void setGrab(bool grab);
       void setSaveGrab(bool grab);
+      /** The file extension of saved frames, e.g. "png" or "raw". */
+      void setSaveFormat(const std::string &extension);
 
       void getImageData(void **data, int &width, int &height);
+      bool getImageData(char *buffer, std::size_t size,
+                        int &width, int &height);
+
+      virtual void frameRead(const void *data, int width, int height,
+                             GLenum pixelFormat, GLenum type);
 
     private:
-      osg::Image* _image;
-      int _width;
-      int _height;
+      osg::ref_ptr<AsyncReadback> readback;
+      ImageEncoder *encoder;
       bool _grab, _save_grab;
-      unsigned long *image_id;
-      pthread_mutex_t *imageMutex;
+      unsigned long image_id;
+      std::string saveFormat;
     };
 
   } // end of namespace graphics
@@ -37,6 +37,7 @@
 #endif
 
 #include <mars/utils/mathUtils.h>
+#include <mars/utils/MutexLocker.h>
 
 namespace mars {
   namespace graphics {
@@ -50,6 +51,7 @@ namespace mars {
     vector<nodeFileStruct> GuiHelper::nodeFiles;
     vector<textureFileStruct> GuiHelper::textureFiles;
     vector<imageFileStruct> GuiHelper::imageFiles;
+    mars::utils::Mutex GuiHelper::fileCacheMutex;
 
     /////////////
 
@@ -364,13 +366,22 @@ namespace mars {
     osg::ref_ptr<osg::Node> GuiHelper::readNodeFromFile(string fileName) {
       std::vector<nodeFileStruct>::iterator iter;
 
+      // the caches are shared by all simulator instances of the process;
+      // the file itself is read without holding the lock
+      fileCacheMutex.lock();
       for(iter = GuiHelper::nodeFiles.begin();
           iter != GuiHelper::nodeFiles.end(); iter++) {
-        if((*iter).fileName == fileName) return (*iter).node;
+        if((*iter).fileName == fileName) {
+          osg::ref_ptr<osg::Node> cached = (*iter).node;
+          fileCacheMutex.unlock();
+          return cached;
+        }
       }
+      fileCacheMutex.unlock();
       nodeFileStruct newNodeFile;
       newNodeFile.fileName = fileName;
       newNodeFile.node = osgDB::readNodeFile(fileName);
+      mars::utils::MutexLocker locker(&fileCacheMutex);
       GuiHelper::nodeFiles.push_back(newNodeFile);
       return newNodeFile.node;
     }
@@ -380,10 +391,16 @@ namespace mars {
 
       std::vector<nodeFileStruct>::iterator iter;
 
+      fileCacheMutex.lock();
       for(iter = GuiHelper::nodeFiles.begin();
           iter != GuiHelper::nodeFiles.end(); iter++) {
-        if((*iter).fileName == filename) return (*iter).node;
+        if((*iter).fileName == filename) {
+          osg::ref_ptr<osg::Node> cached = (*iter).node;
+          fileCacheMutex.unlock();
+          return cached;
+        }
       }
+      fileCacheMutex.unlock();
       nodeFileStruct newNodeFile;
       newNodeFile.fileName = filename;
 
@@ -520,6 +537,7 @@ namespace mars {
       optimizer.optimize( geode );
 
       newNodeFile.node = geode;
+      mars::utils::MutexLocker locker(&fileCacheMutex);
       GuiHelper::nodeFiles.push_back(newNodeFile);
       return newNodeFile.node;
     }
@@ -610,12 +628,16 @@ namespace mars {
     osg::ref_ptr<osg::Texture2D> GuiHelper::loadTexture(string filename) {
       std::vector<textureFileStruct>::iterator iter;
 
+      fileCacheMutex.lock();
       for (iter = textureFiles.begin();
            iter != textureFiles.end(); iter++) {
         if ((*iter).fileName == filename) {
-          return (*iter).texture;
+          osg::ref_ptr<osg::Texture2D> cached = (*iter).texture;
+          fileCacheMutex.unlock();
+          return cached;
         }
       }
+      fileCacheMutex.unlock();
       textureFileStruct newTextureFile;
       newTextureFile.fileName = filename;
       newTextureFile.texture = new osg::Texture2D;
@@ -626,6 +648,7 @@ namespace mars {
 
       osg::Image* textureImage = loadImage(filename);
       newTextureFile.texture->setImage(textureImage);
+      mars::utils::MutexLocker locker(&fileCacheMutex);
       textureFiles.push_back(newTextureFile);
 
       return newTextureFile.texture;
@@ -634,16 +657,21 @@ namespace mars {
     osg::ref_ptr<osg::Image> GuiHelper::loadImage(string filename) {
       std::vector<imageFileStruct>::iterator iter;
 
+      fileCacheMutex.lock();
       for (iter = imageFiles.begin();
            iter != imageFiles.end(); iter++) {
         if ((*iter).fileName == filename) {
-          return (*iter).image;
+          osg::ref_ptr<osg::Image> cached = (*iter).image;
+          fileCacheMutex.unlock();
+          return cached;
         }
       }
+      fileCacheMutex.unlock();
       imageFileStruct newImageFile;
       newImageFile.fileName = filename;
       osg::Image* image = osgDB::readImageFile(filename);
       newImageFile.image = image;
+      mars::utils::MutexLocker locker(&fileCacheMutex);
       imageFiles.push_back(newImageFile);
 
       return newImageFile.image;
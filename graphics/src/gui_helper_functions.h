@@ -40,6 +40,7 @@
 #include <mars/interfaces/sim/LoadCenter.h>
 
 #include <mars/interfaces/graphics/GraphicsManagerInterface.h>
+#include <mars/utils/Mutex.h>
 
 
 namespace mars {
@@ -138,6 +139,8 @@ namespace mars {
       static std::vector<textureFileStruct> textureFiles;
       // vector to prevent double load of images
       static std::vector<imageFileStruct> imageFiles;
+      // guards the three caches
+      static mars::utils::Mutex fileCacheMutex;
       void getPhysicsFromNode(mars::interfaces::NodeData* node,
                               osg::ref_ptr<osg::Node> completeNode);
     }; // end of class GuiHelper
@@ -0,0 +1,146 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file OSGDrawBatch.cpp
+ * \brief Draws the drawBatch of a DrawInterface with one vertex buffer per
+ *        primitive type.
+ */
+
+#include "OSGDrawBatch.h"
+
+#include <cstring>
+
+namespace mars {
+  namespace graphics {
+
+    using namespace mars::interfaces;
+
+    OSGDrawBatch::OSGDrawBatch(const std::string &fontPath)
+      : osg::Group() {
+      osg::StateSet *states = getOrCreateStateSet();
+
+      fontFile = fontPath;
+      fontFile.append("/arial.ttf");
+
+      geode = new osg::Geode;
+      createBuffer(&lines, osg::PrimitiveSet::LINES);
+      createBuffer(&points, osg::PrimitiveSet::POINTS);
+      geode->addDrawable(lines.geometry.get());
+      geode->addDrawable(points.geometry.get());
+      addChild(geode.get());
+
+      textGeode = new osg::Geode;
+      addChild(textGeode.get());
+
+      lineWidth = new osg::LineWidth(1.0);
+      point = new osg::Point(1.0);
+      states->setAttributeAndModes(lineWidth.get(), osg::StateAttribute::ON);
+      states->setAttribute(point.get());
+      states->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+    }
+
+    void OSGDrawBatch::createBuffer(Buffer *buffer, GLenum mode) {
+      buffer->geometry = new osg::Geometry;
+      buffer->vertices = new osg::Vec3Array;
+      buffer->colors = new osg::Vec4Array;
+      buffer->primitives = new osg::DrawArrays(mode, 0, 0);
+
+      buffer->geometry->setDataVariance(osg::Object::DYNAMIC);
+      buffer->geometry->setUseDisplayList(false);
+      buffer->geometry->setUseVertexBufferObjects(true);
+      buffer->geometry->setVertexArray(buffer->vertices.get());
+      buffer->geometry->setColorArray(buffer->colors.get());
+      buffer->geometry->setColorBinding(osg::Geometry::BIND_PER_VERTEX);
+      buffer->geometry->addPrimitiveSet(buffer->primitives.get());
+    }
+
+    void OSGDrawBatch::update(const drawBatch &batch) {
+      lineWidth->setWidth(batch.lineWidth);
+      point->setSize(batch.pointSize);
+      updateBuffer(&lines, batch.lines, batch.lineColors);
+      updateBuffer(&points, batch.points, batch.pointColors);
+      updateTexts(batch);
+    }
+
+    void OSGDrawBatch::updateBuffer(Buffer *buffer,
+                                    const std::vector<float> &vertices,
+                                    const std::vector<float> &colors) {
+      std::size_t n = vertices.size() / 3;
+
+      if(n == 0 && buffer->vertices->empty()) return;
+      // grow geometrically, the arrays never shrink
+      if(buffer->vertices->capacity() < n) {
+        std::size_t capacity = buffer->vertices->capacity()*2;
+        if(capacity < n) capacity = n;
+        buffer->vertices->reserve(capacity);
+        buffer->colors->reserve(capacity);
+      }
+      buffer->vertices->resize(n);
+      buffer->colors->resize(n);
+      if(n) {
+        memcpy(&(*buffer->vertices)[0], &vertices[0], n*3*sizeof(float));
+        memcpy(&(*buffer->colors)[0], &colors[0], n*4*sizeof(float));
+      }
+      buffer->primitives->setCount(n);
+
+      buffer->vertices->dirty();
+      buffer->colors->dirty();
+      buffer->primitives->dirty();
+      buffer->geometry->dirtyBound();
+    }
+
+    void OSGDrawBatch::updateTexts(const drawBatch &batch) {
+      std::size_t i;
+
+      for(i=0; i<batch.numTexts; ++i) {
+        const drawBatchText &t = batch.texts[i];
+        if(i == texts.size()) {
+          osg::ref_ptr<osgText::Text> text = new osgText::Text;
+          text->setDataVariance(osg::Object::DYNAMIC);
+          text->setFont(fontFile);
+          text->setAxisAlignment(osgText::Text::SCREEN);
+          text->setAlignment(osgText::Text::CENTER_CENTER);
+          textGeode->addDrawable(text.get());
+          texts.push_back(text);
+          textStrings.push_back(std::string());
+        }
+        osgText::Text *text = texts[i].get();
+        // setText lays the glyphs out again; skip it if nothing changed
+        if(textStrings[i] != t.text) {
+          textStrings[i] = t.text;
+          text->setText(t.text);
+        }
+        text->setPosition(osg::Vec3(t.pos.x(), t.pos.y(), t.pos.z()));
+        text->setColor(osg::Vec4(t.color.r, t.color.g, t.color.b,
+                                 t.color.a));
+        text->setCharacterSize(t.size);
+      }
+      // unused texts are kept for later frames
+      for(; i<texts.size(); ++i) {
+        if(!textStrings[i].empty()) {
+          textStrings[i].clear();
+          texts[i]->setText(std::string());
+        }
+      }
+    }
+
+  } // end of namespace graphics
+} // end of namespace mars
@@ -0,0 +1,81 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file OSGDrawBatch.h
+ * \brief Draws the drawBatch of a DrawInterface with one vertex buffer per
+ *        primitive type.
+ */
+
+#ifndef MARS_GRAPHICS_OSGDRAWBATCH_H
+#define MARS_GRAPHICS_OSGDRAWBATCH_H
+
+#include <mars/interfaces/graphics/draw_structs.h>
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Group>
+#include <osg/LineWidth>
+#include <osg/Point>
+#include <osgText/Text>
+
+#include <string>
+#include <vector>
+
+namespace mars {
+  namespace graphics {
+
+    /**
+     * Wraps a drawBatch in osg::Group. The node is created once per
+     * DrawInterface; update() rewrites the vertex arrays in place and only
+     * grows them, so the scene graph does not change while drawing.
+     */
+    class OSGDrawBatch : public osg::Group {
+    public:
+      OSGDrawBatch(const std::string &fontPath);
+
+      void update(const interfaces::drawBatch &batch);
+
+    private:
+      struct Buffer {
+        osg::ref_ptr<osg::Geometry> geometry;
+        osg::ref_ptr<osg::Vec3Array> vertices;
+        osg::ref_ptr<osg::Vec4Array> colors;
+        osg::ref_ptr<osg::DrawArrays> primitives;
+      };
+
+      void createBuffer(Buffer *buffer, GLenum mode);
+      void updateBuffer(Buffer *buffer, const std::vector<float> &vertices,
+                        const std::vector<float> &colors);
+      void updateTexts(const interfaces::drawBatch &batch);
+
+      Buffer lines, points;
+      osg::ref_ptr<osg::Geode> geode, textGeode;
+      osg::ref_ptr<osg::LineWidth> lineWidth;
+      osg::ref_ptr<osg::Point> point;
+      std::vector<osg::ref_ptr<osgText::Text> > texts;
+      std::vector<std::string> textStrings;
+      std::string fontFile;
+    };
+
+  } // end of namespace graphics
+} // end of namespace mars
+
+#endif /* MARS_GRAPHICS_OSGDRAWBATCH_H */
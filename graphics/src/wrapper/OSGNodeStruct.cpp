@@ -137,7 +137,7 @@ namespace mars {
         drawObject_->setScaledSize(vizSize);
       } else if (origname.compare("terrain") == 0) {
         // we have a heightfield
-        if (!node.terrain->pixelData) {
+        if (!node.terrain->pixelData && !node.terrain->tiles) {
           node.terrain->pixelData = (double*)calloc((node.terrain->width*node.terrain->height), sizeof(double));
           //QImage image(QString::fromStdString(snode->filename));
           int r = 0, g = 0, b = 0;
@@ -0,0 +1,307 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file HeadlessRunner.cpp
+ * \brief Loads and steps a simulation without any graphics or GUI library.
+ */
+
+#include "HeadlessRunner.h"
+
+#include <lib_manager/LibManager.hpp>
+#include <mars/interfaces/sim/SimulatorInterface.h>
+#include <mars/interfaces/sim/ControlCenter.h>
+#include <mars/data_broker/DataBrokerInterface.h>
+#include <mars/data_broker/DataRecorder.h>
+#include <mars/cfg_manager/CFGManagerInterface.h>
+#include <mars/utils/misc.h>
+
+#include <getopt.h>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef DEFAULT_CONFIG_DIR
+    #define DEFAULT_CONFIG_DIR "."
+#endif
+
+namespace mars {
+  namespace headless {
+
+    // the libraries are released in the reverse order
+    static const char *coreLibs[] = {"cfg_manager", "data_broker", "mars_sim"};
+    static const char *loaderLibs[] = {"mars_scene_loader",
+                                       "mars_entity_factory",
+                                       "mars_smurf",
+                                       "mars_smurf_loader"};
+
+    HeadlessRunner::HeadlessRunner() : configDir(DEFAULT_CONFIG_DIR),
+                                       numSteps(1000), seed(0),
+                                       logGroup("*"), logData("*"),
+                                       quiet(false),
+                                       libManager(new lib_manager::LibManager()),
+                                       ownLibManager(true), sim(NULL),
+                                       recorder(NULL), stop(false) {
+    }
+
+    HeadlessRunner::HeadlessRunner(lib_manager::LibManager *theManager) :
+      configDir(DEFAULT_CONFIG_DIR), numSteps(1000), seed(0),
+      logGroup("*"), logData("*"), quiet(false), libManager(theManager),
+      ownLibManager(false), sim(NULL), recorder(NULL), stop(false) {
+    }
+
+    HeadlessRunner::~HeadlessRunner() {
+      if(recorder) {
+        recorder->stop();
+        delete recorder;
+      }
+      if(sim) sim->exitMars();
+
+      for(int i=loadedLibs.size()-1; i>=0; --i) {
+        libManager->releaseLibrary(loadedLibs[i]);
+      }
+      if(ownLibManager) delete libManager;
+    }
+
+    bool HeadlessRunner::readArguments(int argc, char **argv) {
+      int c;
+      int option_index = 0;
+      const int old_opterr = opterr;
+
+      static struct option long_options[] = {
+        {"help", no_argument, 0, 'h'},
+        {"scenename", required_argument, 0, 's'},
+        {"steps", required_argument, 0, 'n'},
+        {"seed", required_argument, 0, 'r'},
+        {"output", required_argument, 0, 'o'},
+        {"filter", required_argument, 0, 'f'},
+        {"state", required_argument, 0, 'S'},
+        {"config_dir", required_argument, 0, 'C'},
+        {"quiet", no_argument, 0, 'q'},
+        {0, 0, 0, 0}
+      };
+
+      opterr = 0;
+      bool ok = true;
+      while(ok) {
+        c = getopt_long(argc, argv, "hs:n:r:o:f:S:C:q", long_options,
+                        &option_index);
+        if(c == -1) break;
+        switch(c) {
+        case 's':
+          {
+            std::vector<std::string> names;
+            names = utils::explodeString(';', optarg);
+            for(size_t i=0; i<names.size(); ++i) {
+              if(utils::pathExists(names[i])) {
+                scenes.push_back(names[i]);
+              } else {
+                fprintf(stderr, "The given scene file does not exists: %s\n",
+                        names[i].c_str());
+                ok = false;
+              }
+            }
+          }
+          break;
+        case 'n':
+          numSteps = atol(optarg);
+          break;
+        case 'r':
+          seed = (unsigned int)strtoul(optarg, NULL, 10);
+          break;
+        case 'o':
+          logFile = optarg;
+          break;
+        case 'f':
+          {
+            // group and data pattern, e.g. "mars_sim/*"
+            std::string filter = optarg;
+            size_t pos = filter.find('/');
+            logGroup = filter.substr(0, pos);
+            logData = (pos == std::string::npos) ? "*" : filter.substr(pos+1);
+          }
+          break;
+        case 'S':
+          stateFile = optarg;
+          break;
+        case 'C':
+          if(utils::pathExists(optarg)) configDir = optarg;
+          else {
+            fprintf(stderr,
+                    "The given configuration Directory does not exists: %s\n",
+                    optarg);
+            ok = false;
+          }
+          break;
+        case 'q':
+          quiet = true;
+          break;
+        case 'h':
+        default:
+          printHelp();
+          ok = false;
+        }
+      }
+
+      opterr = old_opterr;
+      optind = 1;
+      optarg = NULL;
+      return ok;
+    }
+
+    void HeadlessRunner::printHelp() const {
+      printf("\nusage: mars_headless -s <scene> [options]\n");
+      printf("=======================================\n");
+      printf("-h             this screen\n");
+      printf("-s <filename>  scene to load, several scenes are separated by ';'\n");
+      printf("-n <steps>     number of simulation steps (default: 1000)\n");
+      printf("-r <seed>      seed of the random number generator (default: 0)\n");
+      printf("-o <filename>  record the DataBroker streams into a binary log\n");
+      printf("-f <grp/data>  pattern of the recorded streams (default: */*)\n");
+      printf("-S <filename>  write the final simulation state into a file\n");
+      printf("-C <path>      path to Configuration\n");
+      printf("-q             do not print the step rate\n");
+      printf("\n");
+    }
+
+    bool HeadlessRunner::init() {
+#ifndef WIN32
+      setenv("LC_ALL","C", 1);
+      unsetenv("LANG");
+#endif
+      setlocale(LC_ALL, "C");
+      srand(seed);
+
+      for(size_t i=0; i<sizeof(coreLibs)/sizeof(coreLibs[0]); ++i) {
+        if(libManager->loadLibrary(coreLibs[i]) !=
+           lib_manager::LibManager::LIBMGR_NO_ERROR) {
+          fprintf(stderr, "mars_headless: could not load %s\n", coreLibs[i]);
+          return false;
+        }
+        loadedLibs.push_back(coreLibs[i]);
+
+        if(i == 0) {
+          // the config path has to be set before mars_sim is loaded
+          cfg_manager::CFGManagerInterface *cfg;
+          cfg = libManager->getLibraryAs<cfg_manager::CFGManagerInterface>("cfg_manager");
+          if(cfg) {
+            cfg_manager::cfgPropertyStruct configPath;
+            configPath = cfg->getOrCreateProperty("Config", "config_path",
+                                                  configDir);
+            configPath.sValue = configDir;
+            cfg->setProperty(configPath);
+            std::string loadFile = configDir + "/mars_Preferences.yaml";
+            cfg->loadConfig(loadFile.c_str());
+          }
+        }
+      }
+      // the scene loaders register themselves in the LoadCenter of
+      // mars_sim; missing loaders are only a problem for their scene types
+      for(size_t i=0; i<sizeof(loaderLibs)/sizeof(loaderLibs[0]); ++i) {
+        if(libManager->loadLibrary(loaderLibs[i], NULL, true) ==
+           lib_manager::LibManager::LIBMGR_NO_ERROR) {
+          loadedLibs.push_back(loaderLibs[i]);
+        }
+      }
+
+      sim = libManager->getLibraryAs<interfaces::SimulatorInterface>("mars_sim");
+      if(!sim) {
+        fprintf(stderr, "mars_headless: error while casting simulation lib\n");
+        return false;
+      }
+      // without a thread the simulation is only stepped by run()
+      sim->runSimulation(false);
+
+      for(size_t i=0; i<scenes.size(); ++i) {
+        if(!sim->loadScene(scenes[i])) {
+          fprintf(stderr, "mars_headless: could not load scene %s\n",
+                  scenes[i].c_str());
+          return false;
+        }
+      }
+
+      if(!logFile.empty()) {
+        data_broker::DataBrokerInterface *dataBroker;
+        dataBroker = sim->getControlCenter()->dataBroker;
+        if(!dataBroker) {
+          fprintf(stderr, "mars_headless: no DataBroker to record\n");
+          return false;
+        }
+        recorder = new data_broker::DataRecorder(dataBroker);
+        if(!recorder->start(logFile, logGroup, logData)) {
+          fprintf(stderr, "mars_headless: could not create log %s\n",
+                  logFile.c_str());
+          return false;
+        }
+      }
+      return true;
+    }
+
+    long HeadlessRunner::run(long steps) {
+      if(!sim) return 0;
+      if(steps < 0) steps = numSteps;
+
+      // adds the plugins that were registered while loading
+      sim->finishedDraw();
+      sim->StartSimulation();
+
+      long long startTime = utils::getTime();
+      long i;
+      for(i=0; i<steps && !stop; ++i) {
+        sim->step();
+        if(sim->hasSimFault()) {
+          fprintf(stderr, "mars_headless: physics error in step %ld\n", i);
+          ++i;
+          break;
+        }
+      }
+      long long time = utils::getTimeDiff(startTime);
+      sim->StopSimulation();
+
+      if(!quiet) {
+        fprintf(stderr, "mars_headless: %ld steps in %lld ms", i, time);
+        if(time > 0) {
+          fprintf(stderr, " (%.1f steps/s)", i*1000.0/time);
+        }
+        fprintf(stderr, "\n");
+      }
+      if(!stateFile.empty() && !saveState()) {
+        fprintf(stderr, "mars_headless: could not write state %s\n",
+                stateFile.c_str());
+      }
+      return i;
+    }
+
+    void HeadlessRunner::requestStop() {
+      stop = true;
+    }
+
+    bool HeadlessRunner::saveState() const {
+      std::vector<char> state;
+      sim->saveState(&state);
+      FILE *file = fopen(stateFile.c_str(), "wb");
+      if(!file) return false;
+      bool ok = (state.empty() ||
+                 fwrite(&state[0], 1, state.size(), file) == state.size());
+      return (fclose(file) == 0) && ok;
+    }
+
+  } // end of namespace headless
+} // end of namespace mars
@@ -0,0 +1,121 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file HeadlessRunner.h
+ * \brief Loads and steps a simulation without any graphics or GUI library.
+ */
+
+#ifndef HEADLESS_RUNNER_H
+#define HEADLESS_RUNNER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "HeadlessRunner.h"
+#endif
+
+#include <string>
+#include <vector>
+
+namespace lib_manager {
+  class LibManager;
+}
+
+namespace mars {
+
+  namespace interfaces {
+    class SimulatorInterface;
+  }
+
+  namespace data_broker {
+    class DataRecorder;
+  }
+
+  namespace headless {
+
+    /**
+     * The HeadlessRunner loads only the libraries needed to simulate a
+     * scene (data_broker, cfg_manager, mars_sim and the scene loaders)
+     * and steps the simulation in the calling thread as fast as possible.
+     * The physics thread of the simulator is not started, so there is no
+     * real time pacing and no handoff between threads per step.
+     *
+     * Optionally the DataBroker streams are recorded into a binary log
+     * (see data_broker::DataRecorder) and the final simulation state is
+     * written to a file (see SimulatorInterface::saveState).
+     */
+    class HeadlessRunner {
+    public:
+      HeadlessRunner();
+      HeadlessRunner(lib_manager::LibManager *theManager);
+      ~HeadlessRunner();
+
+      /**
+       * Reads the command line.
+       * \return \c false if the runner should exit, e.g. after "-h".
+       */
+      bool readArguments(int argc, char **argv);
+
+      /**
+       * Loads the libraries, the configuration and the scenes.
+       * \return \c false if the simulation could not be set up.
+       */
+      bool init();
+
+      /**
+       * Steps the simulation \a numSteps times, or the number given on
+       * the command line if \a numSteps is negative.
+       * \return The number of steps done.
+       */
+      long run(long numSteps = -1);
+
+      /** Stops a running run() after the current step. */
+      void requestStop();
+
+      interfaces::SimulatorInterface* getSimulator() const {
+        return sim;
+      }
+
+      std::string configDir;
+      std::vector<std::string> scenes;
+      long numSteps;
+      unsigned int seed;
+      std::string logFile, logGroup, logData;
+      std::string stateFile;
+      bool quiet;
+
+    private:
+      lib_manager::LibManager *libManager;
+      bool ownLibManager;
+      interfaces::SimulatorInterface *sim;
+      data_broker::DataRecorder *recorder;
+      std::vector<std::string> loadedLibs;
+      volatile bool stop;
+
+      void printHelp() const;
+      bool saveState() const;
+
+      HeadlessRunner(const HeadlessRunner &);
+      HeadlessRunner &operator=(const HeadlessRunner &);
+    }; // end of class HeadlessRunner
+
+  } // end of namespace headless
+} // end of namespace mars
+
+#endif // HEADLESS_RUNNER_H
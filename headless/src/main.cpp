@@ -0,0 +1,61 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file main.cpp
+ * \brief Runs a scene with the HeadlessRunner.
+ */
+
+#include "HeadlessRunner.h"
+
+#include <signal.h>
+#include <cstdio>
+
+static mars::headless::HeadlessRunner *runner = NULL;
+
+void stopHandler(int sig) {
+  (void)(sig);
+  if(runner) runner->requestStop();
+}
+
+int main(int argc, char *argv[]) {
+  signal(SIGINT, stopHandler);
+  signal(SIGTERM, stopHandler);
+
+  runner = new mars::headless::HeadlessRunner();
+  if(!runner->readArguments(argc, argv)) {
+    delete runner;
+    return 1;
+  }
+  if(runner->scenes.empty()) {
+    fprintf(stderr, "mars_headless: no scene given, see -h\n");
+    delete runner;
+    return 1;
+  }
+
+  int state = 0;
+  if(runner->init()) runner->run();
+  else state = 2;
+
+  mars::headless::HeadlessRunner *tmp = runner;
+  runner = NULL;
+  delete tmp;
+  return state;
+}
@@ -36,6 +36,7 @@ namespace mars {
 
     ControllerData::ControllerData() {
       rate = 20;
+      protocol = "ascii";
     }
 
     bool ControllerData::fromConfigMap(ConfigMap *config,
@@ -51,6 +52,7 @@ namespace mars {
       GET_VALUE("index", id, ULong);
       GET_VALUE("rate", rate, Double);
       dylib_path = config->get("dylib_path", dylib_path);
+      protocol = config->get("protocol", protocol);
 
       if((it = config->find("sensorid")) != config->end()) {
         ConfigVector _ids = (*config)["sensorid"];
@@ -99,6 +101,9 @@ namespace mars {
       SET_VALUE("index", id);
       SET_VALUE("rate", rate);
       SET_VALUE("dylib_path", dylib_path);
+      if(protocol != "ascii") {
+        SET_VALUE("protocol", protocol);
+      }
 
       for(it=sensors.begin(); it!=sensors.end(); ++it) {
         (*config)["sensorid"] << *it;
@@ -49,6 +49,12 @@ namespace mars {
       std::vector<unsigned long> sensors;
       std::vector<unsigned long> sNodes;
       std::string dylib_path;
+      /**
+       * The protocol of a socket controller: "ascii" (default), "binary"
+       * over tcp or "shm" for a binary controller on the same host. See
+       * ControllerProtocol.h.
+       */
+      std::string protocol;
     }; // end of class ControllerData
 
   } // end of namespace interfaces
@@ -0,0 +1,252 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ControllerProtocol.h
+ * \brief The binary protocol between the simulation and external
+ *        controllers.
+ *
+ * Every message starts with a ControllerMessageHeader. All integers and
+ * values are stored in little endian byte order; the values are float64.
+ * The simulation opens the connection and sends a schema message. The
+ * controller answers with a schema ack. After that the simulation sends
+ * one sensor message per control step and waits for the motor message.
+ * Both carry the frames of all controllers that use the same endpoint:
+ *
+ *  - CONTROLLER_MSG_SCHEMA: \c count ControllerSchemaEntry, each followed
+ *    by \c numSensors ControllerSchemaSensor and \c numMotors uint32
+ *    motor ids.
+ *  - CONTROLLER_MSG_SCHEMA_ACK: only the header, with the acknowledged
+ *    \c schemaId.
+ *  - CONTROLLER_MSG_SENSORS: the float64 sim time in ms, followed by
+ *    \c count ControllerFrameHeader, each followed by \c numValues
+ *    float64 sensor values in schema order.
+ *  - CONTROLLER_MSG_MOTORS: \c count ControllerFrameHeader, each followed
+ *    by \c numValues float64 motor values in schema order and
+ *    \c numCommands ControllerCommandHeader with \c numValues float64
+ *    values each. The command ids are the Command enum of MARSDefs.h.
+ *
+ * The shared memory transport uses a file created with shm_open(). It
+ * starts with a ControllerShmHeader padded to \c headerSize bytes and
+ * holds two rings, the first from the simulation to the controller and
+ * the second back. Each ring is a ControllerShmRing followed by
+ * \c ringSize bytes. head and tail count the written and read bytes; a
+ * message is published by advancing head after the message is written.
+ */
+
+#ifndef MARS_INTERFACES_CONTROLLER_PROTOCOL_H
+#define MARS_INTERFACES_CONTROLLER_PROTOCOL_H
+
+#ifdef _PRINT_HEADER_
+  #warning "ControllerProtocol.h"
+#endif
+
+#include <cstring>
+#include <stdint.h>
+
+#define CONTROLLER_PROTOCOL_MAGIC 0x4c54434d // "MCTL"
+#define CONTROLLER_PROTOCOL_VERSION 1
+#define CONTROLLER_SHM_MAGIC "MARSCTRL"
+#define CONTROLLER_SHM_DEFAULT_RING_SIZE (1 << 20)
+
+namespace mars {
+  namespace interfaces {
+
+    enum ControllerMessageType {
+      CONTROLLER_MSG_SCHEMA = 1,
+      CONTROLLER_MSG_SCHEMA_ACK = 2,
+      CONTROLLER_MSG_SENSORS = 3,
+      CONTROLLER_MSG_MOTORS = 4
+    };
+
+    enum ControllerFrameFlags {
+      CONTROLLER_FRAME_RESET_SIM = 1
+    };
+
+    struct ControllerMessageHeader {
+      uint32_t magic;
+      uint16_t version;
+      uint16_t type;      ///< ControllerMessageType
+      uint32_t size;      ///< including this header
+      uint32_t schemaId;  ///< the schema the message refers to
+      uint32_t sequence;
+      uint32_t count;     ///< number of entries / frames
+    };
+
+    struct ControllerSchemaEntry {
+      uint32_t controllerId;
+      uint32_t numSensors;
+      uint32_t numMotors;
+      uint32_t numSensorValues;
+    };
+
+    struct ControllerSchemaSensor {
+      uint32_t sensorId;
+      uint32_t numValues;
+    };
+
+    struct ControllerFrameHeader {
+      uint32_t controllerId;
+      uint32_t numValues;
+      uint32_t numCommands; ///< only used in motor frames
+      uint32_t flags;       ///< ControllerFrameFlags
+    };
+
+    struct ControllerCommandHeader {
+      uint32_t command;
+      uint32_t numValues;
+      uint64_t id;
+    };
+
+    struct ControllerShmHeader {
+      char magic[8];
+      uint32_t version;
+      uint32_t headerSize;
+      uint32_t ringSize;    ///< a power of two
+      uint32_t attached;    ///< set to 1 by the controller process
+      uint32_t reserved[2];
+    };
+
+    struct ControllerShmRing {
+      volatile uint32_t head;
+      uint32_t pad0[15];
+      volatile uint32_t tail;
+      uint32_t pad1[15];
+    };
+
+    /*
+     * Conversion from and to the little endian wire format. The structs
+     * above are written field by field with these functions.
+     */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    inline void controllerPutU32(char *p, uint32_t v) {
+      p[0] = (char)v; p[1] = (char)(v >> 8);
+      p[2] = (char)(v >> 16); p[3] = (char)(v >> 24);
+    }
+
+    inline uint32_t controllerGetU32(const char *p) {
+      const unsigned char *u = (const unsigned char*)p;
+      return (uint32_t)u[0] | ((uint32_t)u[1] << 8) |
+        ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+    }
+
+    inline void controllerPutU64(char *p, uint64_t v) {
+      controllerPutU32(p, (uint32_t)v);
+      controllerPutU32(p+4, (uint32_t)(v >> 32));
+    }
+
+    inline uint64_t controllerGetU64(const char *p) {
+      return (uint64_t)controllerGetU32(p) |
+        ((uint64_t)controllerGetU32(p+4) << 32);
+    }
+#else
+    inline void controllerPutU32(char *p, uint32_t v) {
+      memcpy(p, &v, sizeof(v));
+    }
+
+    inline uint32_t controllerGetU32(const char *p) {
+      uint32_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+
+    inline void controllerPutU64(char *p, uint64_t v) {
+      memcpy(p, &v, sizeof(v));
+    }
+
+    inline uint64_t controllerGetU64(const char *p) {
+      uint64_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+#endif
+
+    inline void controllerPutU16(char *p, uint16_t v) {
+      p[0] = (char)v; p[1] = (char)(v >> 8);
+    }
+
+    inline uint16_t controllerGetU16(const char *p) {
+      const unsigned char *u = (const unsigned char*)p;
+      return (uint16_t)(u[0] | (u[1] << 8));
+    }
+
+    inline void controllerPutF64(char *p, double v) {
+      uint64_t u;
+      memcpy(&u, &v, sizeof(u));
+      controllerPutU64(p, u);
+    }
+
+    inline double controllerGetF64(const char *p) {
+      uint64_t u = controllerGetU64(p);
+      double v;
+      memcpy(&v, &u, sizeof(v));
+      return v;
+    }
+
+    const uint32_t controllerMessageHeaderSize = 24;
+    const uint32_t controllerSchemaEntrySize = 16;
+    const uint32_t controllerSchemaSensorSize = 8;
+    const uint32_t controllerFrameHeaderSize = 16;
+    const uint32_t controllerCommandHeaderSize = 16;
+
+    inline void controllerPutHeader(char *p, const ControllerMessageHeader &h) {
+      controllerPutU32(p, h.magic);
+      controllerPutU16(p+4, h.version);
+      controllerPutU16(p+6, h.type);
+      controllerPutU32(p+8, h.size);
+      controllerPutU32(p+12, h.schemaId);
+      controllerPutU32(p+16, h.sequence);
+      controllerPutU32(p+20, h.count);
+    }
+
+    inline void controllerGetHeader(const char *p, ControllerMessageHeader *h) {
+      h->magic = controllerGetU32(p);
+      h->version = controllerGetU16(p+4);
+      h->type = controllerGetU16(p+6);
+      h->size = controllerGetU32(p+8);
+      h->schemaId = controllerGetU32(p+12);
+      h->sequence = controllerGetU32(p+16);
+      h->count = controllerGetU32(p+20);
+    }
+
+    inline void controllerPutFrame(char *p, const ControllerFrameHeader &f) {
+      controllerPutU32(p, f.controllerId);
+      controllerPutU32(p+4, f.numValues);
+      controllerPutU32(p+8, f.numCommands);
+      controllerPutU32(p+12, f.flags);
+    }
+
+    inline void controllerGetFrame(const char *p, ControllerFrameHeader *f) {
+      f->controllerId = controllerGetU32(p);
+      f->numValues = controllerGetU32(p+4);
+      f->numCommands = controllerGetU32(p+8);
+      f->flags = controllerGetU32(p+12);
+    }
+
+    inline void controllerGetCommand(const char *p, ControllerCommandHeader *c) {
+      c->command = controllerGetU32(p);
+      c->numValues = controllerGetU32(p+4);
+      c->id = controllerGetU64(p+8);
+    }
+
+  } // end of namespace interfaces
+} // end of namespace mars
+
+#endif // MARS_INTERFACES_CONTROLLER_PROTOCOL_H
@@ -0,0 +1,340 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file TiledHeightmap.cpp
+ * \brief A memory mapped heightmap file that is shared by the physics and
+ *        the graphics.
+ */
+
+#include "TiledHeightmap.h"
+
+#include <mars/utils/MutexLocker.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/stat.h>
+
+#ifndef WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace mars {
+  namespace interfaces {
+
+    static const std::size_t pageSize = 4096;
+
+    static std::size_t alignToPage(std::size_t size) {
+      return (size + pageSize - 1) & ~(pageSize - 1);
+    }
+
+    std::map<std::string, TiledHeightmap*> TiledHeightmap::heightmaps;
+    utils::Mutex TiledHeightmap::heightmapsMutex;
+
+    TiledHeightmap* TiledHeightmap::acquire(const std::string &filename) {
+      utils::MutexLocker locker(&heightmapsMutex);
+      std::map<std::string, TiledHeightmap*>::iterator it;
+      it = heightmaps.find(filename);
+      if(it != heightmaps.end()) {
+        it->second->references++;
+        return it->second;
+      }
+      TiledHeightmap *heightmap = new TiledHeightmap(filename);
+      if(!heightmap->open()) {
+        delete heightmap;
+        return NULL;
+      }
+      heightmap->references = 1;
+      heightmaps[filename] = heightmap;
+      return heightmap;
+    }
+
+    void TiledHeightmap::acquire() {
+      utils::MutexLocker locker(&heightmapsMutex);
+      references++;
+    }
+
+    void TiledHeightmap::release() {
+      utils::MutexLocker locker(&heightmapsMutex);
+      if(--references > 0) return;
+      heightmaps.erase(filename);
+      delete this;
+    }
+
+    TiledHeightmap::TiledHeightmap(const std::string &filename) :
+      filename(filename), width(0), height(0), tileSize(1), tilesX(0),
+      tilesY(0), tileBytes(0), sampleType(HEIGHT_SAMPLE_FLOAT), scale(1.0),
+      offset(0.0), tiles(NULL), mapping(NULL), mappingSize(0),
+      references(0) {
+    }
+
+    TiledHeightmap::~TiledHeightmap() {
+      close();
+    }
+
+    bool TiledHeightmap::open() {
+      TiledHeightmapHeader header;
+#ifndef WIN32
+      int fd = ::open(filename.c_str(), O_RDONLY);
+      if(fd < 0) return false;
+      struct stat fileStat;
+      if(fstat(fd, &fileStat) != 0 ||
+         (std::size_t)fileStat.st_size < sizeof(header)) {
+        ::close(fd);
+        return false;
+      }
+      mappingSize = fileStat.st_size;
+      void *data = mmap(NULL, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+      // the mapping stays valid after the file is closed
+      ::close(fd);
+      if(data == MAP_FAILED) return false;
+      mapping = (char*)data;
+#else
+      FILE *file = fopen(filename.c_str(), "rb");
+      if(!file) return false;
+      fseek(file, 0, SEEK_END);
+      long size = ftell(file);
+      fseek(file, 0, SEEK_SET);
+      if(size < (long)sizeof(header)) {
+        fclose(file);
+        return false;
+      }
+      buffer.resize(size);
+      bool ok = (fread(&buffer[0], 1, size, file) == (size_t)size);
+      fclose(file);
+      if(!ok) return false;
+      mapping = &buffer[0];
+      mappingSize = size;
+#endif
+
+      memcpy(&header, mapping, sizeof(header));
+      if(memcmp(header.magic, TILED_HEIGHTMAP_MAGIC, 8) ||
+         header.version != TILED_HEIGHTMAP_VERSION ||
+         header.headerSize < sizeof(header) || header.tileSize == 0 ||
+         header.width == 0 || header.height == 0 ||
+         header.sampleType > HEIGHT_SAMPLE_FLOAT) {
+        fprintf(stderr, "TiledHeightmap: invalid file %s\n", filename.c_str());
+        close();
+        return false;
+      }
+      width = header.width;
+      height = header.height;
+      tileSize = header.tileSize;
+      sampleType = header.sampleType;
+      scale = header.scale;
+      offset = header.offset;
+      tilesX = (width + tileSize - 1) / tileSize;
+      tilesY = (height + tileSize - 1) / tileSize;
+      std::size_t sampleSize = (sampleType == HEIGHT_SAMPLE_UINT16) ?
+        sizeof(uint16_t) : sizeof(float);
+      tileBytes = alignToPage((std::size_t)tileSize*tileSize*sampleSize);
+      if(header.headerSize + tilesX*tilesY*tileBytes > mappingSize) {
+        fprintf(stderr, "TiledHeightmap: file %s is truncated\n",
+                filename.c_str());
+        close();
+        return false;
+      }
+      tiles = mapping + header.headerSize;
+      userTiles.clear();
+      residentTiles.assign(tilesX*tilesY, false);
+      return true;
+    }
+
+    void TiledHeightmap::close() {
+#ifndef WIN32
+      if(mapping) munmap(mapping, mappingSize);
+#else
+      buffer.clear();
+#endif
+      mapping = NULL;
+      tiles = NULL;
+      mappingSize = 0;
+    }
+
+    bool TiledHeightmap::write(const std::string &filename,
+                               const double *pixelData, int width, int height,
+                               int tileSize, HeightSampleType type) {
+      if(width <= 0 || height <= 0 || tileSize <= 0) return false;
+
+      TiledHeightmapHeader header;
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, TILED_HEIGHTMAP_MAGIC, 8);
+      header.version = TILED_HEIGHTMAP_VERSION;
+      header.headerSize = pageSize;
+      header.width = width;
+      header.height = height;
+      header.tileSize = tileSize;
+      header.sampleType = type;
+      header.scale = 1.0f;
+      header.offset = 0.0f;
+
+      std::size_t numSamples = (std::size_t)width*height;
+      if(type == HEIGHT_SAMPLE_UINT16) {
+        // map the range of the samples onto the 16 bit values
+        double min = pixelData[0], max = pixelData[0];
+        for(std::size_t i=1; i<numSamples; ++i) {
+          if(pixelData[i] < min) min = pixelData[i];
+          if(pixelData[i] > max) max = pixelData[i];
+        }
+        header.offset = min;
+        header.scale = (max > min) ? (max - min) / 65535.0 : 1.0;
+      }
+
+      std::string tmpFilename = filename + ".tmp";
+      FILE *file = fopen(tmpFilename.c_str(), "wb");
+      if(!file) return false;
+      std::vector<char> page(pageSize, 0);
+      memcpy(&page[0], &header, sizeof(header));
+      bool ok = fwrite(&page[0], 1, pageSize, file) == pageSize;
+
+      std::size_t tilesX = (width + tileSize - 1) / tileSize;
+      std::size_t tilesY = (height + tileSize - 1) / tileSize;
+      std::size_t sampleSize = (type == HEIGHT_SAMPLE_UINT16) ?
+        sizeof(uint16_t) : sizeof(float);
+      std::vector<char> tile(alignToPage((std::size_t)tileSize*tileSize*
+                                         sampleSize));
+      for(std::size_t ty=0; ok && ty<tilesY; ++ty) {
+        for(std::size_t tx=0; ok && tx<tilesX; ++tx) {
+          std::fill(tile.begin(), tile.end(), 0);
+          for(int y=0; y<tileSize; ++y) {
+            std::size_t py = ty*tileSize + y;
+            if(py >= (std::size_t)height) break;
+            for(int x=0; x<tileSize; ++x) {
+              std::size_t px = tx*tileSize + x;
+              if(px >= (std::size_t)width) break;
+              double v = pixelData[py*width + px];
+              std::size_t index = (std::size_t)y*tileSize + x;
+              if(type == HEIGHT_SAMPLE_UINT16) {
+                double s = floor((v - header.offset) / header.scale + 0.5);
+                if(s < 0) s = 0;
+                if(s > 65535) s = 65535;
+                ((uint16_t*)&tile[0])[index] = (uint16_t)s;
+              }
+              else {
+                ((float*)&tile[0])[index] = (float)v;
+              }
+            }
+          }
+          ok = fwrite(&tile[0], 1, tile.size(), file) == tile.size();
+        }
+      }
+      if(fclose(file) != 0) ok = false;
+#ifdef WIN32
+      // rename does not replace an existing file on windows
+      if(ok) remove(filename.c_str());
+#endif
+      if(ok && rename(tmpFilename.c_str(), filename.c_str()) != 0) ok = false;
+      if(!ok) remove(tmpFilename.c_str());
+      return ok;
+    }
+
+    bool TiledHeightmap::isUpToDate(const std::string &filename,
+                                    const std::string &sourceFilename) {
+      struct stat fileStat, sourceStat;
+      if(stat(filename.c_str(), &fileStat) != 0) return false;
+      if(stat(sourceFilename.c_str(), &sourceStat) != 0) return true;
+      return fileStat.st_mtime >= sourceStat.st_mtime;
+    }
+
+    void TiledHeightmap::getHeights(int x, int y, int w, int h,
+                                    double *heights) const {
+      for(int j=0; j<h; ++j) {
+        for(int i=0; i<w; ++i) {
+          *(heights++) = getHeight(x+i, y+j);
+        }
+      }
+    }
+
+    void TiledHeightmap::updateResidency(const void *user,
+                                         const std::vector<double> &points,
+                                         double radius) {
+      std::vector<bool> needed(tilesX*tilesY, false);
+      for(std::size_t i=0; i+1<points.size(); i+=2) {
+        int x0 = (int)floor((points[i] - radius) / tileSize);
+        int x1 = (int)floor((points[i] + radius) / tileSize);
+        int y0 = (int)floor((points[i+1] - radius) / tileSize);
+        int y1 = (int)floor((points[i+1] + radius) / tileSize);
+        if(x0 < 0) x0 = 0;
+        if(y0 < 0) y0 = 0;
+        if(x1 >= (int)tilesX) x1 = tilesX-1;
+        if(y1 >= (int)tilesY) y1 = tilesY-1;
+        for(int ty=y0; ty<=y1; ++ty) {
+          for(int tx=x0; tx<=x1; ++tx) {
+            needed[ty*tilesX + tx] = true;
+          }
+        }
+      }
+
+      utils::MutexLocker locker(&residencyMutex);
+      userTiles[user].swap(needed);
+      updateResidentTiles();
+    }
+
+    void TiledHeightmap::removeResidencyUser(const void *user) {
+      utils::MutexLocker locker(&residencyMutex);
+      if(userTiles.erase(user)) {
+        updateResidentTiles();
+      }
+    }
+
+    /**
+     * Advises the tiles whose state in the union of the user sets changed.
+     * The residencyMutex has to be locked.
+     */
+    void TiledHeightmap::updateResidentTiles() {
+      std::vector<bool> needed(tilesX*tilesY, false);
+      std::map<const void*, std::vector<bool> >::const_iterator it;
+      for(it=userTiles.begin(); it!=userTiles.end(); ++it) {
+        for(std::size_t i=0; i<needed.size(); ++i) {
+          if(it->second[i]) needed[i] = true;
+        }
+      }
+      for(std::size_t i=0; i<needed.size(); ++i) {
+        if(needed[i] != residentTiles[i]) {
+          adviseTile(i, needed[i]);
+        }
+      }
+      residentTiles.swap(needed);
+    }
+
+    std::size_t TiledHeightmap::getNumResidentTiles() const {
+      utils::MutexLocker locker(&residencyMutex);
+      return std::count(residentTiles.begin(), residentTiles.end(), true);
+    }
+
+    void TiledHeightmap::adviseTile(std::size_t tile, bool needed) const {
+#ifndef WIN32
+      // the file is mapped read only, so released pages are read again
+      // from the page cache or the file on the next access
+      void *address = (void*)(tiles + tile*tileBytes);
+      madvise(address, tileBytes, needed ? MADV_WILLNEED : MADV_DONTNEED);
+#else
+      (void)tile;
+      (void)needed;
+#endif
+    }
+
+  } // end of namespace interfaces
+} // end of namespace mars
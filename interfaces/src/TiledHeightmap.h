@@ -0,0 +1,191 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file TiledHeightmap.h
+ * \brief A memory mapped heightmap file that is shared by the physics and
+ *        the graphics.
+ *
+ * The file starts with a TiledHeightmapHeader padded to \c headerSize
+ * bytes. It is followed by the tiles in row major order. Every tile holds
+ * tileSize x tileSize samples in row major order and is padded to a
+ * multiple of 4096 bytes, so that single tiles can be paged in and out.
+ * The tiles at the right and bottom border are padded with zeros. All
+ * values are stored in host byte order.
+ */
+
+#ifndef TILED_HEIGHTMAP_H
+#define TILED_HEIGHTMAP_H
+
+#ifdef _PRINT_HEADER_
+  #warning "TiledHeightmap.h"
+#endif
+
+#include <mars/utils/Mutex.h>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#define TILED_HEIGHTMAP_MAGIC "MARSHMAP"
+#define TILED_HEIGHTMAP_VERSION 1
+#define TILED_HEIGHTMAP_SUFFIX ".mth"
+
+namespace mars {
+  namespace interfaces {
+
+    enum HeightSampleType {
+      HEIGHT_SAMPLE_UINT16 = 0, ///< value = sample * scale + offset
+      HEIGHT_SAMPLE_FLOAT = 1
+    };
+
+    struct TiledHeightmapHeader {
+      char magic[8];
+      uint32_t version;
+      uint32_t headerSize;
+      uint32_t width;
+      uint32_t height;
+      uint32_t tileSize;
+      uint32_t sampleType;  ///< HeightSampleType
+      float scale;
+      float offset;
+      uint32_t reserved[2];
+    };
+
+    /**
+     * The TiledHeightmap maps a heightmap file once per process. All
+     * terrains that use the same file share the mapping, so the samples
+     * exist only once in memory, in the page cache. The heights have the
+     * same meaning as terrainStruct::pixelData: (x, y) is column and row
+     * and the value is scaled by terrainStruct::scale.
+     *
+     * The pages of a tile are only read if the tile is accessed.
+     * updateResidency() additionally prefetches the tiles around a set
+     * of points. Every user of the heightmap has its own set of tiles;
+     * the pages of the tiles that no user needs are given back to the
+     * system.
+     */
+    class TiledHeightmap {
+    public:
+      /**
+       * Returns the heightmap of \a filename and increases its reference
+       * count. The file is opened on the first call.
+       * \return \c NULL if the file could not be read.
+       */
+      static TiledHeightmap* acquire(const std::string &filename);
+      /** Increases the reference count. */
+      void acquire();
+      /** Decreases the reference count and closes the file at zero. */
+      void release();
+
+      /**
+       * Writes \a pixelData (\a width x \a height values in row major
+       * order, as in terrainStruct) into a tiled heightmap file. The file
+       * is written under a temporary name and renamed at the end, so a
+       * mapping of the old file stays valid.
+       */
+      static bool write(const std::string &filename, const double *pixelData,
+                        int width, int height, int tileSize = 256,
+                        HeightSampleType type = HEIGHT_SAMPLE_UINT16);
+
+      /**
+       * \return \c true if \a filename exists and was modified after
+       * \a sourceFilename, i.e. a conversion of the source can be used.
+       */
+      static bool isUpToDate(const std::string &filename,
+                             const std::string &sourceFilename);
+
+      const std::string& getFilename() const {return filename;}
+      int getWidth() const {return width;}
+      int getHeight() const {return height;}
+      int getTileSize() const {return tileSize;}
+      std::size_t getNumTiles() const {return tilesX*tilesY;}
+
+      inline double getHeight(int x, int y) const {
+        int tx = x / tileSize, ty = y / tileSize;
+        std::size_t index = (std::size_t)(y - ty*tileSize)*tileSize +
+          (x - tx*tileSize);
+        const char *tile = tiles + (ty*tilesX + tx)*tileBytes;
+        if(sampleType == HEIGHT_SAMPLE_UINT16) {
+          return ((const uint16_t*)tile)[index]*scale + offset;
+        }
+        return ((const float*)tile)[index];
+      }
+
+      /**
+       * Copies the \a w x \a h heights starting at (\a x, \a y) row by row
+       * into \a heights.
+       */
+      void getHeights(int x, int y, int w, int h, double *heights) const;
+
+      /**
+       * Replaces the tiles of \a user by the tiles within \a radius
+       * samples of the points. The new tiles are prefetched and the pages
+       * of the tiles that no user needs anymore are released.
+       * \param user Identifies the caller, e.g. its terrain.
+       * \param points Pairs of x and y in sample coordinates.
+       */
+      void updateResidency(const void *user, const std::vector<double> &points,
+                           double radius);
+      /**
+       * Drops the tiles of \a user; has to be called before the user
+       * releases the heightmap.
+       */
+      void removeResidencyUser(const void *user);
+      /** The number of tiles that are requested by any user. */
+      std::size_t getNumResidentTiles() const;
+
+    private:
+      TiledHeightmap(const std::string &filename);
+      ~TiledHeightmap();
+
+      bool open();
+      void close();
+      void adviseTile(std::size_t tile, bool needed) const;
+      void updateResidentTiles();
+
+      static std::map<std::string, TiledHeightmap*> heightmaps;
+      static utils::Mutex heightmapsMutex;
+
+      std::string filename;
+      int width, height, tileSize;
+      std::size_t tilesX, tilesY, tileBytes;
+      uint32_t sampleType;
+      double scale, offset;
+      const char *tiles;
+      char *mapping;
+      std::size_t mappingSize;
+      std::vector<char> buffer;
+      int references;
+      // the tiles needed by every user and the union of them
+      std::map<const void*, std::vector<bool> > userTiles;
+      std::vector<bool> residentTiles;
+      mutable utils::Mutex residencyMutex;
+
+      TiledHeightmap(const TiledHeightmap &);
+      TiledHeightmap &operator=(const TiledHeightmap &);
+    }; // end of class TiledHeightmap
+
+  } // end of namespace interfaces
+} // end of namespace mars
+
+#endif // TILED_HEIGHTMAP_H
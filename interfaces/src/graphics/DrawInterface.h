@@ -32,6 +32,7 @@ namespace mars {
   namespace interfaces {
 
     struct draw_item;
+    struct drawBatch;
 
     /**
      * The interface DrawInterface is used for updating draw_item structs via an update function
@@ -44,6 +45,12 @@ namespace mars {
        * structs contained in drawItems
        */
       virtual void update(std::vector<draw_item> *drawItems) = 0;
+      /**
+       * Refills the batch of debug lines, points and texts. It is called
+       * every frame after update(). Drawing through the batch avoids a
+       * scene graph node per primitive.
+       */
+      virtual void updateBatch(drawBatch *batch) {(void)batch;}
       virtual ~DrawInterface(){}
     }; // end of class DrawInterface
 
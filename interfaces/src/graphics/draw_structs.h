@@ -36,6 +36,8 @@
 #include <mars/utils/Color.h>
 #include <mars/utils/Vector.h>
 
+#include <algorithm>
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -102,6 +104,99 @@ namespace mars {
       int resolution;
     }; // end of struct draw_item
 
+    struct drawBatchText {
+      mars::utils::Vector pos;
+      mars::utils::Color color;
+      mars::interfaces::sReal size;
+      std::string text;
+    }; // end of struct drawBatchText
+
+    /**
+     * \brief drawBatch collects the debug lines, points and labels of one
+     * DrawInterface.
+     *
+     * The batch is refilled by DrawInterface::updateBatch() every frame and
+     * is drawn with one vertex buffer per primitive type. clear() keeps the
+     * memory, so a batch of constant size does not allocate.
+     */
+    struct drawBatch {
+      // x, y, z of the start and end vertex of every line
+      std::vector<float> lines;
+      // r, g, b, a of every line vertex
+      std::vector<float> lineColors;
+      // x, y, z of every point
+      std::vector<float> points;
+      // r, g, b, a of every point
+      std::vector<float> pointColors;
+      std::vector<drawBatchText> texts;
+      std::size_t numTexts;
+      mars::interfaces::sReal lineWidth;
+      mars::interfaces::sReal pointSize;
+
+      drawBatch() : numTexts(0), lineWidth(1.0), pointSize(1.0) {}
+
+      void clear() {
+        lines.clear();
+        lineColors.clear();
+        points.clear();
+        pointColors.clear();
+        // the strings of the texts are reused
+        numTexts = 0;
+      }
+
+      void swap(drawBatch &other) {
+        lines.swap(other.lines);
+        lineColors.swap(other.lineColors);
+        points.swap(other.points);
+        pointColors.swap(other.pointColors);
+        texts.swap(other.texts);
+        std::swap(numTexts, other.numTexts);
+        std::swap(lineWidth, other.lineWidth);
+        std::swap(pointSize, other.pointSize);
+      }
+
+      bool empty() const {
+        return lines.empty() && points.empty() && numTexts == 0;
+      }
+
+      void addLine(const mars::utils::Vector &start,
+                   const mars::utils::Vector &end,
+                   const mars::utils::Color &color) {
+        addVertex(&lines, &lineColors, start, color);
+        addVertex(&lines, &lineColors, end, color);
+      }
+
+      void addPoint(const mars::utils::Vector &pos,
+                    const mars::utils::Color &color) {
+        addVertex(&points, &pointColors, pos, color);
+      }
+
+      void addText(const mars::utils::Vector &pos, const std::string &text,
+                   const mars::utils::Color &color,
+                   mars::interfaces::sReal size) {
+        if(numTexts == texts.size()) texts.push_back(drawBatchText());
+        drawBatchText &t = texts[numTexts++];
+        t.pos = pos;
+        t.text = text;
+        t.color = color;
+        t.size = size;
+      }
+
+    private:
+      static void addVertex(std::vector<float> *vertices,
+                            std::vector<float> *colors,
+                            const mars::utils::Vector &v,
+                            const mars::utils::Color &c) {
+        vertices->push_back(v.x());
+        vertices->push_back(v.y());
+        vertices->push_back(v.z());
+        colors->push_back(c.r);
+        colors->push_back(c.g);
+        colors->push_back(c.b);
+        colors->push_back(c.a);
+      }
+    }; // end of struct drawBatch
+
     /** \brief drawStruct connects a vector of draw_item objects with
      * their update interface DrawInterface
      */
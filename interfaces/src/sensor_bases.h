@@ -31,6 +31,9 @@
 #include <mars/utils/Quaternion.h>
 #include <mars/utils/Vector.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
 #include <limits>
 
@@ -74,14 +77,74 @@ namespace mars {
         return name;
       }
 
+      /**
+       * \brief Returns the number of values of the sensor, i.e. the size of
+       *        the buffer readSensorData() needs.
+       *
+       * Returns -1 for sensors that only implement getSensorData().
+       */
+      virtual int getSensorDataSize() const{
+        return -1;
+      }
+
+      /**
+       * \brief Writes the values of the sensor into a buffer of the caller.
+       *
+       * At most \a size values are written; sensors with a fixed layout
+       * write nothing if the buffer is too small.
+       * \return The number of values of the sensor.
+       */
+      virtual int readSensorData(double *data, int size) const{
+        // fallback for sensors that only implement getSensorData()
+        double *values = 0;
+        int n = getSensorData(&values);
+        if(values) {
+          memcpy(data, values, sizeof(double)*std::min(n, size));
+          free(values);
+        }
+        return n;
+      }
+
+      /**
+       * \brief Returns the values in a buffer allocated with calloc() that
+       *        the caller has to free.
+       *
+       * Sensors implement getSensorDataSize() and readSensorData(); this
+       * method is kept for older callers. Callers that read a sensor
+       * often should reuse a buffer with readSensorData().
+       */
       virtual int getSensorData(double **data) const{
-        return 0;
-      };
+        int n = getSensorDataSize();
+        if(n <= 0) {
+          *data = 0;
+          return 0;
+        }
+        *data = (double*)calloc(n, sizeof(double));
+        return readSensorData(*data, n);
+      }
 
       virtual int getAsciiData(char *data) const{
         return 0;
       }
 
+      /**
+       * \brief Returns the number of values the sensor keeps between two
+       *        updates, i.e. its part of a saved simulation state.
+       *
+       * Sensors that compute their values on request have no state.
+       */
+      virtual int getStateSize() const{
+        return 0;
+      }
+
+      /** \brief Writes getStateSize() values into \a state. */
+      virtual void getState(double *state) const{
+      }
+
+      /** \brief Restores the values written by getState(). */
+      virtual void setState(const double *state){
+      }
+
       void getCoreExchange(core_objects_exchange* obj) const{
         obj->index = id;
         obj->name = name;
@@ -245,13 +308,33 @@ namespace mars {
       }
       virtual ~BasePolarIntersectionSensor(){}
 
-      virtual int getSensorData(double **data) const{
-        (*data) = (new double[this->data.size()]);
-        memcpy((*data),&this->data[0],sizeof(double)*this->data.size());
+      virtual int getSensorDataSize() const{
         return this->data.size();
-      };
+      }
 
+      virtual int readSensorData(double *data, int size) const{
+        int n = this->data.size();
+        if(n && size > 0) {
+          memcpy(data, &this->data[0], sizeof(double)*std::min(n, size));
+        }
+        return n;
+      }
+
+      virtual int getStateSize() const{
+        return this->data.size();
+      }
 
+      virtual void getState(double *state) const{
+        if(!this->data.empty()) {
+          memcpy(state, &this->data[0], sizeof(double)*this->data.size());
+        }
+      }
+
+      virtual void setState(const double *state){
+        if(!this->data.empty()) {
+          memcpy(&this->data[0], state, sizeof(double)*this->data.size());
+        }
+      }
 
       double stepX;
       double stepY;
@@ -274,6 +357,21 @@ namespace mars {
       }
       virtual ~BaseGridIntersectionSensor(){}
 
+      virtual int getStateSize() const{
+        return this->data.size();
+      }
+
+      virtual void getState(double *state) const{
+        if(!this->data.empty()) {
+          memcpy(state, &this->data[0], sizeof(double)*this->data.size());
+        }
+      }
+
+      virtual void setState(const double *state){
+        if(!this->data.empty()) {
+          memcpy(&this->data[0], state, sizeof(double)*this->data.size());
+        }
+      }
 
       double stepX;
       double stepY;
@@ -106,6 +106,8 @@ namespace mars {
       data_broker::DataBrokerInterface *dataBroker;
       LoadCenter *loadCenter;
 
+      /** The DataBroker used by the LOG_* macros; shared by all
+          simulator instances of the process. */
       static data_broker::DataBrokerInterface *theDataBroker;
     };
 
@@ -38,6 +38,8 @@
 
 #include "../MotorData.h"
 
+#include <vector>
+
 namespace mars {
 
   namespace sim {
@@ -324,6 +326,17 @@ namespace mars {
       virtual void connectMimics() = 0;
       virtual void edit(MotorId id, const std::string &key,
                         const std::string &value) = 0;
+
+      /** Appends the controller state of all motors to \a state. */
+      virtual void saveState(std::vector<char> *state) const = 0;
+      /**
+       * Reads the motor state written by saveState and moves \a data
+       * behind it. With \a apply set to \c false the state is only
+       * checked.
+       * \return \c false if the state does not match the motors.
+       */
+      virtual bool restoreState(const char **data, const char *end,
+                                bool apply) = 0;
     }; // class MotorManagerInterface
 
   } // end of namespace interfaces
@@ -38,6 +38,7 @@
 #include "../sensor_bases.h"
 #include "../NodeData.h"
 #include "../nodeState.h"
+#include "NodeStateCache.h"
 
 #include <mars/utils/Vector.h>
 #include <mars/utils/Quaternion.h>
@@ -791,6 +792,30 @@ namespace mars {
        */
       virtual void edit(NodeId id, const std::string &key,
                         const std::string &value) = 0;
+
+      /**
+       * Returns the state of the dynamic nodes of the last step. The cache
+       * is only consistent within the simulation thread; it is refilled
+       * by every step.
+       */
+      virtual const NodeStateCache* getNodeStateCache() const = 0;
+
+      /** Copies the state of the dynamic nodes of the last step. */
+      virtual void getNodeStates(NodeStateCache *states) const = 0;
+
+      /**
+       * Appends the physical state of all dynamic nodes to \a state; see
+       * SimulatorInterface::saveState.
+       */
+      virtual void saveState(std::vector<char> *state) const = 0;
+      /**
+       * Reads the node state written by saveState and moves \a data
+       * behind it. With \a apply set to \c false the state is only
+       * checked.
+       * \return \c false if the state does not match the nodes.
+       */
+      virtual bool restoreState(const char **data, const char *end,
+                                bool apply) = 0;
     };
 
   } // end of namespace interfaces
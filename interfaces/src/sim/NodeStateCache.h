@@ -0,0 +1,129 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file NodeStateCache.h
+ * \brief "NodeStateCache" holds the physical state of all dynamic nodes
+ *        as structure of arrays.
+ */
+
+#ifndef NODE_STATE_CACHE_H
+#define NODE_STATE_CACHE_H
+
+#ifdef _PRINT_HEADER_
+  #warning "NodeStateCache.h"
+#endif
+
+#include "../MARSDefs.h"
+
+#include <mars/utils/Vector.h>
+#include <mars/utils/Quaternion.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace mars {
+  namespace interfaces {
+
+    /**
+     * The state of the dynamic nodes as it was read from the physics after
+     * the last step. The values of node \c i are stored at
+     * \c positions[3*i], \c rotations[4*i] (x, y, z, w), and so on.
+     *
+     * The NodeManager fills the cache in one pass while the world is
+     * locked. Within the simulation thread, e.g. in plugin updates or
+     * DataBroker callbacks of the step, the cache can be read directly;
+     * other threads should copy it with
+     * NodeManagerInterface::getNodeStates.
+     */
+    struct NodeStateCache {
+      unsigned long step; ///< Incremented every time the cache is filled.
+      std::vector<NodeId> ids;
+      std::vector<sReal> positions;
+      std::vector<sReal> rotations;
+      std::vector<sReal> linearVelocities;
+      std::vector<sReal> angularVelocities;
+      std::vector<sReal> forces;
+      std::vector<sReal> torques;
+      std::vector<char> groundContacts;
+      std::vector<sReal> groundContactForces;
+
+      NodeStateCache() : step(0) {}
+
+      std::size_t size() const {
+        return ids.size();
+      }
+
+      void resize(std::size_t numNodes) {
+        ids.resize(numNodes);
+        positions.resize(3*numNodes);
+        rotations.resize(4*numNodes);
+        linearVelocities.resize(3*numNodes);
+        angularVelocities.resize(3*numNodes);
+        forces.resize(3*numNodes);
+        torques.resize(3*numNodes);
+        groundContacts.resize(numNodes);
+        groundContactForces.resize(numNodes);
+      }
+
+      utils::Vector getPosition(std::size_t i) const {
+        return getVector(positions, i);
+      }
+
+      utils::Quaternion getRotation(std::size_t i) const {
+        const sReal *q = &rotations[4*i];
+        return utils::Quaternion(q[3], q[0], q[1], q[2]);
+      }
+
+      utils::Vector getLinearVelocity(std::size_t i) const {
+        return getVector(linearVelocities, i);
+      }
+
+      utils::Vector getAngularVelocity(std::size_t i) const {
+        return getVector(angularVelocities, i);
+      }
+
+      utils::Vector getForce(std::size_t i) const {
+        return getVector(forces, i);
+      }
+
+      utils::Vector getTorque(std::size_t i) const {
+        return getVector(torques, i);
+      }
+
+      bool getGroundContact(std::size_t i) const {
+        return groundContacts[i] != 0;
+      }
+
+      sReal getGroundContactForce(std::size_t i) const {
+        return groundContactForces[i];
+      }
+
+    private:
+      static utils::Vector getVector(const std::vector<sReal> &v,
+                                     std::size_t i) {
+        return utils::Vector(v[3*i], v[3*i+1], v[3*i+2]);
+      }
+    }; // end of struct NodeStateCache
+
+  } // end of namespace interfaces
+} // end of namespace mars
+
+#endif  // NODE_STATE_CACHE_H
@@ -35,12 +35,15 @@
 
 #include <mars/utils/Vector.h>
 
+#include <cstddef>
+#include <string>
 #include <vector>
 
 namespace mars {
   namespace interfaces {
 
     class NodeInterface;
+    struct NodeStateCache;
 
     enum PhysicsError {
       PHYSICS_NO_ERROR = 0,
@@ -58,6 +61,11 @@ namespace mars {
       bool fast_step;
       bool draw_contact_points;
       sReal world_cfm, world_erp;
+      int sensor_threads; /**< Threads used for the sensor update; 0 or 1
+                             updates the sensors with the nodes */
+      std::string space_type; /**< Broad phase: "hash", "sap" or "quadtree" */
+      int space_hash_min_level, space_hash_max_level;
+      int space_quadtree_depth;
 
       virtual ~PhysicsInterface() {}
       virtual void initTheWorld(void) = 0;
@@ -67,6 +75,27 @@ namespace mars {
       virtual const utils::Vector getCenterOfMass(const std::vector<NodeInterface*> &nodes) const = 0;
       virtual int checkCollisions(void) = 0;
       virtual sReal getVectorCollision(const utils::Vector &pos, const utils::Vector &ray) const = 0;
+      /**
+       * Reads the state of all \a nodes into \a cache with the world
+       * locked only once. The entry \c i of the cache belongs to
+       * \c nodes[i]; the ids are left untouched.
+       */
+      virtual void getNodeStates(const std::vector<NodeInterface*> &nodes,
+                                 NodeStateCache *cache) const = 0;
+      /**
+       * The number of values getBodyStates writes for every node. The
+       * layout of the values is up to the physics implementation.
+       */
+      virtual std::size_t getBodyStateSize(void) const = 0;
+      /**
+       * Copies the complete dynamic state of the bodies of \a nodes, i.e.
+       * pose, velocities and accumulated forces, to \a states.
+       */
+      virtual void getBodyStates(const std::vector<NodeInterface*> &nodes,
+                                 sReal *states) const = 0;
+      /** Restores states that were read by getBodyStates. */
+      virtual void setBodyStates(const std::vector<NodeInterface*> &nodes,
+                                 const sReal *states) = 0;
     };
 
   } // end of namespace interfaces
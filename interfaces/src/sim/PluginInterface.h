@@ -35,19 +35,37 @@
 #include <mars/interfaces/MARSDefs.h> // for sReal
 
 #include <string>
+#include <vector>
 
 namespace mars {
   namespace interfaces {
 
     class ControlCenter;
 
+    /**
+     * The data a plugin reads and writes in its update call. The node and
+     * motor ids are the ids of the NodeManager and MotorManager; the
+     * DataBroker topics are given as "groupName/dataName" and may contain
+     * wildcards.
+     *
+     * Plugins whose sets do not overlap may be updated in parallel by the
+     * Simulator (see the "Simulator/plugin threads" parameter).
+     */
+    struct PluginAccessSet {
+      std::vector<unsigned long> readNodes, writeNodes;
+      std::vector<unsigned long> readMotors, writeMotors;
+      std::vector<std::string> readTopics, writeTopics;
+    };
+
     /**
      * The interface to load plugin dynamically into the simulation
      *
      */
     class PluginInterface {
     public:
-      PluginInterface(ControlCenter *control) { this->control = control; };
+      PluginInterface(ControlCenter *control) : noDataAccess(false) {
+        this->control = control;
+      };
       virtual ~PluginInterface(void) {};
       virtual void update(sReal time_ms) = 0;
       virtual void reset(void) = 0;
@@ -55,9 +73,31 @@ namespace mars {
       virtual void handleError(void) {};
       virtual void getSomeData(void* data) {(void)data;};
 
+      /**
+       * Is called by the Simulator whenever the plugins or the scene
+       * change. A plugin that fills \a accessSet and returns \c true
+       * promises to only touch that data in update() and may then run in
+       * parallel to other plugins. The default returns \c false and keeps
+       * the plugin exclusive, i.e. it is updated alone and in order, unless
+       * the plugin called setNoDataAccess().
+       */
+      virtual bool getAccessSet(PluginAccessSet *accessSet) {
+        (void)accessSet;
+        return noDataAccess;
+      };
+
     protected:
       ControlCenter *control;
 
+      /**
+       * Declares that update() touches no simulation data, so the plugin
+       * never has to wait for other plugins.
+       */
+      void setNoDataAccess(void) {noDataAccess = true;}
+
+    private:
+      bool noDataAccess;
+
     };
 
     typedef void *pDestroyPlugin(PluginInterface *sp);
@@ -154,6 +154,35 @@ namespace mars {
        * \param index The index of the sensor to get the data 
        */
       virtual int getSensorData(unsigned long id, sReal **data) const = 0;
+
+      /**
+       * \brief Returns the number of values of the sensor with the given
+       * id, or 0 if there is no such sensor.
+       */
+      virtual int getSensorDataSize(unsigned long id) const = 0;
+
+      /**
+       * \brief Writes the values of a sensor into a buffer of the caller.
+       *
+       * \return The number of values of the sensor; nothing is written
+       * beyond \a size.
+       */
+      virtual int readSensorData(unsigned long id, sReal *data,
+                                 int size) const = 0;
+
+      /**
+       * \brief Reads the values of \a numSensors sensors one after
+       * another into one block.
+       *
+       * \param offsets If not \c NULL, it receives \a numSensors+1
+       * entries: the values of sensor \c i start at \c offsets[i].
+       * \return The number of values of all sensors. If it is larger than
+       * \a size, the block was too small and the sensors that did not fit
+       * are missing.
+       */
+      virtual int readSensorData(const unsigned long *ids, int numSensors,
+                                 sReal *data, int size,
+                                 int *offsets = 0) const = 0;
   
       /**
        *\brief Returns the number of sensors that are currently present in the simulation.
@@ -197,6 +226,19 @@ namespace mars {
                                              BaseConfig *config,
                                              bool reload=false)=0;
 
+      /**
+       * Appends the values the sensors keep between two updates to
+       * \a state; see SimulatorInterface::saveState.
+       */
+      virtual void saveState(std::vector<char> *state) const = 0;
+      /**
+       * Reads the sensor state written by saveState and moves \a data
+       * behind it. With \a apply set to \c false the state is only
+       * checked.
+       * \return \c false if the state does not match the sensors.
+       */
+      virtual bool restoreState(const char **data, const char *end,
+                                bool apply) = 0;
 
     }; // class SensorManagerInterface
 
@@ -0,0 +1,83 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file SimState.h
+ * \brief Helpers to write and read the binary simulation state of
+ *        SimulatorInterface::saveState.
+ *
+ * The state is a sequence of blocks in host byte order. Every block is
+ * padded to a multiple of 8 bytes, so arrays of sReal or ids can be read
+ * in place.
+ */
+
+#ifndef SIM_STATE_H
+#define SIM_STATE_H
+
+#ifdef _PRINT_HEADER_
+  #warning "SimState.h"
+#endif
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#define SIM_STATE_MAGIC "MARSSTAT"
+#define SIM_STATE_VERSION 2
+
+namespace mars {
+  namespace interfaces {
+
+    inline std::size_t getStateBlockSize(std::size_t size) {
+      return (size + 7) & ~(std::size_t)7;
+    }
+
+    /**
+     * Appends a block of \a size bytes to \a state and returns a pointer to
+     * it. The pointer is valid until the next change of \a state.
+     */
+    inline char* reserveStateBlock(std::vector<char> *state, std::size_t size) {
+      std::size_t offset = state->size();
+      state->resize(offset + getStateBlockSize(size), 0);
+      return &(*state)[0] + offset;
+    }
+
+    inline void appendStateBlock(std::vector<char> *state, const void *data,
+                                 std::size_t size) {
+      if(size) memcpy(reserveStateBlock(state, size), data, size);
+    }
+
+    /**
+     * Returns a pointer to the next block of \a size bytes and moves
+     * \a data behind it, or returns NULL if \a end is reached before.
+     */
+    inline const char* consumeStateBlock(const char **data, const char *end,
+                                         std::size_t size) {
+      const char *block = *data;
+      std::size_t blockSize = getStateBlockSize(size);
+      if((std::size_t)(end - block) < blockSize) return NULL;
+      *data += blockSize;
+      return block;
+    }
+
+  } // end of namespace interfaces
+} // end of namespace mars
+
+#endif  // SIM_STATE_H
@@ -111,12 +111,39 @@ namespace mars {
       virtual void removePlugin(PluginInterface *pl) = 0;
       virtual void switchPluginUpdateMode(int mode, PluginInterface *pl) = 0;
       virtual void sendDataToPlugin(int plugin_index, void* data) = 0;
+      /**
+       * Makes the Simulator ask all plugins for their access sets again
+       * before the next step. A plugin calls this when the data it touches
+       * in update() changed.
+       */
+      virtual void updatePluginAccessSets(void) = 0;
 
       /*
        *  returns the calculated simulation time + the start timestamp
        */
       virtual unsigned long getTime() = 0;
 
+      /*
+       *  returns the calculated simulation time in ms
+       */
+      virtual double getSimTime() = 0;
+
+      /**
+       * Writes the dynamic state of the loaded scene into \a state: the
+       * sim time, the poses, velocities and forces of all bodies, the
+       * controller state of all motors and the values the sensors keep
+       * between two updates. The format is described in SimState.h.
+       */
+      virtual void saveState(std::vector<char> *state) = 0;
+      /**
+       * Restores a state written by saveState for the same scene. The
+       * nodes, joints, motors and sensors are not recreated and the graphics are
+       * not touched.
+       * \return \c false if the state does not belong to the scene; the
+       *         simulation is then left unchanged.
+       */
+      virtual bool restoreState(const std::vector<char> &state) = 0;
+
     };
 
 
@@ -22,6 +22,7 @@
 #define MARS_CORE_TERRAIN_STRUCT_H
 
 #include "MaterialData.h"
+#include "TiledHeightmap.h"
 #include <string>
 
 namespace mars {
@@ -39,6 +40,7 @@ namespace mars {
           texScaleX(0.1),
           texScaleY(0.1),
           pixelData(NULL),
+          tiles(NULL),
           mesh(0) {}
 
       std::string name; //the joints name
@@ -51,8 +53,17 @@ namespace mars {
       double scale;
       double texScaleX, texScaleY; // texture scaling - a value of 0 will fit the complete terrain
       double *pixelData;
+      // used instead of pixelData for tiled heightmap files (*.mth); the
+      // owner of the struct holds one reference
+      TiledHeightmap *tiles;
       int mesh;
 
+      /** Returns the value of pixelData or of the tiled heightmap. */
+      double getPixel(int x, int y) const {
+        if(pixelData) return pixelData[y*width+x];
+        return tiles->getHeight(x, y);
+      }
+
     }; // end of struct terrainStruct
 
   } // end of namespace interfaces
@@ -44,6 +44,7 @@ namespace mars {
 
       Plot3D::Plot3D(lib_manager::LibManager *theManager)
         : MarsPluginTemplateGUI(theManager, "Plot3D"), myWidget(NULL) {
+        setNoDataAccess();
       }
 
       void Plot3D::init() {
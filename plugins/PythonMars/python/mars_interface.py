@@ -3,6 +3,20 @@ from time import clock
 iDict = {}
 startTime = clock()
 
+# NumPy arrays of the bound nodes, sensors and motors. They share their
+# buffers with the plugin and are updated in place every step. Each array
+# keeps its buffer alive, so a kept array is always safe to read, but it
+# is only updated as long as it is bound. A sensor array has a fixed
+# capacity; sensorCounts holds the number of valid values (see
+# sensorData). If a sensor outgrows its capacity, sensors[name] is
+# replaced by a larger array.
+nodes = {}
+sensors = {}
+sensorCounts = None
+sensorIndex = {}
+motors = None
+motorIndex = {}
+
 def timing(s):
     global startTime
     currentTime = clock()
@@ -104,3 +118,55 @@ def pushData(group, name, dataName, value):
     if not "ToDataBroker" in iDict:
         iDict["ToDataBroker"] = []
     iDict["ToDataBroker"].append({"g":group, "n":name, "d":dataName, "v":value})
+
+def _bind(kind, name):
+    global iDict
+    if not "bind" in iDict:
+        iDict["bind"] = {"nodes": [], "sensors": [], "motors": []}
+    iDict["bind"][kind].append(name)
+
+# nodes[name] becomes the array [x, y, z, qx, qy, qz, qw]
+def bindNode(name):
+    _bind("nodes", name)
+
+# sensors[name] becomes the array of the sensor values, sensorData(name)
+# returns the valid part of it
+def bindSensor(name):
+    _bind("sensors", name)
+
+# the value set by commandMotor is applied after update returned
+def bindMotor(name):
+    _bind("motors", name)
+
+def commandMotor(name, value):
+    motors[motorIndex[name]] = value
+
+def sensorData(name):
+    return sensors[name][:int(sensorCounts[sensorIndex[name]])]
+
+def clearArrays():
+    global motors, sensorCounts
+    nodes.clear()
+    sensors.clear()
+    sensorCounts = None
+    sensorIndex.clear()
+    motors = None
+    motorIndex.clear()
+
+def addNodeArray(name, array):
+    nodes[name] = array
+
+def addSensorArray(name, array, index):
+    sensors[name] = array
+    sensorIndex[name] = index
+
+def setSensorCountArray(array):
+    global sensorCounts
+    sensorCounts = array
+
+def setMotorArray(array):
+    global motors
+    motors = array
+
+def addMotorIndex(name, index):
+    motorIndex[name] = index
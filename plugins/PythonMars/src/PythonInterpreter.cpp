@@ -11,6 +11,7 @@
 #include <list>
 #include <cstdarg>
 #include <sstream>
+#include <algorithm>
 
 using namespace configmaps;
 
@@ -387,6 +388,24 @@ struct ListBuilderState
             args.push_back(makePyObjectPtr(obj));
             break;
         }
+        case SHAREDARRAY:
+        {
+            SharedArray* array = va_arg(cppArgs, SharedArray*);
+            const int offset = va_arg(cppArgs, int);
+            const int size = va_arg(cppArgs, int);
+            npy_intp dims[1] = {(npy_intp) size};
+            PyObject *obj = PyArray_SimpleNewFromData(1, dims, NPY_DOUBLE,
+                                                      (void*)(array->data()+offset));
+            if(obj)
+            {
+                // the array keeps the block alive
+                PyObject *owner = (PyObject*)array->getOwner();
+                Py_INCREF(owner);
+                PyArray_SetBaseObject((PyArrayObject*)obj, owner);
+            }
+            args.push_back(makePyObjectPtr(obj));
+            break;
+        }
         default:
             throw std::runtime_error("Unknown function argument type");
         }
@@ -394,6 +413,44 @@ struct ListBuilderState
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//////////////////////// Shared arrays /////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
+static void freeSharedArray(PyObject* capsule)
+{
+    delete[] (double*)PyCapsule_GetPointer(capsule, NULL);
+}
+
+SharedArray::SharedArray()
+    : owner(NULL), values(NULL), numValues(0)
+{
+}
+
+SharedArray::~SharedArray()
+{
+    if(owner && Py_IsInitialized())
+        Py_DECREF((PyObject*)owner);
+}
+
+void SharedArray::assign(std::size_t size, double value)
+{
+    // one extra value so that data() is valid for an empty array
+    double* block = new double[size+1];
+    std::fill(block, block+size+1, value);
+    PyObject* capsule = PyCapsule_New(block, NULL, freeSharedArray);
+    if(!capsule)
+    {
+        delete[] block;
+        throwPythonException();
+    }
+    // NumPy arrays made from the old block keep their own reference
+    Py_XDECREF((PyObject*)owner);
+    owner = capsule;
+    values = block;
+    numValues = size;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //////////////////////// Public interface //////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
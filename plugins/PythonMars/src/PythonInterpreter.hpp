@@ -19,6 +19,7 @@
  */
 
 #pragma once
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <configmaps/ConfigData.h>
@@ -68,7 +69,37 @@ public:
   
 enum CppType
 {
-  INT, DOUBLE, BOOL, STRING, ONEDARRAY, ONEDCARRAY, OBJECT, MAP
+  INT, DOUBLE, BOOL, STRING, ONEDARRAY, ONEDCARRAY, OBJECT, MAP, SHAREDARRAY
+};
+
+/**
+ * A block of doubles that is passed to python without a copy. The block
+ * belongs to a python object that every NumPy array made from it
+ * references, so the arrays stay valid when the SharedArray gets a new
+ * block or is destroyed.
+ *
+ * SHAREDARRAY takes three arguments: the SharedArray*, the offset and
+ * the number of values of the NumPy array.
+ */
+class SharedArray
+{
+    void *owner;
+    double *values;
+    std::size_t numValues;
+
+    SharedArray(const SharedArray&);
+    SharedArray& operator=(const SharedArray&);
+public:
+    SharedArray();
+    ~SharedArray();
+
+    /** Replaces the block by a new one of \a size values. */
+    void assign(std::size_t size, double value);
+    std::size_t size() const {return numValues;}
+    double* data() {return values;}
+    double& operator[](std::size_t i) {return values[i];}
+    const double& operator[](std::size_t i) const {return values[i];}
+    void* getOwner() const {return owner;}
 };
 
 class Object
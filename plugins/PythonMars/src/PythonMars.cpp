@@ -35,7 +35,10 @@
 #include <mars/interfaces/graphics/GraphicsManagerInterface.h>
 #include <mars/data_broker/DataPackage.h>
 #include <mars/utils/misc.h>
+#include <mars/utils/MutexLocker.h>
+#include <limits>
 #ifdef __unix__
+#include <algorithm>
 #include <dlfcn.h>
 #endif
 namespace mars {
@@ -91,6 +94,7 @@ namespace mars {
         pythonException = false;
         gui->addGenericMenuAction("../PythonMars/Reload", 1, this);
         try {
+          pyInterface = PythonInterpreter::instance().import("mars_interface");
           plugin = PythonInterpreter::instance().import("mars_plugin");
           ConfigItem map;
           toConfigMap(plugin->function("init").call().returnObject(), map);
@@ -149,7 +153,8 @@ namespace mars {
                   unsigned long id = control->motors->getID(name);
                   if(id) {
                     motorMap[name] = id;
-                    control->motors->setMotorValue(id, value);
+                    newMotorValues[id] = value;
+                    control->sim->updatePluginAccessSets();
                   }
                 }
                 else {
@@ -212,8 +217,16 @@ namespace mars {
             map.erase(iit);
           }
 
+          if(map.hasKey("bind") && map["bind"].isMap()) {
+            bindArrays(map["bind"]);
+            ConfigMap::iterator it = map.find("bind");
+            map.erase(it);
+          }
+
           if(map.hasKey("request") && map["request"].isVector()) {
             requestMap = map["request"];
+            configHandles.clear();
+            control->sim->updatePluginAccessSets();
             ConfigMap::iterator it = map.find("request");
             map.erase(it);
           }
@@ -223,7 +236,7 @@ namespace mars {
           guiMapMutex.unlock();
 
         }
-        nextStep = true;
+        signalNextStep();
       }
 
       void PythonMars::interpreteGuiMaps() {
@@ -274,9 +287,10 @@ namespace mars {
               std::string name = it->first;
               if(cameras.find(name) == cameras.end()) {
                 unsigned long id = control->sensors->getSensorID(name);
-                sReal *data;
-                int num = control->sensors->getSensorData(id, &data);
-                if(num) {
+                int num = control->sensors->getSensorDataSize(id);
+                if(num > 0) {
+                  sReal *data = (sReal*)calloc(num, sizeof(sReal));
+                  control->sensors->readSensorData(id, data, num);
                   CameraStruct cam = {id, data, NULL, num};
                   cam.pydata = (sReal*)malloc(num*sizeof(sReal));
                   cameras[name] = cam;
@@ -285,12 +299,8 @@ namespace mars {
               }
               else {
                 CameraStruct &cam = cameras[name];
-                sReal *data;
-                int num = control->sensors->getSensorData(cam.id, &data);
-                if(num == cam.size) {
-                  memcpy(cam.data, data, num*sizeof(sReal));
-                }
-                if(num) free(data);
+                // the image is read directly into the buffer of the camera
+                control->sensors->readSensorData(cam.id, cam.data, cam.size);
               }
             }
             mutexCamera.unlock();
@@ -377,13 +387,23 @@ namespace mars {
             }
           }
         }
-        nextStep = true;
+        signalNextStep();
         guiMaps.clear();
         guiMapMutex.unlock();
       }
 
       void PythonMars::reset() {
         motorMap.clear();
+        newMotorValues.clear();
+        configHandles.clear();
+        // the ids are resolved again by the next step
+        std::fill(binding.nodeIds.begin(), binding.nodeIds.end(), 0);
+        std::fill(binding.sensorIds.begin(), binding.sensorIds.end(), 0);
+        std::fill(binding.motorIds.begin(), binding.motorIds.end(), 0);
+        // the motors start from their initial values again, so every
+        // command has to be applied once more
+        std::fill(binding.appliedMotors.begin(), binding.appliedMotors.end(),
+                  std::numeric_limits<double>::quiet_NaN());
         //plugin->reload();
       }
 
@@ -405,7 +425,10 @@ namespace mars {
             gpMutex.unlock();
             return;
           }
-          while(!nextStep) utils::msleep(2);
+          stepMutex.lock();
+          while(!nextStep) stepCondition.wait(&stepMutex);
+          stepMutex.unlock();
+          readBoundArrays();
           ConfigMap sendMap;
 
           ConfigVector::iterator it = requestMap.begin();
@@ -430,41 +453,30 @@ namespace mars {
 
             if(type == "Sensor") {
               unsigned long id = control->sensors->getSensorID(name);
-              sReal *data;
-              int num = control->sensors->getSensorData(id, &data);
+              int num = control->sensors->getSensorDataSize(id);
+              if(num > (int)sensorBuffer.size()) sensorBuffer.resize(num);
+              if(num > 0) {
+                num = std::min(num, control->sensors->readSensorData(id, &sensorBuffer[0], num));
+              }
               for(int i=0; i<num; ++i) {
-                sendMap["Sensors"][name][i] = data[i];
+                sendMap["Sensors"][name][i] = sensorBuffer[i];
               }
-              if(num) free(data);
             }
 
             if(type == "Config") {
               if(!it->hasKey("group")) continue;
               std::string group = (*it)["group"];
-              cfg_manager::cfgParamInfo info;
-              info = control->cfg->getParamInfo(group, name);
-              switch(info.type) {
+              const ConfigHandle &handle = getConfigHandle(group, name);
+              switch(handle.type) {
               case cfg_manager::boolParam:
-                {
-                  bool v;
-                  control->cfg->getPropertyValue(group, name, "value", &v);
-                  sendMap["Config"][group][name] = v;
-                  break;
-                }
+                sendMap["Config"][group][name] = handle.bHandle.get();
+                break;
               case cfg_manager::doubleParam:
-                {
-                  double v;
-                  control->cfg->getPropertyValue(group, name, "value", &v);
-                  sendMap["Config"][group][name] = v;
-                  break;
-                }
+                sendMap["Config"][group][name] = handle.dHandle.get();
+                break;
               case cfg_manager::intParam:
-                {
-                  int v;
-                  control->cfg->getPropertyValue(group, name, "value", &v);
-                  sendMap["Config"][group][name] = v;
-                  break;
-                }
+                sendMap["Config"][group][name] = handle.iHandle.get();
+                break;
               case cfg_manager::stringParam:
                 {
                   std::string v;
@@ -491,8 +503,16 @@ namespace mars {
             mutexCamera.unlock();
             mutex.lock();
             toConfigMap(plugin->function("update").pass(MAP).call(&sendMap).returnObject(), iMap);
-            nextStep = true;
+            signalNextStep();
             mutex.unlock();
+            if(control->sim->isSimRunning()) {
+              std::map<unsigned long, double>::iterator it;
+              for(it=newMotorValues.begin(); it!=newMotorValues.end(); ++it) {
+                control->motors->setMotorValue(it->first, it->second);
+              }
+              newMotorValues.clear();
+              applyBoundMotors();
+            }
             mutexPoints.lock();
             { // udpate point clouds
               std::map<std::string, PointStruct>::iterator it = points.begin();
@@ -548,12 +568,272 @@ namespace mars {
         // control->motors->setMotorValue(id, value);
       }
 
+      /**
+       * update() reads the bound and requested nodes and sensors and
+       * writes the bound motors and the motors commanded by name. The
+       * names are resolved here, so nodes loaded after the binding are
+       * part of the set after the next scene change. The sensors are not
+       * written by plugins and need no entry.
+       */
+      bool PythonMars::getAccessSet(PluginAccessSet *accessSet) {
+        MutexLocker locker(&gpMutex);
+        const ArrayBinding &b = binding;
+        unsigned long id;
+        for(size_t i=0; i<b.nodeNames.size(); ++i) {
+          if((id = control->nodes->getID(b.nodeNames[i]))) {
+            accessSet->readNodes.push_back(id);
+          }
+        }
+        ConfigVector::iterator it = requestMap.begin();
+        for(; it!=requestMap.end(); ++it) {
+          if(!it->hasKey("type") || !it->hasKey("name")) continue;
+          std::string type = (*it)["type"];
+          std::string name = (*it)["name"];
+          if(type != "Node") continue;
+          if((id = control->nodes->getID(name))) {
+            accessSet->readNodes.push_back(id);
+          }
+        }
+        for(size_t i=0; i<b.motorNames.size(); ++i) {
+          if((id = control->motors->getID(b.motorNames[i]))) {
+            accessSet->writeMotors.push_back(id);
+          }
+        }
+        std::map<std::string, unsigned long>::iterator mt = motorMap.begin();
+        for(; mt!=motorMap.end(); ++mt) {
+          accessSet->writeMotors.push_back(mt->second);
+        }
+        return true;
+      }
+
       void PythonMars::receiveData(const data_broker::DataInfo& info,
                                     const data_broker::DataPackage& package,
                                     int id) {
         // package.get("force1/x", force);
       }
 
+      void PythonMars::signalNextStep() {
+        stepMutex.lock();
+        nextStep = true;
+        stepCondition.wakeAll();
+        stepMutex.unlock();
+      }
+
+      void PythonMars::bindArrays(ConfigItem &bind) {
+        if(!pyInterface) return;
+        ArrayBinding &b = binding;
+        // drop the arrays of the old binding on the python side
+        pyInterface->function("clearArrays").call();
+
+        b.nodeNames.clear();
+        b.sensorNames.clear();
+        b.motorNames.clear();
+        if(bind.hasKey("nodes") && bind["nodes"].isVector()) {
+          ConfigVector::iterator it = bind["nodes"].begin();
+          for(; it!=bind["nodes"].end(); ++it) {
+            std::string name = *it;
+            b.nodeNames.push_back(name);
+          }
+        }
+        if(bind.hasKey("sensors") && bind["sensors"].isVector()) {
+          ConfigVector::iterator it = bind["sensors"].begin();
+          for(; it!=bind["sensors"].end(); ++it) {
+            std::string name = *it;
+            b.sensorNames.push_back(name);
+          }
+        }
+        if(bind.hasKey("motors") && bind["motors"].isVector()) {
+          ConfigVector::iterator it = bind["motors"].begin();
+          for(; it!=bind["motors"].end(); ++it) {
+            std::string name = *it;
+            b.motorNames.push_back(name);
+          }
+        }
+
+        b.nodeIds.resize(b.nodeNames.size());
+        b.nodes.assign(b.nodeNames.size()*7, 0.0);
+        for(size_t i=0; i<b.nodeNames.size(); ++i) {
+          b.nodeIds[i] = control->nodes->getID(b.nodeNames[i]);
+        }
+
+        b.sensorIds.resize(b.sensorNames.size());
+        for(size_t i=0; i<b.sensorNames.size(); ++i) {
+          b.sensorIds[i] = control->sensors->getSensorID(b.sensorNames[i]);
+        }
+        b.sensorOffsets.clear();
+        layoutSensorArrays();
+
+        b.motorIds.resize(b.motorNames.size());
+        b.motors.assign(b.motorNames.size(),
+                        std::numeric_limits<double>::quiet_NaN());
+        b.appliedMotors.assign(b.motorNames.size(),
+                               std::numeric_limits<double>::quiet_NaN());
+        for(size_t i=0; i<b.motorNames.size(); ++i) {
+          b.motorIds[i] = control->motors->getID(b.motorNames[i]);
+        }
+        passBoundArrays();
+        control->sim->updatePluginAccessSets();
+      }
+
+      /**
+       * Gives every bound sensor a slice in the sensor block. A slice keeps
+       * its capacity from the last layout and only grows if the sensor has
+       * more values than fit, so variable-size sensors settle after a few
+       * steps. The arrays passed before stay valid since python owns a
+       * reference to the old block.
+       */
+      void PythonMars::layoutSensorArrays() {
+        ArrayBinding &b = binding;
+        std::vector<int> offsets(b.sensorIds.size()+1, 0);
+        for(size_t i=0; i<b.sensorIds.size(); ++i) {
+          int capacity = 0;
+          if(i+1 < b.sensorOffsets.size()) {
+            capacity = b.sensorOffsets[i+1] - b.sensorOffsets[i];
+          }
+          int num = 0;
+          if(b.sensorIds[i]) {
+            num = control->sensors->getSensorDataSize(b.sensorIds[i]);
+          }
+          if(num > capacity) capacity = std::max(num, 2*capacity);
+          offsets[i+1] = offsets[i] + capacity;
+        }
+        b.sensorOffsets.swap(offsets);
+        b.sensors.assign(b.sensorOffsets.back(), 0.0);
+        b.sensorCounts.assign(b.sensorIds.size(), 0.0);
+      }
+
+      void PythonMars::passBoundArrays() {
+        ArrayBinding &b = binding;
+        for(size_t i=0; i<b.nodeNames.size(); ++i) {
+          pyInterface->function("addNodeArray").pass(STRING).pass(SHAREDARRAY).call(&b.nodeNames[i], &b.nodes, (int)i*7, 7);
+        }
+        passSensorArrays();
+        pyInterface->function("setMotorArray").pass(SHAREDARRAY).call(&b.motors, 0, (int)b.motorNames.size());
+        for(size_t i=0; i<b.motorNames.size(); ++i) {
+          pyInterface->function("addMotorIndex").pass(STRING).pass(INT).call(&b.motorNames[i], (int)i);
+        }
+      }
+
+      void PythonMars::passSensorArrays() {
+        ArrayBinding &b = binding;
+        pyInterface->function("setSensorCountArray").pass(SHAREDARRAY).call(&b.sensorCounts, 0, (int)b.sensorNames.size());
+        for(size_t i=0; i<b.sensorNames.size(); ++i) {
+          int offset = b.sensorOffsets[i];
+          pyInterface->function("addSensorArray").pass(STRING).pass(SHAREDARRAY).pass(INT).call(&b.sensorNames[i], &b.sensors, offset, b.sensorOffsets[i+1]-offset, (int)i);
+        }
+      }
+
+      void PythonMars::readBoundArrays() {
+        ArrayBinding &b = binding;
+        for(size_t i=0; i<b.nodeIds.size(); ++i) {
+          if(!b.nodeIds[i]) {
+            b.nodeIds[i] = control->nodes->getID(b.nodeNames[i]);
+            if(!b.nodeIds[i]) continue;
+          }
+          Vector pos = control->nodes->getPosition(b.nodeIds[i]);
+          Quaternion rot = control->nodes->getRotation(b.nodeIds[i]);
+          double *node = &b.nodes[i*7];
+          node[0] = pos.x();
+          node[1] = pos.y();
+          node[2] = pos.z();
+          node[3] = rot.x();
+          node[4] = rot.y();
+          node[5] = rot.z();
+          node[6] = rot.w();
+        }
+        if(!readBoundSensors() && pyInterface) {
+          // a sensor has more values than its slice holds, so the sensor
+          // block is laid out again with more room
+          layoutSensorArrays();
+          passSensorArrays();
+          readBoundSensors();
+        }
+      }
+
+      /**
+       * Reads every bound sensor into its slice and stores the number of
+       * values in sensorCounts.
+       * \return false if a sensor has more values than its slice holds
+       */
+      bool PythonMars::readBoundSensors() {
+        ArrayBinding &b = binding;
+        bool fits = true;
+        for(size_t i=0; i<b.sensorIds.size(); ++i) {
+          if(!b.sensorIds[i]) {
+            b.sensorIds[i] = control->sensors->getSensorID(b.sensorNames[i]);
+            if(!b.sensorIds[i]) continue;
+          }
+          int offset = b.sensorOffsets[i];
+          int size = b.sensorOffsets[i+1] - offset;
+          // returns the current number of values, nothing beyond size is
+          // written
+          int num = control->sensors->readSensorData(b.sensorIds[i],
+                                                     b.sensors.data()+offset,
+                                                     size);
+          num = std::max(num, 0);
+          if(num > size) fits = false;
+          b.sensorCounts[i] = std::min(num, size);
+        }
+        return fits;
+      }
+
+      void PythonMars::applyBoundMotors() {
+        ArrayBinding &b = binding;
+        for(size_t i=0; i<b.motorIds.size(); ++i) {
+          double value = b.motors[i];
+          // skip NaN and values that did not change
+          if(value != value || value == b.appliedMotors[i]) continue;
+          if(!b.motorIds[i]) {
+            b.motorIds[i] = control->motors->getID(b.motorNames[i]);
+            if(!b.motorIds[i]) continue;
+          }
+          control->motors->setMotorValue(b.motorIds[i], value);
+          b.appliedMotors[i] = value;
+        }
+      }
+
+      const ConfigHandle& PythonMars::getConfigHandle(const std::string &group,
+                                                      const std::string &name) {
+        ConfigHandle &handle = configHandles[group + "/" + name];
+        // resolve again if the param did not exist or was removed
+        bool valid = false;
+        switch(handle.type) {
+        case cfg_manager::boolParam:
+          valid = handle.bHandle.isValid();
+          break;
+        case cfg_manager::doubleParam:
+          valid = handle.dHandle.isValid();
+          break;
+        case cfg_manager::intParam:
+          valid = handle.iHandle.isValid();
+          break;
+        case cfg_manager::stringParam:
+          valid = true;
+          break;
+        default:
+          break;
+        }
+        if(!valid) {
+          cfg_manager::cfgParamInfo info;
+          info = control->cfg->getParamInfo(group, name);
+          handle.type = info.type;
+          switch(info.type) {
+          case cfg_manager::boolParam:
+            handle.bHandle = control->cfg->getHandle<bool>(info.id);
+            break;
+          case cfg_manager::doubleParam:
+            handle.dHandle = control->cfg->getHandle<double>(info.id);
+            break;
+          case cfg_manager::intParam:
+            handle.iHandle = control->cfg->getHandle<int>(info.id);
+            break;
+          default:
+            break;
+          }
+        }
+        return handle;
+      }
+
       void PythonMars::cfgUpdateProperty(cfg_manager::cfgPropertyStruct _property) {
 
         if(_property.paramId == example.paramId) {
@@ -567,6 +847,8 @@ namespace mars {
           gpMutex.lock();
           pythonException = false;
           try {
+            if(!pyInterface)
+              pyInterface = PythonInterpreter::instance().import("mars_interface");
             if(plugin)
               plugin->reload();
             else
@@ -40,6 +40,7 @@
 #include <mars/data_broker/ReceiverInterface.h>
 #include <mars/cfg_manager/CFGManagerInterface.h>
 #include <mars/utils/Mutex.h>
+#include <mars/utils/WaitCondition.h>
 #include <osg_points/Points.hpp>
 #include <osg_points/PointsFactory.hpp>
 #include <osg_lines/Lines.h>
@@ -48,6 +49,7 @@
 #include "PythonInterpreter.hpp"
 
 #include <string>
+#include <vector>
 
 namespace mars {
 
@@ -71,6 +73,36 @@ namespace mars {
         int size;
       };
 
+      // resolved param of a "Config" request
+      struct ConfigHandle {
+        cfg_manager::cfgParamType type;
+        cfg_manager::CfgHandle<double> dHandle;
+        cfg_manager::CfgHandle<int> iHandle;
+        cfg_manager::CfgHandle<bool> bHandle;
+        ConfigHandle() : type(cfg_manager::noParam) {}
+      };
+
+      /**
+       * The nodes, sensors and motors bound by the python script. Their
+       * values are exchanged through NumPy arrays that point into these
+       * buffers, so nothing is converted per step.
+       */
+      struct ArrayBinding {
+        std::vector<std::string> nodeNames, sensorNames, motorNames;
+        std::vector<unsigned long> nodeIds, sensorIds, motorIds;
+        // x, y, z, qx, qy, qz, qw of every node
+        SharedArray nodes;
+        // one slice per sensor; a slice keeps its capacity and the
+        // current number of values is stored in sensorCounts
+        SharedArray sensors;
+        SharedArray sensorCounts;
+        std::vector<int> sensorOffsets;
+        // the commands written by python; NaN means no command
+        SharedArray motors;
+        // the last commands passed to the motors
+        std::vector<double> appliedMotors;
+      };
+
       // inherit from MarsPluginTemplateGUI for extending the gui
       class PythonMars: public mars::interfaces::MarsPluginTemplateGUI,
         public mars::data_broker::ReceiverInterface,
@@ -93,6 +125,7 @@ namespace mars {
         void init();
         void reset();
         void update(mars::interfaces::sReal time_ms);
+        bool getAccessSet(mars::interfaces::PluginAccessSet *accessSet);
 
         void interpreteMap(configmaps::ConfigItem &map);
         void interpreteGuiMaps();
@@ -115,6 +148,9 @@ namespace mars {
         utils::Mutex gpMutex, mutex, guiMapMutex, mutexPoints, mutexCamera;
         shared_ptr<Module> plugin;
         std::map<std::string, unsigned long> motorMap;
+        // commands of motors that are not in the access set yet; they are
+        // applied in the next step
+        std::map<unsigned long, double> newMotorValues;
         configmaps::ConfigItem requestMap;
         bool pythonException;
         std::map<std::string, PointStruct> points;
@@ -127,6 +163,28 @@ namespace mars {
         configmaps::ConfigItem iMap;
         double updateTime;
         std::vector<configmaps::ConfigMap> guiMaps;
+        // reused for the values of the requested sensors
+        std::vector<double> sensorBuffer;
+        // handles of the requested config values by "group/name"
+        std::map<std::string, ConfigHandle> configHandles;
+
+        const ConfigHandle& getConfigHandle(const std::string &group,
+                                            const std::string &name);
+
+        shared_ptr<Module> pyInterface;
+        ArrayBinding binding;
+        // set when python is ready for the next step
+        utils::Mutex stepMutex;
+        utils::WaitCondition stepCondition;
+
+        void signalNextStep();
+        void bindArrays(configmaps::ConfigItem &bind);
+        void layoutSensorArrays();
+        void passBoundArrays();
+        void passSensorArrays();
+        void readBoundArrays();
+        bool readBoundSensors();
+        void applyBoundMotors();
 
         }; // end of class definition PythonMars
 
@@ -72,6 +72,7 @@ namespace mars {
 
       SkyDomePlugin::SkyDomePlugin(lib_manager::LibManager *theManager)
         : MarsPluginTemplateGUI(theManager, "SkyDomePlugin") {
+        setNoDataAccess();
       }
 
       void SkyDomePlugin::init() {
@@ -43,6 +43,7 @@ namespace mars {
 
       Text3D::Text3D(lib_manager::LibManager *theManager)
         : MarsPluginTemplate(theManager, "Text3D"), maskId(0) {
+        setNoDataAccess();
       }
 
       void Text3D::init() {
@@ -146,6 +146,7 @@ namespace mars {
               fprintf(stderr, "Adding female connector: %s\n", ((std::string)(tmpmap["name"])).c_str());
             }
           }
+          control->sim->updatePluginAccessSets();
         }
       }
 
@@ -206,6 +207,25 @@ namespace mars {
         }
       }
 
+      /**
+       * update() reads the poses of the connector nodes and joins or
+       * separates them, which changes both nodes. Without autoconnect and
+       * breakable it does nothing.
+       */
+      bool Connectors::getAccessSet(interfaces::PluginAccessSet *accessSet) {
+        if(!cfgautoconnect.bValue && !cfgbreakable.bValue) return true;
+        std::map<std::string, configmaps::ConfigMap>::iterator it;
+        for(it=maleconnectors.begin(); it!=maleconnectors.end(); ++it) {
+          unsigned long id = it->second["nodeid"];
+          accessSet->writeNodes.push_back(id);
+        }
+        for(it=femaleconnectors.begin(); it!=femaleconnectors.end(); ++it) {
+          unsigned long id = it->second["nodeid"];
+          accessSet->writeNodes.push_back(id);
+        }
+        return true;
+      }
+
       void Connectors::receiveData(const data_broker::DataInfo& info,
                                     const data_broker::DataPackage& package,
                                     int id) {
@@ -218,6 +238,7 @@ namespace mars {
         } else if(_property.paramId == cfgbreakable.paramId) {
           cfgbreakable.bValue = _property.bValue;
         }
+        control->sim->updatePluginAccessSets();
       }
 
       void Connectors::menuAction(int action, bool checked) {
@@ -70,6 +70,7 @@ namespace mars {
         void init();
         void reset();
         void update(mars::interfaces::sReal time_ms);
+        bool getAccessSet(mars::interfaces::PluginAccessSet *accessSet);
         void connect(std::string male, std::string female);
         void disconnect(std::string connector);
 
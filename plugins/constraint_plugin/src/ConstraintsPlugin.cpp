@@ -64,6 +64,7 @@ namespace mars {
         interfaces::MarsPluginTemplate(theManager, "constraints_plugin") {
         control->cfg->registerToCFG(this);
         gui = theManager->getLibraryAs<main_gui::GuiInterface>("main_gui");
+        setNoDataAccess();
       }
                    
 
@@ -40,6 +40,7 @@ namespace mars {
 
       EntityView::EntityView(lib_manager::LibManager *theManager)
         : MarsPluginTemplateGUI(theManager, "entity_view") {
+        setNoDataAccess();
       }
 
       void EntityView::init() {
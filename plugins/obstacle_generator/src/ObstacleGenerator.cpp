@@ -46,6 +46,7 @@ namespace mars {
       ObstacleGenerator::ObstacleGenerator(lib_manager::LibManager *theManager)
         : MarsPluginTemplate(theManager, "ObstacleGenerator") {
         sigma = 0.001;
+        setNoDataAccess();
       }
   
       void ObstacleGenerator::init() {
@@ -0,0 +1,112 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file BenchmarkScene.h
+ * \brief Helpers to build plain ode scenes in a WorldPhysics for the
+ *        benchmark programs.
+ *
+ */
+
+#ifndef BENCHMARK_SCENE_H
+#define BENCHMARK_SCENE_H
+
+#include "WorldPhysics.h"
+#include "NodePhysics.h"
+
+#include <mars/utils/misc.h>
+
+#include <cstdlib>
+#include <vector>
+
+namespace mars {
+  namespace sim {
+    namespace benchmark {
+
+      /**
+       * The geoms of a benchmark scene. The geoms carry a geom_data like
+       * the geoms of a NodePhysics, so the collision callback of the
+       * WorldPhysics handles them the same way.
+       */
+      class BenchmarkScene {
+      public:
+        explicit BenchmarkScene(WorldPhysics *world) : world(world) {}
+
+        ~BenchmarkScene() {
+          for(size_t i=0; i<data.size(); ++i) delete data[i];
+        }
+
+        dGeomID addStaticBox(dReal x, dReal y, dReal z,
+                             dReal lx, dReal ly, dReal lz) {
+          dGeomID geom = dCreateBox(world->getStaticSpace(), lx, ly, lz);
+          dGeomSetPosition(geom, x, y, z);
+          setData(geom);
+          return geom;
+        }
+
+        dBodyID addDynamicBox(dReal x, dReal y, dReal z, dReal size) {
+          dMass mass;
+          dBodyID body = dBodyCreate(world->getWorld());
+          dGeomID geom = dCreateBox(world->getSpace(), size, size, size);
+          dMassSetBoxTotal(&mass, 1.0, size, size, size);
+          dBodySetMass(body, &mass);
+          dGeomSetBody(geom, body);
+          dBodySetPosition(body, x, y, z);
+          setData(geom);
+          return body;
+        }
+
+        dBodyID addDynamicSphere(dReal x, dReal y, dReal z, dReal radius) {
+          dMass mass;
+          dBodyID body = dBodyCreate(world->getWorld());
+          dGeomID geom = dCreateSphere(world->getSpace(), radius);
+          dMassSetSphereTotal(&mass, 1.0, radius);
+          dBodySetMass(body, &mass);
+          dGeomSetBody(geom, body);
+          dBodySetPosition(body, x, y, z);
+          setData(geom);
+          return body;
+        }
+
+        geom_data* setData(dGeomID geom) {
+          geom_data *gd = new geom_data();
+          gd->id = data.size() + 1;
+          gd->parent_geom = 0;
+          gd->parent_body = 0;
+          data.push_back(gd);
+          dGeomSetData(geom, gd);
+          return gd;
+        }
+
+      private:
+        WorldPhysics *world;
+        std::vector<geom_data*> data;
+      };
+
+      // a reproducible random value in [min, max)
+      inline dReal random(dReal min, dReal max) {
+        return min + (max - min) * (dReal)rand() / ((dReal)RAND_MAX + 1.0);
+      }
+
+    } // end of namespace benchmark
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif // BENCHMARK_SCENE_H
@@ -0,0 +1,123 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file contact_alloc_benchmark.cpp
+ * \brief Counts the heap allocations of WorldPhysics::stepTheWorld for a
+ *        scene with many resting contacts.
+ *
+ * Usage: contact_alloc_benchmark [numBoxes] [numSteps]
+ *
+ * The boxes are dropped onto a ground box and settle during the warm up.
+ * Afterwards the calls of operator new and, with glibc, of malloc are
+ * counted while the world is stepped. With the reused contact and
+ * feedback memory a step should not allocate once the pools are large
+ * enough.
+ */
+
+#include "BenchmarkScene.h"
+
+#include <mars/interfaces/sim/ControlCenter.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if __cplusplus >= 201103L
+#define THROW_BAD_ALLOC
+#define NO_THROW noexcept
+#else
+#define THROW_BAD_ALLOC throw(std::bad_alloc)
+#define NO_THROW throw()
+#endif
+
+static bool countAllocations = false;
+static unsigned long numNew = 0;
+static unsigned long numMalloc = 0;
+
+void* operator new(std::size_t size) THROW_BAD_ALLOC {
+  if(countAllocations) ++numNew;
+  void *p = malloc(size ? size : 1);
+  if(!p) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](std::size_t size) THROW_BAD_ALLOC {
+  return operator new(size);
+}
+
+void operator delete(void *p) NO_THROW {
+  free(p);
+}
+
+void operator delete[](void *p) NO_THROW {
+  free(p);
+}
+
+#ifdef __GLIBC__
+// ode allocates its joints and feedbacks with malloc
+extern "C" void* __libc_malloc(size_t size);
+
+extern "C" void* malloc(size_t size) {
+  if(countAllocations) ++numMalloc;
+  return __libc_malloc(size);
+}
+#endif
+
+using namespace mars;
+using namespace mars::sim;
+using namespace mars::sim::benchmark;
+
+int main(int argc, char *argv[]) {
+  int numBoxes = (argc > 1) ? atoi(argv[1]) : 200;
+  int numSteps = (argc > 2) ? atoi(argv[2]) : 100;
+  const int warmUpSteps = 300;
+
+  interfaces::ControlCenter control;
+  WorldPhysics world(&control);
+  world.initTheWorld();
+  {
+    BenchmarkScene scene(&world);
+    srand(1);
+    scene.addStaticBox(0, 0, -0.5, 50, 50, 1);
+    for(int i=0; i<numBoxes; ++i) {
+      scene.addDynamicBox(random(-5, 5), random(-5, 5),
+                          random(0.5, 5.0), 0.4);
+    }
+
+    for(int i=0; i<warmUpSteps; ++i) world.stepTheWorld();
+
+    countAllocations = true;
+    long long start = utils::getTime();
+    for(int i=0; i<numSteps; ++i) world.stepTheWorld();
+    double time = (double)utils::getTimeDiff(start);
+    countAllocations = false;
+
+    printf("boxes: %d, steps: %d\n", numBoxes, numSteps);
+    printf("operator new per step: %.2f\n", (double)numNew / numSteps);
+#ifdef __GLIBC__
+    // operator new is counted here as well
+    printf("malloc per step:       %.2f\n", (double)numMalloc / numSteps);
+#endif
+    printf("time per step:         %.3f ms\n", time / numSteps);
+  }
+  world.freeTheWorld();
+  return 0;
+}
@@ -0,0 +1,244 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file motor_batch_benchmark.cpp
+ * \brief Compares MotorBatch::update() with calling SimMotor::update()
+ *        for every motor.
+ *
+ * Usage: motor_batch_benchmark [numSteps]
+ *
+ * The motors drive mock joints that only integrate the commanded
+ * velocity or effort, so no physics is needed. A third of the motors are
+ * position, velocity and effort motors each. The ns per step of both
+ * paths are printed for 16, 64 and 256 motors. Afterwards both paths are
+ * stepped together and must give the same positions, and an effort limit
+ * that is set from outside must be written again by the batch.
+ */
+
+#include "MotorBatch.h"
+#include "SimJoint.h"
+#include "SimMotor.h"
+
+#include <mars/interfaces/sim/ControlCenter.h>
+#include <mars/interfaces/sim/JointInterface.h>
+#include <mars/utils/misc.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace mars;
+using namespace mars::sim;
+using namespace mars::interfaces;
+using mars::utils::Vector;
+
+/**
+ * A joint that integrates the commanded velocity or effort and counts the
+ * effort limits written to it.
+ */
+class MockJoint : public JointInterface {
+public:
+  MockJoint(sReal position) : position(position), velocity(0), torque(0),
+                              numLimitWrites(0) {}
+
+  void step(sReal time_ms) {
+    position += (velocity + torque*0.01) * time_ms * 0.001;
+  }
+
+  bool createJoint(JointData *joint, const NodeInterface *node1,
+                   const NodeInterface *node2) {return true;}
+  void getAnchor(Vector *anchor) const {anchor->setZero();}
+  void setAnchor(const Vector &anchor) {}
+  void setAxis(const Vector &axis) {}
+  void setAxis2(const Vector &axis) {}
+  void getAxis(Vector *axis) const {*axis = Vector(1, 0, 0);}
+  void getAxis2(Vector *axis) const {*axis = Vector(0, 1, 0);}
+  void setWorldObject(PhysicsInterface *world) {}
+  void setForceLimit(sReal max_force) {++numLimitWrites;}
+  void setForceLimit2(sReal max_force) {++numLimitWrites;}
+  void setVelocity(sReal velocity) {this->velocity = velocity;}
+  void setVelocity2(sReal velocity) {}
+  sReal getVelocity(void) const {return velocity;}
+  sReal getVelocity2(void) const {return 0;}
+  void setJointAsMotor(int axis) {}
+  void unsetJointAsMotor(int axis) {}
+  sReal getPosition(void) const {return position;}
+  sReal getPosition2(void) const {return 0;}
+  void getForce1(Vector *f) const {f->setZero();}
+  void getForce2(Vector *f) const {f->setZero();}
+  void getTorque1(Vector *t) const {t->setZero();}
+  void getTorque2(Vector *t) const {t->setZero();}
+  void setTorque(sReal torque) {this->torque = torque;}
+  void setTorque2(sReal torque) {}
+  void reattacheJoint(void) {}
+  void getAxisTorque(Vector *t) const {*t = Vector(torque, 0, 0);}
+  void getAxis2Torque(Vector *t) const {t->setZero();}
+  void update(void) {}
+  void getJointLoad(Vector *t) const {t->setZero();}
+  void changeStepSize(const JointData &jointS) {}
+  sReal getMotorTorque(void) const {return torque;}
+  sReal getLowStop() const {return -1;}
+  sReal getHighStop() const {return 1;}
+  sReal getLowStop2() const {return -1;}
+  sReal getHighStop2() const {return 1;}
+  void setLowStop(sReal lowStop) {}
+  void setHighStop(sReal highStop) {}
+  void setLowStop2(sReal lowStop) {}
+  void setHighStop2(sReal highStop) {}
+
+  sReal position, velocity, torque;
+  int numLimitWrites;
+};
+
+/// \cond HIDDEN_SYMBOLS
+struct Scene {
+  std::vector<MockJoint*> mockJoints;
+  std::vector<SimJoint*> joints;
+  std::vector<SimMotor*> motors;
+};
+/// \endcond
+
+static void createScene(ControlCenter *control, int numMotors,
+                        Scene *scene) {
+  const MotorType types[3] = {MOTOR_TYPE_POSITION, MOTOR_TYPE_VELOCITY,
+                              MOTOR_TYPE_EFFORT};
+  srand(1);
+  for(int i = 0; i < numMotors; ++i) {
+    JointData jointData;
+    jointData.index = i+1;
+    SimJoint *joint = new SimJoint(control, jointData);
+    MockJoint *mockJoint = new MockJoint(-1.0 + 2.0*rand()/RAND_MAX);
+    joint->setPhysicalJoint(mockJoint);
+    joint->update(0);
+
+    MotorData motorData;
+    motorData.index = i+1;
+    motorData.jointIndex = i+1;
+    motorData.axis = 1;
+    motorData.type = types[i%3];
+    motorData.p = 10.0;
+    motorData.i = 0.1;
+    motorData.d = 0.5;
+    motorData.maxSpeed = 5.0;
+    motorData.maxEffort = 20.0;
+    motorData.minValue = -3.0;
+    motorData.maxValue = 3.0;
+    SimMotor *motor = new SimMotor(control, motorData);
+    motor->attachJoint(joint);
+    motor->setSMotor(motorData);
+
+    scene->mockJoints.push_back(mockJoint);
+    scene->joints.push_back(joint);
+    scene->motors.push_back(motor);
+  }
+}
+
+// the SimJoints delete their MockJoints
+static void destroyScene(Scene *scene) {
+  for(size_t i = 0; i < scene->motors.size(); ++i) {
+    delete scene->motors[i];
+    delete scene->joints[i];
+  }
+}
+
+static void stepJoints(Scene *scene, sReal time_ms) {
+  for(size_t i = 0; i < scene->joints.size(); ++i) {
+    scene->mockJoints[i]->step(time_ms);
+    scene->joints[i]->update(time_ms);
+  }
+}
+
+static int countLimitWrites(const Scene &scene) {
+  int num = 0;
+  for(size_t i = 0; i < scene.mockJoints.size(); ++i) {
+    num += scene.mockJoints[i]->numLimitWrites;
+  }
+  return num;
+}
+
+int main(int argc, char *argv[]) {
+  const sReal time_ms = 10.0;
+  int numSteps = (argc > 1) ? atoi(argv[1]) : 20000;
+  const int numMotors[3] = {16, 64, 256};
+  ControlCenter control;
+  long long start, loopTime, batchTime;
+
+  printf("ns per step, %d steps\n", numSteps);
+  printf("%-8s %12s %12s\n", "motors", "loop", "batch");
+  // the joints are not stepped in the timed loops, so both paths run the
+  // same controller arithmetic every step
+  for(int n = 0; n < 3; ++n) {
+    Scene scene;
+    MotorBatch batch;
+    createScene(&control, numMotors[n], &scene);
+    start = utils::getTime();
+    for(int s = 0; s < numSteps; ++s) {
+      for(size_t i = 0; i < scene.motors.size(); ++i) {
+        scene.motors[i]->update(time_ms);
+      }
+    }
+    loopTime = utils::getTimeDiff(start);
+    start = utils::getTime();
+    for(int s = 0; s < numSteps; ++s) batch.update(scene.motors, time_ms);
+    batchTime = utils::getTimeDiff(start);
+    printf("%-8d %12.1f %12.1f\n", numMotors[n],
+           loopTime * 1.0e6 / numSteps, batchTime * 1.0e6 / numSteps);
+    destroyScene(&scene);
+  }
+
+  // both paths on the same start state
+  Scene loopScene, batchScene;
+  MotorBatch batch;
+  createScene(&control, 64, &loopScene);
+  createScene(&control, 64, &batchScene);
+  for(int s = 0; s < 1000; ++s) {
+    for(size_t i = 0; i < loopScene.motors.size(); ++i) {
+      loopScene.motors[i]->update(time_ms);
+    }
+    batch.update(batchScene.motors, time_ms);
+    stepJoints(&loopScene, time_ms);
+    stepJoints(&batchScene, time_ms);
+  }
+  int result = 0;
+  for(size_t i = 0; i < loopScene.motors.size(); ++i) {
+    if(loopScene.mockJoints[i]->position !=
+       batchScene.mockJoints[i]->position) {
+      printf("the positions of motor %lu differ\n", (unsigned long)i+1);
+      result = 1;
+      break;
+    }
+  }
+  printf("effort limit writes in 1000 steps: loop %d, batch %d\n",
+         countLimitWrites(loopScene), countLimitWrites(batchScene));
+
+  // a limit set from outside, like JointManager::setForceLimit() does
+  int numWrites = batchScene.mockJoints[0]->numLimitWrites;
+  batchScene.joints[0]->setEffortLimit(1.0, 1);
+  batch.update(batchScene.motors, time_ms);
+  if(batchScene.mockJoints[0]->numLimitWrites != numWrites+2) {
+    printf("the batch did not restore the effort limit\n");
+    result = 1;
+  }
+
+  destroyScene(&loopScene);
+  destroyScene(&batchScene);
+  return result;
+}
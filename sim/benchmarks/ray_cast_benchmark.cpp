@@ -0,0 +1,169 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ray_cast_benchmark.cpp
+ * \brief Compares the batched RayCastEngine with the former ray marching
+ *        of the intersection sensors.
+ *
+ * Usage: ray_cast_benchmark [numRays] [numScans]
+ *
+ * The scene is a ground box with a grid of static boxes and some dynamic
+ * spheres around the sensor. Both paths cast the same rays and the rays
+ * per second and the largest difference of the distances are printed.
+ */
+
+#include "BenchmarkScene.h"
+#include "RayCastEngine.h"
+
+#include <mars/interfaces/MARSDefs.h>
+#include <mars/interfaces/sim/ControlCenter.h>
+#include <mars/utils/MutexLocker.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace mars;
+using namespace mars::sim;
+using namespace mars::sim::benchmark;
+
+/**
+ * The former NodePhysics::handleSensorData: each beam is marched in steps
+ * of one meter and every step is collided with both spaces.
+ */
+static void marchRays(WorldPhysics *world, const dReal *pos,
+                      const std::vector<dReal> &directions,
+                      dReal maxDistance, std::vector<double> *result) {
+  const dReal stepSize = 1.0;
+  dGeomID ray = dCreateRay(0, 1.0);
+  geom_data gd;
+  gd.ray_sensor = 1;
+  gd.parent_geom = 0;
+  gd.parent_body = 0;
+  gd.value = maxDistance;
+  dGeomSetData(ray, &gd);
+
+  size_t numRays = directions.size() / 3;
+  for(size_t i=0; i<numRays; ++i) {
+    const dReal *dest = &directions[3*i];
+    dReal length = 0.0;
+    bool done = false;
+    int steps = 0;
+    dGeomEnable(ray);
+    while(!done) {
+      dGeomRaySet(ray,
+                  pos[0] + dest[0]*stepSize*steps,
+                  pos[1] + dest[1]*stepSize*steps,
+                  pos[2] + dest[2]*stepSize*steps,
+                  dest[0], dest[1], dest[2]);
+      if(length + stepSize < maxDistance) {
+        steps++;
+        dGeomRaySetLength(ray, stepSize);
+      }
+      else {
+        dGeomRaySetLength(ray, maxDistance - length);
+        done = true;
+      }
+      if(world->handleCollision(ray)) {
+        gd.value += length;
+        done = true;
+      }
+      if(!done) length = stepSize*steps;
+    }
+    dGeomDisable(ray);
+    (*result)[i] = gd.value;
+    gd.value = maxDistance;
+  }
+  dGeomDestroy(ray);
+}
+
+int main(int argc, char *argv[]) {
+  int numRays = (argc > 1) ? atoi(argv[1]) : 360;
+  int numScans = (argc > 2) ? atoi(argv[2]) : 50;
+  const dReal maxDistance = 30.0;
+  const dReal pos[3] = {0.0, 0.0, 0.5};
+
+  interfaces::ControlCenter control;
+  WorldPhysics world(&control);
+  world.initTheWorld();
+  {
+    BenchmarkScene scene(&world);
+    srand(1);
+    scene.addStaticBox(0, 0, -0.5, 100, 100, 1);
+    for(int x=-10; x<=10; ++x) {
+      for(int y=-10; y<=10; ++y) {
+        if(x == 0 && y == 0) continue;
+        scene.addStaticBox(x*4.0, y*4.0, 0.5, 1.0, 1.0, 1.0);
+      }
+    }
+    for(int i=0; i<50; ++i) {
+      scene.addDynamicSphere(random(-15, 15), random(-15, 15),
+                             random(0.5, 3.0), 0.3);
+    }
+    // lets the spaces adapt to the static geoms
+    world.stepTheWorld();
+
+    // a horizontal scan that is tilted down by 5 degree
+    std::vector<dReal> directions(3*numRays);
+    for(int i=0; i<numRays; ++i) {
+      double a = 2*M_PI*i/numRays;
+      double t = -5.0*M_PI/180.0;
+      directions[3*i] = cos(a)*cos(t);
+      directions[3*i+1] = sin(a)*cos(t);
+      directions[3*i+2] = sin(t);
+    }
+
+    std::vector<double> marched(numRays), batched(numRays);
+    RayCastEngine *engine = world.getRayCastEngine();
+    utils::MutexLocker locker(&world.iMutex);
+
+    long long start = utils::getTime();
+    for(int i=0; i<numScans; ++i) {
+      marchRays(&world, pos, directions, maxDistance, &marched);
+    }
+    double marchTime = (double)utils::getTimeDiff(start);
+
+    start = utils::getTime();
+    for(int i=0; i<numScans; ++i) {
+      engine->castRays(pos, 0, &directions[0], numRays, maxDistance,
+                       0, 0, interfaces::COLLIDE_MASK_SENSOR, &batched[0]);
+    }
+    double batchTime = (double)utils::getTimeDiff(start);
+
+    double maxDiff = 0.0;
+    for(int i=0; i<numRays; ++i) {
+      maxDiff = std::max(maxDiff, fabs(marched[i] - batched[i]));
+    }
+
+    double totalRays = (double)numRays * numScans;
+    printf("rays: %d x %d scans, max distance %g\n", numRays, numScans,
+           maxDistance);
+    printf("ray marching:  %12.0f rays/s\n",
+           totalRays / std::max(marchTime, 1.0) * 1000.0);
+    printf("RayCastEngine: %12.0f rays/s\n",
+           totalRays / std::max(batchTime, 1.0) * 1000.0);
+    printf("max difference of the distances: %g\n", maxDiff);
+  }
+  world.freeTheWorld();
+  return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file registry_benchmark.cpp
+ * \brief Compares the lookups of the ObjectRegistry with the std::map
+ *        of the managers for 10000 objects.
+ *
+ * Usage: registry_benchmark [numQueries]
+ *
+ * The name lookup of the managers was a linear scan over the id map;
+ * the iteration compares the map with the dense array of the registry
+ * that is used by MotorManager::updateMotors().
+ */
+
+#include "ObjectRegistry.h"
+
+#include <mars/utils/misc.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace mars;
+using namespace mars::sim;
+
+struct Object {
+  unsigned long id;
+  std::string name;
+  double value;
+};
+
+typedef std::map<unsigned long, Object*> ObjectMap;
+
+// the former getID() of the managers
+static unsigned long scanID(const ObjectMap &objects,
+                            const std::string &name) {
+  ObjectMap::const_iterator iter;
+  for(iter = objects.begin(); iter != objects.end(); ++iter) {
+    if(iter->second->name == name) return iter->first;
+  }
+  return 0;
+}
+
+static void print(const char *name, long long mapTime,
+                  long long registryTime, double numQueries) {
+  printf("%-16s %12.1f %12.1f\n", name, mapTime * 1.0e6 / numQueries,
+         registryTime * 1.0e6 / numQueries);
+}
+
+int main(int argc, char *argv[]) {
+  const int numObjects = 10000;
+  int numQueries = (argc > 1) ? atoi(argv[1]) : 1000000;
+  std::vector<Object> storage(numObjects);
+  ObjectMap objects;
+  ObjectRegistry<Object> registry;
+  std::vector<unsigned long> ids(numQueries);
+  std::vector<std::string> names(numQueries);
+  std::vector<Object*> list;
+  unsigned long checksum[2] = {0, 0};
+  double sum[2] = {0, 0};
+  long long start, mapTime, registryTime;
+  char buffer[32];
+
+  for(int i = 0; i < numObjects; ++i) {
+    Object *object = &storage[i];
+    sprintf(buffer, "object_%d", i);
+    object->id = i+1;
+    object->name = buffer;
+    object->value = i;
+    objects[object->id] = object;
+    registry.add(object->id, object->name, object);
+  }
+  srand(1);
+  for(int i = 0; i < numQueries; ++i) {
+    ids[i] = rand() % numObjects + 1;
+    names[i] = storage[ids[i]-1].name;
+  }
+
+  printf("ns per query, %d objects, %d queries\n", numObjects, numQueries);
+  printf("%-16s %12s %12s\n", "lookup", "map", "registry");
+
+  // the scan is slow, so it only gets a hundredth of the queries
+  start = utils::getTime();
+  for(int i = 0; i < numQueries/100; ++i) checksum[0] += scanID(objects, names[i]);
+  mapTime = utils::getTimeDiff(start);
+  start = utils::getTime();
+  for(int i = 0; i < numQueries/100; ++i) checksum[1] += registry.getID(names[i]);
+  registryTime = utils::getTimeDiff(start);
+  print("name -> id", mapTime, registryTime, numQueries/100);
+
+  start = utils::getTime();
+  for(int i = 0; i < numQueries; ++i) checksum[0] += objects.find(ids[i])->second->id;
+  mapTime = utils::getTimeDiff(start);
+  start = utils::getTime();
+  for(int i = 0; i < numQueries; ++i) checksum[1] += registry.get(ids[i])->id;
+  registryTime = utils::getTimeDiff(start);
+  print("id -> object", mapTime, registryTime, numQueries);
+
+  // reported per object
+  const int numPasses = numQueries/100 + 1;
+  start = utils::getTime();
+  for(int p = 0; p < numPasses; ++p) {
+    ObjectMap::const_iterator iter;
+    for(iter = objects.begin(); iter != objects.end(); ++iter) {
+      sum[0] += iter->second->value;
+    }
+  }
+  mapTime = utils::getTimeDiff(start);
+  start = utils::getTime();
+  for(int p = 0; p < numPasses; ++p) {
+    registry.getObjects(&list);
+    for(size_t i = 0; i < list.size(); ++i) sum[1] += list[i]->value;
+  }
+  registryTime = utils::getTimeDiff(start);
+  print("iteration", mapTime, registryTime, (double)numPasses*numObjects);
+
+  if(checksum[0] != checksum[1] || sum[0] != sum[1]) {
+    printf("the lookups of the map and the registry differ\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file space_benchmark.cpp
+ * \brief Measures the step time of the collision space types for scenes
+ *        of 100, 1000 and 10000 geoms.
+ *
+ * Usage: space_benchmark [numSteps]
+ *
+ * The dynamic boxes are scattered over a volume that grows with their
+ * number, so the density of the scene and the number of contacts per
+ * geom stay about the same. Every configuration runs in a new world.
+ */
+
+#include "BenchmarkScene.h"
+
+#include <mars/interfaces/sim/ControlCenter.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace mars;
+using namespace mars::sim;
+using namespace mars::sim::benchmark;
+
+static double measure(const std::string &spaceType, int numGeoms,
+                      int numSteps) {
+  interfaces::ControlCenter control;
+  WorldPhysics world(&control);
+  world.space_type = spaceType;
+  world.initTheWorld();
+  double time;
+  {
+    BenchmarkScene scene(&world);
+    // about one box per 8 cubic meter
+    dReal extent = pow((dReal)numGeoms, 1.0/3.0);
+    srand(1);
+    scene.addStaticBox(0, 0, -0.5, 4*extent + 10, 4*extent + 10, 1);
+    for(int i=0; i<numGeoms; ++i) {
+      scene.addDynamicBox(random(-extent, extent), random(-extent, extent),
+                          random(0.5, 2*extent + 0.5), 0.5);
+    }
+    // the first step rebuilds the spaces for the new static geom
+    world.stepTheWorld();
+
+    long long start = utils::getTime();
+    for(int i=0; i<numSteps; ++i) world.stepTheWorld();
+    time = (double)utils::getTimeDiff(start) / numSteps;
+  }
+  world.freeTheWorld();
+  return time;
+}
+
+int main(int argc, char *argv[]) {
+  int numSteps = (argc > 1) ? atoi(argv[1]) : 20;
+  const char *spaceTypes[] = {"hash", "sap", "quadtree"};
+  const int numGeoms[] = {100, 1000, 10000};
+
+  printf("ms per step (%d steps)\n", numSteps);
+  printf("%-10s %10s %10s %10s\n", "space", "100", "1000", "10000");
+  for(int s=0; s<3; ++s) {
+    printf("%-10s", spaceTypes[s]);
+    for(int n=0; n<3; ++n) {
+      printf(" %10.3f", measure(spaceTypes[s], numGeoms[n], numSteps));
+      fflush(stdout);
+    }
+    printf("\n");
+  }
+  return 0;
+}
@@ -29,6 +29,7 @@
 
 
 #include "Controller.h"
+#include "ControllerChannel.h"
 
 #include <mars/interfaces/sim/NodeManagerInterface.h>
 #include <mars/interfaces/sim/SimulatorInterface.h>
@@ -41,6 +42,7 @@
 #include <mars/data_broker/DataBrokerInterface.h>
 #include <mars/cfg_manager/CFGManagerInterface.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 
@@ -59,7 +61,8 @@ namespace mars {
                            const std::vector<SimMotor*> &motors,
                            const std::vector<BaseSensor*> &sensors,
                            const std::vector<NodeData*> &sNodes,
-                           ControlCenter* control, int nport) {
+                           ControlCenter* control, int nport,
+                           ControllerChannel *channel) {
       std::vector<SimMotor*>::const_iterator iter;
       std::vector<BaseSensor*>::const_iterator jter;
       std::vector<NodeData*>::const_iterator lter;
@@ -69,6 +72,7 @@ namespace mars {
       this->sensors = sensors;
       this->sNodes  = sNodes;
       this->control = control;
+      this->channel = channel;
       // localhost = "192.168.101.57";
       hostname = "localhost";
       this->nport = nport;
@@ -104,6 +108,14 @@ namespace mars {
 #endif
       connected = 0;
       conn = 0;
+      if(channel) {
+        // binary controllers are connected by their channel
+        sController.protocol = (channel->getTransport() ==
+                                ControllerChannel::TRANSPORT_SHM ?
+                                "shm" : "binary");
+        channel->addController(this);
+        return;
+      }
       //initServer(1500);
       //getClient();
       LOG_ERROR("Controller: try to connect to port: %d", nport);
@@ -128,6 +140,10 @@ namespace mars {
         dlclose(dy);
 #endif
       }
+      if(channel) {
+        channel->removeController(this);
+        return;
+      }
       if(connected) close(conn);
       connected = false;
       while(!isFinished()) 
@@ -162,7 +178,6 @@ namespace mars {
       double t_motors[100];
       double *pt_motors = t_motors;
       int flags = 0, count_val, i, command;
-      sReal *sens_val;
       char *other_stuff = 0;
       char *pt_stuff;
       unsigned long command_id = 0;
@@ -175,9 +190,10 @@ namespace mars {
         if (dylibController) {
           for (i=0; i<100; i++) t_sensors[i] = t_motors[i] = 0;
           for (iter = sensors.begin(); iter != sensors.end(); iter++) {
-            count_val = (*iter)->getSensorData(&sens_val);
-            for(i=0; i<count_val; i++) *(pt_sensors++) = (double)sens_val[i];
-            free(sens_val);
+            // sensors that do not fit into the array are skipped
+            count_val = (*iter)->readSensorData(pt_sensors,
+                                                t_sensors+255-pt_sensors);
+            if(pt_sensors+count_val <= t_sensors+255) pt_sensors += count_val;
           }
           /*
           if (sParams.size()) {
@@ -409,6 +425,11 @@ namespace mars {
               (*jter)->setControlValue((sReal)*pt_motors);
           }
         }
+        else if(channel) {
+          // the frame is sent by the ControllerManager together with the
+          // frames of the other controllers on the same channel
+          channel->queueSensors(this);
+        }
         else if(connected) {
           // here we can communicate
 #ifdef WIN32
@@ -1036,27 +1057,174 @@ namespace mars {
     }
 
     void Controller::connect(void) {
+      if(channel) return;
       if(connected || conn) close(conn);
       openClient(hostname.data(), nport);
     }
 
     void Controller::disconnect(void) {
+      if(channel) return;
       if(connected) close(conn);
     }
 
     std::list<sReal> Controller::getSensorValues(void) {
+      std::vector<sReal> values;
+      std::vector<uint32_t> sizes;
+      readSensors(&values, &sizes);
+      return std::list<sReal>(values.begin(), values.end());
+    }
+
+    void Controller::readSensors(std::vector<sReal> *values,
+                                 std::vector<uint32_t> *sizes) {
       std::vector<BaseSensor*>::iterator iter;
       sReal *sens_val;
-      std::list<sReal> sensorValues;
-
-      for (iter=sensors.begin(); iter!=sensors.end(); ++iter) {
-        int count_val = (*iter)->getSensorData(&sens_val);
-        for(int i=0; i<count_val; i++) {
-          sensorValues.push_back(sens_val[i]);
+      size_t pos;
+      int size, count_val;
+
+      // the vectors keep their capacity between the calls
+      values->clear();
+      sizes->clear();
+      for(iter=sensors.begin(); iter!=sensors.end(); ++iter) {
+        pos = values->size();
+        size = (*iter)->getSensorDataSize();
+        if(size < 0) {
+          // the sensor only implements getSensorData()
+          count_val = (*iter)->getSensorData(&sens_val);
+          values->insert(values->end(), sens_val, sens_val+count_val);
+          free(sens_val);
         }
-        free(sens_val);
+        else {
+          values->resize(pos+size);
+          count_val = size ? (*iter)->readSensorData(&(*values)[pos], size) : 0;
+          if(count_val > size) {
+            // the size changed since getSensorDataSize()
+            values->resize(pos+count_val);
+            count_val = std::min(count_val,
+                                 (*iter)->readSensorData(&(*values)[pos],
+                                                         count_val));
+          }
+          values->resize(pos+count_val);
+        }
+        sizes->push_back(count_val);
+      }
+    }
+
+    void Controller::getSchema(std::vector<unsigned long> *sensorIds,
+                               std::vector<unsigned long> *motorIds) const {
+      std::vector<BaseSensor*>::const_iterator iter;
+      std::vector<SimMotor*>::const_iterator jter;
+
+      sensorIds->clear();
+      motorIds->clear();
+      for(iter=sensors.begin(); iter!=sensors.end(); ++iter) {
+        sensorIds->push_back((*iter)->getID());
+      }
+      for(jter=motors.begin(); jter!=motors.end(); ++jter) {
+        motorIds->push_back((*jter)->getIndex());
+      }
+    }
+
+    void Controller::applyMotorFrame(const ControllerFrameHeader &frame,
+                                     const char *data) {
+      ControllerCommandHeader command;
+      uint32_t i;
+
+      if(frame.flags & CONTROLLER_FRAME_RESET_SIM) {
+        control->sim->resetSim();
+        return;
+      }
+      // the values are in the order of the schema; missing values keep
+      // the last control value
+      for(i=0; i<frame.numValues && i<motors.size(); ++i) {
+        motors[i]->setControlValue(controllerGetF64(data+i*8));
+      }
+      data += frame.numValues*8;
+      for(i=0; i<frame.numCommands; ++i) {
+        controllerGetCommand(data, &command);
+        data += controllerCommandHeaderSize;
+        applyCommand(command, data);
+        data += command.numValues*8;
+      }
+    }
+
+    /**
+     * Applies one command of a binary motor frame. The values have the
+     * same meaning as in the ascii protocol, but angles are given in
+     * radians. Motor commands address the motors by their index in the
+     * schema of the controller.
+     */
+    void Controller::applyCommand(const ControllerCommandHeader &command,
+                                  const char *data) {
+      sReal v[7];
+      Vector pos;
+      Quaternion q;
+      sRotation rot;
+      uint32_t i, n = command.numValues;
+      unsigned long id = command.id;
+
+      if(n > 7) n = 7;
+      for(i=0; i<7; ++i) {
+        v[i] = i < n ? controllerGetF64(data+i*8) : 0.0;
+      }
+      pos = Vector(v[0], v[1], v[2]);
+
+      switch(command.command) {
+      case COMMAND_MOTOR_POSITION:
+        if(id < motors.size()) motors[id]->setControlValue(v[0]);
+        break;
+      case COMMAND_MOTOR_MAX_VELOCITY:
+        if(id < motors.size()) motors[id]->setMaxSpeed(v[0]);
+        break;
+      case COMMAND_MOTOR_PID:
+        if(id < motors.size()) motors[id]->setPID(v[0], v[1], v[2]);
+        break;
+      case COMMAND_NODE_POSITION:
+        control->nodes->setPosition(id, pos);
+        break;
+      case COMMAND_NODE_ROTATION:
+        rot.alpha = v[0]*180.0/M_PI;
+        rot.beta = v[1]*180.0/M_PI;
+        rot.gamma = v[2]*180.0/M_PI;
+        control->nodes->setRotation(id, eulerToQuaternion(rot));
+        break;
+      case COMMAND_NODE_VELOCITY:
+        control->nodes->setVelocity(id, pos);
+        break;
+      case COMMAND_NODE_ANGULAR_VELOCITY:
+        control->nodes->setAngularVelocity(id, pos);
+        break;
+      case COMMAND_NODE_APPLY_FORCE:
+        control->nodes->applyForce(id, pos);
+        break;
+      case COMMAND_NODE_APPLY_FORCE_AT:
+        control->nodes->applyForce(id, pos, Vector(v[3], v[4], v[5]));
+        break;
+      case COMMAND_NODE_ANGULAR_DAMPING:
+        control->nodes->setAngularDamping(id, v[0]);
+        break;
+      case COMMAND_NODE_RELOAD_QUATERNION:
+        q.x() = v[0];
+        q.y() = v[1];
+        q.z() = v[2];
+        q.w() = v[3];
+        control->nodes->setReloadQuaternion(id, q);
+        break;
+      case COMMAND_NODES_CONNECT:
+        control->sim->connectNodes(id, (unsigned long)v[0]);
+        break;
+      case COMMAND_NODES_DISCONNECT:
+        control->sim->disconnectNodes(id, (unsigned long)v[0]);
+        break;
+      case COMMAND_PHYSICS_GRAVITY:
+        control->sim->setGravity(pos);
+        break;
+      case COMMAND_SIM_QUIT:
+        LOG_INFO("Controller: got quit command");
+        control->sim->exitMars();
+        break;
+      default:
+        break;
       }
-      return sensorValues;
     }
 
 
@@ -56,10 +56,13 @@
 #include <mars/interfaces/sensor_bases.h>
 #include <mars/interfaces/ControllerData.h>
 #include <mars/interfaces/sim/ControllerInterface.h>
+#include <mars/interfaces/ControllerProtocol.h>
 
 namespace mars {
   namespace sim {
 
+    class ControllerChannel;
+
     /**
      * The class to log all data.
      *
@@ -70,7 +73,8 @@ namespace mars {
                  const std::vector<SimMotor*> &motors,
                  const std::vector<interfaces::BaseSensor*> &sensors,
                  const std::vector<interfaces::NodeData*> &sNodes,
-                 interfaces::ControlCenter *control, int portn=1500);
+                 interfaces::ControlCenter *control, int portn=1500,
+                 ControllerChannel *channel=0);
       virtual ~Controller(void);
       virtual void update(interfaces::sReal time_ms);
       virtual std::list<interfaces::sReal> getSensorValues(void);
@@ -92,6 +96,23 @@ namespace mars {
       void connect(void);
       void disconnect(void);
 
+      /**
+       * Used by the ControllerChannel of a binary controller: reads the
+       * values of all sensors into \a values and the number of values of
+       * every sensor into \a sizes.
+       */
+      void readSensors(std::vector<interfaces::sReal> *values,
+                       std::vector<uint32_t> *sizes);
+      void getSchema(std::vector<unsigned long> *sensorIds,
+                     std::vector<unsigned long> *motorIds) const;
+      /**
+       * Applies a motor frame of the binary protocol. \a data points to
+       * the motor values that follow the frame header; the frame was
+       * checked by the ControllerChannel.
+       */
+      void applyMotorFrame(const interfaces::ControllerFrameHeader &frame,
+                           const char *data);
+
 #ifdef WIN32
       static bool sock_init;
 #endif
@@ -120,6 +141,9 @@ namespace mars {
       std::vector<SimMotor*> motors;
       std::vector<interfaces::BaseSensor*> sensors;
       std::vector<interfaces::NodeData*> sNodes;
+      ControllerChannel *channel;
+      void applyCommand(const interfaces::ControllerCommandHeader &command,
+                        const char *data);
       int initServer(int port);
       void getClient(void);
       int openClient(const char *host, int port);
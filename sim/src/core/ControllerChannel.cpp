@@ -0,0 +1,564 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ControllerChannel.cpp
+ * \brief "ControllerChannel" exchanges the frames of the binary
+ *        controller protocol with an external process.
+ *
+ */
+
+#include "ControllerChannel.h"
+#include "Controller.h"
+
+#include <mars/utils/misc.h>
+#include <mars/interfaces/Logging.hpp>
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef WIN32
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+    using namespace interfaces;
+
+    // the time to wait for the controller until the connection is dropped
+    static const long long receiveTimeout = 5000;
+    static const long long connectInterval = 1000;
+    static const uint32_t maxMessageSize = 64 << 20;
+
+    ControllerChannel::ControllerChannel(Transport transport,
+                                         const std::string &host, int port)
+      : transport(transport), host(host), port(port), connected(false),
+        schemaAcked(false), schemaId(1), sequence(0), lastConnect(0),
+        numQueued(0), sock(-1), shm(0), shmSize(0), shmHeader(0) {
+      char name[64];
+      rings[0] = rings[1] = 0;
+      ringData[0] = ringData[1] = 0;
+#ifdef WIN32
+      if(transport == TRANSPORT_SHM) {
+        LOG_WARN("ControllerChannel: shared memory is not supported, using tcp");
+        this->transport = TRANSPORT_TCP;
+      }
+#endif
+      sprintf(name, "/mars_controller_%d", port);
+      shmName = name;
+    }
+
+    ControllerChannel::~ControllerChannel(void) {
+      disconnect();
+      closeShm();
+    }
+
+    void ControllerChannel::addController(Controller *controller) {
+      Slot slot;
+      slot.controller = controller;
+      slots.push_back(slot);
+      schemaAcked = false;
+      ++schemaId;
+    }
+
+    void ControllerChannel::removeController(Controller *controller) {
+      std::vector<Slot>::iterator it;
+      for(it=slots.begin(); it!=slots.end(); ++it) {
+        if(it->controller == controller) {
+          slots.erase(it);
+          schemaAcked = false;
+          ++schemaId;
+          // the queued frames may belong to the removed controller
+          numQueued = 0;
+          return;
+        }
+      }
+    }
+
+    bool ControllerChannel::isEmpty(void) const {
+      return slots.empty();
+    }
+
+    bool ControllerChannel::isConnected(void) const {
+      return connected;
+    }
+
+    ControllerChannel::Transport ControllerChannel::getTransport(void) const {
+      return transport;
+    }
+
+    ControllerChannel::Slot* ControllerChannel::getSlot(unsigned long controllerId) {
+      std::vector<Slot>::iterator it;
+      for(it=slots.begin(); it!=slots.end(); ++it) {
+        if(it->controller->getID() == controllerId) return &(*it);
+      }
+      return 0;
+    }
+
+    void ControllerChannel::queueSensors(Controller *controller) {
+      Slot *slot = getSlot(controller->getID());
+      ControllerFrameHeader frame;
+      std::size_t pos, i;
+
+      if(!slot || !connected) return;
+      controller->readSensors(&values, &sizes);
+      if(slot->sensorSizes != sizes) {
+        // a sensor changed its size; the controller gets a new schema
+        // before this frame
+        slot->sensorSizes = sizes;
+        schemaAcked = false;
+        ++schemaId;
+      }
+
+      if(numQueued == 0) {
+        beginMessage(CONTROLLER_MSG_SENSORS);
+        // room for the sim time
+        sendBuffer.resize(sendBuffer.size()+8);
+      }
+      frame.controllerId = controller->getID();
+      frame.numValues = values.size();
+      frame.numCommands = 0;
+      frame.flags = 0;
+      pos = sendBuffer.size();
+      sendBuffer.resize(pos + controllerFrameHeaderSize + values.size()*8);
+      controllerPutFrame(&sendBuffer[pos], frame);
+      pos += controllerFrameHeaderSize;
+      for(i=0; i<values.size(); ++i, pos+=8) {
+        controllerPutF64(&sendBuffer[pos], values[i]);
+      }
+      ++numQueued;
+    }
+
+    void ControllerChannel::exchange(sReal simTime) {
+      if(!connected) {
+        numQueued = 0;
+        if(getTimeDiff(lastConnect) >= connectInterval) {
+          lastConnect = getTime();
+          connect();
+        }
+        return;
+      }
+      if(numQueued == 0) return;
+
+      // keep the sensor message while the schema is sent
+      std::vector<char> sensorMessage;
+      uint32_t count = numQueued;
+      numQueued = 0;
+      if(!schemaAcked) {
+        sensorMessage.swap(sendBuffer);
+        if(!sendSchema()) return;
+        sendBuffer.swap(sensorMessage);
+      }
+
+      controllerPutF64(&sendBuffer[controllerMessageHeaderSize], simTime);
+      controllerPutU32(&sendBuffer[20], count);
+      if(!sendMessage()) return;
+      if(!receiveMessage(CONTROLLER_MSG_MOTORS)) return;
+      applyMotorFrames();
+    }
+
+    bool ControllerChannel::connect(void) {
+      bool ok;
+      if(transport == TRANSPORT_TCP) {
+        ok = openSocket();
+      }
+      else {
+        ok = openShm();
+      }
+      if(!ok) return false;
+      LOG_INFO("ControllerChannel: connected on port %d", port);
+      connected = true;
+      schemaAcked = false;
+      return true;
+    }
+
+    void ControllerChannel::disconnect(void) {
+      if(connected) {
+        LOG_ERROR("ControllerChannel: connection lost on port %d", port);
+      }
+      connected = false;
+      schemaAcked = false;
+      numQueued = 0;
+      if(sock != -1) {
+#ifdef WIN32
+        closesocket(sock);
+#else
+        close(sock);
+#endif
+        sock = -1;
+      }
+#ifndef WIN32
+      if(shmHeader) {
+        // the rings are reset before the next controller attaches
+        __sync_synchronize();
+        rings[0]->head = rings[0]->tail = 0;
+        rings[1]->head = rings[1]->tail = 0;
+        __sync_synchronize();
+        shmHeader->attached = 0;
+      }
+#endif
+    }
+
+    bool ControllerChannel::sendSchema(void) {
+      std::vector<Slot>::iterator it;
+      std::vector<unsigned long> sensorIds, motorIds;
+      std::size_t pos, i;
+
+      beginMessage(CONTROLLER_MSG_SCHEMA);
+      for(it=slots.begin(); it!=slots.end(); ++it) {
+        uint32_t numSensorValues = 0;
+        it->controller->getSchema(&sensorIds, &motorIds);
+        // sensors that were never read yet are announced with size 0
+        it->sensorSizes.resize(sensorIds.size(), 0);
+        for(i=0; i<sensorIds.size(); ++i) {
+          numSensorValues += it->sensorSizes[i];
+        }
+        pos = sendBuffer.size();
+        sendBuffer.resize(pos + controllerSchemaEntrySize +
+                          sensorIds.size()*controllerSchemaSensorSize +
+                          motorIds.size()*4);
+        controllerPutU32(&sendBuffer[pos], it->controller->getID());
+        controllerPutU32(&sendBuffer[pos+4], sensorIds.size());
+        controllerPutU32(&sendBuffer[pos+8], motorIds.size());
+        controllerPutU32(&sendBuffer[pos+12], numSensorValues);
+        pos += controllerSchemaEntrySize;
+        for(i=0; i<sensorIds.size(); ++i, pos+=controllerSchemaSensorSize) {
+          controllerPutU32(&sendBuffer[pos], sensorIds[i]);
+          controllerPutU32(&sendBuffer[pos+4], it->sensorSizes[i]);
+        }
+        for(i=0; i<motorIds.size(); ++i, pos+=4) {
+          controllerPutU32(&sendBuffer[pos], motorIds[i]);
+        }
+      }
+      controllerPutU32(&sendBuffer[20], slots.size());
+      if(!sendMessage()) return false;
+      if(!receiveMessage(CONTROLLER_MSG_SCHEMA_ACK)) return false;
+      schemaAcked = true;
+      return true;
+    }
+
+    void ControllerChannel::beginMessage(uint32_t type) {
+      ControllerMessageHeader header;
+      header.magic = CONTROLLER_PROTOCOL_MAGIC;
+      header.version = CONTROLLER_PROTOCOL_VERSION;
+      header.type = type;
+      header.size = 0;
+      header.schemaId = schemaId;
+      header.sequence = ++sequence;
+      header.count = 0;
+      sendBuffer.resize(controllerMessageHeaderSize);
+      controllerPutHeader(&sendBuffer[0], header);
+    }
+
+    bool ControllerChannel::sendMessage(void) {
+      bool ok;
+      controllerPutU32(&sendBuffer[8], sendBuffer.size());
+      // the schema id may have changed while the frames were queued
+      controllerPutU32(&sendBuffer[12], schemaId);
+      if(transport == TRANSPORT_TCP) {
+        ok = sendSocket(&sendBuffer[0], sendBuffer.size());
+      }
+      else {
+        ok = writeRing(&sendBuffer[0], sendBuffer.size());
+      }
+      if(!ok) disconnect();
+      return ok;
+    }
+
+    bool ControllerChannel::receiveMessage(uint32_t type) {
+      ControllerMessageHeader header;
+      bool ok;
+
+      receiveBuffer.resize(controllerMessageHeaderSize);
+      if(transport == TRANSPORT_TCP) {
+        ok = receiveSocket(&receiveBuffer[0], controllerMessageHeaderSize);
+      }
+      else {
+        ok = readRing(&receiveBuffer[0], controllerMessageHeaderSize);
+      }
+      if(!ok) {
+        disconnect();
+        return false;
+      }
+      controllerGetHeader(&receiveBuffer[0], &header);
+      if(header.magic != CONTROLLER_PROTOCOL_MAGIC ||
+         header.version != CONTROLLER_PROTOCOL_VERSION ||
+         header.size < controllerMessageHeaderSize ||
+         header.size > maxMessageSize) {
+        LOG_ERROR("ControllerChannel: invalid message on port %d", port);
+        disconnect();
+        return false;
+      }
+      receiveBuffer.resize(header.size);
+      if(header.size > controllerMessageHeaderSize) {
+        char *body = &receiveBuffer[controllerMessageHeaderSize];
+        std::size_t size = header.size - controllerMessageHeaderSize;
+        if(transport == TRANSPORT_TCP) {
+          ok = receiveSocket(body, size);
+        }
+        else {
+          ok = readRing(body, size);
+        }
+        if(!ok) {
+          disconnect();
+          return false;
+        }
+      }
+      if(header.type != type) {
+        LOG_ERROR("ControllerChannel: unexpected message %d on port %d",
+                  header.type, port);
+        disconnect();
+        return false;
+      }
+      if(header.schemaId != schemaId) {
+        // the controller answers an older schema; the frames are dropped
+        // and the schema is sent again with the next step
+        schemaAcked = false;
+        return false;
+      }
+      return true;
+    }
+
+    void ControllerChannel::applyMotorFrames(void) {
+      ControllerMessageHeader header;
+      ControllerFrameHeader frame;
+      ControllerCommandHeader command;
+      std::size_t pos = controllerMessageHeaderSize;
+      std::size_t end = receiveBuffer.size();
+      std::size_t framePos, i;
+      Slot *slot;
+
+      controllerGetHeader(&receiveBuffer[0], &header);
+      for(uint32_t n=0; n<header.count; ++n) {
+        if(pos + controllerFrameHeaderSize > end) break;
+        controllerGetFrame(&receiveBuffer[pos], &frame);
+        pos += controllerFrameHeaderSize;
+        framePos = pos;
+        if((uint64_t)frame.numValues*8 > end - pos) break;
+        pos += frame.numValues*8;
+        // check the commands before anything is applied
+        for(i=0; i<frame.numCommands; ++i) {
+          if(pos + controllerCommandHeaderSize > end) break;
+          controllerGetCommand(&receiveBuffer[pos], &command);
+          pos += controllerCommandHeaderSize;
+          if((uint64_t)command.numValues*8 > end - pos) break;
+          pos += command.numValues*8;
+        }
+        if(i < frame.numCommands) break;
+        if((slot = getSlot(frame.controllerId))) {
+          slot->controller->applyMotorFrame(frame, &receiveBuffer[framePos]);
+        }
+      }
+      if(pos != end) {
+        LOG_ERROR("ControllerChannel: malformed motor message on port %d",
+                  port);
+      }
+    }
+
+    bool ControllerChannel::openSocket(void) {
+      struct sockaddr_in servAddr;
+      struct hostent *h;
+      int flag = 1;
+
+      h = gethostbyname(host.c_str());
+      if(!h) return false;
+      memset(&servAddr, 0, sizeof(servAddr));
+      servAddr.sin_family = h->h_addrtype;
+      memcpy((char *) &servAddr.sin_addr.s_addr, h->h_addr_list[0],
+             h->h_length);
+      servAddr.sin_port = htons(port);
+
+      sock = socket(AF_INET, SOCK_STREAM, 0);
+      if(sock < 0) {
+        sock = -1;
+        return false;
+      }
+      if(::connect(sock, (struct sockaddr *) &servAddr, sizeof(servAddr)) < 0) {
+#ifdef WIN32
+        closesocket(sock);
+#else
+        close(sock);
+#endif
+        sock = -1;
+        return false;
+      }
+      // the messages are small and answered immediately
+      setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&flag, sizeof(flag));
+#ifdef WIN32
+      DWORD timeout = receiveTimeout;
+      setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout,
+                 sizeof(timeout));
+#else
+      struct timeval timeout;
+      timeout.tv_sec = receiveTimeout / 1000;
+      timeout.tv_usec = (receiveTimeout % 1000) * 1000;
+      setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+      return true;
+    }
+
+    bool ControllerChannel::sendSocket(const char *data, std::size_t size) {
+      int n;
+      while(size) {
+        n = send(sock, data, size, MSG_NOSIGNAL);
+        if(n <= 0) return false;
+        data += n;
+        size -= n;
+      }
+      return true;
+    }
+
+    bool ControllerChannel::receiveSocket(char *data, std::size_t size) {
+      int n;
+      while(size) {
+        n = recv(sock, data, size, 0);
+        if(n <= 0) return false;
+        data += n;
+        size -= n;
+      }
+      return true;
+    }
+
+    bool ControllerChannel::openShm(void) {
+#ifdef WIN32
+      return false;
+#else
+      if(!shm) {
+        uint32_t ringSize = CONTROLLER_SHM_DEFAULT_RING_SIZE;
+        std::size_t headerSize = 64;
+        std::size_t ringBytes = sizeof(ControllerShmRing) + ringSize;
+        int fd;
+
+        shmSize = headerSize + 2*ringBytes;
+        fd = shm_open(shmName.c_str(), O_CREAT | O_RDWR, 0600);
+        if(fd == -1) {
+          LOG_ERROR("ControllerChannel: could not create %s",
+                    shmName.c_str());
+          return false;
+        }
+        if(ftruncate(fd, shmSize) != 0) {
+          close(fd);
+          return false;
+        }
+        void *p = mmap(0, shmSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if(p == MAP_FAILED) return false;
+        shm = (char*)p;
+        memset(shm, 0, shmSize);
+        shmHeader = (ControllerShmHeader*)shm;
+        rings[0] = (ControllerShmRing*)(shm + headerSize);
+        ringData[0] = (char*)(rings[0]+1);
+        rings[1] = (ControllerShmRing*)(shm + headerSize + ringBytes);
+        ringData[1] = (char*)(rings[1]+1);
+        shmHeader->version = CONTROLLER_PROTOCOL_VERSION;
+        shmHeader->headerSize = headerSize;
+        shmHeader->ringSize = ringSize;
+        __sync_synchronize();
+        // the magic is written last; a controller waits for it
+        memcpy(shmHeader->magic, CONTROLLER_SHM_MAGIC, 8);
+        LOG_INFO("ControllerChannel: waiting for controller on %s",
+                 shmName.c_str());
+      }
+      __sync_synchronize();
+      return *(volatile uint32_t*)&shmHeader->attached == 1;
+#endif
+    }
+
+    void ControllerChannel::closeShm(void) {
+#ifndef WIN32
+      if(shm) {
+        munmap(shm, shmSize);
+        shm_unlink(shmName.c_str());
+        shm = 0;
+        shmHeader = 0;
+      }
+#endif
+    }
+
+    bool ControllerChannel::writeRing(const char *data, std::size_t size) {
+#ifdef WIN32
+      return false;
+#else
+      ControllerShmRing *ring = rings[0];
+      uint32_t ringSize = shmHeader->ringSize;
+      uint32_t head = ring->head, pos, first;
+      long long start = 0;
+      int spins = 0;
+
+      if(size > ringSize) {
+        LOG_ERROR("ControllerChannel: message exceeds the ring size");
+        return false;
+      }
+      while(ringSize - (head - ring->tail) < size) {
+        if(++spins < 1000) continue;
+        if(!start) start = getTime();
+        else if(getTimeDiff(start) > receiveTimeout) return false;
+        sched_yield();
+      }
+      pos = head & (ringSize-1);
+      first = ringSize - pos;
+      if(first > size) first = size;
+      memcpy(ringData[0]+pos, data, first);
+      memcpy(ringData[0], data+first, size-first);
+      __sync_synchronize();
+      ring->head = head + size;
+      return true;
+#endif
+    }
+
+    bool ControllerChannel::readRing(char *data, std::size_t size) {
+#ifdef WIN32
+      return false;
+#else
+      ControllerShmRing *ring = rings[1];
+      uint32_t ringSize = shmHeader->ringSize;
+      uint32_t tail = ring->tail, pos, first;
+      long long start = 0;
+      int spins = 0;
+
+      while(ring->head - tail < size) {
+        if(++spins < 1000) continue;
+        if(!start) start = getTime();
+        else if(getTimeDiff(start) > receiveTimeout) return false;
+        sched_yield();
+      }
+      __sync_synchronize();
+      pos = tail & (ringSize-1);
+      first = ringSize - pos;
+      if(first > size) first = size;
+      memcpy(data, ringData[1]+pos, first);
+      memcpy(data+first, ringData[1], size-first);
+      __sync_synchronize();
+      ring->tail = tail + size;
+      return true;
+#endif
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
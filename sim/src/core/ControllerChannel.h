@@ -0,0 +1,142 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ControllerChannel.h
+ * \brief "ControllerChannel" exchanges the frames of the binary
+ *        controller protocol with an external process.
+ *
+ */
+
+#ifndef CONTROLLER_CHANNEL_H
+#define CONTROLLER_CHANNEL_H
+
+#ifdef _PRINT_HEADER_
+  #warning "ControllerChannel.h"
+#endif
+
+#include <mars/interfaces/MARSDefs.h>
+#include <mars/interfaces/ControllerProtocol.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    class Controller;
+
+    /**
+     * A ControllerChannel is the endpoint of the binary controller
+     * protocol (see ControllerProtocol.h). All controllers that talk to
+     * the same port share one channel, so one sensor message and one
+     * motor message per step carry the frames of all of them.
+     *
+     * The channel either connects to a tcp server, like the ascii
+     * controllers do, or creates a shared memory file that a controller
+     * process on the same host attaches to. The connection is retried
+     * once per second from exchange(). All methods are called by the
+     * ControllerManager with its controller mutex locked.
+     */
+    class ControllerChannel {
+    public:
+      enum Transport {
+        TRANSPORT_TCP,
+        TRANSPORT_SHM
+      };
+
+      ControllerChannel(Transport transport, const std::string &host,
+                        int port);
+      ~ControllerChannel(void);
+
+      void addController(Controller *controller);
+      void removeController(Controller *controller);
+      bool isEmpty(void) const;
+      bool isConnected(void) const;
+      Transport getTransport(void) const;
+
+      /** Appends the sensor frame of \a controller to the next message. */
+      void queueSensors(Controller *controller);
+
+      /**
+       * Sends the queued sensor frames, waits for the motor frames and
+       * passes them to the controllers. Does nothing if no frame is
+       * queued.
+       */
+      void exchange(interfaces::sReal simTime);
+
+    private:
+      struct Slot {
+        Controller *controller;
+        std::vector<uint32_t> sensorSizes;
+      };
+
+      ControllerChannel(const ControllerChannel &);
+      ControllerChannel &operator=(const ControllerChannel &);
+
+      Slot* getSlot(unsigned long controllerId);
+      bool connect(void);
+      void disconnect(void);
+      bool sendSchema(void);
+      void beginMessage(uint32_t type);
+      bool sendMessage(void);
+      bool receiveMessage(uint32_t type);
+      void applyMotorFrames(void);
+
+      bool openSocket(void);
+      bool sendSocket(const char *data, std::size_t size);
+      bool receiveSocket(char *data, std::size_t size);
+      bool openShm(void);
+      void closeShm(void);
+      bool writeRing(const char *data, std::size_t size);
+      bool readRing(char *data, std::size_t size);
+
+      Transport transport;
+      std::string host;
+      int port;
+      std::string shmName;
+      std::vector<Slot> slots;
+
+      bool connected;
+      bool schemaAcked;
+      uint32_t schemaId;
+      uint32_t sequence;
+      long long lastConnect;
+
+      std::vector<char> sendBuffer;
+      std::vector<char> receiveBuffer;
+      std::size_t numQueued;
+      // reused for the sensor values of one controller
+      std::vector<interfaces::sReal> values;
+      std::vector<uint32_t> sizes;
+
+      int sock;
+      char *shm;
+      std::size_t shmSize;
+      interfaces::ControllerShmHeader *shmHeader;
+      interfaces::ControllerShmRing *rings[2];
+      char *ringData[2];
+    }; // end of class ControllerChannel
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif // CONTROLLER_CHANNEL_H
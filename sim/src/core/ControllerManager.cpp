@@ -60,6 +60,13 @@ namespace mars {
       do_not_load_controller = false;
     }
 
+    ControllerManager::~ControllerManager() {
+      map<string, ControllerChannel*>::iterator it;
+      for(it=channels.begin(); it!=channels.end(); ++it) {
+        delete it->second;
+      }
+    }
+
     /**
      * \brief Gives information about core exchange data for controllers.
      *
@@ -126,6 +133,7 @@ namespace mars {
         simController.erase(iter);
         if (tmpController)
           delete tmpController;
+        removeEmptyChannels();
       }
       iMutex.unlock();
       control->sim->sceneHasChanged(false);
@@ -266,6 +274,14 @@ namespace mars {
       map<unsigned long, Controller*>::iterator iter;
       for(iter = simController.begin(); iter != simController.end(); iter++)
         iter->second->update(calc_ms);
+
+      if(!channels.empty()) {
+        double simTime = control->sim->getSimTime();
+        map<string, ControllerChannel*>::iterator it;
+        for(it=channels.begin(); it!=channels.end(); ++it) {
+          it->second->exchange(simTime);
+        }
+      }
     }
 
 
@@ -294,6 +310,7 @@ namespace mars {
         delete simController.begin()->second;
         simController.erase(simController.begin());
       }
+      removeEmptyChannels();
       /*
         for(iter = simController.begin(); iter != simController.end(); iter++)
         delete iter->second;
@@ -347,8 +364,22 @@ namespace mars {
         LOG_WARN("ControllerManager::addController: sNodes are not implemented yet and are currently ignored!");
       }
 
-      newController = new Controller(controller.rate, vmotor, vsensor, nodes,
-                                     control, std_port);
+      if(controller.protocol == "binary" || controller.protocol == "shm") {
+        // the channel is used by the physics thread
+        iMutex.lock();
+        ControllerChannel *channel = getChannel(controller.protocol, std_port);
+        newController = new Controller(controller.rate, vmotor, vsensor, nodes,
+                                       control, std_port, channel);
+        iMutex.unlock();
+      }
+      else {
+        if(!controller.protocol.empty() && controller.protocol != "ascii") {
+          LOG_WARN("ControllerManager::addController: unknown protocol \"%s\", using ascii",
+                   controller.protocol.c_str());
+        }
+        newController = new Controller(controller.rate, vmotor, vsensor, nodes,
+                                       control, std_port);
+      }
       newController->setDylibPath(controller.dylib_path);
       newController->setID(id);
       iMutex.lock();
@@ -357,6 +388,37 @@ namespace mars {
       return id;
     }
 
+    /**
+     * \brief Returns the channel shared by the binary controllers with the
+     * same protocol and port. The controller mutex has to be locked.
+     */
+    ControllerChannel* ControllerManager::getChannel(const string &protocol,
+                                                     int port) {
+      char key[64];
+      sprintf(key, "%s:%d", protocol.c_str(), port);
+      map<string, ControllerChannel*>::iterator it = channels.find(key);
+      if(it != channels.end()) return it->second;
+
+      ControllerChannel *channel;
+      channel = new ControllerChannel(protocol == "shm" ?
+                                      ControllerChannel::TRANSPORT_SHM :
+                                      ControllerChannel::TRANSPORT_TCP,
+                                      "localhost", port);
+      channels[key] = channel;
+      return channel;
+    }
+
+    void ControllerManager::removeEmptyChannels(void) {
+      map<string, ControllerChannel*>::iterator it = channels.begin();
+      while(it != channels.end()) {
+        if(it->second->isEmpty()) {
+          delete it->second;
+          channels.erase(it++);
+        }
+        else ++it;
+      }
+    }
+
     /**
      * \brief Gets the default port, with which all controllers are created.
      *
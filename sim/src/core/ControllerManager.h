@@ -39,6 +39,7 @@
 #endif
 
 #include "Controller.h"
+#include "ControllerChannel.h"
 
 #include <mars/interfaces/sim/ControlCenter.h>
 #include <mars/interfaces/sim/ControllerManagerInterface.h>
@@ -70,7 +71,7 @@ namespace mars {
       /**
        * \brief Destructor.
        */
-      virtual ~ControllerManager(){}
+      virtual ~ControllerManager();
   
       /**
        * \brief Gives information about core exchange data for controllers.
@@ -249,6 +250,12 @@ namespace mars {
       //! a containter holding all controllers in the simulation
       std::map<unsigned long, Controller*> simController;
 
+      //! the channels of the binary controllers by protocol and port
+      std::map<std::string, ControllerChannel*> channels;
+
+      ControllerChannel* getChannel(const std::string &protocol, int port);
+      void removeEmptyChannels(void);
+
       //! a pointer to the control center
       interfaces::ControlCenter *control;
 
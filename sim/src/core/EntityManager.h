@@ -41,6 +41,7 @@
 #include <mars/interfaces/graphics/GraphicsEventClient.h>
 #include <mars/interfaces/sim/EntityManagerInterface.h>
 #include <mars/utils/Mutex.h>
+#include "ObjectRegistry.h"
 #include <configmaps/ConfigData.h>
 
 namespace mars {
@@ -113,6 +114,7 @@ namespace mars {
       /**the id assigned to the next created entity; use getNextId function*/
       unsigned long next_entity_id;
       std::map<unsigned long, SimEntity*> entities;
+      ObjectRegistry<SimEntity> entityRegistry;
 
       /**returns the id to be assigned to the next entity*/
       unsigned long getNextId() {
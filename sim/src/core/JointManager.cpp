@@ -120,6 +120,7 @@ namespace mars {
         //    newJoint->setSJoint(*jointS);
         newJoint->setPhysicalJoint(newJointInterface);
         simJoints[jointS->index] = newJoint;
+        jointRegistry.add(jointS->index, jointS->name, newJoint);
         iMutex.unlock();
         control->sim->sceneHasChanged(false);
         return jointS->index;
@@ -194,6 +195,7 @@ namespace mars {
       if (iter != simJoints.end()) {
         tmpJoint = iter->second;
         simJoints.erase(iter);
+        jointRegistry.remove(index);
       }
 
       control->motors->removeJointFromMotors(index);
@@ -275,6 +277,7 @@ namespace mars {
         delete simJoints.begin()->second;
         simJoints.erase(simJoints.begin());
       }
+      jointRegistry.clear();
       control->sim->sceneHasChanged(false);
 
       next_joint_id = 1;
@@ -377,14 +380,7 @@ namespace mars {
 
 
     unsigned long JointManager::getID(const std::string& joint_name) const {
-      map<unsigned long, SimJoint*>::const_iterator iter;
-      MutexLocker locker(&iMutex);
-      for(iter = simJoints.begin(); iter != simJoints.end(); iter++) {
-        JointData joint = iter->second->getSJoint();
-        if (joint.name == joint_name)
-          return joint.index;
-      }
-      return 0;
+      return jointRegistry.getID(joint_name);
     }
 
     bool JointManager::getDataBrokerNames(unsigned long id, std::string *groupName,
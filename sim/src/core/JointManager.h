@@ -35,6 +35,8 @@
 
 #include <mars/interfaces/sim/ControlCenter.h>
 #include <mars/interfaces/sim/JointManagerInterface.h>
+#include "ObjectRegistry.h"
+
 #include <mars/utils/Mutex.h>
 
 namespace mars {
@@ -95,6 +97,7 @@ namespace mars {
     private:
       unsigned long next_joint_id;
       std::map<unsigned long, SimJoint*> simJoints;
+      ObjectRegistry<SimJoint> jointRegistry;
       std::list<interfaces::JointData> simJointsReload;
       interfaces::ControlCenter *control;
       mutable utils::Mutex iMutex;
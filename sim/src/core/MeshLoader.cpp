@@ -0,0 +1,758 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file MeshLoader.cpp
+ * \brief "MeshLoader" reads the physics meshes of the nodes without the
+ *        graphics library.
+ *
+ */
+
+#include "MeshLoader.h"
+
+#include <mars/interfaces/sim/ControlCenter.h>
+#include <mars/interfaces/NodeData.h>
+#include <mars/interfaces/Logging.hpp>
+#include <mars/utils/mathUtils.h>
+#include <mars/utils/MutexLocker.h>
+#include <mars/utils/misc.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#ifndef WIN32
+  #include <climits>
+  #include <unistd.h>
+#endif
+
+#define MESH_CACHE_MAGIC "MARSMESH"
+#define MESH_CACHE_VERSION 1
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+    using namespace interfaces;
+
+    namespace {
+
+      struct MeshCacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t keySize;
+        int64_t mtime;
+        uint32_t numVertices;
+        uint32_t numIndices;
+        float min[3], max[3];
+      };
+
+      bool readFile(const std::string &filename, std::vector<char> *data) {
+        FILE *file = fopen(filename.c_str(), "rb");
+        if(!file) return false;
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        if(size < 0) {
+          fclose(file);
+          return false;
+        }
+        // the terminating zero allows to parse text files in place
+        data->resize(size+1);
+        bool ok = ((long)fread(&(*data)[0], 1, size, file) == size);
+        (*data)[size] = '\0';
+        data->resize(size);
+        fclose(file);
+        return ok;
+      }
+
+      long long getModificationTime(const std::string &filename) {
+        struct stat fileStat;
+        if(stat(filename.c_str(), &fileStat) != 0) return -1;
+        return (long long)fileStat.st_mtime;
+      }
+
+      const char* skipSpace(const char *p) {
+        while(*p == ' ' || *p == '\t') ++p;
+        return p;
+      }
+
+      const char* nextLine(const char *p) {
+        while(*p && *p != '\n') ++p;
+        if(*p) ++p;
+        return p;
+      }
+
+      std::string readName(const char *p) {
+        const char *begin = skipSpace(p);
+        const char *end = begin;
+        while(*end && *end != '\n' && *end != '\r') ++end;
+        while(end > begin && (end[-1] == ' ' || end[-1] == '\t')) --end;
+        return std::string(begin, end);
+      }
+
+      struct VertexKey {
+        double x, y, z;
+        int index;
+        bool operator<(const VertexKey &other) const {
+          if(x != other.x) return x < other.x;
+          if(y != other.y) return y < other.y;
+          return z < other.z;
+        }
+        bool samePosition(const VertexKey &other) const {
+          return x == other.x && y == other.y && z == other.z;
+        }
+      };
+
+      /**
+       * Merges the vertices with the same key into the first one of them
+       * and removes the degenerated triangles. The position of a merged
+       * vertex is the mean of its sources if \a average is set.
+       */
+      void mergeVertices(MeshData *mesh, std::vector<VertexKey> &keys,
+                         bool average) {
+        std::vector<int> remap(keys.size());
+        std::vector<float> vertices;
+        std::vector<int> counts;
+        std::sort(keys.begin(), keys.end());
+
+        for(size_t i=0; i<keys.size(); ++i) {
+          const float *v = &mesh->vertices[keys[i].index*3];
+          if(i == 0 || !keys[i].samePosition(keys[i-1])) {
+            vertices.push_back(v[0]);
+            vertices.push_back(v[1]);
+            vertices.push_back(v[2]);
+            counts.push_back(1);
+          }
+          else if(average) {
+            float *m = &vertices[vertices.size()-3];
+            m[0] += v[0];
+            m[1] += v[1];
+            m[2] += v[2];
+            counts.back() += 1;
+          }
+          remap[keys[i].index] = counts.size()-1;
+        }
+        if(average) {
+          for(size_t i=0; i<counts.size(); ++i) {
+            vertices[i*3] /= counts[i];
+            vertices[i*3+1] /= counts[i];
+            vertices[i*3+2] /= counts[i];
+          }
+        }
+
+        std::vector<int> indices;
+        indices.reserve(mesh->indices.size());
+        for(size_t i=0; i+2<mesh->indices.size(); i+=3) {
+          int a = remap[mesh->indices[i]];
+          int b = remap[mesh->indices[i+1]];
+          int c = remap[mesh->indices[i+2]];
+          if(a == b || b == c || a == c) continue;
+          indices.push_back(a);
+          indices.push_back(b);
+          indices.push_back(c);
+        }
+        mesh->vertices.swap(vertices);
+        mesh->indices.swap(indices);
+      }
+
+      /** Removes the vertices that are not used by any triangle. */
+      void removeUnusedVertices(MeshData *mesh) {
+        std::vector<int> remap(mesh->vertices.size()/3, -1);
+        std::vector<float> vertices;
+        for(size_t i=0; i<mesh->indices.size(); ++i) {
+          int &index = remap[mesh->indices[i]];
+          if(index < 0) {
+            index = vertices.size()/3;
+            vertices.push_back(mesh->vertices[mesh->indices[i]*3]);
+            vertices.push_back(mesh->vertices[mesh->indices[i]*3+1]);
+            vertices.push_back(mesh->vertices[mesh->indices[i]*3+2]);
+          }
+          mesh->indices[i] = index;
+        }
+        mesh->vertices.swap(vertices);
+      }
+
+      /** Removes triangles with the same vertices; the winding is kept. */
+      void removeDuplicateTriangles(MeshData *mesh) {
+        std::vector<std::pair<std::pair<int, int>, std::pair<int, int> > > tris;
+        size_t numTriangles = mesh->indices.size()/3;
+        tris.reserve(numTriangles);
+        for(size_t i=0; i<numTriangles; ++i) {
+          int v[3] = {mesh->indices[i*3], mesh->indices[i*3+1],
+                      mesh->indices[i*3+2]};
+          std::sort(v, v+3);
+          tris.push_back(std::make_pair(std::make_pair(v[0], v[1]),
+                                        std::make_pair(v[2], (int)i)));
+        }
+        std::sort(tris.begin(), tris.end());
+        std::vector<bool> keep(numTriangles, false);
+        for(size_t i=0; i<tris.size(); ++i) {
+          if(i == 0 || tris[i].first != tris[i-1].first ||
+             tris[i].second.first != tris[i-1].second.first) {
+            keep[tris[i].second.second] = true;
+          }
+        }
+        std::vector<int> indices;
+        indices.reserve(mesh->indices.size());
+        for(size_t i=0; i<numTriangles; ++i) {
+          if(!keep[i]) continue;
+          indices.push_back(mesh->indices[i*3]);
+          indices.push_back(mesh->indices[i*3+1]);
+          indices.push_back(mesh->indices[i*3+2]);
+        }
+        mesh->indices.swap(indices);
+      }
+
+      void clusterVertices(const MeshData &source, int resolution,
+                           MeshData *mesh) {
+        double cell[3];
+        for(int k=0; k<3; ++k) {
+          cell[k] = (source.max[k] - source.min[k]) / resolution;
+          if(cell[k] <= 0) cell[k] = 1;
+        }
+        *mesh = source;
+        std::vector<VertexKey> keys(mesh->vertices.size()/3);
+        for(size_t i=0; i<keys.size(); ++i) {
+          const float *v = &mesh->vertices[i*3];
+          double c[3];
+          for(int k=0; k<3; ++k) {
+            c[k] = floor((v[k] - source.min[k]) / cell[k]);
+            if(c[k] >= resolution) c[k] = resolution-1;
+          }
+          keys[i].x = c[0];
+          keys[i].y = c[1];
+          keys[i].z = c[2];
+          keys[i].index = i;
+        }
+        mergeVertices(mesh, keys, true);
+        removeDuplicateTriangles(mesh);
+        removeUnusedVertices(mesh);
+      }
+
+      /** 64 bit FNV-1a hash of the cache key */
+      uint64_t hashKey(const std::string &key) {
+        uint64_t hash = 14695981039346656037ULL;
+        for(size_t i=0; i<key.size(); ++i) {
+          hash ^= (unsigned char)key[i];
+          hash *= 1099511628211ULL;
+        }
+        return hash;
+      }
+
+    } // end of anonymous namespace
+
+    MeshLoader::MeshLoader() : fallback(NULL), maxTriangles(0) {
+    }
+
+    MeshLoader::~MeshLoader() {
+      std::map<std::string, MeshData*>::iterator it;
+      for(it=meshes.begin(); it!=meshes.end(); ++it) {
+        delete it->second;
+      }
+    }
+
+    void MeshLoader::setFallback(LoadMeshInterface *fallback) {
+      this->fallback = fallback;
+    }
+
+    void MeshLoader::setCachePath(const std::string &path) {
+      cachePath = path;
+    }
+
+    void MeshLoader::setMaxTriangles(int maxTriangles) {
+      this->maxTriangles = maxTriangles;
+    }
+
+    bool MeshLoader::isSupported(const std::string &filename) {
+      std::string suffix = utils::tolower(utils::getFilenameSuffix(filename));
+      return (suffix == ".obj" || suffix == ".stl" || suffix == ".bobj");
+    }
+
+    void MeshLoader::getPhysicsFromMesh(NodeData *node) {
+      if(!isSupported(node->filename)) {
+        if(fallback) {
+          fallback->getPhysicsFromMesh(node);
+          return;
+        }
+        LOG_ERROR("MeshLoader: no loader for mesh %s",
+                  node->filename.c_str());
+        throw std::runtime_error("cannot read node from file");
+      }
+
+      int limit = maxTriangles;
+      if(node->map.find("maxTriangles") != node->map.end()) {
+        limit = (int)node->map["maxTriangles"];
+      }
+      const MeshData *mesh = getMesh(node->filename, node->origName, limit);
+      if(!mesh) {
+        throw std::runtime_error("cannot read node from file");
+      }
+
+      Vector ex(mesh->max[0] - mesh->min[0],
+                mesh->max[1] - mesh->min[1],
+                mesh->max[2] - mesh->min[2]);
+      if (node->map.find("loadSizeFromMesh") != node->map.end()) {
+        if (node->map["loadSizeFromMesh"]) {
+          Vector physicalScale;
+          utils::vectorFromConfigItem(&(node->map["physicalScale"][0]), &physicalScale);
+          node->ext=Vector(ex.x()*physicalScale.x(), ex.y()*physicalScale.y(), ex.z()*physicalScale.z());
+        }
+      }
+
+      //compute scale factor
+      double scale[3] = {1, 1, 1};
+      if (ex.x() != 0) scale[0] = node->ext.x() / ex.x();
+      if (ex.y() != 0) scale[1] = node->ext.y() / ex.y();
+      if (ex.z() != 0) scale[2] = node->ext.z() / ex.z();
+      double pivot[3] = {node->pivot.x(), node->pivot.y(), node->pivot.z()};
+
+      int numVertices = mesh->vertices.size()/3;
+      int numIndices = mesh->indices.size();
+      node->mesh.vertices = 0;
+      node->mesh.indices = 0;
+      if(numVertices > 0) {
+        node->mesh.vertices = new mydVector3[numVertices];
+      }
+      if(numIndices > 0) {
+        node->mesh.indices = new int[numIndices];
+      }
+      for(int i=0; i<numVertices; ++i) {
+        for(int k=0; k<3; ++k) {
+          node->mesh.vertices[i][k] = (mesh->vertices[i*3+k] - pivot[k]) * scale[k];
+        }
+        node->mesh.vertices[i][3] = 0;
+      }
+      if(numIndices > 0) {
+        memcpy(node->mesh.indices, &mesh->indices[0], numIndices*sizeof(int));
+      }
+      node->mesh.vertexcount = numVertices;
+      node->mesh.indexcount = numIndices;
+    }
+
+    std::vector<double> MeshLoader::getMeshSize(const std::string &filename) {
+      if(!isSupported(filename) && fallback) {
+        return fallback->getMeshSize(filename);
+      }
+      std::vector<double> r(3, 0.0);
+      const MeshData *mesh = NULL;
+      if(isSupported(filename)) {
+        mesh = getMesh(filename, "", maxTriangles);
+      }
+      if(mesh) {
+        for(int k=0; k<3; ++k) {
+          r[k] = mesh->max[k] - mesh->min[k];
+        }
+      }
+      return r;
+    }
+
+    const MeshData* MeshLoader::getMesh(const std::string &filename,
+                                        const std::string &objectName,
+                                        int maxTriangles) {
+      std::string path = filename;
+#ifndef WIN32
+      char resolved[PATH_MAX];
+      if(realpath(filename.c_str(), resolved)) path = resolved;
+#endif
+      std::stringstream keyStream;
+      keyStream << path << "\n" << objectName << "\n" << maxTriangles;
+      std::string key = keyStream.str();
+
+      meshMutex.lock();
+      std::map<std::string, MeshData*>::iterator it = meshes.find(key);
+      if(it != meshes.end()) {
+        MeshData *mesh = it->second;
+        meshMutex.unlock();
+        return mesh;
+      }
+      meshMutex.unlock();
+
+      // the mesh is read without holding the lock
+      long long mtime = getModificationTime(path);
+      std::string cacheFile = getCacheFile(key);
+      MeshData *mesh = new MeshData();
+      if(cacheFile.empty() || !readCache(cacheFile, key, mtime, mesh)) {
+        if(!readMesh(path, objectName, mesh)) {
+          LOG_ERROR("MeshLoader: could not read mesh %s", filename.c_str());
+          delete mesh;
+          return NULL;
+        }
+        weldVertices(mesh);
+        // the scale of the node refers to the size of the original mesh
+        computeBounds(mesh);
+        float min[3], max[3];
+        memcpy(min, mesh->min, sizeof(min));
+        memcpy(max, mesh->max, sizeof(max));
+        if(maxTriangles > 0) decimate(mesh, maxTriangles);
+        memcpy(mesh->min, min, sizeof(min));
+        memcpy(mesh->max, max, sizeof(max));
+        if(!cacheFile.empty()) writeCache(cacheFile, key, mtime, *mesh);
+      }
+
+      MutexLocker locker(&meshMutex);
+      it = meshes.find(key);
+      if(it != meshes.end()) {
+        delete mesh;
+        return it->second;
+      }
+      meshes[key] = mesh;
+      return mesh;
+    }
+
+    bool MeshLoader::readMesh(const std::string &filename,
+                              const std::string &objectName,
+                              MeshData *mesh) const {
+      std::string suffix = utils::tolower(utils::getFilenameSuffix(filename));
+      if(suffix == ".obj") return readObj(filename, objectName, mesh);
+      if(suffix == ".stl") return readStl(filename, mesh);
+      if(suffix == ".bobj") return readBobj(filename, mesh);
+      return false;
+    }
+
+    /**
+     * Reads the vertices and faces of an .obj file. If \a objectName is
+     * not empty, only the faces of the object or group with this name are
+     * used; if no such object exists, all faces are used.
+     */
+    bool MeshLoader::readObj(const std::string &filename,
+                             const std::string &objectName, MeshData *mesh) {
+      std::vector<char> data;
+      if(!readFile(filename, &data)) return false;
+      data.push_back('\0');
+
+      std::vector<int> allIndices, objectIndices;
+      std::vector<int> face;
+      std::string object, group;
+      bool selected = objectName.empty();
+      mesh->vertices.clear();
+      mesh->indices.clear();
+
+      const char *p = &data[0];
+      while(*p) {
+        p = skipSpace(p);
+        if(p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+          char *end;
+          p += 2;
+          for(int k=0; k<3; ++k) {
+            mesh->vertices.push_back((float)strtod(p, &end));
+            p = end;
+          }
+        }
+        else if(p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+          int numVertices = mesh->vertices.size()/3;
+          face.clear();
+          p += 2;
+          while(true) {
+            p = skipSpace(p);
+            if(*p == '\0' || *p == '\n' || *p == '\r') break;
+            char *end;
+            long index = strtol(p, &end, 10);
+            if(end == p) break;
+            // negative indices are relative to the end of the vertex list
+            index = (index < 0) ? numVertices + index : index - 1;
+            if(index < 0 || index >= numVertices) return false;
+            face.push_back(index);
+            p = end;
+            // skip texture coordinate and normal indices
+            while(*p && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') ++p;
+          }
+          for(size_t i=2; i<face.size(); ++i) {
+            int triangle[3] = {face[0], face[i-1], face[i]};
+            allIndices.insert(allIndices.end(), triangle, triangle+3);
+            if(!objectName.empty() && selected) {
+              objectIndices.insert(objectIndices.end(), triangle, triangle+3);
+            }
+          }
+        }
+        else if((p[0] == 'o' || p[0] == 'g') && (p[1] == ' ' || p[1] == '\t')) {
+          if(p[0] == 'o') {
+            // a group does not reach into the next object
+            object = readName(p+2);
+            group.clear();
+          }
+          else group = readName(p+2);
+          selected = (objectName.empty() || object == objectName ||
+                      group == objectName);
+        }
+        p = nextLine(p);
+      }
+
+      if(!objectIndices.empty()) mesh->indices.swap(objectIndices);
+      else mesh->indices.swap(allIndices);
+      return !mesh->indices.empty();
+    }
+
+    bool MeshLoader::readStl(const std::string &filename, MeshData *mesh) {
+      std::vector<char> data;
+      if(!readFile(filename, &data)) return false;
+      mesh->vertices.clear();
+      mesh->indices.clear();
+
+      // binary files have an 80 byte header, the number of triangles and
+      // 50 bytes per triangle; ascii files start with "solid" but some
+      // binary files do too, so the size is the better test
+      if(data.size() >= 84) {
+        uint32_t numTriangles;
+        memcpy(&numTriangles, &data[80], sizeof(uint32_t));
+        if(data.size() == 84 + (size_t)numTriangles*50) {
+          mesh->vertices.resize((size_t)numTriangles*9);
+          mesh->indices.resize((size_t)numTriangles*3);
+          for(size_t i=0; i<numTriangles; ++i) {
+            // skip the normal
+            memcpy(&mesh->vertices[i*9], &data[84 + i*50 + 12],
+                   9*sizeof(float));
+            mesh->indices[i*3] = i*3;
+            mesh->indices[i*3+1] = i*3+1;
+            mesh->indices[i*3+2] = i*3+2;
+          }
+          return numTriangles > 0;
+        }
+      }
+
+      data.push_back('\0');
+      const char *p = &data[0];
+      while((p = strstr(p, "vertex")) != NULL) {
+        char *end;
+        p += 6;
+        for(int k=0; k<3; ++k) {
+          mesh->vertices.push_back((float)strtod(p, &end));
+          p = end;
+        }
+      }
+      size_t numVertices = (mesh->vertices.size()/9)*3;
+      mesh->vertices.resize(numVertices*3);
+      mesh->indices.resize(numVertices);
+      for(size_t i=0; i<numVertices; ++i) {
+        mesh->indices[i] = i;
+      }
+      return numVertices > 0;
+    }
+
+    /**
+     * The .bobj format is a sequence of records that start with an int
+     * type: 1 vertex (3 floats), 2 texture coordinate (2 floats),
+     * 3 normal (3 floats) and 4 face (3 times vertex, texture coordinate
+     * and normal index starting at 1).
+     */
+    bool MeshLoader::readBobj(const std::string &filename, MeshData *mesh) {
+      std::vector<char> data;
+      if(!readFile(filename, &data)) return false;
+      mesh->vertices.clear();
+      mesh->indices.clear();
+
+      size_t o = 0;
+      while(o + sizeof(int) <= data.size()) {
+        int type;
+        memcpy(&type, &data[o], sizeof(int));
+        o += sizeof(int);
+        if(type == 1) {
+          if(o + 3*sizeof(float) > data.size()) return false;
+          float v[3];
+          memcpy(v, &data[o], sizeof(v));
+          mesh->vertices.insert(mesh->vertices.end(), v, v+3);
+          o += sizeof(v);
+        }
+        else if(type == 2) {
+          o += 2*sizeof(float);
+        }
+        else if(type == 3) {
+          o += 3*sizeof(float);
+        }
+        else if(type == 4) {
+          if(o + 9*sizeof(int) > data.size()) return false;
+          int f[9];
+          memcpy(f, &data[o], sizeof(f));
+          o += sizeof(f);
+          for(int i=0; i<9; i+=3) {
+            if(f[i] < 1 || f[i] > (int)mesh->vertices.size()/3) return false;
+            mesh->indices.push_back(f[i]-1);
+          }
+        }
+        else {
+          return false;
+        }
+      }
+      return !mesh->indices.empty();
+    }
+
+    void MeshLoader::weldVertices(MeshData *mesh, float epsilon) {
+      std::vector<VertexKey> keys(mesh->vertices.size()/3);
+      for(size_t i=0; i<keys.size(); ++i) {
+        const float *v = &mesh->vertices[i*3];
+        if(epsilon > 0) {
+          keys[i].x = floor(v[0] / epsilon + 0.5);
+          keys[i].y = floor(v[1] / epsilon + 0.5);
+          keys[i].z = floor(v[2] / epsilon + 0.5);
+        }
+        else {
+          keys[i].x = v[0];
+          keys[i].y = v[1];
+          keys[i].z = v[2];
+        }
+        keys[i].index = i;
+      }
+      mergeVertices(mesh, keys, false);
+      removeUnusedVertices(mesh);
+    }
+
+    void MeshLoader::decimate(MeshData *mesh, int maxTriangles) {
+      if(maxTriangles <= 0 || (int)mesh->indices.size()/3 <= maxTriangles) {
+        return;
+      }
+      computeBounds(mesh);
+
+      // search the finest grid that reduces the mesh enough
+      MeshData best, current;
+      int low = 1, high = 1024;
+      clusterVertices(*mesh, low, &best);
+      while(low < high) {
+        int resolution = (low + high + 1) / 2;
+        clusterVertices(*mesh, resolution, &current);
+        if((int)current.indices.size()/3 <= maxTriangles) {
+          low = resolution;
+          best.vertices.swap(current.vertices);
+          best.indices.swap(current.indices);
+        }
+        else {
+          high = resolution - 1;
+        }
+      }
+      mesh->vertices.swap(best.vertices);
+      mesh->indices.swap(best.indices);
+      computeBounds(mesh);
+    }
+
+    void MeshLoader::computeBounds(MeshData *mesh) {
+      for(int k=0; k<3; ++k) {
+        mesh->min[k] = mesh->max[k] = 0.0f;
+      }
+      for(size_t i=0; i+2<mesh->vertices.size(); i+=3) {
+        for(int k=0; k<3; ++k) {
+          float v = mesh->vertices[i+k];
+          if(i == 0 || v < mesh->min[k]) mesh->min[k] = v;
+          if(i == 0 || v > mesh->max[k]) mesh->max[k] = v;
+        }
+      }
+    }
+
+    std::string MeshLoader::getCacheFile(const std::string &key) const {
+      if(cachePath.empty()) return "";
+      char name[32];
+      snprintf(name, sizeof(name), "%016llx.mesh",
+               (unsigned long long)hashKey(key));
+      return pathJoin(cachePath, name);
+    }
+
+    bool MeshLoader::readCache(const std::string &cacheFile,
+                               const std::string &key, long long mtime,
+                               MeshData *mesh) const {
+      FILE *file = fopen(cacheFile.c_str(), "rb");
+      if(!file) return false;
+      MeshCacheHeader header;
+      bool ok = (fread(&header, sizeof(header), 1, file) == 1 &&
+                 memcmp(header.magic, MESH_CACHE_MAGIC, 8) == 0 &&
+                 header.version == MESH_CACHE_VERSION &&
+                 header.mtime == mtime && header.keySize == key.size());
+      if(ok) {
+        std::string fileKey(key.size(), '\0');
+        ok = (key.empty() ||
+              fread(&fileKey[0], 1, key.size(), file) == key.size()) &&
+          fileKey == key;
+      }
+      if(ok) {
+        mesh->vertices.resize((size_t)header.numVertices*3);
+        mesh->indices.resize(header.numIndices);
+        ok = (mesh->vertices.empty() ||
+              fread(&mesh->vertices[0], sizeof(float), mesh->vertices.size(),
+                    file) == mesh->vertices.size()) &&
+          (mesh->indices.empty() ||
+           fread(&mesh->indices[0], sizeof(int), mesh->indices.size(),
+                 file) == mesh->indices.size());
+        memcpy(mesh->min, header.min, sizeof(header.min));
+        memcpy(mesh->max, header.max, sizeof(header.max));
+        for(size_t i=0; ok && i<mesh->indices.size(); ++i) {
+          ok = (mesh->indices[i] >= 0 &&
+                mesh->indices[i] < (int)header.numVertices);
+        }
+      }
+      fclose(file);
+      return ok && !mesh->indices.empty();
+    }
+
+    void MeshLoader::writeCache(const std::string &cacheFile,
+                                const std::string &key, long long mtime,
+                                const MeshData &mesh) const {
+      MeshCacheHeader header;
+      memcpy(header.magic, MESH_CACHE_MAGIC, 8);
+      header.version = MESH_CACHE_VERSION;
+      header.keySize = key.size();
+      header.mtime = mtime;
+      header.numVertices = mesh.vertices.size()/3;
+      header.numIndices = mesh.indices.size();
+      memcpy(header.min, mesh.min, sizeof(header.min));
+      memcpy(header.max, mesh.max, sizeof(header.max));
+
+      createDirectory(cachePath);
+      // several processes may share the cache, so the file is written
+      // under a temporary name first
+      std::string tmpFile = cacheFile;
+#ifndef WIN32
+      std::stringstream s;
+      s << cacheFile << "." << getpid();
+      tmpFile = s.str();
+#endif
+      FILE *file = fopen(tmpFile.c_str(), "wb");
+      if(!file) {
+        LOG_WARN("MeshLoader: could not write mesh cache %s",
+                 cacheFile.c_str());
+        return;
+      }
+      bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+      if(!key.empty()) {
+        ok &= fwrite(key.data(), 1, key.size(), file) == key.size();
+      }
+      if(!mesh.vertices.empty()) {
+        ok &= fwrite(&mesh.vertices[0], sizeof(float), mesh.vertices.size(),
+                     file) == mesh.vertices.size();
+      }
+      if(!mesh.indices.empty()) {
+        ok &= fwrite(&mesh.indices[0], sizeof(int), mesh.indices.size(),
+                     file) == mesh.indices.size();
+      }
+      ok &= (fclose(file) == 0);
+#ifndef WIN32
+      if(ok) ok = (rename(tmpFile.c_str(), cacheFile.c_str()) == 0);
+      if(!ok) remove(tmpFile.c_str());
+#endif
+      if(!ok) {
+        LOG_WARN("MeshLoader: could not write mesh cache %s",
+                 cacheFile.c_str());
+      }
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,134 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file MeshLoader.h
+ * \brief "MeshLoader" reads the physics meshes of the nodes without the
+ *        graphics library.
+ *
+ */
+
+#ifndef MESH_LOADER_H
+#define MESH_LOADER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "MeshLoader.h"
+#endif
+
+#include <mars/interfaces/sim/LoadCenter.h>
+#include <mars/utils/Mutex.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    /**
+     * An indexed triangle mesh. The vertices are stored as x, y, z
+     * triples and every three indices form a triangle.
+     */
+    struct MeshData {
+      std::vector<float> vertices;
+      std::vector<int> indices;
+      float min[3], max[3];
+    };
+
+    /**
+     * The MeshLoader reads .obj, .stl and .bobj files, welds vertices with
+     * the same position and, if requested, reduces the number of triangles
+     * of the collision mesh by vertex clustering.
+     *
+     * The welded mesh is kept in memory for the lifetime of the loader and
+     * written to a binary cache file. The cache is keyed by the path, the
+     * modification time and the sub-object of the mesh file and by the
+     * triangle limit; the node scale is applied when the mesh is copied
+     * into the NodeData, so one cache entry serves every scale. Other
+     * file types are passed to the fallback loader if one is set, e.g. the
+     * one of the graphics library.
+     */
+    class MeshLoader : public interfaces::LoadMeshInterface {
+    public:
+      MeshLoader();
+      virtual ~MeshLoader();
+
+      virtual void getPhysicsFromMesh(interfaces::NodeData *node);
+      virtual std::vector<double> getMeshSize(const std::string &filename);
+
+      void setFallback(interfaces::LoadMeshInterface *fallback);
+      /**
+       * Sets the directory of the binary cache files. An empty path
+       * disables the cache.
+       */
+      void setCachePath(const std::string &path);
+      /**
+       * Meshes with more triangles are reduced to at most \a maxTriangles.
+       * 0 keeps all triangles. A node can override the limit with the
+       * "maxTriangles" entry of its config map.
+       */
+      void setMaxTriangles(int maxTriangles);
+
+      static bool isSupported(const std::string &filename);
+
+      static bool readObj(const std::string &filename,
+                          const std::string &objectName, MeshData *mesh);
+      static bool readStl(const std::string &filename, MeshData *mesh);
+      static bool readBobj(const std::string &filename, MeshData *mesh);
+
+      /**
+       * Merges the vertices whose distance is below \a epsilon and
+       * removes the triangles that collapse by this. An \a epsilon of
+       * zero only merges vertices with the same position.
+       */
+      static void weldVertices(MeshData *mesh, float epsilon = 0.0f);
+      /**
+       * Reduces the mesh to at most \a maxTriangles by clustering the
+       * vertices into a regular grid.
+       */
+      static void decimate(MeshData *mesh, int maxTriangles);
+      static void computeBounds(MeshData *mesh);
+
+    private:
+      interfaces::LoadMeshInterface *fallback;
+      std::string cachePath;
+      int maxTriangles;
+      std::map<std::string, MeshData*> meshes;
+      utils::Mutex meshMutex;
+
+      const MeshData* getMesh(const std::string &filename,
+                              const std::string &objectName,
+                              int maxTriangles);
+      bool readMesh(const std::string &filename,
+                    const std::string &objectName, MeshData *mesh) const;
+      std::string getCacheFile(const std::string &key) const;
+      bool readCache(const std::string &cacheFile, const std::string &key,
+                     long long mtime, MeshData *mesh) const;
+      void writeCache(const std::string &cacheFile, const std::string &key,
+                      long long mtime, const MeshData &mesh) const;
+
+      MeshLoader(const MeshLoader &);
+      MeshLoader &operator=(const MeshLoader &);
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // MESH_LOADER_H
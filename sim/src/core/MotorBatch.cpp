@@ -0,0 +1,376 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MotorBatch.h"
+#include "SimMotor.h"
+#include "SimJoint.h"
+
+#include <mars/utils/mathUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mars {
+  namespace sim {
+
+    using namespace interfaces;
+
+    MotorBatch::MotorBatch() : dirty(true) {
+    }
+
+    void MotorBatch::invalidate() {
+      dirty = true;
+    }
+
+    void MotorBatch::Group::clear() {
+      motors.clear();
+      joints.clear();
+      axis.clear();
+      p.clear();
+      i.clear();
+      d.clear();
+      minValue.clear();
+      maxValue.clear();
+      maxSpeed.clear();
+      maxEffort.clear();
+      mimicMultiplier.clear();
+      mimicOffset.clear();
+      heatTransfer.clear();
+      ambientTemperature.clear();
+      voltage.clear();
+      heatLoss.clear();
+      active.clear();
+      controlValue.clear();
+      position.clear();
+      error.clear();
+      integError.clear();
+      lastError.clear();
+      velocity.clear();
+      effort.clear();
+      jointVelocity.clear();
+      current.clear();
+      temperature.clear();
+      appliedEffortLimit.clear();
+      effortLimitVersion.clear();
+    }
+
+    void MotorBatch::Group::add(SimMotor *motor) {
+      motors.push_back(motor);
+      joints.push_back(motor->myJoint);
+      axis.push_back(motor->axis);
+      p.push_back(motor->sMotor.p);
+      i.push_back(motor->sMotor.i);
+      d.push_back(motor->sMotor.d);
+      minValue.push_back(motor->sMotor.minValue);
+      maxValue.push_back(motor->sMotor.maxValue);
+      maxSpeed.push_back(motor->sMotor.maxSpeed);
+      maxEffort.push_back(motor->sMotor.maxEffort);
+      mimicMultiplier.push_back(motor->mimic_multiplier);
+      mimicOffset.push_back(motor->mimic_offset);
+      heatTransfer.push_back(motor->heatTransferCoefficient);
+      ambientTemperature.push_back(motor->ambientTemperature);
+      voltage.push_back(motor->voltage);
+      heatLoss.push_back(motor->heatlossCoefficient);
+      active.push_back(0);
+      controlValue.push_back(0);
+      position.push_back(0);
+      error.push_back(0);
+      integError.push_back(0);
+      lastError.push_back(0);
+      velocity.push_back(0);
+      effort.push_back(0);
+      jointVelocity.push_back(0);
+      current.push_back(0);
+      temperature.push_back(0);
+      appliedEffortLimit.push_back(std::numeric_limits<sReal>::quiet_NaN());
+      effortLimitVersion.push_back(0);
+    }
+
+    bool MotorBatch::isBatchable(const SimMotor *motor) {
+      if(!motor->myJoint || motor->myPlayJoint) return false;
+      // the mimics are set by their parent during its update
+      if(motor->mimic || !motor->mimics.empty()) return false;
+      if(motor->maxSpeedApproximation != &utils::pipe ||
+         motor->maxspeed_x != &motor->sMotor.maxSpeed) return false;
+      if(motor->maxEffortApproximation != &utils::pipe ||
+         motor->maxeffort_x != &motor->sMotor.maxEffort) return false;
+      return motor->position == &motor->position1;
+    }
+
+    bool MotorBatch::needsRebuild(const std::vector<SimMotor*> &motors) const {
+      if(dirty || versions.size() != motors.size()) return true;
+      for(size_t k = 0; k < motors.size(); ++k) {
+        if(motors[k]->paramVersion != versions[k]) return true;
+      }
+      return false;
+    }
+
+    void MotorBatch::rebuild(const std::vector<SimMotor*> &motors) {
+      for(int g = 0; g < NUM_GROUPS; ++g) groups[g].clear();
+      scalarMotors.clear();
+      versions.clear();
+
+      for(size_t k = 0; k < motors.size(); ++k) {
+        SimMotor *motor = motors[k];
+        versions.push_back(motor->paramVersion);
+        if(!isBatchable(motor)) {
+          scalarMotors.push_back(motor);
+        }
+        else if(motor->runController == &SimMotor::runPositionController &&
+                motor->controlParameter == &motor->velocity &&
+                motor->setJointControlParameter == &SimJoint::setVelocity) {
+          groups[POSITION_GROUP].add(motor);
+        }
+        else if(motor->runController == &SimMotor::runVeloctiyController &&
+                motor->controlParameter == &motor->velocity &&
+                motor->setJointControlParameter == &SimJoint::setVelocity) {
+          groups[VELOCITY_GROUP].add(motor);
+        }
+        else if(motor->runController == &SimMotor::runEffortController &&
+                motor->controlParameter == &motor->effort &&
+                motor->setJointControlParameter == &SimJoint::setEffort) {
+          groups[EFFORT_GROUP].add(motor);
+        }
+        else {
+          scalarMotors.push_back(motor);
+        }
+      }
+      dirty = false;
+    }
+
+    void MotorBatch::update(const std::vector<SimMotor*> &motors,
+                            sReal time_ms) {
+      if(needsRebuild(motors)) rebuild(motors);
+
+      for(size_t k = 0; k < scalarMotors.size(); ++k) {
+        scalarMotors[k]->update(time_ms);
+      }
+
+      for(int g = 0; g < NUM_GROUPS; ++g) {
+        Group *group = groups + g;
+        if(!group->size()) continue;
+        gather(group, time_ms);
+        switch(g) {
+        case POSITION_GROUP:
+          runPositionControllers(group, time_ms);
+          break;
+        case VELOCITY_GROUP:
+          runVelocityControllers(group);
+          break;
+        case EFFORT_GROUP:
+          runEffortControllers(group, time_ms);
+          break;
+        }
+        applyLimits(group);
+        estimate(group, time_ms);
+        scatter(group, (GroupType)g);
+      }
+    }
+
+    void MotorBatch::gather(Group *group, sReal time_ms) {
+      const size_t n = group->size();
+      for(size_t k = 0; k < n; ++k) {
+        SimMotor *motor = group->motors[k];
+        motor->time = time_ms;
+        group->active[k] = motor->active;
+        if(!motor->active) continue;
+        motor->refreshPosition();
+        group->position[k] = *motor->position;
+        group->controlValue[k] = motor->controlValue;
+        group->integError[k] = motor->integ_error;
+        group->lastError[k] = motor->last_error;
+        group->velocity[k] = motor->velocity;
+        group->temperature[k] = motor->temperature;
+      }
+    }
+
+    /*
+     * The controllers below are SimMotor::runPositionController(),
+     * runVeloctiyController() and runEffortController() with the branches
+     * written as selects, so the loops can be vectorized. The arithmetic
+     * is done in the same order to get the same results.
+     */
+    void MotorBatch::runPositionControllers(Group *group, sReal time_ms) {
+      const size_t n = group->size();
+      const sReal *p = &group->p[0], *i = &group->i[0], *d = &group->d[0];
+      const sReal *minValue = &group->minValue[0];
+      const sReal *maxValue = &group->maxValue[0];
+      const sReal *maxSpeed = &group->maxSpeed[0];
+      const sReal *multiplier = &group->mimicMultiplier[0];
+      const sReal *offset = &group->mimicOffset[0];
+      const sReal *position = &group->position[0];
+      sReal *controlValue = &group->controlValue[0];
+      sReal *error = &group->error[0];
+      sReal *integError = &group->integError[0];
+      sReal *lastError = &group->lastError[0];
+      sReal *velocity = &group->velocity[0];
+
+      for(size_t k = 0; k < n; ++k) {
+        sReal value = multiplier[k] * controlValue[k] + offset[k];
+        value = std::max(minValue[k], std::min(value, maxValue[k]));
+        sReal e = value - position[k];
+        e = std::fabs(e) < 0.000001 ? 0.0 : e;
+        sReal integ = integError[k] + e*time_ms;
+
+        // anti wind up
+        sReal iPart = integ * i[k];
+        const bool upper = iPart > maxSpeed[k];
+        iPart = upper ? maxSpeed[k] : iPart;
+        integ = upper ? maxSpeed[k] / i[k] : integ;
+        const bool lower = iPart < -maxSpeed[k];
+        iPart = lower ? -maxSpeed[k] : iPart;
+        integ = lower ? -maxSpeed[k] / i[k] : integ;
+
+        sReal v = 0;
+        v += e * p[k];
+        v += iPart;
+        v += ((e - lastError[k])/time_ms) * d[k];
+
+        controlValue[k] = value;
+        error[k] = e;
+        integError[k] = integ;
+        lastError[k] = e;
+        velocity[k] = v;
+      }
+    }
+
+    void MotorBatch::runVelocityControllers(Group *group) {
+      const size_t n = group->size();
+      const sReal *controlValue = &group->controlValue[0];
+      sReal *velocity = &group->velocity[0];
+      for(size_t k = 0; k < n; ++k) {
+        velocity[k] = controlValue[k];
+      }
+    }
+
+    void MotorBatch::runEffortControllers(Group *group, sReal time_ms) {
+      const size_t n = group->size();
+      const sReal *p = &group->p[0], *i = &group->i[0], *d = &group->d[0];
+      const sReal *minValue = &group->minValue[0];
+      const sReal *maxValue = &group->maxValue[0];
+      const sReal *maxEffort = &group->maxEffort[0];
+      const sReal *position = &group->position[0];
+      sReal *controlValue = &group->controlValue[0];
+      sReal *error = &group->error[0];
+      sReal *integError = &group->integError[0];
+      sReal *lastError = &group->lastError[0];
+      sReal *effort = &group->effort[0];
+
+      for(size_t k = 0; k < n; ++k) {
+        sReal value = std::max(minValue[k], std::min(controlValue[k],
+                                                     maxValue[k]));
+        value = (value > 2*M_PI) ? 0 :
+          (value > M_PI) ? -2*M_PI + value :
+          (value < -2*M_PI) ? 0 :
+          (value < -M_PI) ? 2*M_PI + value : value;
+
+        sReal e = value - position[k];
+        e = (e > M_PI) ? -2*M_PI + e : (e < -M_PI) ? 2*M_PI + e : e;
+        const sReal integ = integError[k] + e * time_ms;
+        sReal f = e * p[k];
+        f += integ * i[k];
+        f += ((e - lastError[k])/time_ms) * d[k];
+
+        controlValue[k] = value;
+        error[k] = e;
+        integError[k] = integ;
+        lastError[k] = e;
+        effort[k] = std::max(-maxEffort[k], std::min(f, maxEffort[k]));
+      }
+    }
+
+    void MotorBatch::applyLimits(Group *group) {
+      const size_t n = group->size();
+      const sReal *maxSpeed = &group->maxSpeed[0];
+      sReal *velocity = &group->velocity[0];
+      for(size_t k = 0; k < n; ++k) {
+        velocity[k] = std::max(-maxSpeed[k], std::min(velocity[k], maxSpeed[k]));
+      }
+
+      // the effort of all groups is replaced by the measured torque in
+      // estimate(), so only the limit of the joint has to be set
+      for(size_t k = 0; k < n; ++k) {
+        if(!group->active[k]) continue;
+        SimJoint *joint = group->joints[k];
+        if(group->appliedEffortLimit[k] != group->maxEffort[k] ||
+           group->effortLimitVersion[k] != joint->getEffortLimitVersion()) {
+          joint->setEffortLimit(group->maxEffort[k], group->axis[k]);
+          group->appliedEffortLimit[k] = group->maxEffort[k];
+          group->effortLimitVersion[k] = joint->getEffortLimitVersion();
+        }
+      }
+    }
+
+    void MotorBatch::estimate(Group *group, sReal time_ms) {
+      const size_t n = group->size();
+      for(size_t k = 0; k < n; ++k) {
+        if(!group->active[k]) continue;
+        SimMotor *motor = group->motors[k];
+        group->effort[k] = group->joints[k]->getMotorTorque();
+        group->jointVelocity[k] = group->joints[k]->getVelocity();
+        group->current[k] = (*motor->currentApproximation)(&group->effort[k],
+                                                           &group->jointVelocity[k],
+                                                           motor->current_coefficients);
+      }
+
+      const sReal *heatTransfer = &group->heatTransfer[0];
+      const sReal *ambientTemperature = &group->ambientTemperature[0];
+      const sReal *voltage = &group->voltage[0];
+      const sReal *heatLoss = &group->heatLoss[0];
+      const sReal *current = &group->current[0];
+      sReal *temperature = &group->temperature[0];
+      for(size_t k = 0; k < n; ++k) {
+        temperature[k] = temperature[k] -
+          (heatTransfer[k] * (temperature[k] - ambientTemperature[k]))*time_ms/1000.0 +
+          (current[k] * voltage[k] * heatLoss[k])*time_ms/1000.0;
+      }
+    }
+
+    void MotorBatch::scatter(Group *group, GroupType type) {
+      const size_t n = group->size();
+      for(size_t k = 0; k < n; ++k) {
+        if(!group->active[k]) continue;
+        SimMotor *motor = group->motors[k];
+        motor->controlValue = group->controlValue[k];
+        motor->velocity = group->velocity[k];
+        motor->effort = group->effort[k];
+        motor->joint_velocity = group->jointVelocity[k];
+        motor->current = group->current[k];
+        motor->temperature = group->temperature[k];
+        motor->tmpmaxspeed = group->maxSpeed[k];
+        motor->tmpmaxeffort = group->maxEffort[k];
+        if(type != VELOCITY_GROUP) {
+          motor->error = group->error[k];
+          motor->integ_error = group->integError[k];
+          motor->last_error = group->lastError[k];
+        }
+
+        if(type == EFFORT_GROUP) {
+          group->joints[k]->setEffort(group->effort[k], group->axis[k]);
+        }
+        else {
+          group->joints[k]->setVelocity(group->velocity[k], group->axis[k]);
+        }
+      }
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
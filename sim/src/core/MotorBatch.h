@@ -0,0 +1,142 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file MotorBatch.h
+ * \brief "MotorBatch" updates the motors of the MotorManager grouped by
+ * their controller type.
+ *
+ */
+
+#ifndef MOTOR_BATCH_H
+#define MOTOR_BATCH_H
+
+#ifdef _PRINT_HEADER_
+  #warning "MotorBatch.h"
+#endif
+
+#include <mars/interfaces/MARSDefs.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    class SimMotor;
+    class SimJoint;
+
+    /**
+     * Runs SimMotor::update() for all motors of a scene in a structure of
+     * arrays.
+     *
+     * The parameters and the controller state of the position, velocity
+     * and effort motors are kept in one contiguous array per value and
+     * group. The controllers of a group are evaluated in plain loops over
+     * these arrays, only reading the joint state and writing the control
+     * value touch the joints. The effort limit is only passed to the joint
+     * if it differs from the last one written by the batch or if the limit
+     * of the joint was set by someone else in between, e.g. by
+     * JointManager::setForceLimit().
+     *
+     * Motors that need the generic update, i.e. motors with a play joint,
+     * with mimics or an approximation of their maximum speed or effort,
+     * are updated by SimMotor::update() before the groups. The results
+     * are the same as the ones of calling SimMotor::update() for every
+     * motor.
+     *
+     * The arrays are rebuilt if invalidate() was called or if a parameter
+     * of one of the motors changed since the last update.
+     */
+    class MotorBatch {
+    public:
+      MotorBatch();
+
+      /**
+       * Has to be called whenever motors are added or removed. The motors
+       * of the last update are not accessed anymore afterwards.
+       */
+      void invalidate();
+
+      /** \param motors all motors of the scene in ascending id order */
+      void update(const std::vector<SimMotor*> &motors,
+                  interfaces::sReal time_ms);
+
+    private:
+      enum GroupType {
+        POSITION_GROUP = 0,
+        VELOCITY_GROUP,
+        EFFORT_GROUP,
+        NUM_GROUPS
+      };
+
+      struct Group {
+        std::vector<SimMotor*> motors;
+        std::vector<SimJoint*> joints;
+        std::vector<unsigned char> axis;
+
+        // parameters
+        std::vector<interfaces::sReal> p, i, d;
+        std::vector<interfaces::sReal> minValue, maxValue;
+        std::vector<interfaces::sReal> maxSpeed, maxEffort;
+        std::vector<interfaces::sReal> mimicMultiplier, mimicOffset;
+        std::vector<interfaces::sReal> heatTransfer, ambientTemperature;
+        std::vector<interfaces::sReal> voltage, heatLoss;
+
+        // state
+        std::vector<char> active;
+        std::vector<interfaces::sReal> controlValue, position;
+        std::vector<interfaces::sReal> error, integError, lastError;
+        std::vector<interfaces::sReal> velocity, effort, jointVelocity;
+        std::vector<interfaces::sReal> current, temperature;
+        // the effort limit last written to the joint, NaN if unknown
+        std::vector<interfaces::sReal> appliedEffortLimit;
+        // SimJoint::getEffortLimitVersion() after that write
+        std::vector<unsigned long> effortLimitVersion;
+
+        void clear();
+        void add(SimMotor *motor);
+        size_t size() const {return motors.size();}
+      };
+
+      bool needsRebuild(const std::vector<SimMotor*> &motors) const;
+      void rebuild(const std::vector<SimMotor*> &motors);
+      static bool isBatchable(const SimMotor *motor);
+
+      void gather(Group *group, interfaces::sReal time_ms);
+      void runPositionControllers(Group *group, interfaces::sReal time_ms);
+      void runVelocityControllers(Group *group);
+      void runEffortControllers(Group *group, interfaces::sReal time_ms);
+      void applyLimits(Group *group);
+      void estimate(Group *group, interfaces::sReal time_ms);
+      void scatter(Group *group, GroupType type);
+
+      bool dirty;
+      Group groups[NUM_GROUPS];
+      // motors that are updated by SimMotor::update(), in id order
+      std::vector<SimMotor*> scalarMotors;
+      // paramVersion of every motor at the last rebuild, in id order
+      std::vector<unsigned long> versions;
+    }; // end of class MotorBatch
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif // MOTOR_BATCH_H
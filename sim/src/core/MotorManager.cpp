@@ -40,9 +40,11 @@
 
 #include <mars/interfaces/sim/SimulatorInterface.h>
 #include <mars/interfaces/sim/JointManagerInterface.h>
+#include <mars/interfaces/sim/SimState.h>
 #include <mars/utils/MutexLocker.h>
 #include <mars/utils/mathUtils.h>
 #include <mars/utils/misc.h>
+#include <mars/cfg_manager/CFGManagerInterface.h>
 
 namespace mars {
   namespace sim {
@@ -96,6 +98,8 @@ namespace mars {
       newMotor->setSMotor(*motorS);
       iMutex.lock();
       simMotors[newMotor->getIndex()] = newMotor;
+      motorRegistry.add(newMotor->getIndex(), newMotor->getName(), newMotor);
+      motorBatch.invalidate();
       iMutex.unlock();
       control->sim->sceneHasChanged(false);
 
@@ -168,8 +172,10 @@ namespace mars {
     void MotorManager::editMotor(const MotorData &motorS) {
       MutexLocker locker(&iMutex);
       map<unsigned long, SimMotor*>::iterator iter = simMotors.find(motorS.index);
-      if (iter != simMotors.end())
+      if (iter != simMotors.end()) {
         iter->second->setSMotor(motorS);
+        motorRegistry.rename(motorS.index, iter->second->getName());
+      }
     }
 
 
@@ -226,6 +232,8 @@ namespace mars {
       if (iter != simMotors.end()) {
         tmpMotor = iter->second;
         simMotors.erase(iter);
+        motorRegistry.remove(index);
+        motorBatch.invalidate();
         if (tmpMotor)
           delete tmpMotor;
       }
@@ -271,12 +279,7 @@ namespace mars {
      * \returns Returns a pointer to the corresponding motor object.
      */
     SimMotor* MotorManager::getSimMotorByName(const std::string &name) const {
-      MutexLocker locker(&iMutex);
-      std::map<unsigned long, SimMotor*>::const_iterator iter;
-      for (iter = simMotors.begin(); iter != simMotors.end(); iter++)
-        if (iter->second->getName() == name)
-          return iter->second;
-      return NULL;
+      return motorRegistry.get(name);
     }
 
 
@@ -386,14 +389,7 @@ namespace mars {
      * \return Id of the motor if it exists, otherwise 0
      */
     unsigned long MotorManager::getID(const std::string& name) const {
-      map<unsigned long, SimMotor*>::const_iterator iter;
-      MutexLocker locker(&iMutex);
-
-      for (iter = simMotors.begin(); iter != simMotors.end(); iter++) {
-        if (iter->second->getName() == name)
-          return iter->first;
-      }
-      return 0;
+      return motorRegistry.getID(name);
     }
 
 
@@ -431,6 +427,9 @@ namespace mars {
       for(iter = simMotors.begin(); iter != simMotors.end(); iter++)
         delete iter->second;
       simMotors.clear();
+      motorRegistry.clear();
+      motorList.clear();
+      motorBatch.invalidate();
       mimicmotors.clear();
       if(clear_all) simMotorsReload.clear();
       next_motor_id = 1;
@@ -464,10 +463,20 @@ namespace mars {
      * \param calc_ms The timing value in miliseconds.
      */
     void MotorManager::updateMotors(double calc_ms) {
-      map<unsigned long, SimMotor*>::iterator iter;
       MutexLocker locker(&iMutex);
-      for(iter = simMotors.begin(); iter != simMotors.end(); iter++)
-        iter->second->update(calc_ms);
+      if(!cfgBatchMotors.isValid() && control->cfg) {
+        cfg_manager::cfgPropertyStruct batchMotors;
+        batchMotors = control->cfg->getOrCreateProperty("Simulator",
+                                                        "batch motors", false);
+        cfgBatchMotors = control->cfg->getHandle<bool>(batchMotors.paramId);
+      }
+      motorRegistry.getObjects(&motorList);
+      if(cfgBatchMotors.get()) {
+        motorBatch.update(motorList, calc_ms);
+        return;
+      }
+      for(size_t i = 0; i < motorList.size(); ++i)
+        motorList[i]->update(calc_ms);
     }
 
 
@@ -579,5 +588,66 @@ namespace mars {
       }
     }
 
+    /**
+     * \brief Appends the number of motors, the motor ids and the state of
+     * every motor in the order of the ids.
+     */
+    void MotorManager::saveState(std::vector<char> *state) const {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, SimMotor*>::const_iterator iter;
+      unsigned long header[2];
+      unsigned long *ids;
+      sReal *values;
+
+      header[0] = simMotors.size();
+      header[1] = SimMotor::stateSize;
+      appendStateBlock(state, header, sizeof(header));
+      if(simMotors.empty()) return;
+
+      ids = (unsigned long*)reserveStateBlock(state, simMotors.size()*sizeof(unsigned long));
+      for(iter = simMotors.begin(); iter != simMotors.end(); ++iter) {
+        *ids++ = iter->first;
+      }
+      values = (sReal*)reserveStateBlock(state, simMotors.size()*SimMotor::stateSize*sizeof(sReal));
+      for(iter = simMotors.begin(); iter != simMotors.end(); ++iter) {
+        iter->second->getState(values);
+        values += SimMotor::stateSize;
+      }
+    }
+
+    bool MotorManager::restoreState(const char **data, const char *end,
+                                    bool apply) {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, SimMotor*>::iterator iter;
+      const unsigned long *header, *ids;
+      const sReal *values;
+      size_t numMotors = simMotors.size();
+
+      header = (const unsigned long*)consumeStateBlock(data, end,
+                                                        2*sizeof(unsigned long));
+      if(!header) return false;
+      if(header[0] != numMotors || header[1] != SimMotor::stateSize) {
+        return false;
+      }
+      if(!numMotors) return true;
+
+      ids = (const unsigned long*)consumeStateBlock(data, end,
+                                                     numMotors*sizeof(unsigned long));
+      values = (const sReal*)consumeStateBlock(data, end,
+                                               numMotors*SimMotor::stateSize*sizeof(sReal));
+      if(!ids || !values) return false;
+      iter = simMotors.begin();
+      for(size_t i = 0; i < numMotors; ++i, ++iter) {
+        if(ids[i] != iter->first) return false;
+      }
+      if(!apply) return true;
+
+      for(iter = simMotors.begin(); iter != simMotors.end(); ++iter) {
+        iter->second->setState(values);
+        values += SimMotor::stateSize;
+      }
+      return true;
+    }
+
   } // end of namespace sim
 } // end of namespace mars
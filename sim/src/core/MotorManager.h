@@ -40,7 +40,11 @@
 
 #include <mars/interfaces/sim/ControlCenter.h>
 #include <mars/interfaces/sim/MotorManagerInterface.h>
+#include "ObjectRegistry.h"
+#include "MotorBatch.h"
+
 #include <mars/utils/Mutex.h>
+#include <mars/cfg_manager/CfgHandle.h>
 
 namespace mars {
   namespace sim {
@@ -316,6 +320,9 @@ namespace mars {
       virtual void connectMimics();
       virtual void edit(interfaces::MotorId id, const std::string &key,
                         const std::string &value);
+      virtual void saveState(std::vector<char> *state) const;
+      virtual bool restoreState(const char **data, const char *end,
+                                bool apply);
 
     private:
       //! the id of the next motor that is added to the simulation
@@ -323,6 +330,9 @@ namespace mars {
 
       //! a container for all motors currently present in the simulation
       std::map<unsigned long, SimMotor*> simMotors;
+      ObjectRegistry<SimMotor> motorRegistry;
+      //! the motors of the registry in id order, refilled by updateMotors()
+      std::vector<SimMotor*> motorList;
 
       //! a containter for all motors that are reloaded after a reset of the simulation
       std::list<interfaces::MotorData> simMotorsReload;
@@ -335,6 +345,10 @@ namespace mars {
 
       // map of mimicmotors
       std::map<unsigned long, std::string> mimicmotors;
+
+      //! updates the motors if "Simulator/batch motors" is set
+      MotorBatch motorBatch;
+      cfg_manager::CfgHandle<bool> cfgBatchMotors;
     }; // class MotorManager
 
   } // end of namespace sim
@@ -33,6 +33,7 @@
 
 #include <mars/interfaces/sim/LoadCenter.h>
 #include <mars/interfaces/sim/SimulatorInterface.h>
+#include <mars/interfaces/sim/SimState.h>
 #include <mars/interfaces/graphics/GraphicsManagerInterface.h>
 #include <mars/interfaces/terrainStruct.h>
 #include <mars/interfaces/Logging.hpp>
@@ -44,6 +45,7 @@
 #include <mars/utils/misc.h>
 
 #include <stdexcept>
+#include <algorithm>
 
 #include <mars/utils/MutexLocker.h>
 
@@ -54,6 +56,12 @@ namespace mars {
     using namespace utils;
     using namespace interfaces;
 
+    // the tiles of tiled terrains within this distance (in m) of a dynamic
+    // node are kept in memory; the tiles are updated every
+    // terrainResidencyInterval steps
+    static const double terrainResidencyMargin = 5.0;
+    static const unsigned long terrainResidencyInterval = 50;
+
     /**
      *\brief Initialization of a new NodeManager
      *
@@ -68,6 +76,7 @@ namespace mars {
                                                  update_all_nodes(false),
                                                  visual_rep(1),
                                                  maxGroupID(0),
+                                                 stateNodesChanged(true),
                                                  control(c),
                                                  libManager(theManager)
     {
@@ -116,18 +125,17 @@ namespace mars {
         iMutex.lock();
         NodeData reloadNode = *nodeS;
         if((nodeS->physicMode == NODE_TYPE_TERRAIN) && nodeS->terrain ) {
-          if(!control->loadCenter || !control->loadCenter->loadHeightmap) {
-            LOG_ERROR("NodeManager:: loadCenter is missing, can not create Node");
-            iMutex.unlock();
-            return INVALID_ID;
-          }
           reloadNode.terrain = new(terrainStruct);
           *(reloadNode.terrain) = *(nodeS->terrain);
-          control->loadCenter->loadHeightmap->readPixelData(reloadNode.terrain);
-          if(!reloadNode.terrain->pixelData) {
-            LOG_ERROR("NodeManager::addNode: could not load image for terrain");
-            iMutex.unlock();
-            return INVALID_ID;
+          if(reloadNode.terrain->tiles) {
+            reloadNode.terrain->tiles->acquire();
+          }
+          else {
+            reloadNode.terrain->pixelData = NULL;
+            if(!loadTerrain(reloadNode.terrain)) {
+              iMutex.unlock();
+              return INVALID_ID;
+            }
           }
         }
         simNodesReload.push_back(reloadNode);
@@ -172,28 +180,8 @@ namespace mars {
         control->loadCenter->loadMesh->getPhysicsFromMesh(nodeS);
       }
       if((nodeS->physicMode == NODE_TYPE_TERRAIN) && nodeS->terrain ) {
-        if(!nodeS->terrain->pixelData) {
-          if(!control->loadCenter) {
-            LOG_ERROR("NodeManager:: loadCenter is missing, can not create Node");
-            return INVALID_ID;
-          }
-          if(!control->loadCenter->loadHeightmap) {
-            GraphicsManagerInterface *g = libManager->getLibraryAs<GraphicsManagerInterface>("mars_graphics");
-            if(!g) {
-              libManager->loadLibrary("mars_graphics", NULL, false, true);
-              g = libManager->getLibraryAs<GraphicsManagerInterface>("mars_graphics");
-            }
-            if(g) {
-              control->loadCenter->loadHeightmap = g->getLoadHeightmapInterface();
-            }
-            else {
-              LOG_ERROR("NodeManager:: loadHeightmap is missing, can not create Node");
-              return INVALID_ID;
-            }
-          }
-          control->loadCenter->loadHeightmap->readPixelData(nodeS->terrain);
-          if(!nodeS->terrain->pixelData) {
-            LOG_ERROR("NodeManager::addNode: could not load image for terrain");
+        if(!nodeS->terrain->pixelData && !nodeS->terrain->tiles) {
+          if(!loadTerrain(nodeS->terrain)) {
             return INVALID_ID;
           }
         }
@@ -229,8 +217,11 @@ namespace mars {
         newNode->setInterface(newNodeInterface);
         iMutex.lock();
         simNodes[nodeS->index] = newNode;
-        if (nodeS->movable)
+        nodeRegistry.add(nodeS->index, newNode->getName(), newNode);
+        if (nodeS->movable) {
           simNodesDyn[nodeS->index] = newNode;
+          stateNodesChanged = true;
+        }
         iMutex.unlock();
         control->sim->sceneHasChanged(false);
         NodeId id;
@@ -286,8 +277,11 @@ namespace mars {
       } else {  //if nonPhysical
         iMutex.lock();
         simNodes[nodeS->index] = newNode;
-        if (nodeS->movable)
+        nodeRegistry.add(nodeS->index, newNode->getName(), newNode);
+        if (nodeS->movable) {
           simNodesDyn[nodeS->index] = newNode;
+          stateNodesChanged = true;
+        }
         iMutex.unlock();
         control->sim->sceneHasChanged(false);
         if(control->graphics) {
@@ -308,6 +302,79 @@ namespace mars {
       return nodeS->index;
     }
 
+    /**
+     * Reads the heights of \a terrain from terrain->srcname. Tiled
+     * heightmap files are mapped directly; all other files are read by the
+     * LoadHeightmapInterface, which is provided by the graphics.
+     *
+     * An image is converted into a tiled heightmap next to it, named
+     * srcname + ".mth", on the first load. Later loads map that file as
+     * long as it is newer than the image. If the file can not be written,
+     * the heights of the image are used directly.
+     */
+    bool NodeManager::loadTerrain(terrainStruct *terrain) {
+      if(getFilenameSuffix(terrain->srcname) == TILED_HEIGHTMAP_SUFFIX) {
+        terrain->tiles = TiledHeightmap::acquire(terrain->srcname);
+        if(!terrain->tiles) {
+          LOG_ERROR("NodeManager::addNode: could not load tiled heightmap %s",
+                    terrain->srcname.c_str());
+          return false;
+        }
+        terrain->width = terrain->tiles->getWidth();
+        terrain->height = terrain->tiles->getHeight();
+        return true;
+      }
+
+      std::string tilesName = terrain->srcname + TILED_HEIGHTMAP_SUFFIX;
+      if(TiledHeightmap::isUpToDate(tilesName, terrain->srcname)) {
+        terrain->tiles = TiledHeightmap::acquire(tilesName);
+        if(terrain->tiles) {
+          terrain->width = terrain->tiles->getWidth();
+          terrain->height = terrain->tiles->getHeight();
+          return true;
+        }
+      }
+
+      if(!control->loadCenter) {
+        LOG_ERROR("NodeManager:: loadCenter is missing, can not create Node");
+        return false;
+      }
+      if(!control->loadCenter->loadHeightmap) {
+        GraphicsManagerInterface *g = libManager->getLibraryAs<GraphicsManagerInterface>("mars_graphics");
+        if(!g) {
+          libManager->loadLibrary("mars_graphics", NULL, false, true);
+          g = libManager->getLibraryAs<GraphicsManagerInterface>("mars_graphics");
+        }
+        if(g) {
+          control->loadCenter->loadHeightmap = g->getLoadHeightmapInterface();
+        }
+        else {
+          LOG_ERROR("NodeManager:: loadHeightmap is missing, can not create Node");
+          return false;
+        }
+      }
+      control->loadCenter->loadHeightmap->readPixelData(terrain);
+      if(!terrain->pixelData) {
+        LOG_ERROR("NodeManager::addNode: could not load image for terrain");
+        return false;
+      }
+
+      // the image holds at most 16 bit per pixel, floats keep the heights
+      if(TiledHeightmap::write(tilesName, terrain->pixelData, terrain->width,
+                               terrain->height, 256, HEIGHT_SAMPLE_FLOAT)) {
+        terrain->tiles = TiledHeightmap::acquire(tilesName);
+        if(terrain->tiles) {
+          free(terrain->pixelData);
+          terrain->pixelData = NULL;
+        }
+      }
+      else {
+        LOG_WARN("NodeManager::addNode: could not write tiled heightmap %s",
+                 tilesName.c_str());
+      }
+      return true;
+    }
+
     /**
      *\brief This function maps a terrainStruct to a node struct and adds
      * that node to the simulation.
@@ -316,6 +383,7 @@ namespace mars {
     NodeId NodeManager::addTerrain(terrainStruct* terrain) {
       NodeData newNode;
       terrainStruct *newTerrain = new terrainStruct(*terrain);
+      if(newTerrain->tiles) newTerrain->tiles->acquire();
       sRotation trot = {0, 0, 0};
 
       newNode.name = terrain->name;
@@ -618,6 +686,7 @@ namespace mars {
       if (iter != simNodes.end()) {
         tmpNode = iter->second; //iter->second is a pointer to the SimNode associated with the map
         simNodes.erase(iter);
+        nodeRegistry.remove(id);
       }
 
       iter = nodesToUpdate.find(id);
@@ -629,6 +698,7 @@ namespace mars {
         iter = simNodesDyn.find(id);
         if (iter != simNodesDyn.end()) {
           simNodesDyn.erase(iter);
+          stateNodesChanged = true;
         }
       }
 
@@ -818,8 +888,10 @@ namespace mars {
       if (iter != simNodes.end()) {
         iter->second->addSensor(sensor);
         NodeMap::iterator kter = simNodesDyn.find(sensor->getAttachedNode());
-        if (kter == simNodesDyn.end())
+        if (kter == simNodesDyn.end()) {
           simNodesDyn[iter->first] = iter->second;
+          stateNodesChanged = true;
+        }
       }
       else
         {
@@ -1135,11 +1207,17 @@ namespace mars {
         if(tmp.terrain) {
           tmp.terrain = new(terrainStruct);
           *(tmp.terrain) = *(iter->terrain);
-          tmp.terrain->pixelData = (double*)calloc((tmp.terrain->width*
-                                                     tmp.terrain->height),
-                                                    sizeof(double));
-          memcpy(tmp.terrain->pixelData, iter->terrain->pixelData,
-                 (tmp.terrain->width*tmp.terrain->height)*sizeof(double));
+          if(tmp.terrain->tiles) {
+            // the tiled heightmap is shared and not copied
+            tmp.terrain->tiles->acquire();
+          }
+          else {
+            tmp.terrain->pixelData = (double*)calloc((tmp.terrain->width*
+                                                       tmp.terrain->height),
+                                                      sizeof(double));
+            memcpy(tmp.terrain->pixelData, iter->terrain->pixelData,
+                   (tmp.terrain->width*tmp.terrain->height)*sizeof(double));
+          }
         }
         iMutex.unlock();
         addNode(&tmp, true, reloadGrahpics);
@@ -1205,12 +1283,157 @@ namespace mars {
      */
     void NodeManager::updateDynamicNodes(sReal calc_ms, bool physics_thread) {
       MutexLocker locker(&iMutex);
+
+      updateStateNodes();
+      // read the state of all nodes with one lock of the world
+      control->sim->getPhysics()->getNodeStates(stateInterfaces, &stateCache);
+      ++stateCache.step;
+      for(size_t i = 0; i < stateNodes.size(); ++i) {
+        stateNodes[i]->update(calc_ms, physics_thread, stateCache, i);
+      }
+      if(stateCache.step % terrainResidencyInterval == 0) {
+        updateTerrainResidency();
+      }
+    }
+
+    /**
+     * \brief Keeps the tiles of the tiled terrains around the dynamic nodes
+     * in memory and gives the other tiles back to the system.
+     *
+     * pre:
+     *     - iMutex is locked
+     *     - the stateCache is up to date
+     */
+    void NodeManager::updateTerrainResidency() {
       NodeMap::iterator iter;
+      std::vector<double> points;
+
+      for(iter = simNodes.begin(); iter != simNodes.end(); iter++) {
+        if(iter->second->getPhysicMode() != NODE_TYPE_TERRAIN) continue;
+        NodeData node = iter->second->getSNode();
+        const terrainStruct *terrain = node.terrain;
+        if(!terrain || !terrain->tiles || terrain->width < 2 ||
+           terrain->height < 2) continue;
+
+        // the heightfield is centered at the node position
+        double dx = terrain->targetWidth / (terrain->width-1);
+        double dy = terrain->targetHeight / (terrain->height-1);
+        Quaternion inverse = node.rot.inverse();
+        points.clear();
+        for(size_t i = 0; i < stateCache.size(); ++i) {
+          Vector local = inverse * (stateCache.getPosition(i) - node.pos);
+          points.push_back((local.x() + terrain->targetWidth*0.5) / dx);
+          points.push_back((local.y() + terrain->targetHeight*0.5) / dy);
+        }
+        terrain->tiles->updateResidency(terrain, points,
+                                        terrainResidencyMargin /
+                                        std::min(dx, dy));
+      }
+    }
+
+    /**
+     * \brief Rebuilds the node lists of the state cache if the dynamic
+     * nodes changed.
+     *
+     * pre:
+     *     - iMutex is locked
+     */
+    void NodeManager::updateStateNodes() const {
+      NodeMap::const_iterator iter;
+
+      if(!stateNodesChanged) return;
+      stateNodes.clear();
+      stateInterfaces.clear();
       for(iter = simNodesDyn.begin(); iter != simNodesDyn.end(); iter++) {
-        iter->second->update(calc_ms, physics_thread);
+        // nodes without physics keep their state
+        if(iter->second->getInterface()) {
+          stateNodes.push_back(iter->second);
+          stateInterfaces.push_back(iter->second->getInterface());
+        }
+      }
+      stateCache.resize(stateNodes.size());
+      for(size_t i = 0; i < stateNodes.size(); ++i) {
+        stateCache.ids[i] = stateNodes[i]->getID();
+      }
+      stateNodesChanged = false;
+    }
+
+    const NodeStateCache* NodeManager::getNodeStateCache() const {
+      return &stateCache;
+    }
+
+    void NodeManager::getNodeStates(NodeStateCache *states) const {
+      MutexLocker locker(&iMutex);
+      *states = stateCache;
+    }
+
+    /**
+     * \brief Appends the number of nodes and the size of a body state,
+     * the node ids, the body states and the accelerations of the nodes.
+     */
+    void NodeManager::saveState(std::vector<char> *state) const {
+      MutexLocker locker(&iMutex);
+      PhysicsInterface *physics = control->sim->getPhysics();
+      unsigned long header[2];
+      size_t numNodes, bodyStateSize;
+      sReal *values;
+
+      updateStateNodes();
+      numNodes = stateNodes.size();
+      bodyStateSize = physics->getBodyStateSize();
+      header[0] = numNodes;
+      header[1] = bodyStateSize;
+      appendStateBlock(state, header, sizeof(header));
+      if(!numNodes) return;
+      appendStateBlock(state, &stateCache.ids[0], numNodes*sizeof(NodeId));
+
+      values = (sReal*)reserveStateBlock(state, numNodes*bodyStateSize*sizeof(sReal));
+      physics->getBodyStates(stateInterfaces, values);
+
+      values = (sReal*)reserveStateBlock(state, numNodes*6*sizeof(sReal));
+      for(size_t i = 0; i < numNodes; ++i) {
+        stateNodes[i]->getAccelerations(values + 6*i);
       }
     }
 
+    bool NodeManager::restoreState(const char **data, const char *end,
+                                   bool apply) {
+      MutexLocker locker(&iMutex);
+      PhysicsInterface *physics = control->sim->getPhysics();
+      const unsigned long *header;
+      const NodeId *ids;
+      const sReal *bodyStates, *accelerations;
+      size_t numNodes, bodyStateSize;
+
+      updateStateNodes();
+      header = (const unsigned long*)consumeStateBlock(data, end,
+                                                        2*sizeof(unsigned long));
+      if(!header) return false;
+      numNodes = stateNodes.size();
+      bodyStateSize = physics->getBodyStateSize();
+      if(header[0] != numNodes || header[1] != bodyStateSize) return false;
+      if(!numNodes) return true;
+
+      ids = (const NodeId*)consumeStateBlock(data, end, numNodes*sizeof(NodeId));
+      bodyStates = (const sReal*)consumeStateBlock(data, end,
+                                                   numNodes*bodyStateSize*sizeof(sReal));
+      accelerations = (const sReal*)consumeStateBlock(data, end,
+                                                      numNodes*6*sizeof(sReal));
+      if(!ids || !bodyStates || !accelerations) return false;
+      if(memcmp(ids, &stateCache.ids[0], numNodes*sizeof(NodeId))) {
+        return false;
+      }
+      if(!apply) return true;
+
+      physics->setBodyStates(stateInterfaces, bodyStates);
+      // the SimNodes take the restored values without damping them again
+      physics->getNodeStates(stateInterfaces, &stateCache);
+      for(size_t i = 0; i < numNodes; ++i) {
+        stateNodes[i]->restoreState(stateCache, i, accelerations + 6*i);
+      }
+      return true;
+    }
+
     void NodeManager::preGraphicsUpdate() {
       NodeMap::iterator iter;
       if(!control->graphics)
@@ -1265,7 +1488,9 @@ namespace mars {
       while (!simNodes.empty())
         removeNode(simNodes.begin()->first, false, clearGraphics);
       simNodes.clear();
+      nodeRegistry.clear();
       simNodesDyn.clear();
+      stateNodesChanged = true;
       if(clear_all) simNodesReload.clear();
       next_node_id = 1;
       iMutex.unlock();
@@ -1492,17 +1717,7 @@ namespace mars {
     }
 
     NodeId NodeManager::getID(const std::string& node_name) const {
-
-      iMutex.lock();
-      NodeMap::const_iterator iter;
-      for(iter = simNodes.begin(); iter != simNodes.end(); iter++) {
-        if (iter->second->getName() == node_name)  {
-          iMutex.unlock();
-          return iter->first;
-        }
-      }
-      iMutex.unlock();
-      return INVALID_ID;
+      return nodeRegistry.getID(node_name);
     }
 
     void NodeManager::pushToUpdate(SimNode* node) {
@@ -1821,6 +2036,7 @@ namespace mars {
         control->graphics->setDrawObjectScale(editedNode->getGraphicsID2(), nodeS->ext);
       }
       editedNode->changeNode(nodeS);
+      nodeRegistry.rename(editedNode->getID(), editedNode->getName());
       if(sNode.groupID != 0 || nodeS->groupID != 0) {
         for(auto it: simNodes) {
           if(it.second->getGroupID() == sNode.groupID ||
@@ -32,6 +32,8 @@
   #warning "NodeManager.h"
 #endif
 
+#include "ObjectRegistry.h"
+
 #include <mars/utils/Mutex.h>
 #include <mars/interfaces/graphics/GraphicsUpdateInterface.h>
 #include <mars/interfaces/sim/ControlCenter.h>
@@ -158,12 +160,18 @@ namespace mars {
       virtual unsigned long getMaxGroupID() { return maxGroupID; }
       virtual void edit(interfaces::NodeId id, const std::string &key,
                         const std::string &value);
+      virtual const interfaces::NodeStateCache* getNodeStateCache() const;
+      virtual void getNodeStates(interfaces::NodeStateCache *states) const;
+      virtual void saveState(std::vector<char> *state) const;
+      virtual bool restoreState(const char **data, const char *end,
+                                bool apply);
 
     private:
       interfaces::NodeId next_node_id;
       bool update_all_nodes;
       int visual_rep;
       NodeMap simNodes;
+      ObjectRegistry<SimNode> nodeRegistry;
       NodeMap simNodesDyn;
       NodeMap nodesToUpdate;
       std::list<interfaces::NodeData> simNodesReload;
@@ -171,6 +179,16 @@ namespace mars {
       lib_manager::LibManager *libManager;
       mutable utils::Mutex iMutex;
 
+      // the dynamic nodes with a physical representation in the order of
+      // the stateCache; rebuild if simNodesDyn changes
+      mutable bool stateNodesChanged;
+      mutable std::vector<SimNode*> stateNodes;
+      mutable std::vector<interfaces::NodeInterface*> stateInterfaces;
+      mutable interfaces::NodeStateCache stateCache;
+      void updateStateNodes() const;
+      void updateTerrainResidency();
+      bool loadTerrain(interfaces::terrainStruct *terrain);
+
       interfaces::ControlCenter *control;
 
       std::list<interfaces::NodeData>::iterator getReloadNode(interfaces::NodeId id);
@@ -0,0 +1,197 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file ObjectRegistry.h
+ * \brief "ObjectRegistry" indexes the objects of a manager by id and name.
+ *
+ */
+
+#ifndef OBJECT_REGISTRY_H
+#define OBJECT_REGISTRY_H
+
+#ifdef _PRINT_HEADER_
+  #warning "ObjectRegistry.h"
+#endif
+
+#include <mars/utils/ReadWriteLock.h>
+#include <mars/utils/ReadWriteLocker.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <tr1/unordered_map>
+
+namespace mars {
+  namespace sim {
+
+    /**
+     * Maps the ids and names of the objects of a manager to the objects in
+     * constant time.
+     *
+     * The ids of the managers are counted up from one, so every id gets a
+     * slot in an array. The names are interned in a hash table; if several objects have the same name, the one with
+     * the lowest id is found. The live objects are also stored in a dense
+     * array in ascending id order, so the managers can iterate them in the
+     * same order as their id maps without walking the tree.
+     *
+     * The registry has its own lock, so lookups do not have to wait for
+     * the lock of the manager.
+     */
+    template <typename T>
+    class ObjectRegistry {
+    public:
+      ObjectRegistry() {}
+
+      void add(unsigned long id, const std::string &name, T *object) {
+        utils::ReadWriteLocker locker(&lock, utils::READWRITELOCK_MODE_WRITE);
+        if(!id) return;
+        if(id >= slots.size()) slots.resize(id+1);
+        Slot &slot = slots[id];
+        if(slot.object) {
+          unlinkName(id);
+          objects[denseIndex(id)] = object;
+        }
+        else {
+          // the ids are counted up, so this is an append in most cases
+          size_t dense = denseIndex(id);
+          objects.insert(objects.begin()+dense, object);
+          objectIds.insert(objectIds.begin()+dense, id);
+        }
+        slot.object = object;
+        linkName(id, name);
+      }
+
+      void remove(unsigned long id) {
+        utils::ReadWriteLocker locker(&lock, utils::READWRITELOCK_MODE_WRITE);
+        if(id >= slots.size() || !slots[id].object) return;
+        Slot &slot = slots[id];
+        unlinkName(id);
+        size_t dense = denseIndex(id);
+        objects.erase(objects.begin()+dense);
+        objectIds.erase(objectIds.begin()+dense);
+        slot.object = NULL;
+      }
+
+      void rename(unsigned long id, const std::string &name) {
+        utils::ReadWriteLocker locker(&lock, utils::READWRITELOCK_MODE_WRITE);
+        if(id >= slots.size() || !slots[id].object) return;
+        if(slots[id].name && *slots[id].name == name) return;
+        unlinkName(id);
+        linkName(id, name);
+      }
+
+      void clear() {
+        utils::ReadWriteLocker locker(&lock, utils::READWRITELOCK_MODE_WRITE);
+        for(size_t i=0; i<slots.size(); ++i) {
+          slots[i].object = NULL;
+          slots[i].name = NULL;
+        }
+        names.clear();
+        objects.clear();
+        objectIds.clear();
+      }
+
+      /** \return the id of the object or 0 if the name is unknown */
+      unsigned long getID(const std::string &name) const {
+        utils::ReadWriteLocker locker(&lock, utils::READWRITELOCK_MODE_READ);
+        typename NameTable::const_iterator it = names.find(name);
+        return it == names.end() ? 0 : it->second.front();
+      }
+
+      T* get(unsigned long id) const {
+        utils::ReadWriteLocker locker(&lock, utils::READWRITELOCK_MODE_READ);
+        return id < slots.size() ? slots[id].object : NULL;
+      }
+
+      T* get(const std::string &name) const {
+        utils::ReadWriteLocker locker(&lock, utils::READWRITELOCK_MODE_READ);
+        typename NameTable::const_iterator it = names.find(name);
+        return it == names.end() ? NULL : slots[it->second.front()].object;
+      }
+
+      size_t size() const {
+        utils::ReadWriteLocker locker(&lock, utils::READWRITELOCK_MODE_READ);
+        return objects.size();
+      }
+
+      /**
+       * copies the live objects in ascending id order; the capacity of
+       * \a list is reused.
+       */
+      void getObjects(std::vector<T*> *list) const {
+        utils::ReadWriteLocker locker(&lock, utils::READWRITELOCK_MODE_READ);
+        *list = objects;
+      }
+
+    private:
+      // the ids of every name in ascending order
+      typedef std::tr1::unordered_map<std::string,
+                                      std::vector<unsigned long> > NameTable;
+
+      struct Slot {
+        Slot() : object(NULL), name(NULL) {}
+        T *object;
+        // points to the key in the name table
+        const std::string *name;
+      };
+
+      size_t denseIndex(unsigned long id) const {
+        return std::lower_bound(objectIds.begin(), objectIds.end(),
+                                id) - objectIds.begin();
+      }
+
+      void linkName(unsigned long id, const std::string &name) {
+        typename NameTable::iterator it = names.find(name);
+        if(it == names.end()) {
+          it = names.insert(std::make_pair(name,
+                                           std::vector<unsigned long>())).first;
+        }
+        std::vector<unsigned long> &ids = it->second;
+        ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+        slots[id].name = &it->first;
+      }
+
+      void unlinkName(unsigned long id) {
+        Slot &slot = slots[id];
+        if(!slot.name) return;
+        typename NameTable::iterator it = names.find(*slot.name);
+        slot.name = NULL;
+        if(it == names.end()) return;
+        std::vector<unsigned long> &ids = it->second;
+        ids.erase(std::lower_bound(ids.begin(), ids.end(), id));
+        if(ids.empty()) names.erase(it);
+      }
+
+      // disallow copying
+      ObjectRegistry(const ObjectRegistry &);
+      ObjectRegistry &operator=(const ObjectRegistry &);
+
+      mutable utils::ReadWriteLock lock;
+      NameTable names;
+      std::vector<Slot> slots;
+      std::vector<T*> objects;
+      std::vector<unsigned long> objectIds;
+    }; // end of class ObjectRegistry
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // OBJECT_REGISTRY_H
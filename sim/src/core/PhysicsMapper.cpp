@@ -45,5 +45,17 @@ namespace mars {
       return (JointInterface*) (new JointPhysics(worldPhysics));
     }
 
+    void PhysicsMapper::initThread(void) {
+#ifdef ODE11
+      dAllocateODEDataForThread(dAllocateMaskAll);
+#endif
+    }
+
+    void PhysicsMapper::releaseThread(void) {
+#ifdef ODE11
+      dCleanupODEAllDataForThread();
+#endif
+    }
+
   } // end of namespace sim
 } // end of namespace mars
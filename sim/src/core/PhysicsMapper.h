@@ -45,6 +45,10 @@ namespace mars {
       static interfaces::PhysicsInterface* newWorldPhysics(interfaces::ControlCenter *control);
       static interfaces::NodeInterface* newNodePhysics(interfaces::PhysicsInterface *worldPhysics);
       static interfaces::JointInterface* newJointPhysics(interfaces::PhysicsInterface *worldPhysics);
+      /** Has to be called by every thread that steps a world before the
+          first step and before the thread exits. */
+      static void initThread(void);
+      static void releaseThread(void);
     };
 
   } // end of namespace sim
@@ -0,0 +1,353 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file PluginScheduler.cpp
+ * \brief "PluginScheduler" updates the simulation plugins in a fixed
+ *        order and runs independent plugins in parallel.
+ *
+ */
+
+#include "PluginScheduler.h"
+
+#include <mars/utils/MutexLocker.h>
+#include <mars/utils/Thread.h>
+#include <mars/utils/misc.h>
+
+#include <algorithm>
+
+#ifndef WIN32
+  #include <sys/time.h>
+#endif
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+    using namespace interfaces;
+
+    class PluginWorker : public Thread {
+    public:
+      PluginWorker(PluginScheduler *scheduler) : scheduler(scheduler) {}
+
+    protected:
+      void run() {
+        scheduler->workerLoop();
+      }
+
+    private:
+      PluginScheduler *scheduler;
+    };
+
+    namespace {
+
+      // plugin updates often take less than a ms, so getTime is too coarse
+      double getTimeMs(void) {
+#ifdef WIN32
+        return (double)utils::getTime();
+#else
+        struct timeval tv;
+        gettimeofday(&tv, 0);
+        return tv.tv_sec*1000.0 + tv.tv_usec*0.001;
+#endif
+      }
+
+      /// \cond HIDDEN_SYMBOLS
+      struct AccessInfo {
+        bool exclusive;
+        PluginAccessSet set;
+      };
+      /// \endcond
+
+      bool intersects(const std::vector<unsigned long> &a,
+                      const std::vector<unsigned long> &b) {
+        std::vector<unsigned long>::const_iterator ia = a.begin();
+        std::vector<unsigned long>::const_iterator ib = b.begin();
+        // both are sorted
+        while(ia != a.end() && ib != b.end()) {
+          if(*ia < *ib) ++ia;
+          else if(*ib < *ia) ++ib;
+          else return true;
+        }
+        return false;
+      }
+
+      bool intersects(const std::vector<std::string> &a,
+                      const std::vector<std::string> &b) {
+        std::vector<std::string>::const_iterator ia, ib;
+        for(ia=a.begin(); ia!=a.end(); ++ia) {
+          for(ib=b.begin(); ib!=b.end(); ++ib) {
+            if(matchPattern(*ia, *ib) || matchPattern(*ib, *ia)) return true;
+          }
+        }
+        return false;
+      }
+
+      // true if one of both writes data the other one reads or writes
+      bool writesInto(const PluginAccessSet &a, const PluginAccessSet &b) {
+        return (intersects(a.writeNodes, b.readNodes) ||
+                intersects(a.writeNodes, b.writeNodes) ||
+                intersects(a.writeMotors, b.readMotors) ||
+                intersects(a.writeMotors, b.writeMotors) ||
+                intersects(a.writeTopics, b.readTopics) ||
+                intersects(a.writeTopics, b.writeTopics));
+      }
+
+      bool conflicts(const AccessInfo &a, const AccessInfo &b) {
+        if(a.exclusive || b.exclusive) return true;
+        return writesInto(a.set, b.set) || writesInto(b.set, a.set);
+      }
+
+      void sortIds(std::vector<unsigned long> *ids) {
+        std::sort(ids->begin(), ids->end());
+      }
+
+    } // end of anonymous namespace
+
+    PluginScheduler::PluginScheduler(void) : numThreads(1), calc_ms(0),
+                                             measureTime(false), nextJob(0),
+                                             endJob(0), busyWorkers(0),
+                                             generation(0), quit(false) {
+      waveStart.push_back(0);
+    }
+
+    PluginScheduler::~PluginScheduler(void) {
+      stopPool();
+    }
+
+    void PluginScheduler::setNumThreads(int numThreads) {
+      this->numThreads = (numThreads < 1) ? 1 : numThreads;
+    }
+
+    int PluginScheduler::getNumThreads(void) const {
+      return numThreads;
+    }
+
+    void PluginScheduler::setPlugins(const std::vector<pluginStruct> &plugins) {
+      std::vector<AccessInfo> access(plugins.size());
+      std::size_t waveBegin = 0;
+      Job job;
+
+      timingMutex.lock();
+      jobs.clear();
+      waveStart.clear();
+      for(std::size_t i=0; i<plugins.size(); ++i) {
+        job.plugin = plugins[i].p_interface;
+        job.active = true;
+        job.timing.name = plugins[i].name;
+        job.timing.lastTime = job.timing.avgTime = job.timing.maxTime = 0.0;
+        job.timing.count = 0;
+        job.windowTime = 0.0;
+        job.windowCount = 0;
+        jobs.push_back(job);
+
+        access[i].exclusive = !job.plugin->getAccessSet(&access[i].set);
+        sortIds(&access[i].set.readNodes);
+        sortIds(&access[i].set.writeNodes);
+        sortIds(&access[i].set.readMotors);
+        sortIds(&access[i].set.writeMotors);
+
+        // a plugin starts a new wave if it conflicts with any plugin of
+        // the current one; this keeps the order of all dependent plugins
+        bool newWave = (i == 0);
+        for(std::size_t k=waveBegin; k<i && !newWave; ++k) {
+          newWave = conflicts(access[k], access[i]);
+        }
+        if(newWave) {
+          waveBegin = i;
+          waveStart.push_back(i);
+        }
+      }
+      waveStart.push_back(jobs.size());
+      timingMutex.unlock();
+    }
+
+    void PluginScheduler::removePlugin(PluginInterface *plugin) {
+      std::vector<Job>::iterator iter;
+      MutexLocker locker(&timingMutex);
+      for(iter=jobs.begin(); iter!=jobs.end(); ++iter) {
+        if(iter->plugin == plugin) {
+          iter->active = false;
+        }
+      }
+    }
+
+    int PluginScheduler::getNumWaves(void) const {
+      return (int)waveStart.size() - 1;
+    }
+
+    void PluginScheduler::getTimings(std::vector<PluginTiming> *timings) const {
+      std::vector<Job>::const_iterator iter;
+      MutexLocker locker(&timingMutex);
+
+      timings->clear();
+      for(iter=jobs.begin(); iter!=jobs.end(); ++iter) {
+        if(iter->active) timings->push_back(iter->timing);
+      }
+    }
+
+    void PluginScheduler::resetTimings(void) {
+      std::vector<Job>::iterator iter;
+      MutexLocker locker(&timingMutex);
+
+      for(iter=jobs.begin(); iter!=jobs.end(); ++iter) {
+        iter->timing.lastTime = iter->timing.avgTime = 0.0;
+        iter->timing.maxTime = 0.0;
+        iter->timing.count = 0;
+        iter->windowTime = 0.0;
+        iter->windowCount = 0;
+      }
+    }
+
+    /**
+     * \brief Updates all plugins; returns when every plugin is done.
+     *
+     * pre:
+     *     - setPlugins was called after the last change of the plugins
+     *
+     * post:
+     *     - every active plugin was updated once with \a calc_ms
+     */
+    void PluginScheduler::update(sReal calc_ms, bool measureTime) {
+      if((int)workers.size()+1 != numThreads) resizePool();
+
+      this->calc_ms = calc_ms;
+      this->measureTime = measureTime;
+
+      for(std::size_t wave=0; wave+1<waveStart.size(); ++wave) {
+        std::size_t begin = waveStart[wave];
+        std::size_t end = waveStart[wave+1];
+
+        if(workers.empty() || end - begin < 2) {
+          for(std::size_t i=begin; i<end; ++i) runJob(&jobs[i]);
+          continue;
+        }
+
+        poolMutex.lock();
+        nextJob = begin;
+        endJob = end;
+        busyWorkers = (int)workers.size();
+        ++generation;
+        startCondition.wakeAll();
+        poolMutex.unlock();
+
+        runJobs();
+
+        poolMutex.lock();
+        while(busyWorkers > 0) doneCondition.wait(&poolMutex);
+        poolMutex.unlock();
+      }
+    }
+
+    void PluginScheduler::runJob(Job *job) {
+      double start, time;
+      bool active;
+
+      timingMutex.lock();
+      active = job->active;
+      timingMutex.unlock();
+      if(!active) return;
+      if(!measureTime) {
+        job->plugin->update(calc_ms);
+        return;
+      }
+
+      start = getTimeMs();
+      job->plugin->update(calc_ms);
+      time = getTimeMs() - start;
+
+      MutexLocker locker(&timingMutex);
+      job->timing.lastTime = time;
+      if(time > job->timing.maxTime) job->timing.maxTime = time;
+      ++job->timing.count;
+      job->windowTime += time;
+      if(++job->windowCount >= timingWindow) {
+        job->timing.avgTime = job->windowTime / job->windowCount;
+        job->windowTime = 0.0;
+        job->windowCount = 0;
+      }
+    }
+
+    PluginScheduler::Job* PluginScheduler::getNextJob(void) {
+      MutexLocker locker(&poolMutex);
+      if(nextJob < endJob) return &jobs[nextJob++];
+      return 0;
+    }
+
+    void PluginScheduler::runJobs(void) {
+      Job *job;
+      while((job = getNextJob())) {
+        runJob(job);
+      }
+    }
+
+    void PluginScheduler::workerLoop(void) {
+      // like the SensorThreadPool every worker takes part in every wave
+      unsigned long done = 0;
+
+      poolMutex.lock();
+      while(true) {
+        while(!quit && generation == done) startCondition.wait(&poolMutex);
+        if(quit) break;
+        done = generation;
+        poolMutex.unlock();
+
+        runJobs();
+
+        poolMutex.lock();
+        if(--busyWorkers == 0) doneCondition.wakeOne();
+      }
+      poolMutex.unlock();
+    }
+
+    void PluginScheduler::resizePool(void) {
+      PluginWorker *worker;
+
+      stopPool();
+      // the calling thread is used as well
+      for(int i=1; i<numThreads; ++i) {
+        worker = new PluginWorker(this);
+        workers.push_back(worker);
+        worker->start();
+      }
+    }
+
+    void PluginScheduler::stopPool(void) {
+      std::vector<PluginWorker*>::iterator iter;
+
+      if(workers.empty()) return;
+
+      poolMutex.lock();
+      quit = true;
+      startCondition.wakeAll();
+      poolMutex.unlock();
+
+      for(iter=workers.begin(); iter!=workers.end(); ++iter) {
+        (*iter)->wait();
+        delete *iter;
+      }
+      workers.clear();
+      quit = false;
+      // new workers start to count the generations from zero
+      generation = 0;
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
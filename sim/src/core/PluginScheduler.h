@@ -0,0 +1,144 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file PluginScheduler.h
+ * \brief "PluginScheduler" updates the simulation plugins in a fixed
+ *        order and runs independent plugins in parallel.
+ *
+ */
+
+#ifndef PLUGIN_SCHEDULER_H
+#define PLUGIN_SCHEDULER_H
+
+#ifdef _PRINT_HEADER_
+  #warning "PluginScheduler.h"
+#endif
+
+#include <mars/interfaces/sim/PluginInterface.h>
+#include <mars/utils/Mutex.h>
+#include <mars/utils/WaitCondition.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    class PluginWorker;
+
+    /**
+     * The update times of one plugin in ms. avgTime is the mean of the
+     * last complete window of PluginScheduler::timingWindow updates.
+     */
+    struct PluginTiming {
+      std::string name;
+      double lastTime, avgTime, maxTime;
+      unsigned long count;
+    };
+
+    /**
+     * The PluginScheduler splits the list of plugins into waves. A wave is
+     * a run of consecutive plugins whose PluginAccessSets do not overlap;
+     * a plugin without an access set forms a wave of its own. The waves
+     * are updated one after the other in list order and the plugins of a
+     * wave are distributed over the pool. Since the plugins of a wave do
+     * not share data, the result of a step does not depend on the number
+     * of threads or on the order in which the workers pick the plugins.
+     *
+     * With one thread (the default) all plugins are updated in the calling
+     * thread like before.
+     */
+    class PluginScheduler {
+    public:
+      static const unsigned int timingWindow = 20;
+
+      PluginScheduler(void);
+      ~PluginScheduler(void);
+
+      /**
+       * The number of threads including the calling one. The pool is
+       * resized at the beginning of the next update().
+       */
+      void setNumThreads(int numThreads);
+      int getNumThreads(void) const;
+
+      /**
+       * Rebuilds the waves from \a plugins. Asks every plugin for its
+       * access set. Must not be called during update().
+       */
+      void setPlugins(const std::vector<interfaces::pluginStruct> &plugins);
+
+      /**
+       * Skips \a plugin for the rest of the current and all following
+       * updates. Can be called by a plugin from within its update().
+       */
+      void removePlugin(interfaces::PluginInterface *plugin);
+
+      void update(interfaces::sReal calc_ms, bool measureTime);
+
+      int getNumWaves(void) const;
+      void getTimings(std::vector<PluginTiming> *timings) const;
+      void resetTimings(void);
+
+    private:
+      friend class PluginWorker;
+
+      struct Job {
+        interfaces::PluginInterface *plugin;
+        // guarded by the timingMutex
+        bool active;
+        PluginTiming timing;
+        double windowTime;
+        unsigned int windowCount;
+      };
+
+      std::vector<Job> jobs;
+      // the wave i contains the jobs [waveStart[i], waveStart[i+1])
+      std::vector<std::size_t> waveStart;
+      std::vector<PluginWorker*> workers;
+      int numThreads;
+      interfaces::sReal calc_ms;
+      bool measureTime;
+
+      mutable utils::Mutex timingMutex;
+      utils::Mutex poolMutex;
+      utils::WaitCondition startCondition, doneCondition;
+      std::size_t nextJob, endJob;
+      int busyWorkers;
+      unsigned long generation;
+      bool quit;
+
+      void resizePool(void);
+      void stopPool(void);
+      void runJob(Job *job);
+      Job* getNextJob(void);
+      void runJobs(void);
+      void workerLoop(void);
+
+      PluginScheduler(const PluginScheduler &);
+      PluginScheduler &operator=(const PluginScheduler &);
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // PLUGIN_SCHEDULER_H
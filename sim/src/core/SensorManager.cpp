@@ -57,10 +57,13 @@
 #include "ScanningSonar.h"
 
 #include <mars/interfaces/sim/SimulatorInterface.h>
+#include <mars/interfaces/sim/SimState.h>
 #include <mars/utils/MutexLocker.h>
 #include <mars/interfaces/Logging.hpp>
 
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
 #include <stdexcept>
 
 namespace mars {
@@ -168,13 +171,8 @@ namespace mars {
     }
 
     unsigned long SensorManager::getSensorID(std::string name) const {
-      MutexLocker locker(&iMutex);
-      std::map<unsigned long, BaseSensor*>::const_iterator it;
-      for(it = simSensors.begin(); it != simSensors.end(); it++){
-        if(it->second->name.compare(name) == 0){
-          return it->first;
-        }
-      }
+      unsigned long id = sensorRegistry.getID(name);
+      if(id) return id;
       printf("Cannot find Sensor with name: \"%s\"\n",name.c_str());
       return 0;
     }
@@ -191,6 +189,7 @@ namespace mars {
       if (iter != simSensors.end()) {
         tmpSensor = iter->second;
         simSensors.erase(iter);
+        sensorRegistry.remove(index);
         if (tmpSensor)
           delete tmpSensor;
       }
@@ -236,6 +235,60 @@ namespace mars {
       return 0;
     }
 
+    int SensorManager::getSensorDataSize(unsigned long id) const {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, BaseSensor*>::const_iterator iter;
+
+      iter = simSensors.find(id);
+      if (iter != simSensors.end()) {
+        int size = iter->second->getSensorDataSize();
+        if(size < 0) {
+          // the sensor only implements getSensorData()
+          sReal *data = 0;
+          size = iter->second->getSensorData(&data);
+          free(data);
+        }
+        return size;
+      }
+      return 0;
+    }
+
+    int SensorManager::readSensorData(unsigned long id, sReal *data,
+                                      int size) const {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, BaseSensor*>::const_iterator iter;
+
+      iter = simSensors.find(id);
+      if (iter != simSensors.end())
+        return iter->second->readSensorData(data, size);
+
+      LOG_DEBUG("Cannot Find Sensor wirh id: %lu\n",id);
+      return 0;
+    }
+
+    /**
+     * \brief Reads several sensors into one block while the sensor list is
+     * locked once. A missing sensor has no values.
+     */
+    int SensorManager::readSensorData(const unsigned long *ids,
+                                      int numSensors, sReal *data, int size,
+                                      int *offsets) const {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, BaseSensor*>::const_iterator iter;
+      int pos = 0, n;
+
+      for(int i=0; i<numSensors; ++i) {
+        if(offsets) offsets[i] = pos;
+        iter = simSensors.find(ids[i]);
+        if(iter == simSensors.end()) continue;
+        n = iter->second->readSensorData(data+std::min(pos, size),
+                                         std::max(size-pos, 0));
+        pos += n;
+      }
+      if(offsets) offsets[numSensors] = pos;
+      return pos;
+    }
+
 
     /**
      *\brief Returns the number of sensors that are currently present in the simulation.
@@ -266,6 +319,7 @@ namespace mars {
         delete sensor;
       }
       simSensors.clear();
+      sensorRegistry.clear();
       if(clear_all) simSensorsReload.clear();
       next_sensor_id = 1;
     }
@@ -323,6 +377,7 @@ namespace mars {
       BaseSensor *sensor = ((*it).second)(this->control,config);
       iMutex.lock();
       simSensors[id] = sensor;
+      sensorRegistry.add(id, sensor->name, sensor);
       iMutex.unlock();
   
       if(!reload) {
@@ -348,5 +403,79 @@ namespace mars {
       return createAndAddSensor(type, cfg);
     }
 
+    /**
+     * \brief Appends the number of sensors, the sensor ids, the state size
+     * of every sensor and the states in the order of the ids.
+     */
+    void SensorManager::saveState(std::vector<char> *state) const {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, BaseSensor*>::const_iterator iter;
+      unsigned long numSensors = simSensors.size();
+      unsigned long *ids, *sizes;
+      size_t numValues = 0;
+      sReal *values;
+
+      appendStateBlock(state, &numSensors, sizeof(numSensors));
+      if(simSensors.empty()) return;
+
+      ids = (unsigned long*)reserveStateBlock(state, numSensors*sizeof(unsigned long));
+      for(iter = simSensors.begin(); iter != simSensors.end(); ++iter) {
+        *ids++ = iter->first;
+      }
+      sizes = (unsigned long*)reserveStateBlock(state, numSensors*sizeof(unsigned long));
+      for(iter = simSensors.begin(); iter != simSensors.end(); ++iter) {
+        *sizes = std::max(iter->second->getStateSize(), 0);
+        numValues += *sizes++;
+      }
+      values = (sReal*)reserveStateBlock(state, numValues*sizeof(sReal));
+      for(iter = simSensors.begin(); iter != simSensors.end(); ++iter) {
+        if(iter->second->getStateSize() <= 0) continue;
+        iter->second->getState(values);
+        values += iter->second->getStateSize();
+      }
+    }
+
+    bool SensorManager::restoreState(const char **data, const char *end,
+                                     bool apply) {
+      MutexLocker locker(&iMutex);
+      map<unsigned long, BaseSensor*>::iterator iter;
+      const unsigned long *header, *ids, *sizes;
+      const sReal *values;
+      size_t numSensors = simSensors.size();
+      size_t numValues = 0;
+
+      header = (const unsigned long*)consumeStateBlock(data, end,
+                                                        sizeof(unsigned long));
+      if(!header) return false;
+      if(header[0] != numSensors) return false;
+      if(!numSensors) return true;
+
+      ids = (const unsigned long*)consumeStateBlock(data, end,
+                                                     numSensors*sizeof(unsigned long));
+      sizes = (const unsigned long*)consumeStateBlock(data, end,
+                                                       numSensors*sizeof(unsigned long));
+      if(!ids || !sizes) return false;
+      iter = simSensors.begin();
+      for(size_t i = 0; i < numSensors; ++i, ++iter) {
+        if(ids[i] != iter->first) return false;
+        if(sizes[i] != (unsigned long)std::max(iter->second->getStateSize(), 0)) {
+          return false;
+        }
+        numValues += sizes[i];
+      }
+      values = (const sReal*)consumeStateBlock(data, end,
+                                               numValues*sizeof(sReal));
+      if(!values) return false;
+      if(!apply) return true;
+
+      iter = simSensors.begin();
+      for(size_t i = 0; i < numSensors; ++i, ++iter) {
+        if(!sizes[i]) continue;
+        iter->second->setState(values);
+        values += sizes[i];
+      }
+      return true;
+    }
+
   } // end of namespace sim
 } // end of namespace mars
@@ -40,6 +40,8 @@
 
 #include <mars/interfaces/sim/SensorManagerInterface.h>
 #include <mars/interfaces/sim/ControlCenter.h>
+#include "ObjectRegistry.h"
+
 #include <mars/utils/Mutex.h>
 #include <configmaps/ConfigData.h>
 
@@ -169,6 +171,13 @@ namespace mars {
        */
       virtual int getSensorData(unsigned long id, interfaces::sReal **data) const;
 
+      virtual int getSensorDataSize(unsigned long id) const;
+      virtual int readSensorData(unsigned long id, interfaces::sReal *data,
+                                 int size) const;
+      virtual int readSensorData(const unsigned long *ids, int numSensors,
+                                 interfaces::sReal *data, int size,
+                                 int *offsets = 0) const;
+
       /**
        *\brief Returns the number of sensors that are currently present in the simulation.
        * 
@@ -207,6 +216,10 @@ namespace mars {
       virtual interfaces::BaseSensor* createAndAddSensor(configmaps::ConfigMap* config, bool reload=true);
       virtual interfaces::BaseSensor* createAndAddSensor(const std::string &type_name,interfaces::BaseConfig *config, bool reload=false);
 
+      virtual void saveState(std::vector<char> *state) const;
+      virtual bool restoreState(const char **data, const char *end,
+                                bool apply);
+
   
     private:
 
@@ -215,6 +228,7 @@ namespace mars {
 
       //! a containter for all sensors currently present in the simulation
       std::map<unsigned long, interfaces::BaseSensor*> simSensors;
+      ObjectRegistry<interfaces::BaseSensor> sensorRegistry;
 
       //! a containter for all sensors that are loaded after a reset of the simulation
       std::vector<SensorReloadHelper> simSensorsReload;
@@ -41,6 +41,7 @@ namespace mars {
       : control(c) {
 
       physical_joint = 0;
+      effortLimitVersion = 0;
       setSJoint(sJoint_);
 
       setupDataPackageMapping();
@@ -302,6 +303,7 @@ namespace mars {
     }
 
     void SimJoint::setEffortLimit(interfaces::sReal effort, unsigned char axis_index) {
+      ++effortLimitVersion;
       if (axis_index == 1) {
         physical_joint->setForceLimit(effort);
       }
@@ -124,6 +124,8 @@ namespace mars {
       interfaces::sReal getLowerLimit(unsigned char axis_index=1) const;
       interfaces::sReal getUpperLimit(unsigned char axis_index=1) const;
       interfaces::sReal getMotorTorque(void) const;  // FIXME: this should not be in the joint
+      /** is counted up by every setEffortLimit() call */
+      unsigned long getEffortLimitVersion(void) const {return effortLimitVersion;}
       interfaces::NodeId getNodeId(unsigned char node_index=1) const;
       const interfaces::JointData getSJoint(void) const;
       interfaces::sReal getVelocity(unsigned char axis_index=1) const;
@@ -207,6 +209,7 @@ namespace mars {
       utils::Vector t1, t2; // torques
       utils::Vector axis1_torque, axis2_torque, joint_load;
       interfaces::sReal motor_torque, invert;
+      unsigned long effortLimitVersion;
       utils::Vector axis1InNode1;
       utils::Vector node1ToAnchor;
 
@@ -79,6 +79,7 @@ namespace mars {
 
       myPlayJoint = 0;
       active = true;
+      paramVersion = 0;
 
       // controller
       p=0;
@@ -138,20 +139,24 @@ namespace mars {
 
     void SimMotor::addMimic(SimMotor* mimic) {
       mimics[mimic->getName()] = mimic;
+      ++paramVersion;
     }
 
     void SimMotor::removeMimic(std::string mimicname) {
       mimics.erase(mimicname);
+      ++paramVersion;
     }
 
     void SimMotor::clearMimics() {
       mimics.clear();
+      ++paramVersion;
     }
 
     void SimMotor::setMimic(sReal multiplier, sReal offset) {
       mimic = true;
       mimic_multiplier = multiplier;
       mimic_offset = offset;
+      ++paramVersion;
     }
 
     void SimMotor::setMaxEffortApproximation(utils::ApproximationFunction type,
@@ -175,6 +180,7 @@ namespace mars {
           break;
       }
       maxeffort_coefficients = coefficients;
+      ++paramVersion;
     }
 
     void SimMotor::setMaxSpeedApproximation(utils::ApproximationFunction type,
@@ -198,6 +204,7 @@ namespace mars {
           break;
       }
       maxspeed_coefficients = coefficients;
+      ++paramVersion;
     }
 
     void SimMotor::setCurrentApproximation(utils::ApproximationFunction2D type,
@@ -211,6 +218,7 @@ namespace mars {
           break;
       }
       current_coefficients = coefficients;
+      ++paramVersion;
     }
 
     void SimMotor::updateController() {
@@ -250,6 +258,7 @@ namespace mars {
           break;
       }
       //TODO: update the remaining parameters
+      ++paramVersion;
     }
 
     void SimMotor::runEffortController(sReal time) {
@@ -475,10 +484,12 @@ namespace mars {
 
     void SimMotor::attachJoint(SimJoint *joint){
       myJoint = joint;
+      ++paramVersion;
     }
 
     void SimMotor::attachPlayJoint(SimJoint *joint){
       myPlayJoint = joint;
+      ++paramVersion;
     }
 
     SimJoint* SimMotor::getJoint() const {
@@ -550,6 +561,7 @@ namespace mars {
     void SimMotor::setMaxEffort(sReal force) {
       sMotor.maxEffort = force;
       myJoint->setEffortLimit(sMotor.maxEffort, axis);
+      ++paramVersion;
     }
 
     void SimMotor::setMotorMaxForce(sReal force) { // deprecated
@@ -582,6 +594,7 @@ namespace mars {
 
     void SimMotor::setMaxSpeed(sReal speed) {
       sMotor.maxSpeed = fabs(speed);
+      ++paramVersion;
     }
 
     void SimMotor::setMaximumVelocity(sReal v) { // deprecated
@@ -632,22 +645,27 @@ namespace mars {
 
     void SimMotor::setMinValue(interfaces::sReal d) {
       sMotor.minValue = d;
+      ++paramVersion;
     }
 
     void SimMotor::setMaxValue(interfaces::sReal d) {
       sMotor.maxValue = d;
+      ++paramVersion;
     }
 
     void SimMotor::setP(sReal p) {
       sMotor.p = p;
+      ++paramVersion;
     }
 
     void SimMotor::setI(sReal i) {
       sMotor.i = i;
+      ++paramVersion;
     }
 
     void SimMotor::setD(sReal d) {
       sMotor.d = d;
+      ++paramVersion;
     }
 
     sReal SimMotor::getP() const {
@@ -665,6 +683,7 @@ namespace mars {
     void SimMotor::setSMotor(const MotorData &sMotor) {
       // todo: handle name change correctly
       this->sMotor = sMotor;
+      ++paramVersion;
       if(myJoint && (sMotor.type != MOTOR_TYPE_PID_FORCE)) {
           myJoint->attachMotor(axis);
           myJoint->setEffortLimit(sMotor.maxEffort, axis);
@@ -720,6 +739,7 @@ namespace mars {
         sMotor.p = mP;
         sMotor.i = mI;
         sMotor.d = mD;
+        ++paramVersion;
         break;
       case MOTOR_TYPE_DC: // deprecated
       case MOTOR_TYPE_VELOCITY:
@@ -737,6 +757,55 @@ namespace mars {
       return sMotor.jointIndex;
     }
 
+    /**
+     * \brief Writes the controller state (set point, positions, integrator,
+     * current and temperature estimation) into \a state.
+     */
+    void SimMotor::getState(sReal *state) const {
+      state[0] = controlValue;
+      state[1] = position1;
+      state[2] = position2;
+      state[3] = velocity;
+      state[4] = effort;
+      state[5] = current;
+      state[6] = temperature;
+      state[7] = last_error;
+      state[8] = integ_error;
+      state[9] = joint_velocity;
+      state[10] = error;
+      state[11] = time;
+      state[12] = tmpmaxeffort;
+      state[13] = tmpmaxspeed;
+      state[14] = active ? 1 : 0;
+    }
+
+    /**
+     * \brief Restores a state read by getState and passes the restored
+     * control parameter to the joint, as the last update would have done.
+     */
+    void SimMotor::setState(const sReal *state) {
+      controlValue = state[0];
+      position1 = state[1];
+      position2 = state[2];
+      velocity = state[3];
+      effort = state[4];
+      current = state[5];
+      temperature = state[6];
+      last_error = state[7];
+      integ_error = state[8];
+      joint_velocity = state[9];
+      error = state[10];
+      time = state[11];
+      tmpmaxeffort = state[12];
+      tmpmaxspeed = state[13];
+      active = (state[14] != 0);
+      ++paramVersion;
+      if(active && myJoint) {
+        myJoint->setEffortLimit(tmpmaxeffort, axis);
+        (myJoint->*setJointControlParameter)(*controlParameter, axis);
+      }
+    }
+
     void SimMotor::getCoreExchange(core_objects_exchange* obj) const {
       obj->index = sMotor.index;
       obj->name = sMotor.name;
@@ -70,6 +70,10 @@ namespace mars {
 
       void update(interfaces::sReal time_ms);
       void updateController();
+      // the number of values written by getState
+      static const size_t stateSize = 15;
+      void getState(interfaces::sReal *state) const;
+      void setState(const interfaces::sReal *state);
       void activate(void);
       void deactivate(void);
       void attachJoint(SimJoint *joint);
@@ -163,6 +167,10 @@ namespace mars {
 
 
     private:
+      // the MotorBatch reads the parameters and runs the controllers of
+      // the motors that do not need the generic update
+      friend class MotorBatch;
+
       // typedefs for function pointers
       typedef  void (SimJoint::*JointControlFunction)(interfaces::sReal, unsigned char);
       typedef void (SimMotor::*MotorControlFunction)(interfaces::sReal);
@@ -222,6 +230,10 @@ namespace mars {
       interfaces::sReal calcHeatDissipation(interfaces::sReal time_ms) const;
       interfaces::sReal calcHeatProduction(interfaces::sReal time_ms) const;
 
+      // incremented by every change of a parameter, the controller, the
+      // approximations or the attached joints
+      unsigned long paramVersion;
+
       // for dataBroker communication
       data_broker::DataPackage dbPackage;
       unsigned long dbPushId;
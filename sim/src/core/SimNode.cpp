@@ -158,6 +158,10 @@ namespace mars {
       }
       if (sNode.terrain) {
         if(sNode.terrain->pixelData) free(sNode.terrain->pixelData);
+        if(sNode.terrain->tiles) {
+          sNode.terrain->tiles->removeResidencyUser(sNode.terrain);
+          sNode.terrain->tiles->release();
+        }
         delete sNode.terrain;
         sNode.terrain = 0;
       }
@@ -530,8 +534,6 @@ namespace mars {
     void SimNode::update(sReal calc_ms, bool physics_thread) {
       MutexLocker locker(&iMutex);
       if (my_interface) {
-        Vector damping;
-        sReal d;
         last_l_vel = l_vel;
         last_a_vel = a_vel;
         // update the position and rotation of the node
@@ -543,78 +545,129 @@ namespace mars {
         my_interface->getTorque(&t);
         ground_contact = my_interface->getGroundContact();
         ground_contact_force = my_interface->getGroundContactForce();
-        if(calc_ms > 0) {
-          l_acc = (l_vel - last_l_vel) / (calc_ms / 1000.);
-          a_acc = (a_vel - last_a_vel) / (calc_ms / 1000.);
-        } else {
-          l_acc = Vector(0, 0, 0);
-          a_acc = Vector(0, 0, 0);
-        }
-        //i_velocity_sum -= i_velocity[vel_ptr];
-        //i_velocity[vel_ptr] = fabs(a_vel.length());
-        //i_velocity_sum += i_velocity[vel_ptr];
-        //d = i_velocity_sum / BACK_VEL;
+        updateFromPhysics(calc_ms, physics_thread);
+      }
+    }
 
-        //d = fabs(a_vel.length());
-        d = fabs(a_vel.norm());
+    void SimNode::update(sReal calc_ms, bool physics_thread,
+                         const NodeStateCache &states, size_t index) {
+      MutexLocker locker(&iMutex);
+      if (my_interface) {
+        last_l_vel = l_vel;
+        last_a_vel = a_vel;
+        sNode.pos = states.getPosition(index);
+        sNode.rot = states.getRotation(index);
+        l_vel = states.getLinearVelocity(index);
+        a_vel = states.getAngularVelocity(index);
+        f = states.getForce(index);
+        t = states.getTorque(index);
+        ground_contact = states.getGroundContact(index);
+        ground_contact_force = states.getGroundContactForce(index);
+        updateFromPhysics(calc_ms, physics_thread);
+      }
+    }
 
-        // here we can handle damping
-        if (sNode.linear_damping != 0) {
-          damping = l_vel;
-          damping *= 1-sNode.linear_damping;
-          my_interface->setLinearVelocity(damping);
-        }
-        if (sNode.angular_treshold && d < sNode.angular_treshold) {
-          damping = a_vel;
-          /*
-               damping.normalize();
-               damping *= ((i_velocity[1]-i_velocity[2])*(1-sNode.angular_low)+
-               i_velocity[1]);
-               //damping *= i_velocity[0];
-               */
-          damping *= 1-sNode.angular_low;
-          //i_velocity_sum -= i_velocity[vel_ptr];
-          //i_velocity[vel_ptr] = damping.length();
-          //i_velocity_sum += i_velocity[vel_ptr];
-          my_interface->setAngularVelocity(damping);
-        }
-        else if (sNode.angular_damping != 0) {
-          damping = a_vel;
-          /*damping.normalize();
-            damping *= ((i_velocity[1]-i_velocity[2])*(1-sNode.angular_damping)+
-            i_velocity[1]);
-            //damping *= i_velocity[0];
-            */
-          damping *= 1-sNode.angular_damping;
-          //i_velocity_sum -= i_velocity[vel_ptr];
-          //i_velocity[vel_ptr] = damping.length();
-          /*
-            if(i_velocity[vel_ptr] > sNode.angular_damping) {
-            damping.normalize();
-            damping *= i_velocity[0] - sNode.angular_damping;
-            }
-            else {
-            damping *= 0;
-            }*/
-          //i_velocity_sum += i_velocity[vel_ptr];
-          my_interface->setAngularVelocity(damping);
-        }
-        // handle friction direction by mirror node orientation
-        if(frictionDirNode && my_interface) {
-          Vector v = fRotation*fDirNode;
-          if(!sNode.c_params.friction_direction1) {
-            sNode.c_params.friction_direction1 = new Vector();
+    void SimNode::getAccelerations(sReal *acc) const {
+      MutexLocker locker(&iMutex);
+      for(int i = 0; i < 3; ++i) {
+        acc[i] = l_acc[i];
+        acc[3+i] = a_acc[i];
+      }
+    }
+
+    void SimNode::restoreState(const NodeStateCache &states, size_t index,
+                               const sReal *acc) {
+      MutexLocker locker(&iMutex);
+      sNode.pos = states.getPosition(index);
+      sNode.rot = states.getRotation(index);
+      l_vel = last_l_vel = states.getLinearVelocity(index);
+      a_vel = last_a_vel = states.getAngularVelocity(index);
+      f = states.getForce(index);
+      t = states.getTorque(index);
+      l_acc = Vector(acc[0], acc[1], acc[2]);
+      a_acc = Vector(acc[3], acc[4], acc[5]);
+    }
+
+    /**
+     * \brief Handles the values that depend on the new physical state.
+     *
+     * pre:
+     *     - iMutex is locked and my_interface is set
+     */
+    void SimNode::updateFromPhysics(sReal calc_ms, bool physics_thread) {
+      Vector damping;
+      sReal d;
+      if(calc_ms > 0) {
+        l_acc = (l_vel - last_l_vel) / (calc_ms / 1000.);
+        a_acc = (a_vel - last_a_vel) / (calc_ms / 1000.);
+      } else {
+        l_acc = Vector(0, 0, 0);
+        a_acc = Vector(0, 0, 0);
+      }
+      //i_velocity_sum -= i_velocity[vel_ptr];
+      //i_velocity[vel_ptr] = fabs(a_vel.length());
+      //i_velocity_sum += i_velocity[vel_ptr];
+      //d = i_velocity_sum / BACK_VEL;
+
+      //d = fabs(a_vel.length());
+      d = fabs(a_vel.norm());
+
+      // here we can handle damping
+      if (sNode.linear_damping != 0) {
+        damping = l_vel;
+        damping *= 1-sNode.linear_damping;
+        my_interface->setLinearVelocity(damping);
+      }
+      if (sNode.angular_treshold && d < sNode.angular_treshold) {
+        damping = a_vel;
+        /*
+             damping.normalize();
+             damping *= ((i_velocity[1]-i_velocity[2])*(1-sNode.angular_low)+
+             i_velocity[1]);
+             //damping *= i_velocity[0];
+             */
+        damping *= 1-sNode.angular_low;
+        //i_velocity_sum -= i_velocity[vel_ptr];
+        //i_velocity[vel_ptr] = damping.length();
+        //i_velocity_sum += i_velocity[vel_ptr];
+        my_interface->setAngularVelocity(damping);
+      }
+      else if (sNode.angular_damping != 0) {
+        damping = a_vel;
+        /*damping.normalize();
+          damping *= ((i_velocity[1]-i_velocity[2])*(1-sNode.angular_damping)+
+          i_velocity[1]);
+          //damping *= i_velocity[0];
+          */
+        damping *= 1-sNode.angular_damping;
+        //i_velocity_sum -= i_velocity[vel_ptr];
+        //i_velocity[vel_ptr] = damping.length();
+        /*
+          if(i_velocity[vel_ptr] > sNode.angular_damping) {
+          damping.normalize();
+          damping *= i_velocity[0] - sNode.angular_damping;
           }
-          *(sNode.c_params.friction_direction1) = v;
-          my_interface->setContactParams(sNode.c_params);
-        }
-        //vel_ptr = (vel_ptr+1)%BACK_VEL;
-        if(update_ray || true) {
-          my_interface->handleSensorData(physics_thread);
-          update_ray = false;
+          else {
+          damping *= 0;
+          }*/
+        //i_velocity_sum += i_velocity[vel_ptr];
+        my_interface->setAngularVelocity(damping);
+      }
+      // handle friction direction by mirror node orientation
+      if(frictionDirNode && my_interface) {
+        Vector v = fRotation*fDirNode;
+        if(!sNode.c_params.friction_direction1) {
+          sNode.c_params.friction_direction1 = new Vector();
         }
-        checkNodeState();
+        *(sNode.c_params.friction_direction1) = v;
+        my_interface->setContactParams(sNode.c_params);
+      }
+      //vel_ptr = (vel_ptr+1)%BACK_VEL;
+      if(update_ray || true) {
+        my_interface->handleSensorData(physics_thread);
+        update_ray = false;
       }
+      checkNodeState();
     }
 
     void SimNode::getCoreExchange(core_objects_exchange *obj) const {
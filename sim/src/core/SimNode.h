@@ -33,6 +33,7 @@
 #include <mars/interfaces/sensor_bases.h>
 #include <mars/interfaces/nodeState.h>
 #include <mars/interfaces/sim/NodeInterface.h>
+#include <mars/interfaces/sim/NodeStateCache.h>
 
 namespace mars {
 
@@ -167,6 +168,11 @@ namespace mars {
       
       // manipulation
       void update(interfaces::sReal calc_ms, bool physics_thread = true); ///< Updates the values of the node from the physical layer.
+      void update(interfaces::sReal calc_ms, bool physics_thread,
+                  const interfaces::NodeStateCache &states, size_t index); ///< Updates the values of the node from the entry \a index of the state cache.
+      void getAccelerations(interfaces::sReal *acc) const; ///< Writes the linear and angular acceleration.
+      void restoreState(const interfaces::NodeStateCache &states, size_t index,
+                        const interfaces::sReal *acc); ///< Takes a restored state without applying damping or sensors.
       void rotateAtPoint(const utils::Vector &rotation_point, const utils::Quaternion &rotation, bool move_group);
       void changeNode(interfaces::NodeData *node);
       void clearRelativePosition(void);
@@ -195,6 +201,8 @@ namespace mars {
       void setBrightness(double v);
 
     private:
+      void updateFromPhysics(interfaces::sReal calc_ms, bool physics_thread);
+
       interfaces::ControlCenter *control;
       interfaces::NodeData sNode;
       utils::Vector f;
@@ -38,10 +38,12 @@
 #include "Controller.h"
 
 #include <mars/utils/misc.h>
+#include <mars/utils/MutexLocker.h>
 #include <mars/interfaces/SceneParseException.h>
 #include <mars/interfaces/graphics/GraphicsManagerInterface.h>
 #include <mars/interfaces/sim/LoadCenter.h>
 #include <mars/interfaces/sim/LoadSceneInterface.h>
+#include <mars/interfaces/sim/SimState.h>
 #include <mars/data_broker/DataBrokerInterface.h>
 #include <lib_manager/LibInterface.hpp>
 #include <mars/interfaces/Logging.hpp>
@@ -51,6 +53,8 @@
 #include <stdexcept>
 #include <algorithm>
 #include <cctype> // for tolower()
+#include <stdint.h>
+#include <cstdlib>
 
 #ifdef __linux__
 #include <time.h>
@@ -73,13 +77,11 @@ namespace mars {
     }
 
 
-    Simulator *Simulator::activeSimulator = 0;
-
     Simulator::Simulator(lib_manager::LibManager *theManager) :
       lib_manager::LibInterface(theManager),
       exit_sim(false), allow_draw(true),
       sync_graphics(false), physics_mutex_count(0), physics(0),
-      haveNewPlugin(false) {
+      pluginsChanged(true), haveNewPlugin(false) {
 
       config_dir = DEFAULT_CONFIG_DIR;
       calc_time = 0;
@@ -108,13 +110,15 @@ namespace mars {
       arg_run    = 0;
       arg_grid   = 0;
       arg_ortho  = 0;
-      Simulator::activeSimulator = this; // set this Simulator object to the active one
 
       gravity = Vector(0.0, 0.0, -9.81); // set gravity to earth conditions
 
       // build the factories
       control = new ControlCenter();
       control->loadCenter = new LoadCenter();
+      // the physics meshes are loaded without the graphics
+      meshLoader = new MeshLoader();
+      control->loadCenter->loadMesh = meshLoader;
       control->sim = (SimulatorInterface*)this;
       control->cfg = 0;//defaultCFG;
       dbSimTimePackage.add("simTime", 0.);
@@ -154,6 +158,13 @@ namespace mars {
         control->cfg->writeConfig(saveFile.c_str(), "Simulator");
       }
       // TODO: do we need to delete control?
+      if(ControlCenter::theDataBroker == control->dataBroker) {
+        ControlCenter::theDataBroker = NULL;
+      }
+      if(control->loadCenter->loadMesh == meshLoader) {
+        control->loadCenter->loadMesh = NULL;
+      }
+      delete meshLoader;
       libManager->releaseLibrary("mars_graphics");
       libManager->releaseLibrary("cfg_manager");
       libManager->releaseLibrary("data_broker");
@@ -168,7 +179,11 @@ namespace mars {
       if(libName == "data_broker") {
         control->dataBroker = libManager->getLibraryAs<data_broker::DataBrokerInterface>("data_broker");
         if(control->dataBroker) {
-          ControlCenter::theDataBroker = control->dataBroker;
+          // with several simulators in one process the log messages go
+          // to the DataBroker of the first one
+          if(!ControlCenter::theDataBroker) {
+            ControlCenter::theDataBroker = control->dataBroker;
+          }
           // create streams
           getTimeMutex.lock();
           dbSimTimeId = control->dataBroker->pushData("mars_sim", "simTime",
@@ -188,7 +203,8 @@ namespace mars {
       } else if(libName == "mars_graphics") {
         control->graphics = libManager->getLibraryAs<interfaces::GraphicsManagerInterface>("mars_graphics");
         if(control->graphics) {
-          control->loadCenter->loadMesh = control->graphics->getLoadMeshInterface();
+          // mesh formats the MeshLoader does not know are read by osg
+          meshLoader->setFallback(control->graphics->getLoadMeshInterface());
           control->loadCenter->loadHeightmap = control->graphics->getLoadHeightmapInterface();
         }
       } else if(libName == "log_console") {
@@ -255,6 +271,11 @@ namespace mars {
       // init the physics-engine
       //Convention startPhysics function
       physics = PhysicsMapper::newWorldPhysics(control);
+      // the space has to be configured before the world is created
+      physics->space_type = cfgSpaceType.sValue;
+      physics->space_hash_min_level = cfgHashMinLevel.iValue;
+      physics->space_hash_max_level = cfgHashMaxLevel.iValue;
+      physics->space_quadtree_depth = cfgQuadtreeDepth.iValue;
       physics->initTheWorld();
       // the physics step_size is in seconds
       physics->step_size = calc_ms/1000.;
@@ -268,6 +289,7 @@ namespace mars {
       gravity.z() = cfgGZ.dValue;
       physics->world_gravity = gravity;
       physics->draw_contact_points = cfgDrawContact.bValue;
+      physics->sensor_threads = cfgSensorThreads.iValue;
 #ifndef __linux__
       this->setStackSize(16777216);
       fprintf(stderr, "INFO: set physics stack size to: %lu\n", getStackSize());
@@ -352,6 +374,7 @@ namespace mars {
       std::vector<pluginStruct>::iterator p_iter;
       long time;
       Status oldState;
+      bool publishTiming = false;
 
       physicsThreadLock();
 
@@ -394,42 +417,25 @@ namespace mars {
           avg_log_time /= count;
           avg_step_time /= count;
           count = 0;
-          fprintf(stderr, "Step World: %g\n", avg_step_time);
-          fprintf(stderr, "debug_log_time: %g\n", avg_log_time);
-          avg_step_time = avg_log_time = 0.0;
+          publishTiming = true;
         }
       }
 
       pluginLocker.lockForRead();
 
-      // It is possible for plugins to call switchPluginUpdateMode during
-      // the update call and get removed from the activePlugins list there.
-      // We use erased_active to notify this loop about an erasure.
-      for(unsigned int i = 0; i < activePlugins.size();) {
-        erased_active = false;
-        if(show_time)
-          time = utils::getTime();
-
-        activePlugins[i].p_interface->update(calc_ms);
-
-        if(!erased_active) {
-          if(show_time) {
-            time = getTimeDiff(time);
-            activePlugins[i].timer += time;
-            activePlugins[i].t_count++;
-            if(activePlugins[i].t_count > 20) {
-              activePlugins[i].timer /= activePlugins[i].t_count;
-              activePlugins[i].t_count = 0;
-              fprintf(stderr, "debug_time: %s: %g\n",
-                      activePlugins[i].name.c_str(),
-                      activePlugins[i].timer);
-              activePlugins[i].timer = 0.0;
-            }
-          }
-          ++i;
-        }
+      // Plugins that call switchPluginUpdateMode during their update are
+      // skipped by the scheduler; the waves are rebuild in the next step.
+      pluginListMutex.lock();
+      if(pluginsChanged) {
+        pluginScheduler.setPlugins(activePlugins);
+        pluginsChanged = false;
       }
+      pluginListMutex.unlock();
+
+      pluginScheduler.update(calc_ms, show_time);
       pluginLocker.unlock();
+
+      if(publishTiming) publishTimings();
       if (sync_graphics) {
         calc_time += calc_ms;
         if (calc_time >= sync_time) {
@@ -450,6 +456,24 @@ namespace mars {
       physicsThreadUnlock();
     }
 
+    void Simulator::publishTimings(void) {
+      std::vector<PluginTiming>::iterator iter;
+
+      if(control->dataBroker) {
+        pluginScheduler.getTimings(&pluginTimings);
+        dbTimingPackage.clear();
+        dbTimingPackage.add("step world", avg_step_time);
+        dbTimingPackage.add("data broker", avg_log_time);
+        for(iter=pluginTimings.begin(); iter!=pluginTimings.end(); ++iter) {
+          dbTimingPackage.add(iter->name, iter->avgTime);
+        }
+        control->dataBroker->pushData("mars_sim", "Timing",
+                                      dbTimingPackage, NULL,
+                                      data_broker::DATA_PACKAGE_READ_FLAG);
+      }
+      avg_step_time = avg_log_time = 0.0;
+    }
+
     /**
      * \return \c true if started, \c false if stopped
      */
@@ -570,6 +594,10 @@ namespace mars {
       } else {
         b_SceneChanged = true;
       }
+      // the access sets of the plugins may refer to the new nodes
+      pluginListMutex.lock();
+      pluginsChanged = true;
+      pluginListMutex.unlock();
     }
 
     int Simulator::loadScene(const std::string &filename, const std::string &robotname, bool threadsave, bool blocking) {
@@ -660,6 +688,7 @@ namespace mars {
 
     void Simulator::finishedDraw(void) {
       long time;
+      bool publishTiming = false;
       processRequests();
 
       if (reloadSim) {
@@ -698,12 +727,14 @@ namespace mars {
           newPlugins[i].p_interface->init();
         }
         newPlugins.clear();
+        pluginsChanged = true;
         haveNewPlugin = false;
         pluginLocker.unlock();
       }
 
 
       pluginLocker.lockForRead();
+      if(show_time) dbGuiTimingPackage.clear();
       for (unsigned int i=0; i<guiPlugins.size(); i++) {
         if(show_time)
           time = utils::getTime();
@@ -717,18 +748,90 @@ namespace mars {
           if(guiPlugins[i].t_count_gui > 20) {
             guiPlugins[i].timer_gui /= guiPlugins[i].t_count_gui;
             guiPlugins[i].t_count_gui = 0;
-            fprintf(stderr, "debug_time_gui: %s: %g\n",
-                    guiPlugins[i].name.data(),
-                    guiPlugins[i].timer_gui);
+            dbGuiTimingPackage.add(guiPlugins[i].name,
+                                   guiPlugins[i].timer_gui);
             guiPlugins[i].timer_gui = 0.0;
+            publishTiming = true;
           }
         }
       }
       pluginLocker.unlock();
 
+      if(publishTiming && control->dataBroker) {
+        control->dataBroker->pushData("mars_sim", "GuiTiming",
+                                      dbGuiTimingPackage, NULL,
+                                      data_broker::DATA_PACKAGE_READ_FLAG);
+      }
+
       control->dataBroker->trigger("mars_sim/finishedDrawTrigger");
     }
 
+    namespace {
+      struct SimStateHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        double simTime;
+      };
+    }
+
+    void Simulator::saveState(std::vector<char> *state) {
+      SimStateHeader header;
+      memcpy(header.magic, SIM_STATE_MAGIC, sizeof(header.magic));
+      header.version = SIM_STATE_VERSION;
+      header.headerSize = sizeof(SimStateHeader);
+
+      state->clear();
+      physicsThreadLock();
+      getTimeMutex.lock();
+      header.simTime = dbSimTimePackage[0].d;
+      getTimeMutex.unlock();
+      appendStateBlock(state, &header, sizeof(header));
+      control->nodes->saveState(state);
+      control->motors->saveState(state);
+      control->sensors->saveState(state);
+      physicsThreadUnlock();
+    }
+
+    bool Simulator::restoreState(const std::vector<char> &state) {
+      if(state.empty()) return false;
+      const char *begin = &state[0];
+      const char *end = begin + state.size();
+      const char *data = begin;
+      const SimStateHeader *header;
+
+      header = (const SimStateHeader*)consumeStateBlock(&data, end,
+                                                        sizeof(SimStateHeader));
+      if(!header || memcmp(header->magic, SIM_STATE_MAGIC,
+                           sizeof(header->magic)) ||
+         header->version != SIM_STATE_VERSION ||
+         header->headerSize != sizeof(SimStateHeader)) {
+        LOG_ERROR("Simulator: invalid simulation state");
+        return false;
+      }
+
+      physicsThreadLock();
+      // first check that the whole state matches the scene, so a wrong
+      // state does not leave the world half restored
+      const char *blocks = data;
+      if(!control->nodes->restoreState(&data, end, false) ||
+         !control->motors->restoreState(&data, end, false) ||
+         !control->sensors->restoreState(&data, end, false)) {
+        physicsThreadUnlock();
+        LOG_ERROR("Simulator: the simulation state does not match the scene");
+        return false;
+      }
+      data = blocks;
+      control->nodes->restoreState(&data, end, true);
+      control->motors->restoreState(&data, end, true);
+      control->sensors->restoreState(&data, end, true);
+      getTimeMutex.lock();
+      dbSimTimePackage[0].set(header->simTime);
+      getTimeMutex.unlock();
+      physicsThreadUnlock();
+      return true;
+    }
+
     void Simulator::newWorld(bool clear_all) {
       getTimeMutex.lock();
       realStartTime = utils::getTime();
@@ -928,6 +1031,7 @@ namespace mars {
       std::vector<pluginStruct>::iterator p_iter;
       bool afound = false;
       bool gfound = false;
+      MutexLocker locker(&pluginListMutex);
 
       for(p_iter=activePlugins.begin(); p_iter!=activePlugins.end();
           p_iter++) {
@@ -935,7 +1039,8 @@ namespace mars {
           afound = true;
           if(!(mode & PLUGIN_SIM_MODE)) {
             activePlugins.erase(p_iter);
-            erased_active = true;
+            pluginScheduler.removePlugin(pl);
+            pluginsChanged = true;
           }
           break;
         }
@@ -954,8 +1059,10 @@ namespace mars {
       for(p_iter=allPlugins.begin(); p_iter!=allPlugins.end();
           p_iter++) {
         if((*p_iter).p_interface == pl) {
-          if(mode & PLUGIN_SIM_MODE && !afound)
+          if(mode & PLUGIN_SIM_MODE && !afound) {
             activePlugins.push_back(*p_iter);
+            pluginsChanged = true;
+          }
           if(mode & PLUGIN_GUI_MODE && !gfound)
             guiPlugins.push_back(*p_iter);
           break;
@@ -1053,6 +1160,7 @@ namespace mars {
           p_iter++) {
         if((*p_iter).p_interface == pl) {
           activePlugins.erase(p_iter);
+          pluginsChanged = true;
           break;
         }
       }
@@ -1086,6 +1194,11 @@ namespace mars {
       allPlugins[plugin_index].p_interface->getSomeData(data);
     }
 
+    void Simulator::updatePluginAccessSets(void) {
+      MutexLocker locker(&pluginListMutex);
+      pluginsChanged = true;
+    }
+
 
     void Simulator::setSyncThreads(bool value) {
       sync_graphics = value;
@@ -1231,6 +1344,47 @@ namespace mars {
         return;
       }
 
+      if(_property.paramId == cfgSensorThreads.paramId) {
+        physics->sensor_threads = _property.iValue;
+        return;
+      }
+
+      if(_property.paramId == cfgPluginThreads.paramId) {
+        pluginScheduler.setNumThreads(_property.iValue);
+        return;
+      }
+
+      if(_property.paramId == cfgMeshCachePath.paramId) {
+        meshLoader->setCachePath(_property.sValue);
+        return;
+      }
+
+      if(_property.paramId == cfgMeshTriangles.paramId) {
+        meshLoader->setMaxTriangles(_property.iValue);
+        return;
+      }
+
+      // the spaces are rebuild with the next step
+      if(_property.paramId == cfgSpaceType.paramId) {
+        physics->space_type = _property.sValue;
+        return;
+      }
+
+      if(_property.paramId == cfgHashMinLevel.paramId) {
+        physics->space_hash_min_level = _property.iValue;
+        return;
+      }
+
+      if(_property.paramId == cfgHashMaxLevel.paramId) {
+        physics->space_hash_max_level = _property.iValue;
+        return;
+      }
+
+      if(_property.paramId == cfgQuadtreeDepth.paramId) {
+        physics->space_quadtree_depth = _property.iValue;
+        return;
+      }
+
     }
 
     void Simulator::initCfgParams(void) {
@@ -1275,6 +1429,50 @@ namespace mars {
       cfgVisRep = control->cfg->getOrCreateProperty("Simulator", "visual rep.",
                                                     (int)1, this);
 
+      // more than one thread moves the ray sensor update to a thread pool
+      cfgSensorThreads = control->cfg->getOrCreateProperty("Simulator",
+                                                           "sensor threads",
+                                                           (int)0, this);
+
+      // plugins with disjoint access sets are updated on this many threads
+      cfgPluginThreads = control->cfg->getOrCreateProperty("Simulator",
+                                                           "plugin threads",
+                                                           (int)1, this);
+      pluginScheduler.setNumThreads(cfgPluginThreads.iValue);
+
+      // welded physics meshes are cached in this directory; empty disables
+      // the cache
+      std::string meshCachePath;
+      const char *home = getenv("HOME");
+      if(home) meshCachePath = pathJoin(home, ".cache/mars/meshes");
+      cfgMeshCachePath = control->cfg->getOrCreateProperty("Simulator",
+                                                           "mesh cache path",
+                                                           meshCachePath,
+                                                           this);
+      meshLoader->setCachePath(cfgMeshCachePath.sValue);
+
+      // collision meshes with more triangles are decimated; 0 keeps all
+      cfgMeshTriangles = control->cfg->getOrCreateProperty("Simulator",
+                                                           "collision mesh triangles",
+                                                           (int)0, this);
+      meshLoader->setMaxTriangles(cfgMeshTriangles.iValue);
+
+      // broad phase of the physics: "hash", "sap" or "quadtree"
+      cfgSpaceType = control->cfg->getOrCreateProperty("Simulator", "space_type",
+                                                       "hash", this);
+
+      cfgHashMinLevel = control->cfg->getOrCreateProperty("Simulator",
+                                                          "space_hash_min_level",
+                                                          (int)-3, this);
+
+      cfgHashMaxLevel = control->cfg->getOrCreateProperty("Simulator",
+                                                          "space_hash_max_level",
+                                                          (int)10, this);
+
+      cfgQuadtreeDepth = control->cfg->getOrCreateProperty("Simulator",
+                                                           "space_quadtree_depth",
+                                                           (int)6, this);
+
       cfgUseNow = control->cfg->getOrCreateProperty("Simulator", "getTime:useNow",
                                                     (bool)false, this);
 
@@ -1348,6 +1546,14 @@ namespace mars {
       return returnTime;
     }
 
+    double Simulator::getSimTime() {
+      double simTime;
+      getTimeMutex.lock();
+      simTime = dbSimTimePackage[0].d;
+      getTimeMutex.unlock();
+      return simTime;
+    }
+
 
   } // end of namespace sim
 
@@ -45,6 +45,9 @@
 #include <mars/interfaces/sim/ControlCenter.h>
 #include <mars/interfaces/graphics/GraphicsUpdateInterface.h>
 
+#include "PluginScheduler.h"
+#include "MeshLoader.h"
+
 #include <iostream>
 
 
@@ -80,7 +83,6 @@ namespace mars {
 
       Simulator(lib_manager::LibManager *theManager); ///< Constructor of the \c class Simulator.
       virtual ~Simulator();
-      static Simulator *activeSimulator;
 
 
       // --- LibInterface ---
@@ -183,6 +185,7 @@ namespace mars {
       virtual void removePlugin(interfaces::PluginInterface *pl);
       virtual void switchPluginUpdateMode(int mode, interfaces::PluginInterface *pl);
       virtual void sendDataToPlugin(int plugin_index, void* data);
+      virtual void updatePluginAccessSets(void);
 
       //  virtual double initTimer(void);
       //  virtual double getTimer(double start) const;
@@ -213,6 +216,14 @@ namespace mars {
        */
       virtual unsigned long getTime();
 
+      /*
+       * returns the calculated simulation time
+       */
+      virtual double getSimTime();
+
+      virtual void saveState(std::vector<char> *state);
+      virtual bool restoreState(const std::vector<char> &state);
+
     private:
 
       struct LoadOptions {
@@ -247,8 +258,8 @@ namespace mars {
       int cameraMenuCheckedIndex;
 
       // threads
-      bool erased_active;
       utils::ReadWriteLock pluginLocker;
+      utils::Mutex pluginListMutex; ///< Guards activePlugins against switchPluginUpdateMode calls from parallel plugins.
       int sync_count;
       utils::Mutex externalMutex;
       utils::Mutex coreMutex;
@@ -277,8 +288,14 @@ namespace mars {
       std::vector<interfaces::pluginStruct> newPlugins;
       std::vector<interfaces::pluginStruct> activePlugins;
       std::vector<interfaces::pluginStruct> guiPlugins;
+      PluginScheduler pluginScheduler;
+      bool pluginsChanged; ///< The waves of the pluginScheduler have to be rebuild.
+      std::vector<PluginTiming> pluginTimings;
+      data_broker::DataPackage dbTimingPackage, dbGuiTimingPackage;
+      void publishTimings(void);
 
       // scenes
+      MeshLoader *meshLoader;
       int loadScene_internal(const std::string &filename, bool wasrunning, const std::string &robotname);
       std::string scenename;
       std::list<std::string> arg_v_scene_name;
@@ -293,7 +310,11 @@ namespace mars {
       cfg_manager::cfgPropertyStruct cfgSyncGui, cfgDrawContact;
       cfg_manager::cfgPropertyStruct cfgGX, cfgGY, cfgGZ;
       cfg_manager::cfgPropertyStruct cfgWorldErp, cfgWorldCfm;
+      cfg_manager::cfgPropertyStruct cfgSensorThreads, cfgPluginThreads;
+      cfg_manager::cfgPropertyStruct cfgSpaceType, cfgQuadtreeDepth;
+      cfg_manager::cfgPropertyStruct cfgHashMinLevel, cfgHashMaxLevel;
       cfg_manager::cfgPropertyStruct cfgVisRep;
+      cfg_manager::cfgPropertyStruct cfgMeshCachePath, cfgMeshTriangles;
       cfg_manager::cfgPropertyStruct cfgSyncTime;
       cfg_manager::cfgPropertyStruct configPath;
       cfg_manager::cfgPropertyStruct cfgUseNow;
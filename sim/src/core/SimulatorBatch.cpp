@@ -0,0 +1,167 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file SimulatorBatch.cpp
+ * \brief "SimulatorBatch" steps several simulator instances of one
+ *        process on a thread pool.
+ *
+ */
+
+#include "SimulatorBatch.h"
+#include "PhysicsMapper.h"
+
+#include <mars/utils/MutexLocker.h>
+#include <mars/utils/Thread.h>
+
+#include <algorithm>
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+    using namespace interfaces;
+
+    class BatchWorker : public Thread {
+    public:
+      BatchWorker(SimulatorBatch *batch) : batch(batch) {}
+
+    protected:
+      void run() {
+        // every thread that steps a world needs its own ode data
+        PhysicsMapper::initThread();
+        batch->workerLoop();
+        PhysicsMapper::releaseThread();
+      }
+
+    private:
+      SimulatorBatch *batch;
+    };
+
+    SimulatorBatch::SimulatorBatch(int numThreads) : nextJob(0), numSteps(0),
+                                                     busyWorkers(0),
+                                                     generation(0),
+                                                     quit(false) {
+      BatchWorker *worker;
+
+      // the calling thread only waits; it may not have ode data
+      if(numThreads < 1) numThreads = 1;
+      for(int i=0; i<numThreads; ++i) {
+        worker = new BatchWorker(this);
+        workers.push_back(worker);
+        worker->start();
+      }
+    }
+
+    SimulatorBatch::~SimulatorBatch(void) {
+      std::vector<BatchWorker*>::iterator iter;
+
+      poolMutex.lock();
+      quit = true;
+      startCondition.wakeAll();
+      poolMutex.unlock();
+
+      for(iter=workers.begin(); iter!=workers.end(); ++iter) {
+        (*iter)->wait();
+        delete *iter;
+      }
+    }
+
+    void SimulatorBatch::addSimulator(SimulatorInterface *sim) {
+      MutexLocker locker(&poolMutex);
+      simulators.push_back(sim);
+    }
+
+    void SimulatorBatch::removeSimulator(SimulatorInterface *sim) {
+      MutexLocker locker(&poolMutex);
+      std::vector<SimulatorInterface*>::iterator iter;
+
+      iter = std::find(simulators.begin(), simulators.end(), sim);
+      if(iter != simulators.end()) simulators.erase(iter);
+    }
+
+    std::size_t SimulatorBatch::getNumSimulators(void) const {
+      return simulators.size();
+    }
+
+    SimulatorInterface* SimulatorBatch::getSimulator(std::size_t index) const {
+      if(index < simulators.size()) return simulators[index];
+      return 0;
+    }
+
+    int SimulatorBatch::getNumThreads(void) const {
+      return (int)workers.size();
+    }
+
+    /**
+     * \brief Steps all simulators on the pool.
+     *
+     * pre:
+     *     - the simulators were started with runSimulation(false)
+     *
+     * post:
+     *     - every simulator did \a numSteps steps
+     */
+    void SimulatorBatch::step(int numSteps) {
+      if(numSteps < 1) return;
+
+      poolMutex.lock();
+      if(simulators.empty()) {
+        poolMutex.unlock();
+        return;
+      }
+      this->numSteps = numSteps;
+      nextJob = 0;
+      busyWorkers = (int)workers.size();
+      ++generation;
+      startCondition.wakeAll();
+      while(busyWorkers > 0) doneCondition.wait(&poolMutex);
+      poolMutex.unlock();
+    }
+
+    SimulatorInterface* SimulatorBatch::getNextJob(void) {
+      MutexLocker locker(&poolMutex);
+      if(nextJob < simulators.size()) return simulators[nextJob++];
+      return 0;
+    }
+
+    void SimulatorBatch::workerLoop(void) {
+      SimulatorInterface *sim;
+      unsigned long done = 0;
+
+      poolMutex.lock();
+      while(true) {
+        while(!quit && generation == done) startCondition.wait(&poolMutex);
+        if(quit) break;
+        done = generation;
+        poolMutex.unlock();
+
+        while((sim = getNextJob())) {
+          for(int i=0; i<numSteps; ++i) sim->step();
+        }
+
+        poolMutex.lock();
+        if(--busyWorkers == 0) doneCondition.wakeOne();
+      }
+      poolMutex.unlock();
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,98 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file SimulatorBatch.h
+ * \brief "SimulatorBatch" steps several simulator instances of one
+ *        process on a thread pool.
+ *
+ */
+
+#ifndef SIMULATOR_BATCH_H
+#define SIMULATOR_BATCH_H
+
+#ifdef _PRINT_HEADER_
+  #warning "SimulatorBatch.h"
+#endif
+
+#include <mars/interfaces/sim/SimulatorInterface.h>
+#include <mars/utils/Mutex.h>
+#include <mars/utils/WaitCondition.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    class BatchWorker;
+
+    /**
+     * The SimulatorBatch steps a set of independent simulators in
+     * parallel, e.g. for parameter sweeps or reinforcement learning
+     * rollouts. Every simulator has to be loaded by its own
+     * lib_manager::LibManager, so that it gets its own DataBroker,
+     * CFGManager and ode world. The simulators have to be started with
+     * runSimulation(false); the batch then replaces their physics thread.
+     *
+     * A simulator is always stepped by one thread at a time, so the
+     * result of every instance is the same as if it was stepped alone.
+     */
+    class SimulatorBatch {
+    public:
+      SimulatorBatch(int numThreads);
+      ~SimulatorBatch(void);
+
+      void addSimulator(interfaces::SimulatorInterface *sim);
+      void removeSimulator(interfaces::SimulatorInterface *sim);
+      std::size_t getNumSimulators(void) const;
+      interfaces::SimulatorInterface* getSimulator(std::size_t index) const;
+      int getNumThreads(void) const;
+
+      /**
+       * Steps every simulator \a numSteps times and returns when all are
+       * done. Must not be called while another step() is running.
+       */
+      void step(int numSteps = 1);
+
+    private:
+      friend class BatchWorker;
+
+      std::vector<interfaces::SimulatorInterface*> simulators;
+      std::vector<BatchWorker*> workers;
+      utils::Mutex poolMutex;
+      utils::WaitCondition startCondition, doneCondition;
+      std::size_t nextJob;
+      int numSteps;
+      int busyWorkers;
+      unsigned long generation;
+      bool quit;
+
+      interfaces::SimulatorInterface* getNextJob(void);
+      void workerLoop(void);
+
+      SimulatorBatch(const SimulatorBatch &);
+      SimulatorBatch &operator=(const SimulatorBatch &);
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // SIMULATOR_BATCH_H
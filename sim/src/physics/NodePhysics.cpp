@@ -36,6 +36,7 @@
  */
 
 #include "NodePhysics.h"
+#include "RayCastEngine.h"
 #include "../sensors/RotatingRaySensor.h"
 
 #include <mars/interfaces/Logging.hpp>
@@ -76,6 +77,7 @@ namespace mars {
       myIndices = 0;
       myTriMeshData = 0;
       composite = false;
+      polarSensorsUpdated = false;
       //node_data.num_ground_collisions = 0;
       node_data.setZero();
       height_data = 0;
@@ -97,9 +99,14 @@ namespace mars {
       std::vector<sensor_list_element>::iterator iter;
       MutexLocker locker(&(theWorld->iMutex));
 
+      theWorld->unregisterSensorNode(this);
+      theWorld->releaseGeomData(&node_data);
       if(nBody) theWorld->destroyBody(nBody, this);
 
-      if(nGeom) dGeomDestroy(nGeom);
+      if(nGeom) {
+        dGeomDestroy(nGeom);
+        theWorld->invalidateRayCast();
+      }
 
       if(myVertices) free(myVertices);
       if(myIndices) free(myIndices);
@@ -117,8 +124,22 @@ namespace mars {
       if(myTriMeshData) dGeomTriMeshDataDestroy(myTriMeshData);
     }
 
-    dReal heightfield_callback(void* pUserData, int x, int z ) {
-      return ((NodePhysics*)pUserData)->heightCallback(x, z);
+    /**
+     * \brief Returns the space for the geom of the node. Immovable nodes
+     * are put into the static space of the world.
+     */
+    dSpaceID NodePhysics::getGeomSpace(NodeData *node) const {
+      if(node->movable) return theWorld->getSpace();
+      return theWorld->getStaticSpace();
+    }
+
+    /**
+     * \brief Reads a sample of a tiled terrain directly from the shared
+     * store. ODE counts the rows in the opposite direction of the image.
+     */
+    static dReal tiledHeightfieldCallback(void* pUserData, int x, int z) {
+      terrainStruct *t = (terrainStruct*)pUserData;
+      return (dReal)(t->tiles->getHeight(x, t->height-1-z)*t->scale);
     }
 
     /**
@@ -200,6 +221,7 @@ namespace mars {
         }
         node_data.id = node->index;
         dGeomSetData(nGeom, &node_data);
+        theWorld->invalidateRayCast();
         locker.unlock();
         setContactParams(node->c_params);
         return 1;
@@ -330,6 +352,7 @@ namespace mars {
           //offset.y() = pos->y - (sReal)(tpos[1]);
           //offset.z() = pos->z - (sReal)(tpos[2]);
           dGeomSetPosition(nGeom, (dReal)pos.x(), (dReal)pos.y(), (dReal)pos.z());
+          theWorld->invalidateRayCast();
           return offset;
         }
       }
@@ -553,6 +576,7 @@ namespace mars {
       else if(nGeom) {
         dGeomGetQuaternion(nGeom, tmp2);
         dGeomSetQuaternion(nGeom, tmp);
+        theWorld->invalidateRayCast();
       }
       dQMultiply2(tmp3, tmp, tmp2);
       q2.x() = (sReal)tmp3[1];
@@ -635,7 +659,7 @@ namespace mars {
       dGeomTriMeshDataBuildSimple(myTriMeshData, (dReal*)myVertices,
                                   node->mesh.vertexcount,
                                   myIndices, node->mesh.indexcount);
-      nGeom = dCreateTriMesh(theWorld->getSpace(), myTriMeshData, 0, 0, 0);
+      nGeom = dCreateTriMesh(getGeomSpace(node), myTriMeshData, 0, 0, 0);
 
       // at this moment we set the mass properties as the mass of the
       // bounding box if no mass and inertia is set by the user
@@ -669,7 +693,7 @@ namespace mars {
       }
 
       // build the ode representation
-      nGeom = dCreateBox(theWorld->getSpace(), (dReal)(node->ext.x()),
+      nGeom = dCreateBox(getGeomSpace(node), (dReal)(node->ext.x()),
                          (dReal)(node->ext.y()), (dReal)(node->ext.z()));
 
       // create the mass object for the box
@@ -702,7 +726,7 @@ namespace mars {
       }
 
       // build the ode representation
-      nGeom = dCreateSphere(theWorld->getSpace(), (dReal)node->ext.x());
+      nGeom = dCreateSphere(getGeomSpace(node), (dReal)node->ext.x());
 
       // create the mass object for the sphere
       if(node->inertia_set) {
@@ -732,7 +756,7 @@ namespace mars {
       }
 
       // build the ode representation
-      nGeom = dCreateCapsule(theWorld->getSpace(), (dReal)node->ext.x(),
+      nGeom = dCreateCapsule(getGeomSpace(node), (dReal)node->ext.x(),
                              (dReal)node->ext.y());
 
       // create the mass object for the capsule
@@ -765,7 +789,7 @@ namespace mars {
       }
 
       // build the ode representation
-      nGeom = dCreateCylinder(theWorld->getSpace(), (dReal)node->ext.x(),
+      nGeom = dCreateCylinder(getGeomSpace(node), (dReal)node->ext.x(),
                               (dReal)node->ext.y());
 
       // create the mass object for the cylinder
@@ -790,7 +814,7 @@ namespace mars {
     bool NodePhysics::createPlane(NodeData* node) {
 
       // build the ode representation
-      nGeom = dCreatePlane(theWorld->getSpace(), 0, 0, 1, (dReal)node->pos.z());
+      nGeom = dCreatePlane(getGeomSpace(node), 0, 0, 1, (dReal)node->pos.z());
       return true;
     }
 
@@ -799,29 +823,42 @@ namespace mars {
       unsigned long size;
       int x, y;
       terrain = node->terrain;
-      size = terrain->width*terrain->height;
-      if(!height_data) height_data = (dReal*)calloc(size, sizeof(dReal));
-      for(x=0; x<terrain->height; x++) {
-        for(y=0; y<terrain->width; y++) {
-          height_data[(terrain->height-(x+1))*terrain->width+y] = (dReal)terrain->pixelData[x*terrain->width+y];
-        }
-      }
       // build the ode representation
       dHeightfieldDataID heightid = dGeomHeightfieldDataCreate();
 
-      // Create an finite heightfield.
-      dGeomHeightfieldDataBuildCallback(heightid, this, heightfield_callback,
+      if(terrain->tiles) {
+        // the memory mapped tiles are shared with the graphics and
+        // other simulators; ODE reads them through the callback
+        dGeomHeightfieldDataBuildCallback(heightid, terrain,
+                                          tiledHeightfieldCallback,
+                                          terrain->targetWidth,
+                                          terrain->targetHeight,
+                                          terrain->width, terrain->height,
+                                          REAL(1.0), REAL( 0.0 ),
+                                          REAL(1.0), 0);
+      }
+      else {
+        // a float copy with flipped rows that ODE samples directly
+        size = terrain->width*terrain->height;
+        if(!height_data) height_data = (float*)calloc(size, sizeof(float));
+        for(x=0; x<terrain->height; x++) {
+          for(y=0; y<terrain->width; y++) {
+            height_data[(terrain->height-(x+1))*terrain->width+y] = (float)terrain->pixelData[x*terrain->width+y];
+          }
+        }
+        dGeomHeightfieldDataBuildSingle(heightid, height_data, 0,
                                         terrain->targetWidth,
                                         terrain->targetHeight,
                                         terrain->width, terrain->height,
-                                        REAL(1.0), REAL( 0.0 ),
+                                        REAL(terrain->scale), REAL( 0.0 ),
                                         REAL(1.0), 0);
+      }
       // Give some very bounds which, while conservative,
       // makes AABB computation more accurate than +/-INF.
       dGeomHeightfieldDataSetBounds(heightid, REAL(-terrain->scale*2.0),
                                     REAL(terrain->scale*2.0));
       //dGeomHeightfieldDataSetBounds(heightid, -terrain->scale, terrain->scale);
-      nGeom = dCreateHeightfield(theWorld->getSpace(), heightid, 1);
+      nGeom = dCreateHeightfield(getGeomSpace(node), heightid, 1);
       dRSetIdentity(R);
       dRFromAxisAndAngle(R, 1, 0, 0, M_PI/2);
       dGeomSetRotation(nGeom, R);
@@ -973,6 +1010,7 @@ namespace mars {
         npos.y() = new_pos[1] + (dReal)rotation_point.y();
         npos.z() = new_pos[2] + (dReal)rotation_point.z();
         dGeomSetPosition(nGeom, (dReal)npos.x(), (dReal)npos.y(), (dReal)npos.z());
+        theWorld->invalidateRayCast();
         return npos;
       }
       return npos;
@@ -1094,6 +1132,7 @@ namespace mars {
           }
         }
         dGeomSetData(nGeom, &node_data);
+        theWorld->invalidateRayCast();
         locker.unlock();
         setContactParams(node->c_params);
       }
@@ -1229,19 +1268,15 @@ namespace mars {
     void NodePhysics::getContactPoints(std::vector<Vector> *contact_points) const {
       contact_points->clear();
       if(nGeom) {
-        std::vector<Vector>::const_iterator iter;
-
-        for(iter=node_data.contact_points.begin();
-            iter!=node_data.contact_points.end(); ++iter)
-
-          contact_points->push_back((*iter));
+        contact_points->assign(node_data.contact_points.begin(),
+                               node_data.contact_points.end());
       }
     }
 
     void NodePhysics::getContactIDs(std::list<interfaces::NodeId> *ids) const {
       ids->clear();
       if(nGeom) {
-        *ids = node_data.contact_ids;
+        ids->assign(node_data.contact_ids.begin(), node_data.contact_ids.end());
       }
     }
 
@@ -1334,9 +1369,113 @@ namespace mars {
       dMassTranslate(tMass, pos[0], pos[1], pos[2]);
     }
 
-    dReal NodePhysics::heightCallback(int x, int y) {
+    /**
+     * \brief Writes the same values as the single getters into the entry
+     * \a index of the cache.
+     *
+     * pre:
+     *     - WorldPhysics::iMutex is locked
+     */
+    void NodePhysics::getState(NodeStateCache *cache, size_t index) const {
+      // no lock because the whole cache is filled by the WorldPhysics
+      sReal *pos = &cache->positions[3*index];
+      sReal *rot = &cache->rotations[4*index];
+      sReal *lvel = &cache->linearVelocities[3*index];
+      sReal *avel = &cache->angularVelocities[3*index];
+      sReal *f = &cache->forces[3*index];
+      sReal *t = &cache->torques[3*index];
+      const dReal *tmp;
+      dQuaternion q;
+      int i;
+
+      if(nGeom) {
+        tmp = dGeomGetPosition(nGeom);
+        dGeomGetQuaternion(nGeom, q);
+        for(i=0; i<3; ++i) pos[i] = (sReal)tmp[i];
+        rot[0] = (sReal)q[1];
+        rot[1] = (sReal)q[2];
+        rot[2] = (sReal)q[3];
+        rot[3] = (sReal)q[0];
+      }
+      else {
+        pos[0] = pos[1] = pos[2] = 0;
+        rot[0] = rot[1] = rot[2] = 0;
+        rot[3] = 1;
+      }
+
+      if(nBody) {
+        tmp = dBodyGetLinearVel(nBody);
+        for(i=0; i<3; ++i) lvel[i] = (sReal)tmp[i];
+        tmp = dBodyGetAngularVel(nBody);
+        for(i=0; i<3; ++i) avel[i] = (sReal)tmp[i];
+        tmp = dBodyGetForce(nBody);
+        for(i=0; i<3; ++i) f[i] = (sReal)tmp[i];
+        tmp = dBodyGetTorque(nBody);
+        for(i=0; i<3; ++i) t[i] = (sReal)tmp[i];
+      }
+      else {
+        for(i=0; i<3; ++i) lvel[i] = avel[i] = f[i] = t[i] = 0;
+      }
+
+      cache->groundContacts[index] = getGroundContact();
+      cache->groundContactForces[index] = getGroundContactForce();
+    }
+
+    /**
+     * \brief Copies the state of the body into \a state. Nodes of a
+     * composite group write the same values.
+     *
+     * pre:
+     *     - WorldPhysics::iMutex is locked
+     */
+    void NodePhysics::getBodyState(sReal *state) const {
+      const dReal *tmp;
+      int i;
+
+      if(!nBody) {
+        for(i=0; i<(int)bodyStateSize; ++i) state[i] = 0;
+        return;
+      }
+      tmp = dBodyGetPosition(nBody);
+      for(i=0; i<3; ++i) state[i] = (sReal)tmp[i];
+      tmp = dBodyGetQuaternion(nBody);
+      for(i=0; i<4; ++i) state[3+i] = (sReal)tmp[i];
+      tmp = dBodyGetLinearVel(nBody);
+      for(i=0; i<3; ++i) state[7+i] = (sReal)tmp[i];
+      tmp = dBodyGetAngularVel(nBody);
+      for(i=0; i<3; ++i) state[10+i] = (sReal)tmp[i];
+      tmp = dBodyGetForce(nBody);
+      for(i=0; i<3; ++i) state[13+i] = (sReal)tmp[i];
+      tmp = dBodyGetTorque(nBody);
+      for(i=0; i<3; ++i) state[16+i] = (sReal)tmp[i];
+      state[19] = dBodyIsEnabled(nBody) ? 1 : 0;
+    }
 
-      return (dReal)height_data[(y*terrain->width)+x]*terrain->scale;
+    /**
+     * \brief Restores a state read by getBodyState. The geoms of the body
+     * follow it, so the collision spaces are updated with the next step.
+     *
+     * pre:
+     *     - WorldPhysics::iMutex is locked
+     */
+    void NodePhysics::setBodyState(const sReal *state) {
+      dQuaternion q;
+
+      if(!nBody) return;
+      dBodySetPosition(nBody, (dReal)state[0], (dReal)state[1],
+                       (dReal)state[2]);
+      for(int i=0; i<4; ++i) q[i] = (dReal)state[3+i];
+      dBodySetQuaternion(nBody, q);
+      dBodySetLinearVel(nBody, (dReal)state[7], (dReal)state[8],
+                        (dReal)state[9]);
+      dBodySetAngularVel(nBody, (dReal)state[10], (dReal)state[11],
+                         (dReal)state[12]);
+      dBodySetForce(nBody, (dReal)state[13], (dReal)state[14],
+                    (dReal)state[15]);
+      dBodySetTorque(nBody, (dReal)state[16], (dReal)state[17],
+                     (dReal)state[18]);
+      if(state[19] != 0) dBodyEnable(nBody);
+      else dBodyDisable(nBody);
     }
 
     void NodePhysics::setContactParams(contact_params& c_params) {
@@ -1381,6 +1520,8 @@ namespace mars {
   
       //case SENSOR_TYPE_RAY:
       if(polarSensor){
+        // only the sensors of moving nodes are updated every step
+        if(nBody) theWorld->registerSensorNode(this);
         sle.sensor = sensor;
         sle.updateTime = 0.0;
         //sensor.count_data = sensor.resolution;
@@ -1552,6 +1693,10 @@ namespace mars {
         } else
           ++iter;
       }
+      for(iter = sensor_list.begin(); iter != sensor_list.end(); ++iter) {
+        if(dynamic_cast<BasePolarIntersectionSensor*>(iter->sensor)) return;
+      }
+      theWorld->unregisterSensorNode(this);
     }
 
     /**
@@ -1565,13 +1710,44 @@ namespace mars {
     void NodePhysics::handleSensorData(bool physics_thread) {
       if(!physics_thread) return;
       MutexLocker locker(&(theWorld->iMutex));
-      std::vector<sensor_list_element>::iterator iter;
+      // the polar sensors are already updated if the world uses
+      // the sensor thread pool
+      updateSensors(0, !polarSensorsUpdated, true);
+      polarSensorsUpdated = false;
+    }
+
+    /**
+     * \brief Updates the polar intersection sensors with the given ray cast
+     * context. Called by the sensor thread pool of the world, thus several
+     * nodes are updated in parallel.
+     *
+     * pre:
+     *     - theWorld->iMutex is locked by the thread running the pool
+     *     - the RayCastEngine snapshot is up to date
+     *
+     * post:
+     *     - the polar sensors are skipped by the next handleSensorData call
+     */
+    void NodePhysics::updatePolarSensors(RayCastContext *context) {
+      updateSensors(context, true, false);
+      polarSensorsUpdated = true;
+    }
+
+    /**
+     * \brief Updates the sensors of the node.
+     *
+     * If context is given the rays are cast on the snapshot of the ray cast
+     * engine, otherwise on the current world state.
+     *
+     * pre:
+     *     - theWorld->iMutex is locked
+     */
+    void NodePhysics::updateSensors(RayCastContext *context,
+                                    bool polar, bool grid) {
+      sensor_list_iterator iter;
       const dReal* pos = dGeomGetPosition(nGeom);
       const dReal* rot = dGeomGetRotation(nGeom);
       dVector3 dest, tmp, posOffset;
-      dReal steps_size = 1.0, length = 0.0;
-      bool done = false;
-      int steps = 0;
       dReal worldStep = theWorld->getWorldStep();
       // RotatingRaySensor
       utils::Vector tmpV;
@@ -1579,16 +1755,17 @@ namespace mars {
       turnrotation.setIdentity();
       std::set<unsigned long> ids_rotating_ray_sensors;
 
-      //New Code
-      int i=0;
+      ray_directions.clear();
+      ray_indices.clear();
       for(iter = sensor_list.begin(); iter != sensor_list.end(); iter++) {
-        i+=1;
+        BasePolarIntersectionSensor *polarSensor = dynamic_cast<BasePolarIntersectionSensor*>((*iter).sensor);
+        if(polarSensor ? !polar : !grid) continue;
+
         if((double)iter->sensor->updateRate * 0.001 > worldStep) {
           iter->updateTime += worldStep;
           if(iter->updateTime < 0.001*iter->sensor->updateRate) continue;
           iter->updateTime -= 0.001*iter->sensor->updateRate;
         }
-        BasePolarIntersectionSensor *polarSensor = dynamic_cast<BasePolarIntersectionSensor*>((*iter).sensor);
         if(polarSensor){
           sensor_list_element elem = *iter;
 
@@ -1606,45 +1783,24 @@ namespace mars {
                   turnrotation = rotRaySensor->turn();
                   ids_rotating_ray_sensors.insert(rotRaySensor->id);
               }
-              //fprintf(stderr, "tmp[%i]: %f, %f, %f\n", i, tmpV.x(), tmpV.y(), tmpV.z());
               tmpV = turnrotation * tmpV;
-              //fprintf(stderr, "tmp[%i]: %f, %f, %f\n", i, tmpV.x(), tmpV.y(), tmpV.z());
           }
-          tmp[0] = tmpV.x();//elem.ray_direction.x();
-          tmp[1] = tmpV.y();//elem.ray_direction.y();
-          tmp[2] = tmpV.z();//elem.ray_direction.z();
+          tmp[0] = tmpV.x();
+          tmp[1] = tmpV.y();
+          tmp[2] = tmpV.z();
           dMULTIPLY0_331(dest, rot, tmp);
 
-          if(physics_thread) {
-            steps = 0;
-            length = 0.0;
-            done = false;
-            dGeomEnable(elem.geom);
-            // make here the collision check
-            while (!done) {
-              dGeomRaySet(elem.geom,
-                          pos[0] + dest[0]*steps_size*steps,
-                          pos[1] + dest[1]*steps_size*steps,
-                          pos[2] + dest[2]*steps_size*steps,
-                          dest[0], dest[1], dest[2]);
-              if(length + steps_size < polarSensor->maxDistance) {
-                steps++;
-                dGeomRaySetLength(elem.geom, steps_size);
-              }
-              else {
-                dGeomRaySetLength(elem.geom, polarSensor->maxDistance- length);
-                done = true;
-              }
-              if(theWorld->handleCollision(elem.geom)) {
-                elem.gd->value += length;
-                done = true;
-              }
-              if(!done) length = steps_size*steps;
-            }
-            dGeomDisable(elem.geom);
+          // the rays of one sensor are collected and cast in one batch
+          ray_directions.push_back(dest[0]);
+          ray_directions.push_back(dest[1]);
+          ray_directions.push_back(dest[2]);
+          ray_indices.push_back(elem.index);
+
+          sensor_list_iterator next = iter+1;
+          if(next == sensor_list.end() || next->sensor != iter->sensor) {
+            castSensorRays(context, polarSensor, pos);
           }
-          (*polarSensor)[elem.index] = elem.gd->value;
-          elem.gd->value = polarSensor->maxDistance;
+          continue;
         }
     
         BaseGridIntersectionSensor *polarGridSensor;
@@ -1653,35 +1809,73 @@ namespace mars {
         if(polarGridSensor) {
           sensor_list_element elem = *iter;
 
-          if(physics_thread) {
-        
-            tmp[0] = elem.ray_direction.x();
-            tmp[1] = elem.ray_direction.y();
-            tmp[2] = elem.ray_direction.z();
-            dMULTIPLY0_331(dest, rot, tmp);
+          tmp[0] = elem.ray_direction.x();
+          tmp[1] = elem.ray_direction.y();
+          tmp[2] = elem.ray_direction.z();
+          dMULTIPLY0_331(dest, rot, tmp);
 
-            tmp[0] = elem.ray_pos_offset.x();
-            tmp[1] = elem.ray_pos_offset.y();
-            tmp[2] = elem.ray_pos_offset.z();
-            dMULTIPLY0_331(posOffset, rot, tmp);
+          tmp[0] = elem.ray_pos_offset.x();
+          tmp[1] = elem.ray_pos_offset.y();
+          tmp[2] = elem.ray_pos_offset.z();
+          dMULTIPLY0_331(posOffset, rot, tmp);
 
-            dGeomEnable(elem.geom);
+          dGeomEnable(elem.geom);
 
-            dGeomRaySet(elem.geom, pos[0] + posOffset[0],
-                        pos[1] + posOffset[1],
-                        pos[2] + posOffset[2],
-                        dest[0], dest[1], dest[2]);
+          dGeomRaySet(elem.geom, pos[0] + posOffset[0],
+                      pos[1] + posOffset[1],
+                      pos[2] + posOffset[2],
+                      dest[0], dest[1], dest[2]);
 
-            dGeomRaySetLength(elem.geom, polarGridSensor->maxDistance);
-            theWorld->handleCollision(elem.geom);
-            dGeomDisable(elem.geom);        
-          }
+          dGeomRaySetLength(elem.geom, polarGridSensor->maxDistance);
+          theWorld->handleCollision(elem.geom);
+          dGeomDisable(elem.geom);        
           (*polarGridSensor)[elem.index] = elem.gd->value;
           elem.gd->value = polarGridSensor->maxDistance;      
         }
       } // end for loop.
     }
 
+    /**
+     * \brief Casts the collected rays of a polar intersection sensor
+     *
+     * All rays start at the node position and use one full length ray
+     * with closest hit semantics instead of marching along the ray. With
+     * a context the snapshot of the ray cast engine is used.
+     *
+     * pre:
+     *     - theWorld->iMutex is locked
+     *     - ray_directions and ray_indices contain the rays of the sensor
+     *
+     * post:
+     *     - the sensor values are set and the ray buffers are cleared
+     */
+    void NodePhysics::castSensorRays(RayCastContext *context,
+                                     BasePolarIntersectionSensor *sensor,
+                                     const dReal *pos) {
+      RayCastEngine *engine = theWorld->getRayCastEngine();
+      size_t numRays = ray_indices.size();
+
+      ray_results.resize(numRays);
+      if(engine && context) {
+        engine->castRays(context, pos, 0, &ray_directions[0], (int)numRays,
+                         sensor->maxDistance, nGeom, nBody,
+                         COLLIDE_MASK_SENSOR, &ray_results[0]);
+      }
+      else if(engine) {
+        engine->castRays(pos, 0, &ray_directions[0], (int)numRays,
+                         sensor->maxDistance, nGeom, nBody,
+                         COLLIDE_MASK_SENSOR, &ray_results[0]);
+      }
+      else {
+        ray_results.assign(numRays, sensor->maxDistance);
+      }
+      for(size_t i=0; i<numRays; ++i) {
+        (*sensor)[ray_indices[i]] = ray_results[i];
+      }
+      ray_directions.clear();
+      ray_indices.clear();
+    }
+
     /**
      * \brief destroyes a node from the physics
      *
@@ -1691,9 +1885,13 @@ namespace mars {
      */
     void NodePhysics::destroyNode(void) {
       MutexLocker locker(&(theWorld->iMutex));
+      theWorld->releaseGeomData(&node_data);
       if(nBody) theWorld->destroyBody(nBody, this);
 
-      if(nGeom) dGeomDestroy(nGeom);
+      if(nGeom) {
+        dGeomDestroy(nGeom);
+        theWorld->invalidateRayCast();
+      }
 
       if(myVertices) free(myVertices);
       if(myIndices) free(myIndices);
@@ -1705,6 +1903,7 @@ namespace mars {
       myIndices = 0;
       myTriMeshData = 0;
       composite = false;
+      polarSensorsUpdated = false;
       //node_data.num_ground_collisions = 0;
       node_data.setZero();
       height_data = 0;
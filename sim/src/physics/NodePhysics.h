@@ -35,6 +35,7 @@
 #include "WorldPhysics.h"
 
 #include <mars/interfaces/sim/NodeInterface.h>
+#include <mars/interfaces/sim/NodeStateCache.h>
 
 #ifndef ODE11
   #define dTriIndex int
@@ -43,6 +44,8 @@
 namespace mars {
   namespace sim {
 
+    class RayCastContext;
+
     /*
      * we need a data structure to handle different collision parameter
      * and we need to save the collision_data somewhere
@@ -62,8 +65,9 @@ namespace mars {
       }
       unsigned long id;
       int num_ground_collisions;
+      // the contact vectors are cleared every step but keep their memory
       std::vector<utils::Vector> contact_points;
-      std::list<unsigned long> contact_ids;
+      std::vector<unsigned long> contact_ids;
       std::vector<dJointFeedback*> ground_feedbacks;
       bool node1;
       interfaces::contact_params c_params;
@@ -84,6 +88,8 @@ namespace mars {
       dReal updateTime;
     };
 
+    typedef std::vector<sensor_list_element>::iterator sensor_list_iterator;
+
     /**
      * The class that implements the NodeInterface interface.
      *
@@ -121,6 +127,7 @@ namespace mars {
       virtual void addSensor(interfaces::BaseSensor *sensor);
       virtual void removeSensor(interfaces::BaseSensor *sensor);
       virtual void handleSensorData(bool physics_thread = true);
+      void updatePolarSensors(RayCastContext *context);
       virtual void destroyNode(void);
       virtual void getMass(interfaces::sReal *mass, interfaces::sReal *inertia=0) const;
       virtual const utils::Vector getContactForce(void) const;
@@ -132,7 +139,12 @@ namespace mars {
       dMass getODEMass(void) const;
       void addMassToCompositeBody(dBodyID theBody, dMass *bodyMass);
       void getAbsMass(dMass *pMass) const;
-      dReal heightCallback(int x, int y);
+      void getState(interfaces::NodeStateCache *cache, size_t index) const;
+      // position, quaternion, linear and angular velocity, force, torque
+      // and the enabled flag of the body
+      static const size_t bodyStateSize = 20;
+      void getBodyState(interfaces::sReal *state) const;
+      void setBodyState(const interfaces::sReal *state);
 
     protected:
       WorldPhysics *theWorld;
@@ -145,8 +157,18 @@ namespace mars {
       bool composite;
       geom_data node_data;
       interfaces::terrainStruct *terrain;
-      dReal *height_data;
+      float *height_data;
       std::vector<sensor_list_element> sensor_list;
+      // buffers for the batched ray casts of the intersection sensors
+      std::vector<dReal> ray_directions;
+      std::vector<unsigned int> ray_indices;
+      std::vector<double> ray_results;
+      bool polarSensorsUpdated;
+      void updateSensors(RayCastContext *context, bool polar, bool grid);
+      void castSensorRays(RayCastContext *context,
+                          interfaces::BasePolarIntersectionSensor *sensor,
+                          const dReal *pos);
+      dSpaceID getGeomSpace(interfaces::NodeData *node) const;
       bool createMesh(interfaces::NodeData *node);
       bool createBox(interfaces::NodeData *node);
       bool createSphere(interfaces::NodeData *node);
@@ -0,0 +1,264 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file RayCastEngine.cpp
+ * \brief "RayCastEngine" casts all rays of a sensor in one batch against
+ *        the geoms of the physical world.
+ *
+ */
+
+#include "RayCastEngine.h"
+
+#include <cmath>
+
+// maximum number of contacts requested per ray and geom; with closest hit
+// enabled ode reports the nearest contact first for trimeshes
+#define MAX_RAY_CONTACTS 4
+
+namespace mars {
+  namespace sim {
+
+    static bool isInfinite(const dReal *aabb) {
+      for(int i=0; i<6; ++i) {
+        if(aabb[i] >= dInfinity || aabb[i] <= -dInfinity) return true;
+      }
+      return false;
+    }
+
+    static bool overlaps(const dReal *a, const dReal *b) {
+      return (a[0] <= b[1] && a[1] >= b[0] &&
+              a[2] <= b[3] && a[3] >= b[2] &&
+              a[4] <= b[5] && a[5] >= b[4]);
+    }
+
+    RayCastContext::RayCastContext(void) {
+      // the ray is not inserted into a space, we only use it for dCollide
+      ray = dCreateRay(0, 1.0);
+      dGeomRaySetClosestHit(ray, 1);
+    }
+
+    RayCastContext::~RayCastContext(void) {
+      if(ray) dGeomDestroy(ray);
+    }
+
+    RayCastEngine::RayCastEngine(dSpaceID space,
+                                 dSpaceID staticSpace) : space(space),
+                                                         staticSpace(staticSpace),
+                                                         dirty(true),
+                                                         numTopLevelGeoms(-1) {
+    }
+
+    RayCastEngine::~RayCastEngine(void) {
+    }
+
+    void RayCastEngine::invalidate(void) {
+      dirty = true;
+    }
+
+    void RayCastEngine::update(void) {
+      std::vector<ray_cast_entry>::iterator iter;
+
+      if(dirty || countTopLevelGeoms() != numTopLevelGeoms) rebuild();
+      for(iter=dynamicGeoms.begin(); iter!=dynamicGeoms.end(); ++iter) {
+        dGeomGetAABB(iter->geom, iter->aabb);
+        iter->infinite = isInfinite(iter->aabb);
+      }
+    }
+
+    void RayCastEngine::rebuild(void) {
+      staticGeoms.clear();
+      dynamicGeoms.clear();
+      collectGeoms(space);
+      if(staticSpace) collectGeoms(staticSpace);
+      numTopLevelGeoms = countTopLevelGeoms();
+      dirty = false;
+    }
+
+    int RayCastEngine::countTopLevelGeoms(void) const {
+      int count = dSpaceGetNumGeoms(space);
+      if(staticSpace) count += dSpaceGetNumGeoms(staticSpace);
+      return count;
+    }
+
+    void RayCastEngine::collectGeoms(dSpaceID s) {
+      ray_cast_entry entry;
+      dGeomID geom;
+
+      for(int i=0; i<dSpaceGetNumGeoms(s); ++i) {
+        geom = dSpaceGetGeom(s, i);
+        if(dGeomIsSpace(geom)) {
+          collectGeoms((dSpaceID)geom);
+          continue;
+        }
+        // rays in the space belong to other sensors
+        if(dGeomGetClass(geom) == dRayClass) continue;
+
+        entry.geom = geom;
+        dGeomGetAABB(geom, entry.aabb);
+        entry.infinite = isInfinite(entry.aabb);
+        if(dGeomGetBody(geom)) dynamicGeoms.push_back(entry);
+        else staticGeoms.push_back(entry);
+      }
+    }
+
+    /**
+     * \brief Slab test of a ray segment against an axis aligned box.
+     *
+     * Returns true if the segment [0, maxDistance] hits the box and sets
+     * entry to the distance where the ray enters the box.
+     */
+    bool RayCastEngine::rayHitsBox(const dReal *origin, const dReal *dir,
+                                   const dReal *aabb, dReal maxDistance,
+                                   dReal *entry) {
+      dReal tmin = 0.0, tmax = maxDistance;
+      dReal t1, t2, tmp;
+
+      for(int i=0; i<3; ++i) {
+        if(fabs(dir[i]) < 1e-12) {
+          if(origin[i] < aabb[i*2] || origin[i] > aabb[i*2+1]) return false;
+          continue;
+        }
+        t1 = (aabb[i*2] - origin[i]) / dir[i];
+        t2 = (aabb[i*2+1] - origin[i]) / dir[i];
+        if(t1 > t2) {
+          tmp = t1; t1 = t2; t2 = tmp;
+        }
+        if(t1 > tmin) tmin = t1;
+        if(t2 < tmax) tmax = t2;
+        if(tmin > tmax) return false;
+      }
+      *entry = tmin;
+      return true;
+    }
+
+    int RayCastEngine::castRays(const dReal *origins, int originStride,
+                                const dReal *directions, int numRays,
+                                dReal maxDistance,
+                                dGeomID ignoreGeom, dBodyID ignoreBody,
+                                unsigned long collideBits, double *result) {
+      if(dirty || countTopLevelGeoms() != numTopLevelGeoms) rebuild();
+      return cast(&defaultContext, false, origins, originStride, directions,
+                  numRays, maxDistance, ignoreGeom, ignoreBody, collideBits,
+                  result);
+    }
+
+    int RayCastEngine::castRays(RayCastContext *context,
+                                const dReal *origins, int originStride,
+                                const dReal *directions, int numRays,
+                                dReal maxDistance,
+                                dGeomID ignoreGeom, dBodyID ignoreBody,
+                                unsigned long collideBits,
+                                double *result) const {
+      return cast(context, true, origins, originStride, directions,
+                  numRays, maxDistance, ignoreGeom, ignoreBody, collideBits,
+                  result);
+    }
+
+    int RayCastEngine::cast(RayCastContext *context, bool snapshot,
+                            const dReal *origins, int originStride,
+                            const dReal *directions, int numRays,
+                            dReal maxDistance,
+                            dGeomID ignoreGeom, dBodyID ignoreBody,
+                            unsigned long collideBits, double *result) const {
+      std::vector<ray_cast_entry> &candidates = context->candidates;
+      std::vector<ray_cast_entry>::const_iterator iter;
+      dContactGeom contacts[MAX_RAY_CONTACTS];
+      ray_cast_entry entry;
+      dReal sensorBox[6];
+      const dReal *origin, *dir;
+      dReal best, boxEntry;
+      bool cullSensor;
+      int hits = 0, numc;
+
+      if(numRays <= 0) return 0;
+
+      // first cull the geoms against the volume that can be reached by
+      // any ray of the sensor
+      cullSensor = (maxDistance < dInfinity);
+      if(cullSensor) {
+        for(int k=0; k<3; ++k) {
+          sensorBox[k*2] = origins[k];
+          sensorBox[k*2+1] = origins[k];
+        }
+        for(int i=1; originStride && i<numRays; ++i) {
+          origin = origins + i*originStride;
+          for(int k=0; k<3; ++k) {
+            if(origin[k] < sensorBox[k*2]) sensorBox[k*2] = origin[k];
+            if(origin[k] > sensorBox[k*2+1]) sensorBox[k*2+1] = origin[k];
+          }
+        }
+        for(int k=0; k<3; ++k) {
+          sensorBox[k*2] -= maxDistance;
+          sensorBox[k*2+1] += maxDistance;
+        }
+      }
+
+      candidates.clear();
+      for(iter=staticGeoms.begin(); iter!=staticGeoms.end(); ++iter) {
+        if(iter->geom == ignoreGeom || !dGeomIsEnabled(iter->geom)) continue;
+        if(!(dGeomGetCategoryBits(iter->geom) & collideBits) &&
+           !(dGeomGetCollideBits(iter->geom) & collideBits)) continue;
+        if(cullSensor && !iter->infinite && !overlaps(sensorBox, iter->aabb))
+          continue;
+        candidates.push_back(*iter);
+      }
+      for(iter=dynamicGeoms.begin(); iter!=dynamicGeoms.end(); ++iter) {
+        if(iter->geom == ignoreGeom || !dGeomIsEnabled(iter->geom)) continue;
+        if(ignoreBody && dGeomGetBody(iter->geom) == ignoreBody) continue;
+        if(!(dGeomGetCategoryBits(iter->geom) & collideBits) &&
+           !(dGeomGetCollideBits(iter->geom) & collideBits)) continue;
+        entry = *iter;
+        // without snapshot the boxes are read from the moved geoms
+        if(!snapshot) {
+          dGeomGetAABB(entry.geom, entry.aabb);
+          entry.infinite = isInfinite(entry.aabb);
+        }
+        if(cullSensor && !entry.infinite && !overlaps(sensorBox, entry.aabb))
+          continue;
+        candidates.push_back(entry);
+      }
+
+      // then test each ray against the remaining candidates; the ray is
+      // shortened to the closest hit found so far
+      for(int i=0; i<numRays; ++i) {
+        origin = origins + i*originStride;
+        dir = directions + i*3;
+        best = maxDistance;
+        for(iter=candidates.begin(); iter!=candidates.end(); ++iter) {
+          if(!iter->infinite &&
+             !rayHitsBox(origin, dir, iter->aabb, best, &boxEntry)) continue;
+          dGeomRaySet(context->ray, origin[0], origin[1], origin[2],
+                      dir[0], dir[1], dir[2]);
+          dGeomRaySetLength(context->ray, best);
+          numc = dCollide(context->ray, iter->geom, MAX_RAY_CONTACTS, contacts,
+                          sizeof(dContactGeom));
+          for(int k=0; k<numc; ++k) {
+            if(contacts[k].depth < best) best = contacts[k].depth;
+          }
+        }
+        result[i] = best;
+        if(best < maxDistance) ++hits;
+      }
+      return hits;
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
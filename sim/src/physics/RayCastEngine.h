@@ -0,0 +1,155 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file RayCastEngine.h
+ * \brief "RayCastEngine" casts all rays of a sensor in one batch against
+ *        the geoms of the physical world.
+ *
+ */
+
+#ifndef RAY_CAST_ENGINE_H
+#define RAY_CAST_ENGINE_H
+
+#ifdef _PRINT_HEADER_
+  #warning "RayCastEngine.h"
+#endif
+
+#include <vector>
+
+#include <ode/ode.h>
+
+namespace mars {
+  namespace sim {
+
+    /**
+     * An entry of the broad phase cache: the geom and its axis aligned
+     * bounding box in the ode layout (minx, maxx, miny, maxy, minz, maxz).
+     */
+    struct ray_cast_entry {
+      dGeomID geom;
+      dReal aabb[6];
+      bool infinite;
+    };
+
+    /**
+     * The per thread state of a ray cast: the ray geom used for dCollide
+     * and the candidate buffer. Every thread that casts rays in parallel
+     * needs its own context.
+     */
+    class RayCastContext {
+    public:
+      RayCastContext(void);
+      ~RayCastContext(void);
+
+      dGeomID ray;
+      std::vector<ray_cast_entry> candidates;
+
+    private:
+      RayCastContext(const RayCastContext &);
+      RayCastContext &operator=(const RayCastContext &);
+    };
+
+    /**
+     * The RayCastEngine replaces the stepwise ray marching of the
+     * intersection sensors. Every beam is tested with one full length ray
+     * and the closest hit is returned. The bounding boxes of static geoms
+     * (geoms without body) are cached and only rebuild if the world
+     * changes; dynamic geoms are tested with their current bounding box.
+     *
+     * The engine does not lock the world; the caller has to hold
+     * WorldPhysics::iMutex. For parallel casts update() takes a snapshot
+     * of the bounding boxes; afterwards several threads can call castRays
+     * with their own RayCastContext as long as the world is not changed.
+     */
+    class RayCastEngine {
+    public:
+      RayCastEngine(dSpaceID space, dSpaceID staticSpace = 0);
+      ~RayCastEngine(void);
+
+      /**
+       * Marks the cached geom lists as outdated. Has to be called if a
+       * geom is created, destroyed or a static geom is moved.
+       */
+      void invalidate(void);
+
+      /**
+       * \brief Rebuilds the geom lists if needed and stores the current
+       * bounding boxes of the dynamic geoms.
+       *
+       * Reading the bounding boxes also lets ode update the lazily
+       * computed geom poses. Afterwards the geoms are only read by
+       * castRays as long as no geom is moved, created or destroyed.
+       */
+      void update(void);
+
+      /**
+       * \brief Casts numRays rays and writes the distance to the closest
+       * hit (or maxDistance if nothing is hit) into result.
+       *
+       * \param origins ray start points, three values per ray; if
+       *        originStride is 0 all rays share the first start point
+       * \param directions normalized ray directions in world frame, three
+       *        values per ray
+       * \param ignoreGeom geom that is not tested (the sensor's node)
+       * \param ignoreBody geoms attached to this body are not tested
+       * \return the number of rays that hit something
+       */
+      int castRays(const dReal *origins, int originStride,
+                   const dReal *directions, int numRays, dReal maxDistance,
+                   dGeomID ignoreGeom, dBodyID ignoreBody,
+                   unsigned long collideBits, double *result);
+
+      /**
+       * \brief Same as above, but uses the snapshot of the last update()
+       * call and the given context. Can be called from several threads
+       * at once if every thread uses its own context.
+       */
+      int castRays(RayCastContext *context,
+                   const dReal *origins, int originStride,
+                   const dReal *directions, int numRays, dReal maxDistance,
+                   dGeomID ignoreGeom, dBodyID ignoreBody,
+                   unsigned long collideBits, double *result) const;
+
+    private:
+      dSpaceID space, staticSpace;
+      bool dirty;
+      int numTopLevelGeoms;
+      std::vector<ray_cast_entry> staticGeoms;
+      std::vector<ray_cast_entry> dynamicGeoms;
+      RayCastContext defaultContext;
+
+      void rebuild(void);
+      int countTopLevelGeoms(void) const;
+      void collectGeoms(dSpaceID s);
+      int cast(RayCastContext *context, bool snapshot,
+               const dReal *origins, int originStride,
+               const dReal *directions, int numRays, dReal maxDistance,
+               dGeomID ignoreGeom, dBodyID ignoreBody,
+               unsigned long collideBits, double *result) const;
+      static bool rayHitsBox(const dReal *origin, const dReal *dir,
+                             const dReal *aabb, dReal maxDistance,
+                             dReal *entry);
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // RAY_CAST_ENGINE_H
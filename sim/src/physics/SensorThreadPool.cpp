@@ -0,0 +1,169 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file SensorThreadPool.cpp
+ * \brief "SensorThreadPool" evaluates the ray sensors of several nodes
+ *        in parallel after the physics step.
+ *
+ */
+
+#include "SensorThreadPool.h"
+#include "NodePhysics.h"
+#include "RayCastEngine.h"
+
+#include <mars/utils/MutexLocker.h>
+#include <mars/utils/Thread.h>
+
+namespace mars {
+  namespace sim {
+
+    using namespace utils;
+
+    /**
+     * A worker of the pool; the ray cast context is created by the pool
+     * in the thread that owns the world.
+     */
+    class SensorWorker : public Thread {
+    public:
+      SensorWorker(SensorThreadPool *pool) : pool(pool) {
+        context = new RayCastContext();
+      }
+
+      ~SensorWorker(void) {
+        delete context;
+      }
+
+    protected:
+      void run() {
+#ifdef ODE11
+        // every thread that collides geoms needs its own ode data
+        dAllocateODEDataForThread(dAllocateMaskAll);
+#endif
+        pool->workerLoop(context);
+#ifdef ODE11
+        dCleanupODEAllDataForThread();
+#endif
+      }
+
+    private:
+      SensorThreadPool *pool;
+      RayCastContext *context;
+    };
+
+    SensorThreadPool::SensorThreadPool(int numThreads) : jobs(0), nextJob(0),
+                                                         busyWorkers(0),
+                                                         generation(0),
+                                                         quit(false) {
+      SensorWorker *worker;
+
+      context = new RayCastContext();
+      // the calling thread is used as well
+      for(int i=1; i<numThreads; ++i) {
+        worker = new SensorWorker(this);
+        workers.push_back(worker);
+        worker->start();
+      }
+    }
+
+    SensorThreadPool::~SensorThreadPool(void) {
+      std::vector<SensorWorker*>::iterator iter;
+
+      poolMutex.lock();
+      quit = true;
+      startCondition.wakeAll();
+      poolMutex.unlock();
+
+      for(iter=workers.begin(); iter!=workers.end(); ++iter) {
+        (*iter)->wait();
+        delete *iter;
+      }
+      delete context;
+    }
+
+    int SensorThreadPool::getNumThreads(void) const {
+      return (int)workers.size() + 1;
+    }
+
+    /**
+     * \brief Runs the sensor update of all nodes on the pool and returns
+     * when every node is done.
+     *
+     * pre:
+     *     - WorldPhysics::iMutex is locked
+     *     - RayCastEngine::update was called after the last world change
+     *
+     * post:
+     *     - the polar intersection sensors of all nodes are updated
+     */
+    void SensorThreadPool::updateSensors(const std::vector<NodePhysics*> &nodes) {
+      if(nodes.empty()) return;
+
+      poolMutex.lock();
+      jobs = &nodes;
+      nextJob = 0;
+      busyWorkers = (int)workers.size();
+      ++generation;
+      startCondition.wakeAll();
+      poolMutex.unlock();
+
+      runJobs(context);
+
+      poolMutex.lock();
+      while(busyWorkers > 0) doneCondition.wait(&poolMutex);
+      jobs = 0;
+      poolMutex.unlock();
+    }
+
+    NodePhysics* SensorThreadPool::getNextJob(void) {
+      MutexLocker locker(&poolMutex);
+      if(jobs && nextJob < jobs->size()) return (*jobs)[nextJob++];
+      return 0;
+    }
+
+    void SensorThreadPool::runJobs(RayCastContext *workerContext) {
+      NodePhysics *node;
+      while((node = getNextJob())) {
+        node->updatePolarSensors(workerContext);
+      }
+    }
+
+    void SensorThreadPool::workerLoop(RayCastContext *workerContext) {
+      // a worker takes part in every generation; updateSensors does not
+      // start a new one before all workers finished the last one
+      unsigned long done = 0;
+
+      poolMutex.lock();
+      while(true) {
+        while(!quit && generation == done) startCondition.wait(&poolMutex);
+        if(quit) break;
+        done = generation;
+        poolMutex.unlock();
+
+        runJobs(workerContext);
+
+        poolMutex.lock();
+        if(--busyWorkers == 0) doneCondition.wakeOne();
+      }
+      poolMutex.unlock();
+    }
+
+  } // end of namespace sim
+} // end of namespace mars
@@ -0,0 +1,90 @@
+/*
+ *  Copyright 2011, 2012, DFKI GmbH Robotics Innovation Center
+ *
+ *  This file is part of the MARS simulation framework.
+ *
+ *  MARS is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation, either version 3
+ *  of the License, or (at your option) any later version.
+ *
+ *  MARS is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with MARS.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * \file SensorThreadPool.h
+ * \brief "SensorThreadPool" evaluates the ray sensors of several nodes
+ *        in parallel after the physics step.
+ *
+ */
+
+#ifndef SENSOR_THREAD_POOL_H
+#define SENSOR_THREAD_POOL_H
+
+#ifdef _PRINT_HEADER_
+  #warning "SensorThreadPool.h"
+#endif
+
+#include <mars/utils/Mutex.h>
+#include <mars/utils/WaitCondition.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace mars {
+  namespace sim {
+
+    class NodePhysics;
+    class RayCastContext;
+    class SensorWorker;
+
+    /**
+     * The SensorThreadPool runs NodePhysics::updatePolarSensors for a list
+     * of nodes on a fixed number of threads. The calling thread works on
+     * the list as well and updateSensors returns when all nodes are done.
+     *
+     * The pool does not lock the world. The caller has to hold
+     * WorldPhysics::iMutex and has to call RayCastEngine::update before,
+     * so that the workers only read the ode geoms. For trimesh collisions
+     * ode has to be build with thread local storage.
+     */
+    class SensorThreadPool {
+    public:
+      SensorThreadPool(int numThreads);
+      ~SensorThreadPool(void);
+
+      int getNumThreads(void) const;
+      void updateSensors(const std::vector<NodePhysics*> &nodes);
+
+    private:
+      friend class SensorWorker;
+
+      std::vector<SensorWorker*> workers;
+      RayCastContext *context;
+      utils::Mutex poolMutex;
+      utils::WaitCondition startCondition, doneCondition;
+      const std::vector<NodePhysics*> *jobs;
+      std::size_t nextJob;
+      int busyWorkers;
+      unsigned long generation;
+      bool quit;
+
+      NodePhysics* getNextJob(void);
+      void runJobs(RayCastContext *workerContext);
+      void workerLoop(RayCastContext *workerContext);
+
+      SensorThreadPool(const SensorThreadPool &);
+      SensorThreadPool &operator=(const SensorThreadPool &);
+    };
+
+  } // end of namespace sim
+} // end of namespace mars
+
+#endif  // SENSOR_THREAD_POOL_H
@@ -38,6 +38,8 @@
 
 #include "WorldPhysics.h"
 #include "NodePhysics.h"
+#include "RayCastEngine.h"
+#include "SensorThreadPool.h"
 
 
 #include <mars/utils/MutexLocker.h>
@@ -46,13 +48,24 @@
 #include <mars/interfaces/sim/SimulatorInterface.h>
 #include <mars/interfaces/Logging.hpp>
 
+#include <algorithm>
+
 namespace mars {
   namespace sim {
 
     using namespace utils;
     using namespace interfaces;
 
-    PhysicsError WorldPhysics::error = PHYSICS_NO_ERROR;
+#ifdef WIN32
+  #define WORLD_THREAD_LOCAL __declspec(thread)
+#else
+  #define WORLD_THREAD_LOCAL __thread
+#endif
+
+    // The ode message handlers are global. Several worlds can be stepped
+    // in parallel, so the world that is stepped by the current thread
+    // gets the error.
+    static WORLD_THREAD_LOCAL WorldPhysics *steppingWorld = 0;
 
     void myMessageFunction(int errnum, const char *msg, va_list ap) {
       CPP_UNUSED(errnum);
@@ -62,13 +75,13 @@ namespace mars {
     void myDebugFunction(int errnum, const char *msg, va_list ap) {
       CPP_UNUSED(errnum);
       LOG_DEBUG(msg, ap);
-      WorldPhysics::error = PHYSICS_DEBUG;
+      if(steppingWorld) steppingWorld->error = PHYSICS_DEBUG;
     }
 
     void myErrorFunction(int errnum, const char *msg, va_list ap) {
       CPP_UNUSED(errnum);
       LOG_ERROR(msg, ap);
-      WorldPhysics::error = PHYSICS_ERROR;
+      if(steppingWorld) steppingWorld->error = PHYSICS_ERROR;
     }
 
     /**
@@ -86,18 +99,31 @@ namespace mars {
 
       this->control = control;
       draw_contact_points = 0;
+      draw_intern.lineWidth = draw_extern.lineWidth = 10;
       fast_step = 0;
       world_cfm = 1e-10;
       world_erp = 0.1;
+      sensor_threads = 0;
+      space_type = "hash";
+      // the default levels of the ode hash space
+      space_hash_min_level = -3;
+      space_hash_max_level = 10;
+      space_quadtree_depth = 6;
       world_gravity = Vector(0.0, 0.0, -9.81);
       ground_friction = 20;
       ground_cfm = 0.00000001;
       ground_erp = 0.1;
       world = 0;
       space = 0;
+      static_space = 0;
+      num_static_geoms = 0;
+      rayCastEngine = 0;
+      sensorThreadPool = 0;
+      error = PHYSICS_NO_ERROR;
       contactgroup = 0;
       world_init = 0;
       num_contacts = 0;
+      num_feedbacks = 0;
       create_contacts = 1;
       log_contacts = 0;
 
@@ -129,10 +155,18 @@ namespace mars {
      *
      */
     WorldPhysics::~WorldPhysics(void) {
+      std::vector<dJointFeedback*>::iterator iter;
       // free the ode objects
       freeTheWorld();
       // and close the ODE ...
       MutexLocker locker(&iMutex);
+      // the workers clean up their ode data before ode is closed
+      delete sensorThreadPool;
+      sensorThreadPool = 0;
+      for(iter = feedback_pool.begin(); iter != feedback_pool.end(); ++iter) {
+        free(*iter);
+      }
+      feedback_pool.clear();
       dCloseODE();
     }
 
@@ -149,12 +183,23 @@ namespace mars {
      */
     void WorldPhysics::initTheWorld(void) {
       MutexLocker locker(&iMutex);
+      dVector3 center, extents;
   
       // if world_init = true debug something
       if (!world_init) {
         //LOG_DEBUG("init physics world");
         world = dWorldCreate();
-        space = dHashSpaceCreate(0);
+        old_space_type = space_type;
+        old_hash_min_level = space_hash_min_level;
+        old_hash_max_level = space_hash_max_level;
+        old_quadtree_depth = space_quadtree_depth;
+        getStaticExtents(center, extents);
+        space = createSpace(space_type, 0, center, extents);
+        // static geoms are only collided with the main space; they are in
+        // a quadtree that is rebuild to fit the scene
+        static_space = createSpace("quadtree", 0, center, extents);
+        num_static_geoms = 0;
+        rayCastEngine = new RayCastEngine(space, static_space);
         contactgroup = dJointGroupCreate(0);
 
         old_gravity = world_gravity;
@@ -191,7 +236,12 @@ namespace mars {
       if(world_init) {
         //LOG_DEBUG("free physics world");
         dJointGroupDestroy(contactgroup);
+        delete rayCastEngine;
+        rayCastEngine = 0;
+        dSpaceDestroy(static_space);
         dSpaceDestroy(space);
+        space = static_space = 0;
+        contact_geoms.clear();
         dWorldDestroy(world);
         world_init = 0;
       }
@@ -225,12 +275,10 @@ namespace mars {
      */
     void WorldPhysics::stepTheWorld(void) {
       MutexLocker locker(&iMutex);
-      std::vector<dJointFeedback*>::iterator iter;
-      geom_data* data;
-      int i;
 
       // if world_init = false or step_size <= 0 debug something
       if(world_init && step_size > 0) {
+        steppingWorld = this;
         if(old_gravity != world_gravity) {
           old_gravity = world_gravity;
           dWorldSetGravity(world, world_gravity.x(),
@@ -247,19 +295,13 @@ namespace mars {
           dWorldSetERP(world, (dReal)world_erp);
         }
 
-        /// first clear the collision counters of all geoms
-        for(i=0; i<dSpaceGetNumGeoms(space); i++) {
-          data = (geom_data*)dGeomGetData(dSpaceGetGeom(space, i));
-          data->num_ground_collisions = 0;
-          data->contact_ids.clear();
-          data->contact_points.clear();
-          data->ground_feedbacks.clear();
-        }
-        for(iter = contact_feedback_list.begin();
-            iter != contact_feedback_list.end(); iter++) {
-          free((*iter));
-        }
-        contact_feedback_list.clear();
+        updateSpaces();
+
+        /// first clear the collision counters of the geoms that had
+        /// contacts in the last step
+        clearContactGeoms();
+        // the feedbacks of the last step are reused
+        num_feedbacks = 0;
         draw_intern.clear();
         /// then we have to clear the contacts
         dJointGroupEmpty(contactgroup);
@@ -267,6 +309,8 @@ namespace mars {
         num_contacts = log_contacts = 0;
         create_contacts = 1;
         dSpaceCollide(space,this, &WorldPhysics::callbackForward);
+        dSpaceCollide2((dGeomID)static_space, (dGeomID)space, this,
+                       &WorldPhysics::callbackForward);
         
         drawLock.lock();
         draw_extern.swap(draw_intern);
@@ -279,11 +323,50 @@ namespace mars {
         } catch (...) {
           control->sim->handleError(PHYSICS_UNKNOWN);
         }
-	if(WorldPhysics::error) {
-          control->sim->handleError(WorldPhysics::error);
-          WorldPhysics::error = PHYSICS_NO_ERROR;
+        steppingWorld = 0;
+	if(error) {
+          control->sim->handleError(error);
+          error = PHYSICS_NO_ERROR;
 	}
+        updateSensors();
+      }
+    }
+
+    /**
+     * \brief Updates the intersection sensors of the registered nodes on
+     * the sensor thread pool.
+     *
+     * With less than two sensor threads nothing is done here and the
+     * sensors are updated by NodePhysics::handleSensorData as before.
+     *
+     * pre:
+     *     - iMutex is locked and the world was stepped
+     *
+     * post:
+     *     - the polar intersection sensors of all registered nodes hold
+     *       the values for the new world state
+     */
+    void WorldPhysics::updateSensors(void) {
+      if(sensor_threads < 2) {
+        if(sensorThreadPool) {
+          delete sensorThreadPool;
+          sensorThreadPool = 0;
+        }
+        return;
+      }
+      if(sensorNodes.empty() || !rayCastEngine) return;
+
+      if(sensorThreadPool &&
+         sensorThreadPool->getNumThreads() != sensor_threads) {
+        delete sensorThreadPool;
+        sensorThreadPool = 0;
+      }
+      if(!sensorThreadPool) {
+        sensorThreadPool = new SensorThreadPool(sensor_threads);
       }
+      // the snapshot makes the geoms read only for the workers
+      rayCastEngine->update();
+      sensorThreadPool->updateSensors(sensorNodes);
     }
 
     /**
@@ -312,6 +395,175 @@ namespace mars {
       return space;
     }
 
+    /**
+     * \brief Returns the space for the geoms of the immovable nodes.
+     *
+     * pre:
+     *     - none
+     *
+     * post:
+     *     - static space ID returned
+     */
+    dSpaceID WorldPhysics::getStaticSpace(void) const {
+      return static_space;
+    }
+
+    /**
+     * \brief Creates a broad phase space of the given type.
+     *
+     * Supported types are "hash" (with the configured levels), "sap"
+     * (sweep and prune) and "quadtree" (with the given center and half
+     * extents). Unknown types fall back to a hash space.
+     */
+    dSpaceID WorldPhysics::createSpace(const std::string &type,
+                                       dSpaceID parent,
+                                       const dVector3 center,
+                                       const dVector3 extents) {
+      dSpaceID newSpace;
+
+      if(type == "sap") {
+        newSpace = dSweepAndPruneSpaceCreate(parent, dSAP_AXES_XYZ);
+      }
+      else if(type == "quadtree") {
+        newSpace = dQuadTreeSpaceCreate(parent, center, extents,
+                                        space_quadtree_depth);
+      }
+      else {
+        if(type != "hash") {
+          LOG_WARN("WorldPhysics: unknown space type \"%s\", using hash space",
+                   type.c_str());
+        }
+        newSpace = dHashSpaceCreate(parent);
+        dHashSpaceSetLevels(newSpace, space_hash_min_level,
+                            space_hash_max_level);
+      }
+      return newSpace;
+    }
+
+    /**
+     * \brief Calculates the center and the half extents of the finite
+     * static geoms. The quadtree spaces are fitted to these extents.
+     */
+    void WorldPhysics::getStaticExtents(dVector3 center, dVector3 extents) {
+      dReal aabb[6], box[6];
+      dGeomID geom;
+      bool found = false;
+
+      for(int i=0; static_space && i<dSpaceGetNumGeoms(static_space); ++i) {
+        geom = dSpaceGetGeom(static_space, i);
+        dGeomGetAABB(geom, aabb);
+        if(aabb[0] <= -dInfinity || aabb[1] >= dInfinity ||
+           aabb[2] <= -dInfinity || aabb[3] >= dInfinity ||
+           aabb[4] <= -dInfinity || aabb[5] >= dInfinity) continue;
+        for(int k=0; k<6; k+=2) {
+          if(!found || aabb[k] < box[k]) box[k] = aabb[k];
+          if(!found || aabb[k+1] > box[k+1]) box[k+1] = aabb[k+1];
+        }
+        found = true;
+      }
+      if(!found) {
+        // no scene yet
+        for(int k=0; k<6; k+=2) {
+          box[k] = -50.0;
+          box[k+1] = 50.0;
+        }
+      }
+      for(int k=0; k<3; ++k) {
+        center[k] = 0.5*(box[k*2] + box[k*2+1]);
+        // a small margin keeps geoms at the border inside the root block
+        extents[k] = 0.5*(box[k*2+1] - box[k*2]) + 1.0;
+      }
+      center[3] = extents[3] = 0.0;
+    }
+
+    /**
+     * \brief Rebuilds the spaces if the space configuration changed or the
+     * static quadtree doesn't fit the static geoms anymore.
+     *
+     * The geoms are moved into the new spaces, thus the geom IDs stay
+     * valid.
+     *
+     * pre:
+     *     - iMutex is locked
+     */
+    void WorldPhysics::updateSpaces(void) {
+      dVector3 center, extents;
+      dSpaceID newSpace;
+      dGeomID geom;
+      bool rebuildMain, rebuildStatic;
+
+      rebuildMain = (old_space_type != space_type ||
+                     old_hash_min_level != space_hash_min_level ||
+                     old_hash_max_level != space_hash_max_level ||
+                     (space_type == "quadtree" &&
+                      old_quadtree_depth != space_quadtree_depth));
+      rebuildStatic = (old_quadtree_depth != space_quadtree_depth ||
+                       num_static_geoms != dSpaceGetNumGeoms(static_space));
+      if(!rebuildMain && !rebuildStatic) return;
+
+      old_space_type = space_type;
+      old_hash_min_level = space_hash_min_level;
+      old_hash_max_level = space_hash_max_level;
+      old_quadtree_depth = space_quadtree_depth;
+      num_static_geoms = dSpaceGetNumGeoms(static_space);
+      getStaticExtents(center, extents);
+
+      if(rebuildStatic) {
+        newSpace = createSpace("quadtree", 0, center, extents);
+        while(dSpaceGetNumGeoms(static_space)) {
+          geom = dSpaceGetGeom(static_space, 0);
+          dSpaceRemove(static_space, geom);
+          dSpaceAdd(newSpace, geom);
+        }
+        dSpaceDestroy(static_space);
+        static_space = newSpace;
+      }
+      if(rebuildMain) {
+        newSpace = createSpace(space_type, 0, center, extents);
+        while(dSpaceGetNumGeoms(space)) {
+          geom = dSpaceGetGeom(space, 0);
+          dSpaceRemove(space, geom);
+          dSpaceAdd(newSpace, geom);
+        }
+        dSpaceDestroy(space);
+        space = newSpace;
+      }
+      delete rayCastEngine;
+      rayCastEngine = new RayCastEngine(space, static_space);
+    }
+
+    /**
+     * \brief Resets the collision data of the geoms that had contacts in the
+     * last step. All other geoms are still reset from their last contact.
+     *
+     * pre:
+     *     - iMutex is locked
+     */
+    void WorldPhysics::clearContactGeoms(void) {
+      std::vector<geom_data*>::iterator iter;
+
+      for(iter = contact_geoms.begin(); iter != contact_geoms.end(); ++iter) {
+        (*iter)->num_ground_collisions = 0;
+        (*iter)->contact_ids.clear();
+        (*iter)->contact_points.clear();
+        (*iter)->ground_feedbacks.clear();
+      }
+      contact_geoms.clear();
+    }
+
+    /**
+     * \brief Has to be called before the geom data of a geom is deleted,
+     * otherwise the next step would reset the deleted data.
+     *
+     * pre:
+     *     - iMutex is locked
+     */
+    void WorldPhysics::releaseGeomData(geom_data *data) {
+      std::vector<geom_data*>::iterator iter;
+      iter = std::find(contact_geoms.begin(), contact_geoms.end(), data);
+      if(iter != contact_geoms.end()) contact_geoms.erase(iter);
+    }
+
     /**
      * \brief Sets the body pointer param to the body for the comp_group_id
      *
@@ -450,6 +702,10 @@ namespace mars {
       dBodyID b1=dGeomGetBody(o1);
       dBodyID b2=dGeomGetBody(o2);
 
+      /// two static geoms only have to be tested if one is a ray sensor
+      if(!b1 && !b2 && dGeomGetClass(o1) != dRayClass &&
+         dGeomGetClass(o2) != dRayClass) return;
+
       geom_data* geom_data1 = (geom_data*)dGeomGetData(o1);
       geom_data* geom_data2 = (geom_data*)dGeomGetData(o2);
 
@@ -502,7 +758,13 @@ namespace mars {
       else {
         maxNumContacts = geom_data2->c_params.max_num_contacts;
       }
-      dContact *contact = new dContact[maxNumContacts];
+      if(maxNumContacts <= 0) return;
+      // nearCallback is not reentered while the buffer is used; the
+      // space recursion above returns before we get here
+      if(contact_pool.size() < (size_t)maxNumContacts) {
+        contact_pool.resize(maxNumContacts);
+      }
+      dContact *contact = &contact_pool[0];
 
 
       //for granular test
@@ -657,33 +919,21 @@ namespace mars {
       numc=dCollide(o1,o2, maxNumContacts, &contact[0].geom,sizeof(dContact));
       if(numc){ 
         dJointFeedback *fb;
-        draw_item item;
         Vector contact_point;
 
         num_contacts++;
         if(create_contacts) {
           fb = 0;
-          item.id = 0;
-          item.type = DRAW_LINE;
-          item.draw_state = DRAW_STATE_CREATE;
-          item.point_size = 10;
-          item.myColor.r = 1;
-          item.myColor.g = 0;
-          item.myColor.b = 0;
-          item.myColor.a = 1;
-          item.label = "";
-          item.t_width = item.t_height = 0;
-          item.texture = "";
-          item.get_light = 0;
 
           for(i=0;i<numc;i++){
-            item.start.x() = contact[i].geom.pos[0];
-            item.start.y() = contact[i].geom.pos[1];
-            item.start.z() = contact[i].geom.pos[2];
-            item.end.x() = contact[i].geom.pos[0] + contact[i].geom.normal[0];
-            item.end.y() = contact[i].geom.pos[1] + contact[i].geom.normal[1];
-            item.end.z() = contact[i].geom.pos[2] + contact[i].geom.normal[2];
-            draw_intern.push_back(item);
+            if(draw_contact_points) {
+              Vector pos(contact[i].geom.pos[0], contact[i].geom.pos[1],
+                         contact[i].geom.pos[2]);
+              Vector normal(contact[i].geom.normal[0],
+                            contact[i].geom.normal[1],
+                            contact[i].geom.normal[2]);
+              draw_intern.addLine(pos, pos+normal, Color(1, 0, 0, 1));
+            }
             if(geom_data1->c_params.friction_direction1 ||
                geom_data2->c_params.friction_direction1) {
               v[0] = contact[i].geom.normal[0];
@@ -703,6 +953,13 @@ namespace mars {
             dJointID c=dJointCreateContact(world,contactgroup,contact+i);
             dJointAttach(c,b1,b2);
 
+            // remember the geoms to reset them in the next step
+            if(geom_data1->contact_ids.empty()) {
+              contact_geoms.push_back(geom_data1);
+            }
+            if(geom_data2->contact_ids.empty()) {
+              contact_geoms.push_back(geom_data2);
+            }
             geom_data1->num_ground_collisions += numc;
             geom_data2->num_ground_collisions += numc;
 
@@ -717,18 +974,16 @@ namespace mars {
             //if(dGeomGetClass(o1) == dPlaneClass) {
             fb = 0;
             if(geom_data2->sense_contact_force) {
-              fb = (dJointFeedback*)malloc(sizeof(dJointFeedback));
+              fb = getContactFeedback();
               dJointSetFeedback(c, fb);
-              contact_feedback_list.push_back(fb);
               geom_data2->ground_feedbacks.push_back(fb);
               geom_data2->node1 = false;
             } 
             //else if(dGeomGetClass(o2) == dPlaneClass) {
             if(geom_data1->sense_contact_force) {
               if(!fb) {
-                fb = (dJointFeedback*)malloc(sizeof(dJointFeedback));
+                fb = getContactFeedback();
                 dJointSetFeedback(c, fb);
-                contact_feedback_list.push_back(fb);
               }
               geom_data1->ground_feedbacks.push_back(fb);
               geom_data1->node1 = true;
@@ -736,7 +991,23 @@ namespace mars {
           }
         }
       }
-      delete[] contact;
+    }
+
+    /**
+     * \brief Returns a joint feedback from the feedback pool. The pool
+     * only grows if a step creates more feedbacks than any step before.
+     *
+     * pre:
+     *     - iMutex is locked
+     *
+     * post:
+     *     - the feedback is valid until the next step resets the pool
+     */
+    dJointFeedback* WorldPhysics::getContactFeedback(void) {
+      if(num_feedbacks == feedback_pool.size()) {
+        feedback_pool.push_back((dJointFeedback*)malloc(sizeof(dJointFeedback)));
+      }
+      return feedback_pool[num_feedbacks++];
     }
 
     /**
@@ -820,17 +1091,58 @@ namespace mars {
       return center;
     }
 
+    void WorldPhysics::getNodeStates(const std::vector<NodeInterface*> &nodes,
+                                     NodeStateCache *cache) const {
+      MutexLocker locker(&iMutex);
+
+      if(cache->size() != nodes.size()) cache->resize(nodes.size());
+      for(size_t i=0; i<nodes.size(); ++i) {
+        ((NodePhysics*)nodes[i])->getState(cache, i);
+      }
+    }
+
+    size_t WorldPhysics::getBodyStateSize(void) const {
+      return NodePhysics::bodyStateSize;
+    }
+
+    void WorldPhysics::getBodyStates(const std::vector<NodeInterface*> &nodes,
+                                     sReal *states) const {
+      MutexLocker locker(&iMutex);
+
+      for(size_t i=0; i<nodes.size(); ++i) {
+        ((NodePhysics*)nodes[i])->getBodyState(states);
+        states += NodePhysics::bodyStateSize;
+      }
+    }
+
+    void WorldPhysics::setBodyStates(const std::vector<NodeInterface*> &nodes,
+                                     const sReal *states) {
+      MutexLocker locker(&iMutex);
+
+      for(size_t i=0; i<nodes.size(); ++i) {
+        ((NodePhysics*)nodes[i])->setBodyState(states);
+        states += NodePhysics::bodyStateSize;
+      }
+      // the contacts of the last step belong to the old poses
+      dJointGroupEmpty(contactgroup);
+    }
+
     void WorldPhysics::update(std::vector<draw_item>* drawItems) {
-      MutexLocker locker(&drawLock);
       std::vector<draw_item>::iterator iter;
-  
+
+      // the contacts are drawn by updateBatch
       for(iter=drawItems->begin(); iter!=drawItems->end(); iter++) {
         iter->draw_state = DRAW_STATE_ERASE;
       }
+    }
+
+    void WorldPhysics::updateBatch(drawBatch *batch) {
+      MutexLocker locker(&drawLock);
       if(draw_contact_points) {
-        for(iter=draw_extern.begin(); iter!=draw_extern.end(); iter++) {
-          drawItems->push_back(*iter);
-        }
+        *batch = draw_extern;
+      }
+      else {
+        batch->clear();
       }
     }
 
@@ -838,19 +1150,75 @@ namespace mars {
       ray_collision = 0;
       dSpaceCollide2(theGeom, (dGeomID)space, this,
                      &WorldPhysics::callbackForward);
+      dSpaceCollide2(theGeom, (dGeomID)static_space, this,
+                     &WorldPhysics::callbackForward);
       return ray_collision;
     }
 
+    /**
+     * \brief Returns the engine that handles the batched ray casts of the
+     * intersection sensors. The engine is only available while a world
+     * exists.
+     */
+    RayCastEngine* WorldPhysics::getRayCastEngine(void) const {
+      return rayCastEngine;
+    }
+
+    /**
+     * \brief Has to be called if geoms are created, destroyed or static geoms
+     * are moved, so the ray cast engine rebuilds its geom cache.
+     */
+    void WorldPhysics::invalidateRayCast(void) {
+      if(rayCastEngine) rayCastEngine->invalidate();
+    }
+
+    /**
+     * \brief Adds a node to the list of nodes whose intersection sensors
+     * are updated on the sensor thread pool.
+     *
+     * pre:
+     *     - iMutex is locked
+     */
+    void WorldPhysics::registerSensorNode(NodePhysics *node) {
+      std::vector<NodePhysics*>::iterator iter;
+      iter = std::find(sensorNodes.begin(), sensorNodes.end(), node);
+      if(iter == sensorNodes.end()) sensorNodes.push_back(node);
+    }
+
+    /**
+     * \brief Removes a node from the sensor update list.
+     *
+     * pre:
+     *     - iMutex is locked
+     */
+    void WorldPhysics::unregisterSensorNode(NodePhysics *node) {
+      std::vector<NodePhysics*>::iterator iter;
+      iter = std::find(sensorNodes.begin(), sensorNodes.end(), node);
+      if(iter != sensorNodes.end()) sensorNodes.erase(iter);
+    }
+
     double WorldPhysics::getCollisionDepth(dGeomID theGeom) {
+      double depth = 0.0;
+      getCollisionDepth(space, theGeom, &depth);
+      getCollisionDepth(static_space, theGeom, &depth);
+      return depth;
+    }
+
+    void WorldPhysics::getCollisionDepth(dSpaceID s, dGeomID theGeom,
+                                         double *depth) {
       dGeomID otherGeom;
       dContact contact[1];
-      double depth = 0.0;
       int numc;
       dBodyID b1;
       dBodyID b2;
 
-      for(int i=0; i<dSpaceGetNumGeoms(space); i++) {
-        otherGeom = dSpaceGetGeom(space, i);
+      for(int i=0; i<dSpaceGetNumGeoms(s); i++) {
+        otherGeom = dSpaceGetGeom(s, i);
+
+        if(dGeomIsSpace(otherGeom)) {
+          getCollisionDepth((dSpaceID)otherGeom, theGeom, depth);
+          continue;
+        }
 
         if(!(dGeomGetCollideBits(theGeom) & dGeomGetCollideBits(otherGeom)))
           continue;
@@ -864,12 +1232,10 @@ namespace mars {
         numc = dCollide(theGeom, otherGeom, 1 | CONTACTS_UNIMPORTANT,
                         &(contact[0].geom), sizeof(dContact));
         if(numc) {
-          if(contact[0].geom.depth > depth)
-            depth = contact[0].geom.depth;
+          if(contact[0].geom.depth > *depth)
+            *depth = contact[0].geom.depth;
         }
       }
-
-      return depth;
     }
 
     int WorldPhysics::checkCollisions(void) {
@@ -877,36 +1243,49 @@ namespace mars {
       num_contacts = log_contacts = 0;
       create_contacts = 0;
       dSpaceCollide(space,this, &WorldPhysics::callbackForward);	
+      dSpaceCollide2((dGeomID)static_space, (dGeomID)space, this,
+                     &WorldPhysics::callbackForward);
       return num_contacts;
     }
 
     double WorldPhysics::getVectorCollision(const Vector &pos, 
                                             const Vector &ray) const {
       MutexLocker locker(&iMutex);
-      dGeomID otherGeom;
-      dContact contact[1];
       //double depth = ray.length();
       double depth = ray.norm();
-      int numc;
   
       dGeomID theGeom = dCreateRay(space, depth);
       dGeomRaySet(theGeom, pos.x(), pos.y(), pos.z(), ray.x(), ray.y(), ray.z()); 
 
-      for(int i=0; i<dSpaceGetNumGeoms(space); i++) {
-        otherGeom = dSpaceGetGeom(space, i);
+      getVectorCollision(space, theGeom, &depth);
+      getVectorCollision(static_space, theGeom, &depth);
+
+      dGeomDestroy(theGeom);
+      return depth;
+    }
 
+    void WorldPhysics::getVectorCollision(dSpaceID s, dGeomID theGeom,
+                                          double *depth) const {
+      dGeomID otherGeom;
+      dContact contact[1];
+      int numc;
+
+      for(int i=0; i<dSpaceGetNumGeoms(s); i++) {
+        otherGeom = dSpaceGetGeom(s, i);
+
+        if(dGeomIsSpace(otherGeom)) {
+          getVectorCollision((dSpaceID)otherGeom, theGeom, depth);
+          continue;
+        }
         if(!(dGeomGetCollideBits(theGeom) & dGeomGetCollideBits(otherGeom)))
           continue;
         numc = dCollide(theGeom, otherGeom, 1 | CONTACTS_UNIMPORTANT,
                         &(contact[0].geom), sizeof(dContact));
         if(numc) {
-          if(contact[0].geom.depth < depth)
-            depth = contact[0].geom.depth;
+          if(contact[0].geom.depth < *depth)
+            *depth = contact[0].geom.depth;
         }
       }
-
-      dGeomDestroy(theGeom);
-      return depth;
     }
 
   } // end of namespace sim
@@ -42,6 +42,7 @@
 #include <mars/interfaces/sim/PhysicsInterface.h>
 #include <mars/interfaces/graphics/draw_structs.h>
 
+#include <string>
 #include <vector>
 
 #include <ode/ode.h>
@@ -50,6 +51,9 @@ namespace mars {
   namespace sim {
 
     class NodePhysics;
+    struct geom_data;
+    class RayCastEngine;
+    class SensorThreadPool;
 
     /**
      * The struct is used to handle some sensors in the physical
@@ -92,12 +96,21 @@ namespace mars {
       virtual bool existsWorld(void) const;
       virtual const utils::Vector getCenterOfMass(const std::vector<interfaces::NodeInterface*> &nodes)const;
       virtual void update(std::vector<interfaces::draw_item> *drawItems);
+      virtual void updateBatch(interfaces::drawBatch *batch);
       virtual int checkCollisions(void);
       virtual interfaces::sReal getVectorCollision(const utils::Vector &pos, const utils::Vector &ray) const;
+      virtual void getNodeStates(const std::vector<interfaces::NodeInterface*> &nodes,
+                                 interfaces::NodeStateCache *cache) const;
+      virtual size_t getBodyStateSize(void) const;
+      virtual void getBodyStates(const std::vector<interfaces::NodeInterface*> &nodes,
+                                 interfaces::sReal *states) const;
+      virtual void setBodyStates(const std::vector<interfaces::NodeInterface*> &nodes,
+                                 const interfaces::sReal *states);
 
       // this functions are used by the other physical classes
       dWorldID getWorld(void) const;
       dSpaceID getSpace(void) const;
+      dSpaceID getStaticSpace(void) const;
       bool getCompositeBody(int comp_group, dBodyID *body, NodePhysics *node);
       void destroyBody(dBodyID theBody, NodePhysics *node);
       dReal getWorldStep(void);
@@ -105,28 +118,54 @@ namespace mars {
       void moveCompositeMassCenter(dBodyID theBody, dReal x, dReal y, dReal z);
       int handleCollision(dGeomID theGeom);
       interfaces::sReal getCollisionDepth(dGeomID theGeom);
+      RayCastEngine* getRayCastEngine(void) const;
+      void invalidateRayCast(void);
+      void registerSensorNode(NodePhysics *node);
+      void unregisterSensorNode(NodePhysics *node);
+      void releaseGeomData(geom_data *data);
       mutable utils::Mutex iMutex;
 
-      static interfaces::PhysicsError error;
+      interfaces::PhysicsError error; ///< set by the ode error handlers while this world is stepped
 
     private:
       utils::Mutex drawLock;
-      dSpaceID space;
+      dSpaceID space, static_space;
       dWorldID world;
+      RayCastEngine *rayCastEngine;
+      SensorThreadPool *sensorThreadPool;
+      std::vector<NodePhysics*> sensorNodes;
       dGeomID plane;
       dJointGroupID contactgroup;
       bool world_init;
       interfaces::ControlCenter *control;
       utils::Vector old_gravity;
       interfaces::sReal old_cfm, old_erp;
+      std::string old_space_type;
+      int old_hash_min_level, old_hash_max_level, old_quadtree_depth;
+      int num_static_geoms;
 
       std::vector<body_nbr_tupel> comp_body_list;
-      std::vector<interfaces::draw_item> draw_intern;
-      std::vector<interfaces::draw_item> draw_extern;
-      std::vector<dJointFeedback*> contact_feedback_list;
+      // the contact normals of the current and the last step
+      interfaces::drawBatch draw_intern;
+      interfaces::drawBatch draw_extern;
+      // per step contact arena; the memory is reused in every step
+      std::vector<dContact> contact_pool;
+      std::vector<dJointFeedback*> feedback_pool;
+      size_t num_feedbacks;
+      std::vector<geom_data*> contact_geoms;
       bool create_contacts, log_contacts;
       int num_contacts;
       int ray_collision;
+      void updateSensors(void);
+      dSpaceID createSpace(const std::string &type, dSpaceID parent,
+                           const dVector3 center, const dVector3 extents);
+      void getStaticExtents(dVector3 center, dVector3 extents);
+      void updateSpaces(void);
+      void clearContactGeoms(void);
+      void getCollisionDepth(dSpaceID s, dGeomID theGeom, double *depth);
+      void getVectorCollision(dSpaceID s, dGeomID theGeom,
+                              double *depth) const;
+      dJointFeedback* getContactFeedback(void);
       // this functions are for the collision implementation
       void nearCallback (dGeomID o1, dGeomID o2);
       static void callbackForward(void *data, dGeomID o1, dGeomID o2);
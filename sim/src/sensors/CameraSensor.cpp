@@ -22,6 +22,7 @@
 
 #include <mars/data_broker/DataBrokerInterface.h>
 #include <mars/utils/mathUtils.h>
+#include <mars/utils/imageKernels.h>
 #include <mars/interfaces/sim/LoadCenter.h>
 #include <mars/interfaces/sim/NodeManagerInterface.h>
 #include <mars/interfaces/sim/SimulatorInterface.h>
@@ -159,63 +160,39 @@ namespace mars {
     }
 
 
-    // this function is a hack currently, it uses sReal* as byte buffer
-    // NOTE: never use the cameraSensor in a controller list!!!!
-    int CameraSensor::getSensorData(sReal** data) const {
-      if(gw) {
-        // get image
-        int width, height;
-        /* todo: handle depth image
-        if(false && s_cfg.depthImage) {
-          // if there is a depth image, we would like to
-          // to also get the normal image data.
-          //
-          // what is a problem, is that in order to have it
-          // in the same block of memory, we need to copy
-          // the individual results
-
-          // get the image and depth data
-          void *t1 = 0;
-          gw->getImageData(&t1, width, height);
-          size_t image_size = width * height * sizeof( uint8_t ) * 4;
-
-          float *t2 = 0;
-          gw->getRTTDepthData(&t2, width, height);
-          size_t depth_size = width * height * sizeof( float );
-
-          // get a new block of memory which will contain
-          // both data
-          size_t data_size = image_size + depth_size;
-          uint8_t *res_mem = (uint8_t*)malloc( data_size );
-          *data = (sReal*)res_mem;
-
-          memcpy( res_mem, t1, image_size );
-          memcpy( res_mem + image_size, t2, depth_size );
-
-          free( t1 );
-          free( t2 );
-
-          return data_size;
-        }
-        else*/
-        {
-          unsigned char *buffer;
-          gw->getImageData((void**)&buffer, width, height);
-          unsigned int size = width*height;
-          if(size == 0) return 0;
-          *data = (sReal*)calloc(size*4, sizeof(sReal));
-          double s = 1./255;
-          for(unsigned int i=0; i<size; ++i) {
-            (*data)[i*4] = buffer[i*4]*s;
-            (*data)[i*4+1] = buffer[i*4+1]*s;
-            (*data)[i*4+2] = buffer[i*4+2]*s;
-            (*data)[i*4+3] = buffer[i*4+3]*s;
-          }
-          free(buffer);
-          return size*4;
-        }
-      }
-      return 0;
+    int CameraSensor::getSensorDataSize() const {
+      if(!gw) return 0;
+      return config.width*config.height*4;
+    }
+
+    /**
+     * Writes the rgba values of the image scaled to [0, 1]. readImage()
+     * avoids the conversion.
+     */
+    int CameraSensor::readSensorData(sReal *data, int size) const {
+      int n = getSensorDataSize();
+      if(n == 0 || size < n) return n;
+      imageBuffer.resize(n);
+      n = readImage(&imageBuffer[0], n);
+      utils::convertToDouble(&imageBuffer[0], data, n, 1./255);
+      return n;
+    }
+
+    int CameraSensor::readImage(uint8_t *buffer, int size) const {
+      int width, height;
+      int n = getSensorDataSize();
+      if(n == 0 || size < n) return n;
+      gw->getImageData((char*)buffer, width, height);
+      return width*height*4;
+    }
+
+    int CameraSensor::readDepthImage(float *buffer, int size) const {
+      int width, height;
+      if(!gw) return 0;
+      int n = config.width*config.height;
+      if(size < n) return n;
+      gw->getRTTDepthData(buffer, width, height);
+      return width*height;
     }
 
     void CameraSensor::deactivateRendering() {
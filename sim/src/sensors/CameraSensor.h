@@ -103,7 +103,16 @@ namespace mars {
       CameraSensor(interfaces::ControlCenter *control, const CameraConfigStruct config);
       ~CameraSensor(void);
 
-      virtual int getSensorData(interfaces::sReal** data) const;
+      virtual int getSensorDataSize() const;
+      virtual int readSensorData(interfaces::sReal *data, int size) const;
+      /**
+       * Copies the rgba image into \a buffer without conversion. \a size
+       * has to be at least width*height*4 bytes.
+       * \return The number of written bytes.
+       */
+      int readImage(uint8_t *buffer, int size) const;
+      /** Copies the depth image, width*height floats, into \a buffer. */
+      int readDepthImage(float *buffer, int size) const;
 
       void getImage(std::vector<Pixel> &buffer);
       void getDepthImage(std::vector<DistanceMeasurement> &buffer);
@@ -141,6 +150,8 @@ namespace mars {
       utils::Mutex mutex;
       int renderCam;
       unsigned long draw_id;
+      // reused by readSensorData()
+      mutable std::vector<uint8_t> imageBuffer;
   };
 
   } // end of namespace sim
@@ -153,16 +153,19 @@ namespace mars {
       return 10;
     }
 
-    int HapticFieldSensor::getSensorData(sReal** data) const {
+    int HapticFieldSensor::getSensorDataSize() const {
+      return 1;
+    }
+
+    int HapticFieldSensor::readSensorData(sReal *data, int size) const {
       sReal contact = 0;
       std::vector<double>::const_iterator iter;
 
-      *data = (sReal*) malloc(sizeof(sReal));
-      for (iter = forces.begin(); iter != forces.end(); iter++) {
+      if(size < 1) return 1;
+      for(iter = forces.begin(); iter != forces.end(); iter++) {
         contact += *iter;
-        ;
       }
-      **data = contact;
+      *data = contact;
       return 1;
     }
 
@@ -135,18 +135,22 @@ namespace mars {
     }
 
 
-    int Joint6DOFSensor::getSensorData(sReal** data) const {
+    int Joint6DOFSensor::getSensorDataSize() const {
+      return 6;
+    }
+
+    int Joint6DOFSensor::readSensorData(sReal *data, int size) const {
       Vector tmp;
-  
-      *data = (sReal*)malloc(sizeof(sReal)*6);
+
+      if(size < 6) return 6;
       tmp = (sensor_data.body_q * sensor_data.force);
-      (*data)[0] = tmp.x();
-      (*data)[1] = tmp.y();
-      (*data)[2] = tmp.z();
+      data[0] = tmp.x();
+      data[1] = tmp.y();
+      data[2] = tmp.z();
       tmp = (sensor_data.body_q * sensor_data.torque);
-      (*data)[3] = tmp.x();
-      (*data)[4] = tmp.y();
-      (*data)[5] = tmp.z();
+      data[3] = tmp.x();
+      data[4] = tmp.y();
+      data[5] = tmp.z();
       return 6;
     }
 
@@ -69,7 +69,8 @@ namespace mars {
       ~Joint6DOFSensor(void);
 
       virtual int getAsciiData(char* data) const;
-      virtual int getSensorData(interfaces::sReal **data) const;
+      virtual int getSensorDataSize() const;
+      virtual int readSensorData(interfaces::sReal *data, int size) const;
 
       void getForceData(utils::Vector *force);
       void getTorqueData(utils::Vector *torque);
@@ -82,16 +82,19 @@ namespace mars {
 
     }
 
-    int JointAVGTorqueSensor::getSensorData(sReal** data) const {
+    int JointAVGTorqueSensor::getSensorDataSize() const {
+      return 1;
+    }
+
+    int JointAVGTorqueSensor::readSensorData(sReal *data, int size) const {
       std::vector<double>::const_iterator iter;
+      sReal sum = 0;
 
-      *data = (sReal*)malloc(sizeof(sReal));
-      **data = 0;
+      if(size < 1) return 1;
       for(iter = doubleArray.begin(); iter != doubleArray.end(); iter++) {
-        **data += *iter;
+        sum += *iter;
       }
-      **data /= doubleArray.size();
-
+      *data = sum / doubleArray.size();
       return 1;
     }
 
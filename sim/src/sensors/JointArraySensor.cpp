@@ -109,16 +109,32 @@ namespace mars {
       return num_char;
     }
 
-    int JointArraySensor::getSensorData(sReal** data) const {
-      std::vector<double>::const_iterator iter;
-      int i=0;
+    int JointArraySensor::getSensorDataSize() const {
+      return doubleArray.size();
+    }
 
-      *data = (sReal*)calloc(doubleArray.size(), sizeof(sReal));
-      for(iter = doubleArray.begin(); iter != doubleArray.end(); iter++) {
-        (*data)[i++] = *iter;
+    int JointArraySensor::readSensorData(sReal *data, int size) const {
+      int n = doubleArray.size();
+      for(int i=0; i<n && i<size; ++i) {
+        data[i] = doubleArray[i];
+      }
+      return n;
+    }
+
+    int JointArraySensor::getStateSize() const {
+      return doubleArray.size();
+    }
+
+    void JointArraySensor::getState(double *state) const {
+      for(size_t i=0; i<doubleArray.size(); ++i) {
+        state[i] = doubleArray[i];
       }
+    }
 
-      return i;
+    void JointArraySensor::setState(const double *state) {
+      for(size_t i=0; i<doubleArray.size(); ++i) {
+        doubleArray[i] = state[i];
+      }
     }
 
   } // end of namespace sim
@@ -52,7 +52,11 @@ namespace mars {
                        IDListConfig config, bool initArray=true);
       virtual ~JointArraySensor(void);
       virtual int getAsciiData(char* data) const ;
-      virtual int getSensorData(interfaces::sReal **data) const ;
+      virtual int getSensorDataSize() const;
+      virtual int readSensorData(interfaces::sReal *data, int size) const;
+      virtual int getStateSize() const;
+      virtual void getState(double *state) const;
+      virtual void setState(const double *state);
       virtual void receiveData(const data_broker::DataInfo &info,
                                const data_broker::DataPackage &package,
                                int callbackParam) {}
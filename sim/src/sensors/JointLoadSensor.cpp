@@ -80,15 +80,19 @@ namespace mars {
       return 7;
     }
 
-    int JointLoadSensor::getSensorData(sReal** data) const {
+    int JointLoadSensor::getSensorDataSize() const {
+      return 1;
+    }
+
+    int JointLoadSensor::readSensorData(sReal *data, int size) const {
       std::vector<double>::const_iterator iter;
+      sReal sum = 0;
 
-      *data = (sReal*)malloc(sizeof(sReal));
-      **data = 0;
+      if(size < 1) return 1;
       for(iter = doubleArray.begin(); iter != doubleArray.end(); iter++) {
-        **data += *iter;
+        sum += *iter;
       }
-      **data /= doubleArray.size();
+      *data = sum / doubleArray.size();
       return 1;
     }
 
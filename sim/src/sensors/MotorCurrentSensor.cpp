@@ -98,15 +98,32 @@ namespace mars {
       return num_char;
     }
 
-    int MotorCurrentSensor::getSensorData(sReal** data) const {
-      std::vector<double>::const_iterator iter;
-      int i=0;
+    int MotorCurrentSensor::getSensorDataSize() const {
+      return doubleArray.size();
+    }
 
-      *data = (sReal*)calloc(doubleArray.size(), sizeof(sReal));
-      for(iter = doubleArray.begin(); iter != doubleArray.end(); iter++) {
-        (*data)[i++] = *iter;
+    int MotorCurrentSensor::readSensorData(sReal *data, int size) const {
+      int n = doubleArray.size();
+      for(int i=0; i<n && i<size; ++i) {
+        data[i] = doubleArray[i];
+      }
+      return n;
+    }
+
+    int MotorCurrentSensor::getStateSize() const {
+      return doubleArray.size();
+    }
+
+    void MotorCurrentSensor::getState(double *state) const {
+      for(size_t i=0; i<doubleArray.size(); ++i) {
+        state[i] = doubleArray[i];
+      }
+    }
+
+    void MotorCurrentSensor::setState(const double *state) {
+      for(size_t i=0; i<doubleArray.size(); ++i) {
+        doubleArray[i] = state[i];
       }
-      return i;
     }
 
 
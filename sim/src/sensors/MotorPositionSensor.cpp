@@ -92,17 +92,14 @@ namespace mars {
       return 0;
     }
 
-    int MotorPositionSensor::getSensorData(sReal** data) const {
-#if 0
-      std::vector<motorPositionData>::const_iterator iter;
-      int i=0;
+    int MotorPositionSensor::getSensorDataSize() const {
+      // the values are not collected yet
+      return 0;
+    }
 
-      *data = (sReal*)calloc(values.size(), sizeof(sReal));
-      for(iter = values.begin(); iter != values.end(); iter++) {
-        (*data)[i++] = (*iter).value;
-      }
-      return i;
-#endif
+    int MotorPositionSensor::readSensorData(sReal *data, int size) const {
+      CPP_UNUSED(data);
+      CPP_UNUSED(size);
       return 0;
     }
 
@@ -6,11 +6,13 @@
 
 #include <mars/data_broker/DataBrokerInterface.h>
 #include <mars/utils/mathUtils.h>
+#include <mars/utils/imageKernels.h>
 #include <base/Float.hpp>
 
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
 
 namespace mars {
@@ -166,10 +168,18 @@ const std::vector<double> &MultiLevelLaserRangeFinder::getSensorData() const {
     return rayValues;
 }
 
-int MultiLevelLaserRangeFinder::getSensorData(double** data) const
+int MultiLevelLaserRangeFinder::getSensorDataSize() const
 {
-    throw std::runtime_error("Awfull interface, is not supported by this sensor");
-    
+    return rayValues.size();
+}
+
+int MultiLevelLaserRangeFinder::readSensorData(double *data, int size) const
+{
+    int n = rayValues.size();
+    if(n && size > 0) {
+        memcpy(data, &rayValues[0], std::min(n, size)*sizeof(double));
+    }
+    return n;
 }
 
 
@@ -268,6 +278,31 @@ void MultiLevelLaserRangeFinder::calculateSamplingPixels()
     }
     
     std::cout << "Got " << lookups.size() << " lookup " << std::endl;
+
+    // group the lookups by sub sensor to gather the sampled pixels of
+    // each distance image at once
+    for(std::vector<RaySubSensor>::iterator it = subSensors.begin(); it != subSensors.end();it++)
+    {
+        it->sampleIndices.clear();
+        it->scanPositions.clear();
+        it->directionNorms.clear();
+    }
+    directions.resize(lookups.size());
+    for(size_t i = 0; i < lookups.size(); i++)
+    {
+        Lookup &lookup(lookups[i]);
+        lookup.sensor->sampleIndices.push_back(lookup.y * config.rttResolutionX + lookup.x);
+        lookup.sensor->scanPositions.push_back(i);
+        lookup.sensor->directionNorms.push_back(lookup.directionVector.norm());
+        // the distance image looks along z with y down, the camera of
+        // the sub sensor along -z with y up
+        const Vector &d = lookup.directionVector;
+        directions[i] = lookup.sensor->orientation * Vector(d.x(), -d.y(), -d.z()).normalized();
+    }
+    for(std::vector<RaySubSensor>::iterator it = subSensors.begin(); it != subSensors.end();it++)
+    {
+        it->samples.resize(it->sampleIndices.size());
+    }
     
 }
 
@@ -277,47 +312,39 @@ void MultiLevelLaserRangeFinder::update(std::vector<draw_item>* drawItems) {
     
 //     std::cout << "Update Called " << std::endl;
     
-    //update distance images
+    //update distance images and sample the pixels of the rays
     for(std::vector<RaySubSensor>::iterator it = subSensors.begin(); it != subSensors.end();it++)
     {
         it->gw->getRTTDepthData(it->distImage.data.data(), config.rttResolutionX, config.rttResolutionY);
-    }
-    
-    const int width = config.rttResolutionX;
-    
-    int validCnt = 0;
-    
-    for(int h = 0; h < config.numRaysHorizontal; h++)
-    {
-        for(int v = 0; v < config.numRaysVertical; v++)
+        if(it->sampleIndices.empty())
+            continue;
+        gatherPixels(it->distImage.data.data(), &it->sampleIndices[0],
+                     &it->samples[0], it->samples.size());
+
+        for(size_t i = 0; i < it->samples.size(); i++)
         {
-            const int curScanPos = h*config.numRaysVertical + v;
-            Lookup &lookup(lookups[curScanPos]);
-            
-            const int &x(lookup.x);
-            const int &y(lookup.y);
-            
-            const int curImagePos = y*width + x;
-            
-            const float &dist(lookup.sensor->distImage.data[curImagePos]);
+            const float dist = it->samples[i];
             if(boost::math::isnormal( dist ))
-            {
-                rayValues[curScanPos] = (dist * lookup.directionVector).norm();
-                
-                Eigen::Vector3d p;
-                lookup.sensor->distImage.getScenePoint(x, y, p);
-                
-                assert(fabs(p.norm() -  rayValues[curScanPos]) < 0.0001);
-                validCnt++;
-            }
+                rayValues[it->scanPositions[i]] = dist * it->directionNorms[i];
             else
-            {
-                rayValues[curScanPos] = base::unset<float>();
-            }
+                rayValues[it->scanPositions[i]] = base::unset<float>();
         }
     }
 }
 
+void MultiLevelLaserRangeFinder::updateBatch(drawBatch *batch) {
+    batch->clear();
+    if(!config.drawRays)
+        return;
+    for(size_t i = 0; i < rayValues.size(); i++)
+    {
+        if(!boost::math::isnormal(rayValues[i]))
+            continue;
+        batch->addLine(position, position + orientation * directions[i] * rayValues[i],
+                       Color(1, 0, 0, 1));
+    }
+}
+
 BaseConfig* MultiLevelLaserRangeFinder::parseConfig(ControlCenter *control,
                                     ConfigMap *config) {
     MultiLevelLaserRangeFinderConfig *cfg = new MultiLevelLaserRangeFinderConfig;
@@ -346,6 +373,8 @@ BaseConfig* MultiLevelLaserRangeFinder::parseConfig(ControlCenter *control,
       cfg->horizontalOpeningAngle = it->second;
     if((it = config->find("maxDistance")) != config->end())
       cfg->maxDistance = it->second;
+    if((it = config->find("drawRays")) != config->end())
+      cfg->drawRays = it->second;
 
     return cfg;
 }
@@ -365,6 +394,7 @@ ConfigMap MultiLevelLaserRangeFinder::createConfig() const {
     cfg["horizontalOpeningAngle"] = config.horizontalOpeningAngle;
     cfg["rate"] = config.updateRate;
     cfg["maxDistance"] = config.maxDistance;
+    cfg["drawRays"] = config.drawRays;
     return cfg;
 }
 
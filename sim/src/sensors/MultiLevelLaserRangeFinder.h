@@ -30,6 +30,7 @@ namespace mars {
         horizontalOpeningAngle= 2 * M_PI * (double (numRaysHorizontal - 1)) / numRaysHorizontal;
         attached_node = 0;
         maxDistance = 100.0;
+        drawRays = false;
       }
 
       unsigned long attached_node;
@@ -40,6 +41,7 @@ namespace mars {
       double verticalOpeningAngle;
       double horizontalOpeningAngle;
       double maxDistance;
+      bool drawRays;
     };
 
     class MultiLevelLaserRangeFinder : 
@@ -59,11 +61,14 @@ namespace mars {
   
         const std::vector< double >& getSensorData() const; 
         std::vector<double> getPointCloud();
-        virtual int getSensorData(double** data) const;
+        using interfaces::BaseSensor::getSensorData;
+        virtual int getSensorDataSize() const;
+        virtual int readSensorData(double *data, int size) const;
         virtual void receiveData(const data_broker::DataInfo &info,
                                 const data_broker::DataPackage &package,
                                 int callbackParam);
         virtual void update(std::vector<interfaces::draw_item>* drawItems);
+        virtual void updateBatch(interfaces::drawBatch *batch);
         
         static interfaces::BaseConfig* parseConfig(interfaces::ControlCenter *control,
                                                  configmaps::ConfigMap *config);
@@ -88,6 +93,13 @@ namespace mars {
             int rttHeight;
             double coveredAngle;
             utils::Quaternion orientation;
+            // the pixels of distImage that are sampled by the rays, the
+            // index of the ray in rayValues and the length of its
+            // direction vector
+            std::vector<int> sampleIndices;
+            std::vector<int> scanPositions;
+            std::vector<double> directionNorms;
+            std::vector<float> samples;
         };
         
         struct Lookup
@@ -106,6 +118,7 @@ namespace mars {
         
         std::vector<double> rayValues;
         
+        // the normalized ray directions in the frame of the attached node
         std::vector<utils::Vector> directions;
         long positionIndices[3];
         long rotationIndices[4];
@@ -58,13 +58,16 @@ namespace mars {
       return 21;
     }
 
-    int NodeCOMSensor::getSensorData(sReal** data) const {
+    int NodeCOMSensor::getSensorDataSize() const {
+      return 3;
+    }
+
+    int NodeCOMSensor::readSensorData(sReal *data, int size) const {
+      if(size < 3) return 3;
       Vector center = control->nodes->getCenterOfMass(config.ids);
-  
-      *data = (sReal*)calloc(3, sizeof(sReal));
-      (*data)[0] = center.x();
-      (*data)[1] = center.y();
-      (*data)[2] = center.z();
+      data[0] = center.x();
+      data[1] = center.y();
+      data[2] = center.z();
       return 3;
     }
 
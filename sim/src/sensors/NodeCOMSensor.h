@@ -44,7 +44,8 @@ namespace mars {
       NodeCOMSensor(interfaces::ControlCenter* control, IDListConfig config);
       ~NodeCOMSensor(void) {}
       virtual int getAsciiData(char* data) const;
-      virtual int getSensorData(interfaces::sReal** data) const;
+      virtual int getSensorDataSize() const;
+      virtual int readSensorData(interfaces::sReal *data, int size) const;
       static interfaces::BaseSensor* instanciate(interfaces::ControlCenter *control,
                                            interfaces::BaseConfig *config);
     };
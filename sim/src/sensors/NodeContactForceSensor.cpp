@@ -85,15 +85,19 @@ namespace mars {
       return 10;
     }
 
-    int NodeContactForceSensor::getSensorData(sReal** data) const {
+    int NodeContactForceSensor::getSensorDataSize() const {
+      return 1;
+    }
+
+    int NodeContactForceSensor::readSensorData(sReal *data, int size) const {
       sReal contact = 0;
       std::vector<double>::const_iterator iter;
-  
-      *data = (sReal*)malloc(sizeof(sReal));
+
+      if(size < 1) return 1;
       for(iter = doubleArray.begin(); iter != doubleArray.end(); iter++) {
-        contact += *iter;;
+        contact += *iter;
       }
-      **data = contact;
+      *data = contact;
       return 1;
     }
 
@@ -110,15 +110,19 @@ namespace mars {
       return 2;
     }
 
-    int NodeContactSensor::getSensorData(sReal** data) const {
+    int NodeContactSensor::getSensorDataSize() const {
+      return 1;
+    }
+
+    int NodeContactSensor::readSensorData(sReal *data, int size) const {
       bool contact = 0;
       std::vector<bool>::const_iterator iter;
-  
-      *data = (sReal*)malloc(sizeof(sReal));
+
+      if(size < 1) return 1;
       for(iter = values.begin(); iter != values.end(); iter++) {
         contact |= *iter;
       }
-      **data = contact;
+      *data = contact;
       return 1;
     }
 
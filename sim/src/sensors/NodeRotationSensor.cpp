@@ -97,14 +97,18 @@ namespace mars {
       return num_char;
     }
 
-    int NodeRotationSensor::getSensorData(sReal** data) const {
-      std::vector<sRotation>::const_iterator iter;
-  
-      *data = (sReal*)calloc(3, sizeof(sReal));
-      for(iter = values.begin(); iter != values.end(); iter++) {
-        (*data)[0] = iter->alpha;
-        (*data)[1] = iter->beta;
-        (*data)[2] = iter->gamma;
+    int NodeRotationSensor::getSensorDataSize() const {
+      return 3;
+    }
+
+    int NodeRotationSensor::readSensorData(sReal *data, int size) const {
+      if(size < 3) return 3;
+      // the sensor reports the rotation of its last node
+      data[0] = data[1] = data[2] = 0.0;
+      if(!values.empty()) {
+        data[0] = values.back().alpha;
+        data[1] = values.back().beta;
+        data[2] = values.back().gamma;
       }
       return 3;
     }
@@ -67,17 +67,20 @@ namespace mars {
       return num_char;
     }
 
-    int NodeVelocitySensor::getSensorData(sReal** data) const {
-      std::vector<Vector>::const_iterator iter;
-      int i=0;
+    int NodeVelocitySensor::getSensorDataSize() const {
+      return 3*values.size();
+    }
 
-      *data = (sReal*)calloc(3*values.size(), sizeof(sReal));
+    int NodeVelocitySensor::readSensorData(sReal *data, int size) const {
+      int n = 3*values.size();
+      if(size < n) return n;
+      std::vector<Vector>::const_iterator iter;
       for(iter = values.begin(); iter != values.end(); iter++) {
-        (*data)[i++] = iter->x();
-        (*data)[i++] = iter->y();
-        (*data)[i++] = iter->z();
+        *(data++) = iter->x();
+        *(data++) = iter->y();
+        *(data++) = iter->z();
       }
-      return i;
+      return n;
     }
 
     void NodeVelocitySensor::receiveData(const data_broker::DataInfo &info,
@@ -116,16 +116,15 @@ namespace mars {
 #endif
     }
 
-    int RayGridSensor::getSensorData(sReal** data) const
-    {
-#if 0
-      int i;
-      *data = (sReal*)calloc(s_cfg.resolution, sizeof(sReal));
-      for (i = 0; i < s_cfg.resolution; i++) {
-        (*data)[i] = s_cfg.data[i];
-      }
-      return i;
-#endif
+    int RayGridSensor::getSensorDataSize() const {
+      // the values are not collected yet
+      return 0;
+    }
+
+    int RayGridSensor::readSensorData(sReal *data, int size) const {
+      CPP_UNUSED(data);
+      CPP_UNUSED(size);
+      return 0;
     }
 
     void RayGridSensor::receiveData(const data_broker::DataInfo &info,
@@ -52,7 +52,8 @@ namespace mars {
                     const std::string &name);
       ~RayGridSensor(void);
       virtual int getMonsterData(char* data) const;
-      virtual int getSensorData(interfaces::sReal** data) const;
+      virtual int getSensorDataSize() const;
+      virtual int readSensorData(interfaces::sReal *data, int size) const;
       virtual void receiveData(const data_broker::DataInfo &info,
                                const data_broker::DataPackage &package,
                                int callbackParam);
@@ -65,7 +65,6 @@ namespace mars {
 
       std::string groupName, dataName;
       drawStruct draw;
-      draw_item item;
       int i;
       Vector tmp;
       have_update = false;
@@ -86,20 +85,9 @@ namespace mars {
 
       //Drawing Stuff
       if(config.draw_rays) {
+        // the rays are drawn through updateBatch
         draw.ptr_draw = (DrawInterface*)this;
-        item.id = 0;
-        item.type = DRAW_LINE;
-        item.draw_state = DRAW_STATE_CREATE;
-        item.point_size = 1;
-        item.myColor.r = 1;
-        item.myColor.g = 0;
-        item.myColor.b = 0;
-        item.myColor.a = 1;
-        item.texture = "";
-        item.t_width = item.t_height = 0;
-        item.get_light = 0.0;
-          
-    
+
         double rad_steps = getCols(); //rad_angle/(sReal)(sensor.resolution-1);
         double rad_start = -((rad_steps-1)/2.0)*stepX; //Starting to Left, because 0 is in front and rock convention posive CCW //(M_PI-rad_angle)/2;
         if(rad_steps == 1){
@@ -112,11 +100,6 @@ namespace mars {
           tmp = Vector(cos(rad_start+i*stepX),
                        sin(rad_start+i*stepX), 0);
           directions.push_back(tmp);
-          tmp = (orientation * tmp);
-          item.start = position;
-          item.end = (orientation * tmp);
-          item.end *= data[i];
-          draw.drawItems.push_back(item); // TEST
         }
     
         if(control->graphics)
@@ -143,14 +126,18 @@ namespace mars {
       return result;
     }
 
-    int RaySensor::getSensorData(double **data_) const {
-      *data_ = (double*)malloc(data.size()*sizeof(double));
-      for(unsigned int i=0; i<data.size(); i++) {
-        (*data_)[i] = data[i];
-      }
+    int RaySensor::getSensorDataSize() const {
       return data.size();
     }
 
+    int RaySensor::readSensorData(double *data_, int size) const {
+      int n = data.size();
+      for(int i=0; i<n && i<size; i++) {
+        data_[i] = data[i];
+      }
+      return n;
+    }
+
     void RaySensor::receiveData(const data_broker::DataInfo &info,
                                 const data_broker::DataPackage &package,
                                 int callbackParam) {
@@ -182,24 +169,22 @@ namespace mars {
     }
 
     void RaySensor::update(std::vector<draw_item>* drawItems) {
-      unsigned int i;
+      (void)drawItems;
       if(config.draw_rays) {
         if(have_update) {
           control->nodes->updateRay(attached_node);
           have_update = false;
         }
-    
-    
-        if(!(*drawItems)[0].draw_state) {
-          for(i=0; i<data.size(); i++) {
-            (*drawItems)[i].draw_state = DRAW_STATE_UPDATE;
-            (*drawItems)[i].start = position;
-            (*drawItems)[i].end = (orientation * directions[i]);
-            (*drawItems)[i].end *= data[i];
-            
-            (*drawItems)[i].end += (*drawItems)[i].start;
-          }
-        }
+      }
+    }
+
+    void RaySensor::updateBatch(drawBatch *batch) {
+      batch->clear();
+      if(!config.draw_rays) return;
+      for(size_t i=0; i<data.size(); i++) {
+        batch->addLine(position,
+                       position + (orientation * directions[i]) * data[i],
+                       Color(1, 0, 0, 1));
       }
     }
 
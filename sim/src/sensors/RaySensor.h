@@ -81,11 +81,14 @@ namespace mars {
       ~RaySensor(void);
   
       std::vector<double> getSensorData() const; 
-      int getSensorData(double**) const; 
+      using interfaces::BaseSensor::getSensorData;
+      virtual int getSensorDataSize() const;
+      virtual int readSensorData(double *data, int size) const;
       virtual void receiveData(const data_broker::DataInfo &info,
                                const data_broker::DataPackage &package,
                                int callbackParam);
       virtual void update(std::vector<interfaces::draw_item>* drawItems);
+      virtual void updateBatch(interfaces::drawBatch *batch);
 
       static interfaces::BaseConfig* parseConfig(interfaces::ControlCenter *control,
                                                  configmaps::ConfigMap *config);
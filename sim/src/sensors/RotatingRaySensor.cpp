@@ -35,11 +35,15 @@
 #include <mars/interfaces/graphics/GraphicsManagerInterface.h>
 #include <mars/cfg_manager/CFGManagerInterface.h>
 #include <mars/utils/MutexLocker.h>
+#include <mars/utils/imageKernels.h>
 
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 
+// marks a scan that was not taken by the conversion thread yet
+#define NEW_SCAN 0x100
+
 namespace mars {
   namespace sim {
 
@@ -70,14 +74,14 @@ namespace mars {
       full_scan = false;
       current_pose.setIdentity();
       num_points = 0;
-      toCloud = &pointcloud1;
-      convertPointCloud = false;
-      nextCloud = 2;
+      gatherScan = 0;
+      pendingScan = 1;
+      workScan = 2;
+      frontScan = 3;
       this->attached_node = config.attached_node;
 
       std::string groupName, dataName;
       drawStruct draw;
-      draw_item item;
       Vector tmp;
       update_available = false;
 
@@ -130,35 +134,27 @@ namespace mars {
               Vector(1,0,0);
               
           directions.push_back(tmp);
-        
-          // Add a drawing item for each ray regarding the initial sensor orientation.
-          if(config.draw_rays) {
-            draw.ptr_draw = (DrawInterface*)this;
-            item.id = 0;
-            item.type = DRAW_LINE;
-            item.draw_state = DRAW_STATE_CREATE;
-            item.point_size = 1;
-            item.myColor.r = 1;
-            item.myColor.g = 0;
-            item.myColor.b = 0;
-            item.myColor.a = 1;
-            item.texture = "";
-            item.t_width = item.t_height = 0;
-            item.get_light = 0.0;
-            
-            // Initial vector length is set to 1.0
-            item.start = position;
-            item.end = orientation * tmp;
-            draw.drawItems.push_back(item);
-          }
         }
       }
 
+      // The scans are allocated once for the expected number of points.
+      size_t scanSize = config.bands * config.lasers * 3;
+      if(turning_step > 0) {
+        scanSize *= (size_t)ceil(turning_end_fullscan / turning_step) + 1;
+      }
+      for(int i=0; i<4; ++i) {
+        scans[i].points.reserve(scanSize);
+        scans[i].origin.setIdentity();
+        scans[i].pose.setIdentity();
+      }
+
       // Add sensor after everything has been initialized.
       control->nodes->addNodeSensor(this);
 
       // GraphicsManager crashes if default constructor drawStruct is passed.
+      // The rays are drawn through updateBatch.
       if(config.draw_rays) {
+        draw.ptr_draw = (DrawInterface*)this;
         if(control->graphics) {
           control->graphics->addDrawItems(&draw);
         }
@@ -170,31 +166,53 @@ namespace mars {
     RotatingRaySensor::~RotatingRaySensor(void) {
       control->graphics->removeDrawItems((DrawInterface*)this);
       control->dataBroker->unregisterTimedReceiver(this, "*", "*", "mars_sim/simTimer");
+      wakeupMutex.lock();
       closeThread = true;
+      wakeupCondition.wakeOne();
+      wakeupMutex.unlock();
       this->wait();
     }
 
     bool RotatingRaySensor::getPointcloud(std::vector<utils::Vector>& pcloud) {
       mars::utils::MutexLocker lock(&mutex_pointcloud);
       if(full_scan) {
+        const std::vector<float> &points = scans[frontScan].points;
         full_scan = false;
-        pcloud.swap(pointcloud_full);
+        pcloud.resize(points.size()/3);
+        for(size_t i=0; i<pcloud.size(); i++) {
+          pcloud[i] = Vector(points[i*3], points[i*3+1], points[i*3+2]);
+        }
         return true;
       } else {
           return false;
       }
     }
 
-    int RotatingRaySensor::getSensorData(double** data_) const {
+    const float* RotatingRaySensor::lockPointcloud(size_t *numPoints) const {
+      mutex_pointcloud.lock();
+      const std::vector<float> &points = scans[frontScan].points;
+      *numPoints = points.size()/3;
+      return points.empty() ? NULL : &points[0];
+    }
+
+    void RotatingRaySensor::unlockPointcloud() const {
+      mutex_pointcloud.unlock();
+    }
+
+    int RotatingRaySensor::getSensorDataSize() const {
       mars::utils::MutexLocker lock(&mutex_pointcloud);
-      *data_ = (double*)malloc(pointcloud_full.size()*3*sizeof(double));
-      for(unsigned int i=0; i<pointcloud_full.size(); i++) {
-        int array_pos = i*3;
-        (*data_)[array_pos] = (pointcloud_full[i])[0];
-        (*data_)[array_pos+1] = (pointcloud_full[i])[1];
-        (*data_)[array_pos+2] = (pointcloud_full[i])[2];
+      return scans[frontScan].points.size();
+    }
+
+    int RotatingRaySensor::readSensorData(double *data_, int size) const {
+      mars::utils::MutexLocker lock(&mutex_pointcloud);
+      const std::vector<float> &points = scans[frontScan].points;
+      int n = points.size();
+      if(size < n) return n;
+      for(int i=0; i<n; i++) {
+        data_[i] = points[i];
       }
-      return pointcloud_full.size()*3;
+      return n;
     }
 
     void RotatingRaySensor::receiveData(const data_broker::DataInfo &info,
@@ -228,34 +246,31 @@ namespace mars {
       package.get(rotationIndices[2], &orientation.z());
       package.get(rotationIndices[3], &orientation.w());
 
-      poseMutex.lock();
       current_pose.setIdentity();
       current_pose.rotate(orientation);
       current_pose.translation() = position;
-      poseMutex.unlock();
 
       // data[] contains all the measured distances according to the define directions.
       assert((int)data.size() == config.bands * config.lasers);
 
-      int i = 0; // data_counter
+      // Gathers the pointcloud relative to the pose at the start of the scan
+      // to prevent/reduce movement distortion. This necessitates a
+      // back-transformation to the pose at the end of the scan in run().
+      Scan &scan = scans[gatherScan];
+      if(scan.points.empty()) {
+        scan.origin = current_pose;
+      }
+      Eigen::Affine3d toOrigin = scan.origin.inverse() * current_pose;
       utils::Vector local_ray, tmpvec;
-      for(int b=0; b<config.bands; ++b) {
-        base::Orientation base_orientation;
-        base_orientation.x() = orientation_offset.x();
-        base_orientation.y() = orientation_offset.y();
-        base_orientation.z() = orientation_offset.z();
-        base_orientation.w() = orientation_offset.w();
-
+      for(size_t i=0; i<data.size(); ++i) {
         // If min/max are exceeded distance will be ignored.
-        for(int l=0; l<config.lasers; ++l, ++i){
-          if (data[i] >= config.minDistance && data[i] < config.maxDistance-0.01) {
-            // Calculates the ray/vector within the sensor frame.
-            local_ray = orientation_offset * directions[i] * data[i];
-            // Gathers pointcloud in the world frame to prevent/reduce movement distortion.
-            // This necessitates a back-transformation (world2node) in getPointcloud().
-            tmpvec = current_pose * local_ray;
-            toCloud->push_back(tmpvec); // Scale normalized vector.
-          }
+        if (data[i] >= config.minDistance && data[i] < config.maxDistance-0.01) {
+          // Calculates the ray/vector within the sensor frame.
+          local_ray = orientation_offset * directions[i] * data[i];
+          tmpvec = toOrigin * local_ray;
+          scan.points.push_back(tmpvec.x());
+          scan.points.push_back(tmpvec.y());
+          scan.points.push_back(tmpvec.z());
         }
       }
       num_points += data.size();
@@ -264,48 +279,42 @@ namespace mars {
     }
 
     void RotatingRaySensor::update(std::vector<draw_item>* drawItems) {
-
-      unsigned int i;
-
+      (void)drawItems;
       if(update_available) {
         control->nodes->updateRay(attached_node);
         update_available = false;
       }
-      if(config.draw_rays) {
-        if(!(*drawItems)[0].draw_state) {
-          for(i=0; i<data.size(); i++) {
-              (*drawItems)[i].draw_state = DRAW_STATE_UPDATE;
-              // Updates the rays using the current sensor pose. 
-              (*drawItems)[i].start = position;
-              (*drawItems)[i].end = (orientation * orientation_offset * directions[i]);
-              (*drawItems)[i].end *= data[i];
-              (*drawItems)[i].end += (*drawItems)[i].start;
-          }
-        }
+    }
+
+    void RotatingRaySensor::updateBatch(drawBatch *batch) {
+      batch->clear();
+      if(!config.draw_rays) return;
+      // Updates the rays using the current sensor pose.
+      utils::Quaternion rotation = orientation * orientation_offset;
+      for(size_t i=0; i<data.size(); i++) {
+        batch->addLine(position, position + (rotation * directions[i]) * data[i],
+                       Color(1, 0, 0, 1));
       }
     }
 
     utils::Quaternion RotatingRaySensor::turn() {  
       
-      // If the scan is full the pointcloud will be copied.
-      mutex_pointcloud.lock();
+      // If the scan is full it is handed over to the conversion thread.
       turning_offset += turning_step;
       if(turning_offset >= turning_end_fullscan) {
-        while(convertPointCloud) msleep(1);
-        fromCloud = toCloud;
-        if(nextCloud == 2) {
-          toCloud = &pointcloud2;
-          nextCloud = 1;
-        }
-        else {
-          toCloud = &pointcloud1;
-          nextCloud = 2;
-        }
-        convertPointCloud = true;
+        scans[gatherScan].pose = current_pose;
+        // the pending scan is only replaced after it was written completely
+        __sync_synchronize();
+        int lastScan = __sync_lock_test_and_set(&pendingScan,
+                                                gatherScan | NEW_SCAN);
+        gatherScan = lastScan & ~NEW_SCAN;
+        scans[gatherScan].points.clear();
+        wakeupMutex.lock();
+        wakeupCondition.wakeOne();
+        wakeupMutex.unlock();
         turning_offset = 0;
       }
       orientation_offset = utils::angleAxisToQuaternion(turning_offset, utils::Vector(0.0, 0.0, 1.0));
-      mutex_pointcloud.unlock();
       
       return orientation_offset;
     }
@@ -315,35 +324,38 @@ namespace mars {
     }
 
     void RotatingRaySensor::run() {
-      while(!closeThread) {
-        if(convertPointCloud) {
-          poseMutex.lock();
-          Eigen::Affine3d current_pose2 = current_pose;
-          Eigen::Affine3d rot;
-          rot.setIdentity();
-          rot.rotate(config.transf_sensor_rot_to_sensor);
-          poseMutex.unlock();
-
-          // Copies current full pointcloud to pointcloud_full.
-          std::list<utils::Vector>::iterator it = fromCloud->begin();
-          mutex_pointcloud.lock();
-          pointcloud_full.clear();
-          pointcloud_full.reserve(fromCloud->size());
-          base::Vector3d vec_local;
-
-          for(int i=0; it != fromCloud->end(); it++, i++) {
-            // Transforms the pointcloud back from world to current node (see receiveDate()).
-            // In addition 'transf_sensor_rot_to_sensor' is applied which describes
-            // the orientation of the sensor in the unturned sensor frame.
-            vec_local = rot * current_pose2.inverse() * (*it);
-            pointcloud_full.push_back(vec_local);
-          }
-          mutex_pointcloud.unlock();
-          fromCloud->clear();
-          convertPointCloud = false;
-          full_scan = true;
+      Eigen::Affine3d rot;
+      rot.setIdentity();
+      rot.rotate(config.transf_sensor_rot_to_sensor);
+
+      while(true) {
+        wakeupMutex.lock();
+        while(!closeThread && !(pendingScan & NEW_SCAN)) {
+          wakeupCondition.wait(&wakeupMutex);
+        }
+        wakeupMutex.unlock();
+        if(closeThread) break;
+
+        workScan = __sync_lock_test_and_set(&pendingScan, workScan) & ~NEW_SCAN;
+        __sync_synchronize();
+        Scan &scan = scans[workScan];
+
+        // Transforms the pointcloud from the start to the end pose of the
+        // scan (see receiveData()). In addition 'transf_sensor_rot_to_sensor'
+        // is applied which describes the orientation of the sensor in the
+        // unturned sensor frame.
+        Eigen::Matrix<float, 3, 4, Eigen::RowMajor> m;
+        m = (rot * scan.pose.inverse() * scan.origin).matrix().topRows<3>().cast<float>();
+        if(!scan.points.empty()) {
+          transformPoints(&scan.points[0], &scan.points[0],
+                          scan.points.size()/3, m.data());
         }
-        else msleep(2);
+
+        // Publishes the scan.
+        mutex_pointcloud.lock();
+        std::swap(workScan, frontScan);
+        full_scan = true;
+        mutex_pointcloud.unlock();
       }
     }
 
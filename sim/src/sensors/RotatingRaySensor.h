@@ -39,6 +39,7 @@
 #include <mars/utils/Thread.h>
 #include <mars/utils/mathUtils.h>
 #include <mars/utils/Mutex.h>
+#include <mars/utils/WaitCondition.h>
 #include <mars/interfaces/graphics/draw_structs.h>
 
 #include <base/Pose.hpp>
@@ -101,26 +102,35 @@ namespace mars {
       
       /**
        * Returns a complete scan covering the complete defined horizontal range.
-       * The pointcloud is gathered within the world frame and
-       * - after a complete scan has been received - transformed into the
-       * current local frame. This prevents strong distortions on slower computers.
+       * The pointcloud is gathered relative to the pose at the start of
+       * the scan and - after a complete scan has been received - transformed
+       * into the local frame at the end of the scan by the conversion thread. This prevents strong distortions on slower computers.
        * If a full scan is not available an empty pointcloud will be returned.
        */
       bool getPointcloud(std::vector<utils::Vector>& pointcloud);
 
+      /**
+       * Gives read-only access to the latest full scan without copying it.
+       * The points are stored as x, y, z in the current local frame.
+       * The scan stays valid until unlockPointcloud() is called; a scan
+       * that is completed in the meantime waits to be published.
+       */
+      const float* lockPointcloud(size_t *numPoints) const;
+      void unlockPointcloud() const;
+
       /**
        * Copies the current full pointcloud to a double array with (x,y,z).
-       * \warning Memory has to be freed manually!
        * Inherited from BaseSensor, implemented from BasePolarIntersectionSensor.
        */
-      int getSensorData(double**) const; 
+      virtual int getSensorDataSize() const;
+      virtual int readSensorData(double *data, int size) const;
       
       /**
        * Receives the measured distances, calculates the vectors in the local
-       * sensor frame and transfers them into the world to compensate the
-       * movement during pointcloud gathering.
-       * The points are transformed back to the current node pose
-       * when the pointcloud is requested.
+       * sensor frame and transfers them into the frame of the scan start to
+       * compensate the movement during pointcloud gathering.
+       * The points are transformed to the node pose at the end of the scan
+       * as soon as the scan is complete.
        * Inherited from ReceiverInterface. Method is called by the DataBroker
        * as soon as the registered event occurs.
        */
@@ -128,12 +138,17 @@ namespace mars {
                                const data_broker::DataPackage &package,
                                int callbackParam);
       
+      /**
+       * Updates the rays of the attached node.
+       * Inherited from DrawInterface.
+       */
+      virtual void update(std::vector<interfaces::draw_item>* drawItems);
       /**
        * Uses the current node pose and the current distances to draw 
        * the laser rays.
        * Inherited from DrawInterface.
        */
-      virtual void update(std::vector<interfaces::draw_item>* drawItems);
+      virtual void updateBatch(interfaces::drawBatch *batch);
       
       /**
        * Config methods all part of BaseSensor.
@@ -148,10 +163,10 @@ namespace mars {
       /**
        * Turns the sensor during each simulation step.
        * As soon as a full scan has been done (depends on the number of bands)
-       * the pointcloud is copied to pointcloud_full and a new scan
-       * is initiated. Runs in the same thread than receiveData, so only the use of 
-       * full_pointcloud (turn(), getPointcloud() and getSensorData()) has to be 
-       * synchronized.
+       * the scan is handed over to the conversion thread and a new scan
+       * is initiated. Runs in the same thread than receiveData and never
+       * waits for the conversion; if the conversion thread did not pick up
+       * the previous scan yet, that scan is replaced.
        */
       utils::Quaternion turn();
       
@@ -173,15 +188,25 @@ namespace mars {
     private:
       /** Contains the normalized scan directions. */ 
       std::vector<utils::Vector> directions;
-      // TODO Storing the pointcloud four times is not very effective.
-      // Maybe: Integrate distortion-prevention (use current sensor pose)
-      // in mlls and only create the pointcloud on demand.
-      std::list<utils::Vector> pointcloud1; // TODO Replace with array with fix size.
-      std::list<utils::Vector> pointcloud2; // TODO Replace with array with fix size.
-      std::list<utils::Vector> *toCloud, *fromCloud; // TODO Replace with array with fix size.
-      std::vector<utils::Vector> pointcloud_full; // Stores the full scan.
-      bool convertPointCloud;
-      int nextCloud;
+      /**
+       * One scan stored as x, y, z. While it is gathered, the points are
+       * stored relative to the node pose at the start of the scan.
+       */
+      struct Scan {
+        std::vector<float> points;
+        Eigen::Affine3d origin; // node pose at the start of the scan
+        Eigen::Affine3d pose; // node pose at the end of the scan
+      };
+      // The scans are passed on by exchanging their indices:
+      // gatherScan is filled by receiveData(), pendingScan waits for the
+      // conversion thread, workScan is converted and frontScan is the
+      // latest full scan. pendingScan has the NEW_SCAN flag set until it
+      // is taken by the conversion thread.
+      Scan scans[4];
+      int gatherScan, workScan, frontScan;
+      volatile int pendingScan;
+      mars::utils::Mutex wakeupMutex;
+      mars::utils::WaitCondition wakeupCondition;
       double vertical_resolution;
       bool update_available;
       bool full_scan;
@@ -192,9 +217,9 @@ namespace mars {
       long rotationIndices[4];
       double turning_step;
       int nsamples;
-      mutable mars::utils::Mutex mutex_pointcloud, poseMutex;
+      mutable mars::utils::Mutex mutex_pointcloud;
       Eigen::Affine3d current_pose;
-      bool closeThread;
+      volatile bool closeThread;
       unsigned int num_points;
     };
 
@@ -28,6 +28,7 @@
 #include <mars/interfaces/sim/MotorManagerInterface.h>
 #include <mars/interfaces/sim/SensorManagerInterface.h>
 #include <mars/utils/mathUtils.h>
+#include <mars/utils/imageKernels.h>
 #include <mars/interfaces/graphics/GraphicsManagerInterface.h>
 #include <mars/interfaces/sim/LoadCenter.h>
 
@@ -192,8 +193,15 @@ namespace mars {
     }
 
 
-    int ScanningSonar::getSensorData(double ** data) const {
+    int ScanningSonar::getSensorDataSize() const {
       if(!gw) return 0;
+      if(raySensor) return raySensor->getSensorDataSize()+1;
+      return (int)(config.maxDist/config.resolution)+1;
+    }
+
+    int ScanningSonar::readSensorData(double *data, int size) const {
+      int n = getSensorDataSize();
+      if(n == 0 || size < n) return n;
 
       SimMotor *motor = control->motors->getSimMotor(motorID);
       //Quaternion q = motor->getJoint()->getAttachedNode2()->getRotation().inverse() * motor->getJoint()->getAttachedNode1()->getRotation();
@@ -203,39 +211,35 @@ namespace mars {
       double bearing = mars::utils::getYaw(q);
 
       if(raySensor){
-        std::vector<double> res = raySensor->getSensorData();
-        (*data) = new double[res.size()+1];
-        memcpy((*data)+1,&res[0],sizeof(double)*res.size());
-        (*data)[0] = bearing;
-        return res.size()+1;
+        raySensor->readSensorData(data+1, n-1);
+        data[0] = bearing;
+        return n;
       }
 
-      (*data) = new double[(int)(config.maxDist/config.resolution)+1];
-      double *res = (*data);
       int width, height;
-      float *img_data;
-      gw->getRTTDepthData(&img_data, width, height);
-
-
-      res[0] = bearing;
-      for(int i=0;i<config.maxDist/config.resolution;i++){
-        res[i+1] = 0;
+      if(depthBuffer.empty()) {
+        // the size of the window is only known after the first read
+        float *img_data;
+        gw->getRTTDepthData(&img_data, width, height);
+        depthBuffer.assign(img_data, img_data+width*height);
+        free(img_data);
+      }
+      else {
+        gw->getRTTDepthData(&depthBuffer[0], width, height);
       }
 
-      for(int x = 0; x < width; x++){
-        for(int y = 0;y < height; y++){
-          double dist = img_data[y+(x*height)];
-          if((int)(dist/config.resolution)+1 < (int)(config.maxDist/config.resolution)+1)
-            res[(int)(dist/config.resolution)+1]++;
-        }
+      data[0] = bearing;
+      for(int i=1;i<n;i++){
+        data[i] = 0;
       }
+      distanceHistogram(&depthBuffer[0], width*height, config.resolution,
+                        data+1, n-1);
 
-      static int wth = width*height;
-      for(int i=0;i<config.maxDist/config.resolution;i++){
-        res[i+1]= std::min((res[i+1]/wth)*255.0*config.gain,255.0);
+      const int wth = width*height;
+      for(int i=1;i<n;i++){
+        data[i]= std::min((data[i]/wth)*255.0*config.gain,255.0);
       }
-      free(img_data);
-      return config.maxDist/config.resolution;
+      return n;
     }
 
     void ScanningSonar::preGraphicsUpdate(void) {
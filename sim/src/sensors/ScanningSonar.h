@@ -99,7 +99,8 @@ namespace mars {
       ScanningSonar(interfaces::ControlCenter *control, ScanningSonarConfig _config);
       ~ScanningSonar(void);
 
-      virtual int getSensorData(double** data) const;
+      virtual int getSensorDataSize() const;
+      virtual int readSensorData(interfaces::sReal *data, int size) const;
       virtual void receiveData(const data_broker::DataInfo &info,
                                const data_broker::DataPackage &package,
                                int callbackParam);
@@ -130,6 +131,7 @@ namespace mars {
       utils::Vector head_position;
       unsigned int attached_motor;
       RaySensor *raySensor;
+      mutable std::vector<float> depthBuffer;
     };
 
   } // end of namespace sim
@@ -389,6 +389,9 @@ namespace mars {
             if (physicsmap["ode"].hasKey("stepsize")) {
               control->cfg->setPropertyValue("Simulator", "calc_ms", "value", (sReal)(physicsmap["ode"]["stepsize"]));
             }
+            if (physicsmap["ode"].hasKey("space_type")) {
+              control->cfg->setPropertyValue("Simulator", "space_type", "value", std::string(physicsmap["ode"]["space_type"]));
+            }
           }
         }
         if (map.hasKey("environment")) {